@@ -0,0 +1,274 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * ipmi_engine 的吞吐量 benchmark：epoll + sendmmsg/recvmmsg 對 io_uring
+ *
+ * 同一個 process 裡開一個 responder thread，綁 N 個 127.0.0.1 的 UDP port 當 N 台 BMC，
+ * 收到 request 就地改成 Get Device ID 的回應送回去。engine 對每台維持 depth 個 request
+ * 在路上，跑固定秒數，印每秒 request / 封包數和每千個封包用了幾次 syscall。
+ * io_uring 只有用 IO_URING=1 編譯時才會跑。
+ *
+ * 用法：bench_ipmi_engine [targets] [depth] [seconds]
+ */
+
+#define BENCH_DEFAULT_TARGETS   256
+#define BENCH_DEFAULT_DEPTH     8
+#define BENCH_DEFAULT_SECONDS   3
+#define BENCH_BATCH             64
+#define BENCH_PKT_SIZE          512
+
+// IPMI 1.5 封包裡 message 的位置（RMCP 4 + session 9 + 長度 1）
+#define MSG_OFF                 14
+
+typedef struct {
+    int* fds;
+    int count;
+    int epfd;
+    volatile int stop;
+    unsigned long replies;
+} responder_t;
+
+typedef struct {
+    uint64_t end_us;
+    unsigned long completed;
+    unsigned long failed;
+} bench_state_t;
+
+/* ===== Responder ===== */
+
+// Get Device ID 的回應 data（cc 之後）
+static const uint8_t g_device_id[] = { 0x20, 0x81, 0x02, 0x10, 0x02, 0xbf, 0x57, 0x01, 0x00, 0x10, 0x00 };
+
+// request 就地改成回應，回傳長度；不是 IPMI 1.5 request 回傳 0
+static size_t make_reply(uint8_t* pkt, size_t len) {
+    if (len < MSG_OFF + 7 || pkt[4] != IPMI_AUTH_TYPE_NONE) {
+        return 0;
+    }
+    
+    uint8_t* msg = pkt + MSG_OFF;
+    uint8_t rs_sa = msg[0];
+    uint8_t netfn = msg[1] >> 2;
+    uint8_t rq_sa = msg[3];
+    uint8_t rq_seq = msg[4];
+    uint8_t cmd = msg[5];
+    
+    msg[0] = rq_sa;
+    msg[1] = (uint8_t)(((netfn | 1) << 2) | (rq_seq & 0x03));
+    msg[2] = ipmi_checksum(msg, 2);
+    msg[3] = rs_sa;
+    msg[4] = rq_seq & 0xFC;
+    msg[5] = cmd;
+    msg[6] = 0x00;               // completion code
+    memcpy(msg + 7, g_device_id, sizeof(g_device_id));
+    
+    size_t body = 3 + 1 + sizeof(g_device_id);
+    msg[3 + body] = ipmi_checksum(msg + 3, body);
+    pkt[MSG_OFF - 1] = (uint8_t)(3 + body + 1);
+    
+    return MSG_OFF + 3 + body + 1;
+}
+
+static void* responder_main(void* arg) {
+    responder_t* r = arg;
+    struct mmsghdr msgs[BENCH_BATCH];
+    struct iovec iov[BENCH_BATCH];
+    struct sockaddr_storage from[BENCH_BATCH];
+    static uint8_t bufs[BENCH_BATCH][BENCH_PKT_SIZE];
+    struct epoll_event events[64];
+    
+    while (!r->stop) {
+        int n = epoll_wait(r->epfd, events, 64, 50);
+        
+        for (int e = 0; e < n; e++) {
+            int fd = r->fds[events[e].data.u32];
+            
+            for (;;) {
+                for (int i = 0; i < BENCH_BATCH; i++) {
+                    iov[i].iov_base = bufs[i];
+                    iov[i].iov_len = BENCH_PKT_SIZE;
+                    memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+                    msgs[i].msg_hdr.msg_iov = &iov[i];
+                    msgs[i].msg_hdr.msg_iovlen = 1;
+                    msgs[i].msg_hdr.msg_name = &from[i];
+                    msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+                }
+                
+                int got = recvmmsg(fd, msgs, BENCH_BATCH, MSG_DONTWAIT, NULL);
+                if (got <= 0) {
+                    break;
+                }
+                
+                for (int i = 0; i < got; i++) {
+                    iov[i].iov_len = make_reply(bufs[i], msgs[i].msg_len);
+                }
+                
+                int sent = 0;
+                while (sent < got) {
+                    int s = sendmmsg(fd, msgs + sent, (unsigned int)(got - sent), 0);
+                    if (s <= 0) {
+                        break;
+                    }
+                    sent += s;
+                }
+                r->replies += (unsigned long)sent;
+                
+                if (got < BENCH_BATCH) {
+                    break;
+                }
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+static int responder_open(responder_t* r, int count) {
+    r->fds = calloc((size_t)count, sizeof(int));
+    r->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!r->fds || r->epfd < 0) {
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        struct sockaddr_in sin = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr*)&sin, sizeof(sin)) < 0) {
+            fprintf(stderr, "responder socket %d: %s\n", i, strerror(errno));
+            return -1;
+        }
+        
+        int rcvbuf = 1 << 20;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+        epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev);
+        r->fds[i] = fd;
+        r->count++;
+    }
+    
+    return 0;
+}
+
+static void responder_close(responder_t* r) {
+    for (int i = 0; i < r->count; i++) {
+        close(r->fds[i]);
+    }
+    if (r->epfd >= 0) {
+        close(r->epfd);
+    }
+    free(r->fds);
+}
+
+/* ===== Engine ===== */
+
+static void on_done(ipmi_engine_t* eng, int target, int status,
+                    const ipmi_rsp_view_t* rsp, void* user_data) {
+    bench_state_t* st = user_data;
+    (void)rsp;
+    
+    if (status == BMC_SUCCESS) {
+        st->completed++;
+    } else {
+        st->failed++;
+    }
+    
+    // 時間到之前每完成一個就補一個，維持每台 depth 個在路上
+    if (bmc_monotonic_us() < st->end_us) {
+        ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = IPMI_CMD_GET_DEVICE_ID };
+        ipmi_engine_submit(eng, target, &req, on_done, st);
+    }
+}
+
+static int bench_backend(int backend, const responder_t* r, int depth, int seconds) {
+    ipmi_engine_t* eng = ipmi_engine_create(0);
+    if (!eng) {
+        return -1;
+    }
+    
+    if (ipmi_engine_set_io_backend(eng, backend) != BMC_SUCCESS) {
+        printf("  %-10s not available\n", ipmi_engine_io_backend_name(backend));
+        ipmi_engine_destroy(eng);
+        return 0;
+    }
+    
+    ipmi_engine_set_depth(eng, depth);
+    ipmi_engine_set_max_outstanding(eng, r->count * depth);
+    ipmi_engine_set_timeout(eng, 2000);
+    
+    for (int i = 0; i < r->count; i++) {
+        struct sockaddr_in sin;
+        socklen_t len = sizeof(sin);
+        getsockname(r->fds[i], (struct sockaddr*)&sin, &len);
+        
+        ipmi_addr_t addr = { .addrlen = len, .status = BMC_SUCCESS };
+        memcpy(&addr.addr, &sin, len);
+        ipmi_engine_add_target_addr(eng, NULL, &addr);
+    }
+    
+    bench_state_t st = { .end_us = bmc_monotonic_us() + (uint64_t)seconds * 1000000 };
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = IPMI_CMD_GET_DEVICE_ID };
+    for (int t = 0; t < r->count; t++) {
+        for (int d = 0; d < depth; d++) {
+            ipmi_engine_submit(eng, t, &req, on_done, &st);
+        }
+    }
+    
+    uint64_t start = bmc_monotonic_us();
+    ipmi_engine_run(eng, -1);
+    double elapsed = (double)(bmc_monotonic_us() - start) / 1e6;
+    
+    ipmi_engine_stats_t stats;
+    ipmi_engine_get_stats(eng, &stats);
+    unsigned long packets = stats.sent + stats.received;
+    
+    printf("  %-10s %9.0f req/s  %9.0f pkt/s  %6.1f syscalls/1k pkt  %lu retransmits  %lu failed\n",
+           ipmi_engine_io_backend_name(backend), st.completed / elapsed, packets / elapsed,
+           packets ? stats.syscalls * 1000.0 / packets : 0.0, stats.retransmits, st.failed);
+    
+    ipmi_engine_destroy(eng);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int targets = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_TARGETS;
+    int depth = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_DEPTH;
+    int seconds = argc > 3 ? atoi(argv[3]) : BENCH_DEFAULT_SECONDS;
+    
+    if (targets <= 0 || depth <= 0 || depth > IPMI_SEQ_MAX_DEPTH || seconds <= 0) {
+        fprintf(stderr, "usage: %s [targets] [depth 1-%d] [seconds]\n", argv[0], IPMI_SEQ_MAX_DEPTH);
+        return 1;
+    }
+    
+    responder_t r = { .epfd = -1 };
+    if (responder_open(&r, targets) != 0) {
+        responder_close(&r);
+        return 1;
+    }
+    
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, responder_main, &r) != 0) {
+        responder_close(&r);
+        return 1;
+    }
+    
+    printf("IPMI engine throughput (%d targets, depth %d, %d s each)\n", targets, depth, seconds);
+    bench_backend(IPMI_ENGINE_IO_EPOLL, &r, depth, seconds);
+    bench_backend(IPMI_ENGINE_IO_URING, &r, depth, seconds);
+    
+    r.stop = 1;
+    pthread_join(thread, NULL);
+    responder_close(&r);
+    
+    return 0;
+}
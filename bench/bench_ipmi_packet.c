@@ -0,0 +1,175 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * IPMI request 建封包的 microbenchmark
+ *
+ * legacy  : 舊的 ipmi_send_recv 路徑，複製整個 ipmi_msg_t 再逐欄位建封包
+ * build   : ipmi_build_request()（現在走樣板）
+ * iovec   : ipmi_req_build() 直接吃 iovec payload
+ * set_seq : 封包已經建好，只改 seq 和 data checksum
+ */
+
+#define BENCH_ITERATIONS    5000000
+
+static volatile uint8_t g_sink;
+
+// 舊版的 ipmi_build_request，留著當比較基準
+static int legacy_build_request(const ipmi_msg_t* msg, uint8_t* buffer, size_t* len) {
+    size_t required_size = sizeof(rmcp_header_t) + sizeof(ipmi_session_header_t) + 1 +
+                           sizeof(ipmi_msg_header_t) + msg->data_len + 1;
+    if (*len < required_size) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    uint8_t* ptr = buffer;
+    
+    rmcp_header_t* rmcp = (rmcp_header_t*)ptr;
+    rmcp->version = RMCP_VERSION_1_0;
+    rmcp->reserved = 0x00;
+    rmcp->sequence = RMCP_SEQUENCE_NO_ACK;
+    rmcp->class = RMCP_CLASS_IPMI;
+    ptr += sizeof(rmcp_header_t);
+    
+    ipmi_session_header_t* session = (ipmi_session_header_t*)ptr;
+    session->auth_type = IPMI_AUTH_TYPE_NONE;
+    session->sequence = 0;
+    session->id = 0;
+    ptr += sizeof(ipmi_session_header_t);
+    
+    *ptr++ = (uint8_t)(sizeof(ipmi_msg_header_t) + msg->data_len + 1);
+    
+    ipmi_msg_header_t* msg_hdr = (ipmi_msg_header_t*)ptr;
+    msg_hdr->target_addr = IPMI_BMC_SLAVE_ADDR;
+    msg_hdr->target_lun = (msg->netfn << 2);
+    uint8_t header_data[2] = { msg_hdr->target_addr, msg_hdr->target_lun };
+    msg_hdr->header_checksum = ipmi_checksum(header_data, 2);
+    msg_hdr->source_addr = IPMI_REMOTE_SWID;
+    msg_hdr->source_lun = (msg->seq << 2);
+    msg_hdr->cmd = msg->cmd;
+    ptr += sizeof(ipmi_msg_header_t);
+    
+    if (msg->data_len > 0) {
+        memcpy(ptr, msg->data, msg->data_len);
+        ptr += msg->data_len;
+    }
+    
+    *ptr++ = ipmi_checksum(&msg_hdr->source_addr, 3 + msg->data_len);
+    
+    *len = ptr - buffer;
+    return BMC_SUCCESS;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char* name, size_t data_len, uint64_t elapsed_ns) {
+    printf("  %-10s %3zu bytes payload  %7.2f ns/packet\n", name, data_len,
+           (double)elapsed_ns / BENCH_ITERATIONS);
+}
+
+static void bench_payload(const ipmi_msg_t* msg) {
+    uint8_t buf[IPMI_REQ_MAX_LEN];
+    size_t len;
+    uint64_t start;
+    
+    // 舊路徑：每次都複製 ipmi_msg_t（ipmi_send_recv 的 req_copy）
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        ipmi_msg_t req_copy = *msg;
+        req_copy.seq = (uint8_t)(i & 0x3F);
+        len = sizeof(buf);
+        legacy_build_request(&req_copy, buf, &len);
+        g_sink = buf[len - 1];
+    }
+    report("legacy", msg->data_len, now_ns() - start);
+    
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        len = sizeof(buf);
+        ipmi_build_request(msg, buf, &len);
+        g_sink = buf[len - 1];
+    }
+    report("build", msg->data_len, now_ns() - start);
+    
+    const ipmi_req_tmpl_t* tmpl = ipmi_req_tmpl_get(msg->netfn, msg->cmd);
+    struct iovec iov = { .iov_base = (void*)msg->data, .iov_len = msg->data_len };
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        len = sizeof(buf);
+        ipmi_req_build(tmpl, (uint8_t)(i & 0x3F), &iov, 1, buf, &len);
+        g_sink = buf[len - 1];
+    }
+    report("iovec", msg->data_len, now_ns() - start);
+    
+    len = sizeof(buf);
+    ipmi_req_build(tmpl, 0, &iov, 1, buf, &len);
+    start = now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        ipmi_req_set_seq(buf, len, (uint8_t)(i & 0x3F));
+        g_sink = buf[len - 1];
+    }
+    report("set_seq", msg->data_len, now_ns() - start);
+}
+
+// 新舊兩條路徑建出來的封包要一模一樣，不然量速度沒意義
+static int verify(const ipmi_msg_t* msg) {
+    uint8_t a[IPMI_REQ_MAX_LEN];
+    uint8_t b[IPMI_REQ_MAX_LEN];
+    
+    for (uint8_t seq = 0; seq < 64; seq++) {
+        ipmi_msg_t m = *msg;
+        m.seq = seq;
+        size_t len_a = sizeof(a);
+        size_t len_b = sizeof(b);
+        legacy_build_request(&m, a, &len_a);
+        ipmi_build_request(&m, b, &len_b);
+        
+        // 先用別的 seq 建，再改成 seq，要跟直接建的一樣
+        uint8_t c[IPMI_REQ_MAX_LEN];
+        size_t len_c = sizeof(c);
+        m.seq = (uint8_t)(63 - seq);
+        ipmi_build_request(&m, c, &len_c);
+        ipmi_req_set_seq(c, len_c, seq);
+        
+        if (len_a != len_b || memcmp(a, b, len_a) != 0 ||
+            len_c != len_a || memcmp(a, c, len_a) != 0) {
+            fprintf(stderr, "Mismatch: netfn=0x%02x cmd=0x%02x seq=%d len=%zu\n",
+                    msg->netfn, msg->cmd, seq, msg->data_len);
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+int main(void) {
+    static const size_t sizes[] = { 0, 4, 32, 200 };
+    ipmi_msg_t msg = { .netfn = IPMI_NETFN_SENSOR, .cmd = IPMI_CMD_GET_SENSOR_READING };
+    
+    for (size_t i = 0; i < sizeof(msg.data); i++) {
+        msg.data[i] = (uint8_t)(i * 37 + 11);
+    }
+    
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        msg.data_len = sizes[i];
+        if (verify(&msg) != 0) {
+            return 1;
+        }
+    }
+    
+    printf("IPMI request build (%d iterations each)\n", BENCH_ITERATIONS);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        msg.data_len = sizes[i];
+        bench_payload(&msg);
+    }
+    
+    return 0;
+}
@@ -27,6 +27,15 @@ extern log_level_t g_log_level;
 void bmc_log(log_level_t level, const char* fmt, ...);
 void bmc_hexdump(const uint8_t* data, size_t len);
 
+// Monotonic clock（微秒），用來算 timeout 和 RTT
+uint64_t bmc_monotonic_us(void);
+
+/*
+ * 快取檔的完整路徑：$BMCTOOL_CACHE_DIR/name，沒設就用 $XDG_CACHE_HOME/bmctool
+ * 或 ~/.cache/bmctool；目錄不存在會建立（0700）
+ */
+int bmc_cache_path(const char* name, char* buf, size_t len);
+
 // Output format
 typedef enum {
     OUTPUT_FORMAT_NORMAL,
@@ -38,6 +47,7 @@ extern output_format_t g_output_format;
 
 // Table functions
 void table_init(int num_cols, const char* headers[]);
+void table_set_col_width(int col, int width);
 void table_print_header(void);
 void table_print_row(const char* cols[]);
 void table_print_footer(void);
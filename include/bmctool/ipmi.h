@@ -2,6 +2,7 @@
 #define BMCTOOL_IPMI_H
 
 #include "bmctool/common.h"
+#include <sys/uio.h>
 
 /* RMCP 常數 */
 #define RMCP_VERSION_1_0        0x06
@@ -36,6 +37,10 @@
 #define IPMI_CMD_WARM_RESET     0x03
 #define IPMI_CMD_GET_SENSOR_READING  0x2D
 #define IPMI_CMD_GET_SEL_INFO   0x40
+#define IPMI_CMD_SEND_MESSAGE   0x34
+
+// Chassis commands
+#define IPMI_CMD_GET_CHASSIS_STATUS  0x01
 
 /* RMCP Header */
 typedef struct {
@@ -67,6 +72,9 @@ typedef struct {
     uint8_t netfn;          // Network Function
     uint8_t cmd;            // Command
     uint8_t seq;            // Sequence number
+    uint8_t target_addr;    // 橋接目標的 slave address，0 或 0x20 表示 BMC 本身
+    uint8_t target_lun;     // 橋接目標的 LUN
+    uint8_t channel;        // 橋接用的 channel（0 是 primary IPMB）
     uint8_t data[IPMI_MAX_DATA_SIZE];  // 資料
     size_t data_len;        // 資料長度
 } ipmi_msg_t;
@@ -89,15 +97,99 @@ uint8_t ipmi_checksum(const uint8_t* data, size_t len);
 /* 封包建構 */
 int ipmi_build_request(const ipmi_msg_t* msg, uint8_t* buffer, size_t* len);
 
+/*
+ * Request 樣板（zero-copy 建封包）
+ *
+ * 同一個 (netfn, cmd) 的 request 只有 msg_len、seq、payload 和 data checksum 會變，
+ * 其他 header 和 header checksum 先算好放在樣板裡，建封包時整段複製過去。
+ */
+#define IPMI_REQ_HDR_LEN        20      // RMCP(4) + session(9) + msg_len(1) + msg header(6)
+#define IPMI_REQ_MSG_LEN_OFF    13
+#define IPMI_REQ_SEQ_OFF        18
+#define IPMI_REQ_MAX_LEN        (14 + 0xFF)     // msg_len 最多 255，加上前面 14 bytes
+
+typedef struct {
+    uint8_t hdr[IPMI_REQ_HDR_LEN];
+    uint8_t sum;            // source_addr + cmd，data checksum 固定的部分
+} ipmi_req_tmpl_t;
+
+void ipmi_req_tmpl_init(ipmi_req_tmpl_t* tmpl, uint8_t netfn, uint8_t cmd);
+// 共用的樣板快取，回傳的指標一直有效
+const ipmi_req_tmpl_t* ipmi_req_tmpl_get(uint8_t netfn, uint8_t cmd);
+int ipmi_req_build(const ipmi_req_tmpl_t* tmpl, uint8_t seq,
+                   const struct iovec* iov, size_t iovcnt,
+                   uint8_t* buffer, size_t* len);
+void ipmi_req_set_seq(uint8_t* packet, size_t len, uint8_t seq);
+
 /* 封包解析 */
 int ipmi_parse_response(const uint8_t* buffer, size_t len, ipmi_msg_t* msg);
 
+/*
+ * Response view：驗證完直接指向收到的 buffer，不複製 payload
+ * data 只在原本的 buffer 還有效時能用
+ */
+typedef struct {
+    uint8_t netfn;
+    uint8_t cmd;
+    uint8_t seq;
+    const uint8_t* data;    // 指向 buffer 裡的 payload（第一個 byte 是 completion code）
+    size_t data_len;
+} ipmi_rsp_view_t;
+
+int ipmi_rsp_view(const uint8_t* buffer, size_t len, ipmi_rsp_view_t* view);
+int ipmi_msg_view(const uint8_t* msg, size_t msg_len, ipmi_rsp_view_t* view);
+void ipmi_rsp_copy(const ipmi_rsp_view_t* view, ipmi_msg_t* msg);
+void ipmi_msg_as_view(const ipmi_msg_t* msg, ipmi_rsp_view_t* view);
+
+/*
+ * 橋接（Send Message）
+ *
+ * target_addr 不是 BMC 的 request 整個包成 IPMB message，放進 Send Message 的 data
+ * 交給 BMC 轉送（例如 channel 6 上的 ME 是 0x2C）。Send Message 開 tracking，
+ * BMC 先回一個只有 completion code 的 ack，satellite 的回應之後才包在另一個
+ * Send Message response 裡送回來。內外兩層用同一個 rqSeq，
+ * 所以同時在路上的橋接 request 還是靠外層 seq 對得回來。
+ */
+#define IPMI_SEND_MSG_TRACK     0x40    // channel byte bit 6：BMC 追蹤回應
+#define IPMI_BRIDGE_OVERHEAD    8       // channel + IPMB header(6) + checksum
+#define IPMI_BRIDGE_PENDING     1       // ipmi_bridge_unwrap：只是 ack，回應還沒到
+
+int ipmi_msg_is_bridged(const ipmi_msg_t* msg);
+int ipmi_req_build_bridged(const ipmi_msg_t* msg, uint8_t seq, uint8_t* buffer, size_t* len);
+// ipmi_req_set_seq 的橋接版：內外兩層的 seq 一起改
+void ipmi_req_set_seq_bridged(uint8_t* packet, size_t len, uint8_t seq);
+/*
+ * 拆開對上 seq 的 Send Message response：回傳 BMC_SUCCESS 時 inner 是 satellite 的回應
+ * （外層 completion code 不是 0 時 inner 就是外層，呼叫端看得到 0x80~0x83 這類錯誤），
+ * IPMI_BRIDGE_PENDING 表示是 ack 要繼續等，負數表示不是這個 request 的回應
+ */
+int ipmi_bridge_unwrap(const ipmi_rsp_view_t* outer, const ipmi_msg_t* req, uint8_t seq,
+                       ipmi_rsp_view_t* inner);
+
+/*
+ * Sequence number 視窗（pipelining 用）
+ *
+ * rqSeq 只有 6 bits，同一台 BMC 最多 64 個 request 同時在路上。
+ * 分配時輪流往前走，所以一個 seq 被用掉之後至少要再分配
+ * (64 - 在路上數量) 次才會重用；把深度限制在 IPMI_SEQ_MAX_DEPTH，
+ * 逾時 request 的遲到回應就不會被誤認成新 request 的回應。
+ */
+#define IPMI_SEQ_SPACE          64
+#define IPMI_SEQ_MAX_DEPTH      32
+
+typedef struct {
+    void* slots[IPMI_SEQ_SPACE];   // 在路上的 request，用 rqSeq 當 index
+    uint8_t next;                  // 下一個候選 seq
+    uint8_t count;                 // 在路上的數量
+} ipmi_seq_window_t;
+
+void ipmi_seq_init(ipmi_seq_window_t* win, uint8_t first);
+int ipmi_seq_alloc(ipmi_seq_window_t* win, void* owner);
+void* ipmi_seq_take(ipmi_seq_window_t* win, uint8_t seq);
+
 /* 工具函式 */
 void ipmi_dump_packet(const uint8_t* data, size_t len);
 const char* ipmi_netfn_str(uint8_t netfn);
 const char* ipmi_cmd_str(uint8_t netfn, uint8_t cmd);
 
 #endif /* BMCTOOL_IPMI_H */
-
-// Chassis commands
-#define IPMI_CMD_GET_CHASSIS_STATUS  0x01
@@ -2,6 +2,7 @@
 #define BMCTOOL_IPMI_COMMANDS_H
 
 #include "bmctool/ipmi_context.h"
+#include "bmctool/ipmi_engine.h"
 
 // Get Device ID response
 typedef struct {
@@ -16,11 +17,6 @@ typedef struct {
     uint8_t aux_firmware_rev[4];
 } ipmi_device_id_t;
 
-// 命令函式
-int ipmi_cmd_get_device_id(ipmi_ctx_t* ctx, ipmi_device_id_t* device_id);
-
-#endif
-
 // Chassis Status response
 typedef struct {
     uint8_t current_power_state;
@@ -29,5 +25,42 @@ typedef struct {
     uint8_t front_panel_button;
 } ipmi_chassis_status_t;
 
+// 命令函式
+int ipmi_cmd_get_device_id(ipmi_ctx_t* ctx, ipmi_device_id_t* device_id);
+
 // Chassis 命令
 int ipmi_cmd_get_chassis_status(ipmi_ctx_t* ctx, ipmi_chassis_status_t* status);
+
+/*
+ * 非同步命令（走 ipmi_engine，不會卡住呼叫的 thread）
+ *
+ * op 由呼叫端提供，完成之前不能釋放或重用；可以在 callback 裡處理結果，
+ * 也可以不給 callback，dispatch 之後自己檢查 op->done。
+ * callback 在 ipmi_engine_run / ipmi_engine_dispatch 裡面執行，裡面可以再送下一個命令。
+ */
+typedef struct ipmi_async ipmi_async_t;
+typedef void (*ipmi_async_cb)(ipmi_async_t* op, void* user_data);
+
+struct ipmi_async {
+    int done;                    // 完成（含失敗）後變成 1
+    int status;                  // BMC_SUCCESS 或錯誤碼
+    int target;
+    ipmi_async_cb cb;
+    void* user_data;
+    union {
+        ipmi_device_id_t device_id;
+        ipmi_chassis_status_t chassis_status;
+    } result;                    // status 為 BMC_SUCCESS 時有效
+};
+
+// 回傳 BMC_SUCCESS 表示已排入，cb 之後一定會被呼叫一次（engine 被 destroy 除外）
+int ipmi_cmd_get_device_id_async(ipmi_engine_t* eng, int target, ipmi_async_t* op,
+                                 ipmi_async_cb cb, void* user_data);
+int ipmi_cmd_get_chassis_status_async(ipmi_engine_t* eng, int target, ipmi_async_t* op,
+                                      ipmi_async_cb cb, void* user_data);
+
+// Response 解碼（給 ipmi_engine 這種非同步路徑共用）
+int ipmi_decode_device_id(const ipmi_rsp_view_t* rsp, ipmi_device_id_t* device_id);
+int ipmi_decode_chassis_status(const ipmi_rsp_view_t* rsp, ipmi_chassis_status_t* status);
+
+#endif
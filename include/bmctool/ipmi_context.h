@@ -3,20 +3,40 @@
 
 #include "bmctool/common.h"
 #include "bmctool/ipmi.h"
+#include "bmctool/ipmi_rtt.h"
+#include "bmctool/ipmi_resolve.h"
+#include "bmctool/ipmi_session.h"
+#include "bmctool/ipmi_session_cache.h"
 #include <stdint.h>
 
 // IPMI 連線設定
 typedef struct {
     char host[256];          // BMC IP 或 hostname
     uint16_t port;           // 預設 623
-    char username[32];       // 使用者名稱（目前未用）
-    char password[32];       // 密碼（目前未用）
+    char username[32];       // 使用者名稱（lanplus 用，最長 16 字元）
+    char password[32];       // 密碼（lanplus 用，最長 20 字元）
     
-    int sockfd;              // UDP socket fd
+    int lanplus;             // 1 表示 open 時建立 RMCP+ session
+    int cipher_suite;        // 3 或 17（預設）
+    uint8_t privilege;       // 要求的 privilege level，預設 ADMIN
+    ipmi_session_t session;  // session.active 時所有封包都走 RMCP+
+    
+    ipmi_session_cache_t* session_cache;  // 非 NULL 時 open 先試著接續快取裡的 session
+    ipmi_session_key_t session_key;
+    int session_resumed;     // 這個 session 是從快取借來的
+    int session_stale;       // 用到一半逾時，close 時不要放回快取
+    
+    ipmi_addr_t addr;        // 解析過的位址，addrlen 為 0 表示還沒解析
+    int sockfd;              // UDP socket fd，open 時 connect() 到 addr
     uint8_t seq;             // Request sequence number
     
-    int timeout_ms;          // Timeout（毫秒）
-    int retries;             // 重試次數
+    int timeout_ms;          // 每個命令的總 timeout（毫秒，含重送）
+    int retries;             // 最多重送次數
+    int pipeline_depth;      // ipmi_send_recv_batch 同時在路上的 request 數
+    
+    ipmi_rtt_t rtt;          // 這台 BMC 的 RTT 估計，決定重送時機
+    unsigned long retransmits;  // 累計重送次數
+    uint8_t fru_chunk;       // Read FRU Data 試出來能用的大小，0 表示還沒試過
 } ipmi_ctx_t;
 
 // Context 操作
@@ -24,13 +44,49 @@ ipmi_ctx_t* ipmi_ctx_create(void);
 void ipmi_ctx_destroy(ipmi_ctx_t* ctx);
 
 int ipmi_ctx_set_target(ipmi_ctx_t* ctx, const char* host, uint16_t port);
+// 直接給已經解析好的位址（例如 ipmi_resolve_bulk 的結果），open 時就不用再查 DNS
+int ipmi_ctx_set_target_addr(ipmi_ctx_t* ctx, const char* host, const ipmi_addr_t* addr);
 int ipmi_ctx_set_timeout(ipmi_ctx_t* ctx, int timeout_ms);
+int ipmi_ctx_set_retries(ipmi_ctx_t* ctx, int retries);
+int ipmi_ctx_set_pipeline_depth(ipmi_ctx_t* ctx, int depth);
+int ipmi_ctx_set_auth(ipmi_ctx_t* ctx, const char* username, const char* password);
+// 改用 RMCP+（IPMI 2.0）；cipher_suite 為 0 時用 17，privilege 為 0 時用 ADMIN
+int ipmi_ctx_set_lanplus(ipmi_ctx_t* ctx, int cipher_suite, uint8_t privilege);
+// 跨 process 共用 session（lanplus 才有作用）；cache 由呼叫端擁有，要活得比 ctx 久
+int ipmi_ctx_set_session_cache(ipmi_ctx_t* ctx, ipmi_session_cache_t* cache);
+
+// 這台 BMC 專用的快取檔路徑：bmc_cache_path("<prefix>-<host>-<port>")
+int ipmi_ctx_cache_path(const ipmi_ctx_t* ctx, const char* prefix, char* buf, size_t len);
 
-// 連線管理
+/*
+ * 連線管理：lanplus 時 open 會做完整的 RMCP+ 握手，close 會送 Close Session
+ * 有 session cache 時 open 先接續快取裡的 session，close 把 session 放回快取而不關掉
+ */
 int ipmi_ctx_open(ipmi_ctx_t* ctx);
+/*
+ * 一次 open 很多台：所有 RMCP+ 握手同時進行（每台一個狀態，共用一個 poll 迴圈），
+ * 總時間取決於最慢的一台而不是加總；status[i] 是 ctxs[i] 的結果
+ * 回傳 BMC_SUCCESS，或配置失敗時的錯誤碼（這時沒有任何 ctx 被 open）
+ */
+int ipmi_ctx_open_bulk(ipmi_ctx_t* const* ctxs, size_t count, int* status);
 void ipmi_ctx_close(ipmi_ctx_t* ctx);
 
 // 收發封包
 int ipmi_send_recv(ipmi_ctx_t* ctx, const ipmi_msg_t* req, ipmi_msg_t* rsp);
 
+// 只送不等回應（例如 Close Session，BMC 沒收到也會自己 timeout）
+int ipmi_send_oneway(ipmi_ctx_t* ctx, const ipmi_msg_t* req);
+
+// Pipelined 收發：一次丟一批 request，用 rqSeq 對回應
+int ipmi_send_recv_batch(ipmi_ctx_t* ctx, const ipmi_msg_t* reqs, ipmi_msg_t* rsps,
+                         int* status, size_t count);
+
+/*
+ * 送一個已經建好的原始封包，等 payload type 為 rsp_type、message tag 為 tag 的回應
+ * （RMCP+ 握手用）；依 RTT 估計重送，rsp_len 回傳收到的長度
+ */
+int ipmi_ctx_exchange(ipmi_ctx_t* ctx, const uint8_t* req, size_t req_len,
+                      uint8_t rsp_type, uint8_t tag,
+                      uint8_t* rsp, size_t rsp_size, size_t* rsp_len);
+
 #endif
@@ -0,0 +1,98 @@
+#ifndef BMCTOOL_IPMI_DISCOVER_H
+#define BMCTOOL_IPMI_DISCOVER_H
+
+#include "bmctool/ipmi_engine.h"
+
+/*
+ * 子網路探測（RMCP / ASF Presence Ping）
+ *
+ * 一個 non-blocking socket 依設定的速率把 Presence Ping 用 sendmmsg 整批打到整個網段，
+ * 同一個迴圈裡用 recvmmsg 收 Presence Pong；最後一個 ping 送出後再等 timeout，
+ * 沒回的位址再補下一輪。不用一個 IP 一個 IP 地等 timeout。
+ * 有回應的 BMC 可以再交給 ipmi_engine 一起問 Get Channel Authentication Capabilities，
+ * 記下支援的 IPMI 版本和認證方式。只支援 IPv4，一次最大 /16。
+ */
+
+/* ASF（RMCP class 0x06） */
+#define ASF_IANA                    0x000011BE
+#define ASF_TYPE_PRESENCE_PONG      0x40
+#define ASF_TYPE_PRESENCE_PING      0x80
+#define ASF_ENTITY_IPMI             0x80    // supported entities bit 7：支援 IPMI
+
+#define IPMI_CMD_GET_CHANNEL_AUTH_CAP   0x38
+
+/* Authentication type support（Get Channel Authentication Capabilities byte 3） */
+#define IPMI_AUTH_CAP_NONE          0x01
+#define IPMI_AUTH_CAP_MD2           0x02
+#define IPMI_AUTH_CAP_MD5           0x04
+#define IPMI_AUTH_CAP_PASSWORD      0x10
+#define IPMI_AUTH_CAP_OEM           0x20
+
+/* Login status（byte 4 bits 2:0） */
+#define IPMI_LOGIN_ANONYMOUS        0x01
+#define IPMI_LOGIN_NULL_USER        0x02
+#define IPMI_LOGIN_NON_NULL_USER    0x04
+
+#define IPMI_DISCOVER_MIN_PREFIX    16
+#define IPMI_DISCOVER_DEFAULT_RATE  5000    // ping / 秒
+
+/* ipmi_discover_host_t.auth_status 除了錯誤碼以外的值 */
+#define IPMI_DISCOVER_NOT_PROBED    1
+#define IPMI_DISCOVER_PROBING_V15   2       // 內部用：BMC 不認 IPMI 2.0 的問法，改用 1.5 的再問一次
+
+// Get Channel Authentication Capabilities response
+typedef struct {
+    uint8_t channel;
+    uint8_t auth_types;          // IPMI_AUTH_CAP_*
+    uint8_t login;               // IPMI_LOGIN_*
+    int per_msg_auth_disabled;
+    int ipmi15;                  // 支援 IPMI 1.5 session
+    int ipmi20;                  // 支援 RMCP+
+    uint32_t oem_id;
+} ipmi_auth_caps_t;
+
+int ipmi_decode_auth_caps(const ipmi_rsp_view_t* rsp, ipmi_auth_caps_t* caps);
+
+// 一台有回 Presence Pong 的機器
+typedef struct {
+    uint32_t ipv4;               // host byte order
+    char host[16];               // 點分十進位
+    uint32_t rtt_us;
+    uint32_t iana;               // pong 裡的 IANA enterprise number
+    uint32_t oem;
+    uint8_t entities;            // supported entities（ASF_ENTITY_IPMI ...）
+    uint8_t interactions;
+    int auth_status;             // BMC_SUCCESS、錯誤碼或 IPMI_DISCOVER_NOT_PROBED
+    ipmi_auth_caps_t auth;
+} ipmi_discover_host_t;
+
+typedef struct {
+    ipmi_discover_host_t* hosts; // 依 IP 排序
+    size_t count;
+    uint32_t scanned;            // 掃了幾個位址（不含 network / broadcast）
+    unsigned long pings;         // 送出的 ping（含後面幾輪）
+    unsigned long invalid;       // 收到但不是範圍內的 Presence Pong
+} ipmi_discover_result_t;
+
+typedef struct {
+    uint16_t port;               // 0 表示 IPMI_DEFAULT_PORT
+    int rate_pps;                // 0 表示 IPMI_DISCOVER_DEFAULT_RATE
+    int timeout_ms;              // 每輪最後一個 ping 之後再等多久，0 表示 1000
+    int rounds;                  // 最多打幾輪（只打還沒回的），0 表示 2
+} ipmi_discover_opts_t;
+
+// "a.b.c.d/n" → 第一個位址（host byte order）和位址數；n 不能小於 IPMI_DISCOVER_MIN_PREFIX
+int ipmi_discover_parse_cidr(const char* cidr, uint32_t* first, uint32_t* count);
+
+int ipmi_discover_ping(const char* cidr, const ipmi_discover_opts_t* opts,
+                       ipmi_discover_result_t* result);
+
+/*
+ * 對 result 裡支援 IPMI 的每台問 Get Channel Authentication Capabilities
+ * eng 的 timeout / retries 由呼叫端設定；結果寫回 hosts[i].auth_status 和 auth
+ */
+int ipmi_discover_auth(ipmi_engine_t* eng, uint16_t port, ipmi_discover_result_t* result);
+
+void ipmi_discover_free(ipmi_discover_result_t* result);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef BMCTOOL_IPMI_ENGINE_H
+#define BMCTOOL_IPMI_ENGINE_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi.h"
+#include "bmctool/ipmi_rtt.h"
+#include "bmctool/ipmi_resolve.h"
+#include "bmctool/ipmi_session.h"
+
+/*
+ * 多 BMC 的事件驅動 IPMI 引擎
+ *
+ * 用少數幾個 non-blocking UDP socket + epoll 同時對上千台 BMC 發 request，
+ * 回應用「來源位址 + source_lun 裡的 6-bit sequence」對回原本的 request，
+ * 完成時呼叫使用者給的 callback。
+ *
+ * 收送預設走 epoll + sendmmsg / recvmmsg；用 IO_URING=1 編譯時可以改用 io_uring
+ * （ipmi_engine_set_io_backend），對外的行為和 callback 完全一樣。
+ */
+typedef struct ipmi_engine ipmi_engine_t;
+
+/*
+ * 完成 callback
+ * status 為 BMC_SUCCESS 時 rsp 有效；BMC_ERROR_TIMEOUT 等錯誤時 rsp 為 NULL
+ * rsp 直接指向接收 buffer，只在 callback 執行期間有效，要保存請用 ipmi_rsp_copy()
+ */
+typedef void (*ipmi_engine_cb)(ipmi_engine_t* eng, int target, int status,
+                               const ipmi_rsp_view_t* rsp, void* user_data);
+
+// 統計
+typedef struct {
+    unsigned long sent;          // 送出的封包（含重送）
+    unsigned long received;      // 對上 request 的回應
+    unsigned long retransmits;   // 重送次數
+    unsigned long timeouts;      // 重送用完仍逾時的 request
+    unsigned long stale;         // 丟掉的重複／過期回應
+    unsigned long syscalls;      // sendmmsg / recvmmsg（io_uring 時是 io_uring_enter）呼叫次數
+} ipmi_engine_stats_t;
+
+// Engine 操作
+ipmi_engine_t* ipmi_engine_create(int num_sockets);
+void ipmi_engine_destroy(ipmi_engine_t* eng);
+
+// timeout_ms 是每個 request 的總時限；期間依每台 BMC 的 RTT 估計最多重送 retries 次
+int ipmi_engine_set_timeout(ipmi_engine_t* eng, int timeout_ms);
+int ipmi_engine_set_retries(ipmi_engine_t* eng, int retries);
+int ipmi_engine_set_max_outstanding(ipmi_engine_t* eng, int max_outstanding);
+
+// 每台 BMC 同時在路上的 request 上限（1 ~ IPMI_SEQ_MAX_DEPTH，預設 1）
+int ipmi_engine_set_depth(ipmi_engine_t* eng, int depth);
+
+/* I/O backend */
+#define IPMI_ENGINE_IO_EPOLL    0       // epoll + sendmmsg / recvmmsg（預設）
+#define IPMI_ENGINE_IO_URING    1       // io_uring：multishot recvmsg + provided buffer ring
+
+/*
+ * 要在加 target 之前設；沒用 IO_URING=1 編譯或 kernel 不支援（要 6.0 以上）時回傳錯誤，
+ * engine 維持原本的 backend
+ */
+int ipmi_engine_set_io_backend(ipmi_engine_t* eng, int backend);
+const char* ipmi_engine_io_backend_name(int backend);
+
+// 一次 sendmmsg / recvmmsg 最多處理幾個封包（1 ~ 1024，預設 64；io_uring 不用）
+int ipmi_engine_set_batch_size(ipmi_engine_t* eng, int batch_size);
+
+// Target 管理：回傳 target index（>= 0），失敗回傳負的錯誤碼
+int ipmi_engine_add_target(ipmi_engine_t* eng, const char* host, uint16_t port);
+// 用已經解析好的位址加 target（配合 ipmi_resolve_bulk），host 只拿來顯示，可為 NULL
+int ipmi_engine_add_target_addr(ipmi_engine_t* eng, const char* host, const ipmi_addr_t* addr);
+/*
+ * 讓這個 target 的 request 走已經建好的 RMCP+ session（例如 ipmi_pool_acquire 拿到的）
+ * session 由呼叫端擁有，engine 只借用，要活得比 ipmi_engine_run 久；NULL 表示改回 IPMI 1.5
+ */
+int ipmi_engine_attach_session(ipmi_engine_t* eng, int target, ipmi_session_t* session);
+const char* ipmi_engine_target_host(const ipmi_engine_t* eng, int target);
+int ipmi_engine_num_targets(const ipmi_engine_t* eng);
+
+/*
+ * 排入一個 request，實際送出由 ipmi_engine_run() 負責
+ * target_addr 不是 BMC 的 request 包成 Send Message 轉送；BMC 的 ack 不算完成，
+ * callback 拿到的是 satellite 的回應（外層 completion code 不是 0 時是外層的回應）
+ */
+int ipmi_engine_submit(ipmi_engine_t* eng, int target, const ipmi_msg_t* req,
+                       ipmi_engine_cb cb, void* user_data);
+
+// 同上，payload 用 iovec 給，直接建進封包，不用先複製到 ipmi_msg_t
+int ipmi_engine_submitv(ipmi_engine_t* eng, int target, uint8_t netfn, uint8_t cmd,
+                        const struct iovec* iov, size_t iovcnt,
+                        ipmi_engine_cb cb, void* user_data);
+
+/*
+ * 跑事件迴圈直到所有 request 完成，或經過 timeout_ms（< 0 表示不限）
+ * 回傳還沒完成的 request 數，負數表示錯誤
+ */
+int ipmi_engine_run(ipmi_engine_t* eng, int timeout_ms);
+
+/*
+ * 嵌入呼叫端自己的事件迴圈（不呼叫 ipmi_engine_run）
+ *
+ * 把 ipmi_engine_get_fd() 加進自己的 epoll（EPOLLIN），fd 可讀或經過
+ * ipmi_engine_next_timeout() 毫秒就呼叫 ipmi_engine_dispatch()。submit 之後 next_timeout
+ * 會回傳 0，表示要先 dispatch 一次才會送出。callback 在 dispatch 裡面執行。
+ * fd 在設定 I/O backend 之後才固定，由 engine 擁有，不要自己讀或關掉。
+ * io_uring backend 時 epoll_wait 偶爾會被 kernel 的 task work 打斷（EINTR），照樣 dispatch 就好。
+ */
+int ipmi_engine_get_fd(const ipmi_engine_t* eng);
+// 多久之後要呼叫 dispatch（毫秒），-1 表示等 fd 就好
+int ipmi_engine_next_timeout(const ipmi_engine_t* eng);
+// 送出排隊的 request、處理已經到的回應和到期的重送 / 逾時，不會等待；回傳還沒完成的 request 數
+int ipmi_engine_dispatch(ipmi_engine_t* eng);
+
+size_t ipmi_engine_pending(const ipmi_engine_t* eng);
+void ipmi_engine_get_stats(const ipmi_engine_t* eng, ipmi_engine_stats_t* stats);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef BMCTOOL_IPMI_FRU_H
+#define BMCTOOL_IPMI_FRU_H
+
+#include "bmctool/ipmi_context.h"
+
+/*
+ * FRU inventory
+ *
+ * Read FRU Data 一次能讀多少每台 BMC 不一樣，很多工具保守地一次讀 16 bytes，
+ * 一個 FRU 就要幾十個來回。這裡先用大 chunk 讀，BMC 回 0xC7/0xC8/0xCA 就減半，
+ * 試出來能用的大小記在 ctx->fru_chunk，也存進快取檔給下次用；各段一起 pipeline 送出。
+ *
+ * 解析結果依 BMC 存一個快取檔，用 inventory 大小加上 8 bytes common header
+ * 算 fingerprint：header 沒變就直接用快取，只要兩個來回。
+ * （area 長度不變但內容改了的情況偵測不到，要強制重讀用 ipmi_fru_load 的 refresh。）
+ */
+
+/* Storage 命令（NetFn 0x0A） */
+#define IPMI_CMD_GET_FRU_INVENTORY_INFO 0x10
+#define IPMI_CMD_READ_FRU_DATA          0x11
+
+#define IPMI_FRU_HEADER_LEN     8
+#define IPMI_FRU_FIELD_MAX      64
+
+typedef struct {
+    uint8_t fru_id;
+    uint16_t size;               // inventory area 大小（bytes）
+    int from_cache;              // 1 表示這次沒有重新讀
+    
+    int has_chassis;
+    uint8_t chassis_type;
+    char chassis_part[IPMI_FRU_FIELD_MAX + 1];
+    char chassis_serial[IPMI_FRU_FIELD_MAX + 1];
+    
+    int has_board;
+    uint32_t board_mfg_time;     // 1996-01-01 00:00 起算的分鐘數，0 表示沒填
+    char board_mfg[IPMI_FRU_FIELD_MAX + 1];
+    char board_product[IPMI_FRU_FIELD_MAX + 1];
+    char board_serial[IPMI_FRU_FIELD_MAX + 1];
+    char board_part[IPMI_FRU_FIELD_MAX + 1];
+    
+    int has_product;
+    char product_mfg[IPMI_FRU_FIELD_MAX + 1];
+    char product_name[IPMI_FRU_FIELD_MAX + 1];
+    char product_part[IPMI_FRU_FIELD_MAX + 1];
+    char product_version[IPMI_FRU_FIELD_MAX + 1];
+    char product_serial[IPMI_FRU_FIELD_MAX + 1];
+    char product_asset[IPMI_FRU_FIELD_MAX + 1];
+} ipmi_fru_t;
+
+// Get FRU Inventory Area Info；word_access 為 1 表示 offset/count 以 word 為單位
+int ipmi_fru_get_info(ipmi_ctx_t* ctx, uint8_t fru_id, uint16_t* size, int* word_access);
+
+// 讀 [offset, offset + len)，chunk 大小自動協商
+int ipmi_fru_read(ipmi_ctx_t* ctx, uint8_t fru_id, uint16_t offset, uint16_t len,
+                  int word_access, uint8_t* buf);
+
+// 解析 chassis / board / product area；data 從 common header 開始
+int ipmi_fru_parse(const uint8_t* data, size_t len, ipmi_fru_t* fru);
+
+/*
+ * 讀一個 FRU，fingerprint 對得上就用快取；refresh 為 1 時一律重讀
+ * cache_path 為 NULL 時用 ipmi_ctx_cache_path("fru")；快取讀寫失敗不算錯
+ */
+int ipmi_fru_load(ipmi_ctx_t* ctx, uint8_t fru_id, const char* cache_path, int refresh,
+                  ipmi_fru_t* fru);
+
+// 顯示用：SMBIOS chassis type 名稱
+const char* ipmi_fru_chassis_type_name(uint8_t type);
+
+#endif
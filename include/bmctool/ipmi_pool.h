@@ -0,0 +1,59 @@
+#ifndef BMCTOOL_IPMI_POOL_H
+#define BMCTOOL_IPMI_POOL_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi_context.h"
+
+/*
+ * RMCP+ session pool
+ *
+ * 握手要 4 個來回加一個 Set Session Privilege，比大部分命令本身還貴。
+ * Pool 保留建好的 session，命令之間重複使用；key 和 session 快取一樣是 host、port、
+ * 帳號、密碼、cipher suite 和 privilege 的 SHA-256，密碼不對就借不到別人的 session。
+ * 閒置太久的 session 先用 Get Device ID 確認還活著，BMC 那邊 timeout 掉的就重建。
+ */
+typedef struct ipmi_pool ipmi_pool_t;
+
+// keepalive_ms：閒置超過這麼久就要 ping 一次（<= 0 用預設 30 秒，要比 BMC 的 session timeout 短）
+ipmi_pool_t* ipmi_pool_create(int keepalive_ms);
+// 關掉所有 session（送 Close Session），借出去的 ctx 也一起失效
+void ipmi_pool_destroy(ipmi_pool_t* pool);
+
+// 之後新建的 session 用的設定
+int ipmi_pool_set_lanplus(ipmi_pool_t* pool, int cipher_suite, uint8_t privilege);
+int ipmi_pool_set_timeout(ipmi_pool_t* pool, int timeout_ms);
+int ipmi_pool_set_retries(ipmi_pool_t* pool, int retries);
+// 新建 session 前先查跨 process 的快取，pool 關掉時 session 放回快取（cache 由呼叫端擁有）
+int ipmi_pool_set_session_cache(ipmi_pool_t* pool, ipmi_session_cache_t* cache);
+
+/*
+ * 借一個已經登入的 ctx：有閒置的同 key session 就直接給，沒有就新建
+ * 失敗回傳 NULL，err 帶錯誤碼（可為 NULL）；用完要 release
+ */
+ipmi_ctx_t* ipmi_pool_acquire(ipmi_pool_t* pool, const char* host, uint16_t port,
+                              const char* username, const char* password, int* err);
+// 同上，用已經解析好的位址（配合 ipmi_resolve_bulk）
+ipmi_ctx_t* ipmi_pool_acquire_addr(ipmi_pool_t* pool, const char* host, const ipmi_addr_t* addr,
+                                   const char* username, const char* password, int* err);
+/*
+ * 一次借很多台（addrs 是 ipmi_resolve_bulk 的結果）：沒有閒置 session 的一起握手，
+ * 不是一台等完才換下一台。ctxs[i] 是借到的 ctx，NULL 時 errs[i] 是原因
+ * 回傳 BMC_SUCCESS，或配置失敗時的錯誤碼
+ */
+int ipmi_pool_acquire_bulk(ipmi_pool_t* pool, const char* const* hosts, const ipmi_addr_t* addrs,
+                           size_t count, const char* username, const char* password,
+                           ipmi_ctx_t** ctxs, int* errs);
+
+// 還回 pool 等下次使用；命令失敗懷疑 session 壞了就用 discard，直接關掉
+void ipmi_pool_release(ipmi_pool_t* pool, ipmi_ctx_t* ctx);
+void ipmi_pool_discard(ipmi_pool_t* pool, ipmi_ctx_t* ctx);
+
+/*
+ * 對閒置超過 keepalive 的 session 送 Get Device ID，沒回應的關掉移出 pool
+ * 長時間執行的程式要定期呼叫；回傳這次移除的 session 數
+ */
+int ipmi_pool_keepalive(ipmi_pool_t* pool);
+
+size_t ipmi_pool_size(const ipmi_pool_t* pool);
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef BMCTOOL_IPMI_POWER_H
+#define BMCTOOL_IPMI_POWER_H
+
+#include "bmctool/ipmi_context.h"
+#include "bmctool/ipmi_engine.h"
+#include <stdio.h>
+#include <signal.h>
+
+/*
+ * DCMI 功耗讀取和定時取樣
+ *
+ * 單次讀取走 ipmi_send_recv；取樣器則把 Get Power Reading 交給 ipmi_engine，
+ * 每個 tick 對所有 BMC 各送一個，等回應的同時等下一個 tick。
+ * 樣本帶 monotonic 時間戳，寫進建立時就配好的 ring buffer，累積到一半才整批寫出，
+ * 取樣迴圈裡不配置記憶體、也不會每筆做一次 I/O。
+ * tick 實際開始時間和排定時間的差（jitter）另外統計。
+ */
+
+/* DCMI（NetFn 0x2C group extension，group ID 0xDC） */
+#define IPMI_NETFN_DCGRP                0x2C
+#define IPMI_DCMI_GROUP_ID              0xDC
+#define IPMI_CMD_DCMI_GET_POWER_READING 0x02
+
+#define IPMI_DCMI_POWER_MODE_SYSTEM     0x01    // system power statistics
+
+// Get Power Reading response
+typedef struct {
+    uint16_t current_watts;
+    uint16_t min_watts;
+    uint16_t max_watts;
+    uint16_t avg_watts;
+    uint32_t timestamp;          // BMC 的時間（秒）
+    uint32_t period_ms;          // 統計期間
+    int active;                  // 0 表示 BMC 沒在量，數值不可信
+} ipmi_dcmi_power_t;
+
+int ipmi_dcmi_get_power_reading(ipmi_ctx_t* ctx, ipmi_dcmi_power_t* power);
+int ipmi_decode_dcmi_power_reading(const ipmi_rsp_view_t* rsp, ipmi_dcmi_power_t* power);
+
+/* 樣本狀態 */
+enum {
+    IPMI_POWER_SAMPLE_OK = 0,
+    IPMI_POWER_SAMPLE_INACTIVE,  // BMC 回了，但 power measurement 沒開
+    IPMI_POWER_SAMPLE_ERROR      // 逾時或 completion code 不是 0
+};
+
+// 一筆樣本，24 bytes；binary 輸出就是這個 struct 原樣寫出（本機 byte order）
+typedef struct {
+    uint64_t t_us;               // 收到回應的 monotonic 時間，從取樣開始算
+    uint32_t tick;               // 第幾個 tick（從 0 開始）
+    uint32_t latency_us;         // 送出到收到
+    uint16_t target;             // engine target index
+    uint16_t watts;              // current power，status 不是 OK 時為 0
+    uint8_t status;              // IPMI_POWER_SAMPLE_*
+    uint8_t cc;                  // completion code，逾時等錯誤時為 0
+    uint16_t reserved;
+} ipmi_power_sample_t;
+
+/* 輸出格式 */
+enum {
+    IPMI_POWER_OUTPUT_CSV = 0,
+    IPMI_POWER_OUTPUT_BINARY
+};
+
+// 固定大小的 ring buffer；滿了就蓋掉最舊的並記在 dropped
+typedef struct {
+    ipmi_power_sample_t* samples;
+    size_t capacity;
+    size_t head;                 // 最舊一筆的位置
+    size_t count;
+    unsigned long dropped;
+} ipmi_power_ring_t;
+
+int ipmi_power_ring_init(ipmi_power_ring_t* ring, size_t capacity);
+void ipmi_power_ring_free(ipmi_power_ring_t* ring);
+
+// 拿一格來寫（一定成功）
+ipmi_power_sample_t* ipmi_power_ring_push(ipmi_power_ring_t* ring);
+
+/*
+ * 把目前的樣本整批寫到 fp 並清空；CSV 的 host 欄位用 eng 查，eng 為 NULL 時寫 target index
+ * 回傳寫出的筆數，負數表示寫檔失敗
+ */
+long ipmi_power_ring_flush(ipmi_power_ring_t* ring, FILE* fp, int format,
+                           const ipmi_engine_t* eng);
+
+// 取樣統計（時間單位都是 microsecond）
+typedef struct {
+    unsigned long ticks;
+    unsigned long samples;       // 收到的樣本（含 INACTIVE / ERROR）
+    unsigned long errors;
+    unsigned long overruns;      // tick 到了上一個 request 還沒回來，這台這次跳過
+    unsigned long missed_ticks;  // 整個 tick 都錯過了（例如行程被暫停）
+    unsigned long dropped;       // ring 滿了被蓋掉的樣本
+    double jitter_mean_us;       // tick 實際開始 - 排定時間
+    double jitter_stddev_us;
+    double jitter_max_us;
+    double latency_mean_us;
+    double latency_max_us;
+} ipmi_power_stats_t;
+
+typedef struct ipmi_power_sampler ipmi_power_sampler_t;
+
+/*
+ * eng 裡的 target 要先加好（lanplus 的 session 也要先 attach）
+ * ring_capacity 為 0 時依 target 數決定
+ */
+ipmi_power_sampler_t* ipmi_power_sampler_create(ipmi_engine_t* eng, int interval_ms,
+                                                size_t ring_capacity);
+void ipmi_power_sampler_destroy(ipmi_power_sampler_t* sampler);
+
+// 預設寫到 stdout、CSV
+int ipmi_power_sampler_set_output(ipmi_power_sampler_t* sampler, FILE* fp, int format);
+
+// 不對這台取樣（例如登入失敗）
+int ipmi_power_sampler_disable_target(ipmi_power_sampler_t* sampler, int target);
+
+/*
+ * 跑 ticks 個 tick（0 表示不限），stop 不是 NULL 且變成非 0 時提早結束；
+ * 最後會等還在路上的 request 回來並把 ring 全部寫出。
+ * 寫檔失敗會提早結束，呼叫端用 ferror() 檢查輸出檔
+ */
+int ipmi_power_sampler_run(ipmi_power_sampler_t* sampler, unsigned long ticks,
+                           const volatile sig_atomic_t* stop);
+
+void ipmi_power_sampler_get_stats(const ipmi_power_sampler_t* sampler, ipmi_power_stats_t* stats);
+
+#endif
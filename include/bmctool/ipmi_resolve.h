@@ -0,0 +1,37 @@
+#ifndef BMCTOOL_IPMI_RESOLVE_H
+#define BMCTOOL_IPMI_RESOLVE_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi.h"
+#include <sys/socket.h>
+
+/*
+ * 位址解析
+ *
+ * 在建立連線時用 getaddrinfo 解析一次（thread-safe、支援 IPv6），
+ * 之後每個封包都直接用快取的結果，不再查 DNS。
+ */
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t addrlen;           // 0 表示還沒解析
+    int status;                  // BMC_SUCCESS 或錯誤碼（bulk 解析時逐台填）
+} ipmi_addr_t;
+
+int ipmi_resolve(const char* host, uint16_t port, ipmi_addr_t* out);
+
+/*
+ * 一次解析整份 host 清單
+ *
+ * IP literal 直接轉換，hostname 用 getaddrinfo_a 同時查，
+ * 總時間大約是最慢的那筆 DNS 查詢，而不是全部加總。
+ * ports 可以是 NULL（全部用 IPMI_DEFAULT_PORT）。
+ *
+ * @return 成功解析的數量；個別結果看 out[i].status
+ */
+int ipmi_resolve_bulk(const char* const* hosts, const uint16_t* ports,
+                      size_t count, ipmi_addr_t* out);
+
+// 轉成 "ip:port" 字串（log 用）
+const char* ipmi_addr_str(const ipmi_addr_t* addr, char* buf, size_t len);
+
+#endif
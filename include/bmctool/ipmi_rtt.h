@@ -0,0 +1,31 @@
+#ifndef BMCTOOL_IPMI_RTT_H
+#define BMCTOOL_IPMI_RTT_H
+
+#include <stdint.h>
+
+/*
+ * 每台 BMC 的 RTT 估計與 retransmit timeout（RFC 6298 的算法）
+ *
+ * SRTT/RTTVAR 用 Jacobson/Karels 的方式更新，RTO = SRTT + 4 * RTTVAR。
+ * Karn's algorithm：重送過的 request 不取樣（分不出回應對的是哪一次），
+ * 而且 backoff 要保留到下一個乾淨的樣本出現為止。
+ */
+#define IPMI_RTO_INITIAL_US     1000000   // 還沒有樣本時用 1 秒
+#define IPMI_RTO_MIN_US         50000     // BMC 通常 20 ms 內回，留點餘裕
+#define IPMI_RTO_MAX_US         4000000   // Backoff 上限
+
+typedef struct {
+    uint32_t srtt_us;        // Smoothed RTT
+    uint32_t rttvar_us;      // RTT variance
+    uint32_t rto_us;         // 目前的 retransmit timeout（不含 backoff）
+    uint8_t backoff;         // 連續逾時次數，RTO 每次加倍
+    uint8_t has_sample;
+    uint64_t backoff_at_us;  // 上次 backoff 的時間
+} ipmi_rtt_t;
+
+void ipmi_rtt_init(ipmi_rtt_t* rtt);
+void ipmi_rtt_sample(ipmi_rtt_t* rtt, uint32_t rtt_us);
+void ipmi_rtt_timeout(ipmi_rtt_t* rtt, uint64_t sent_us, uint64_t now_us);
+uint32_t ipmi_rtt_rto(const ipmi_rtt_t* rtt);
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef BMCTOOL_IPMI_SDR_H
+#define BMCTOOL_IPMI_SDR_H
+
+#include "bmctool/ipmi_context.h"
+
+/*
+ * SDR（Sensor Data Record）repository
+ *
+ * Sensor 名稱、單位和換算係數都在 SDR 裡。整個 repository 要用 Get SDR
+ * 一小塊一小塊讀，在慢的 BMC 上要幾十秒，但內容幾乎不會變，
+ * 所以解析好的 record 存成本機快取，用 Get SDR Repository Info 的
+ * 新增／清除時間戳判斷要不要重新下載。
+ */
+
+/* Storage 命令（NetFn 0x0A） */
+#define IPMI_CMD_GET_SDR_REPO_INFO  0x20
+#define IPMI_CMD_RESERVE_SDR_REPO   0x22
+#define IPMI_CMD_GET_SDR            0x23
+
+/* Record type */
+#define IPMI_SDR_TYPE_FULL_SENSOR       0x01
+#define IPMI_SDR_TYPE_COMPACT_SENSOR    0x02
+#define IPMI_SDR_TYPE_EVENT_ONLY        0x03
+#define IPMI_SDR_TYPE_FRU_LOCATOR       0x11
+#define IPMI_SDR_TYPE_MC_LOCATOR        0x12
+
+#define IPMI_SDR_NAME_MAX       16
+#define IPMI_SDR_HEADER_LEN     5
+
+/* Threshold index（threshold[] 和 readable mask 的 bit 順序） */
+enum {
+    IPMI_SDR_LNC = 0,
+    IPMI_SDR_LCR,
+    IPMI_SDR_LNR,
+    IPMI_SDR_UNC,
+    IPMI_SDR_UCR,
+    IPMI_SDR_UNR,
+    IPMI_SDR_THRESHOLDS
+};
+
+// Get SDR Repository Info
+typedef struct {
+    uint8_t version;
+    uint16_t record_count;
+    uint32_t add_timestamp;      // 最後一次新增 record 的時間
+    uint32_t erase_timestamp;    // 最後一次清除的時間
+    uint8_t support;             // operation support flags
+} ipmi_sdr_info_t;
+
+/*
+ * 解析過的 record，固定大小，直接當快取檔的格式
+ * 沒用到的欄位為 0；FRU locator 的 FRU device ID 放在 sensor_number
+ */
+typedef struct {
+    uint16_t record_id;
+    uint8_t type;
+    uint8_t owner_id;            // sensor owner（FRU/MC locator 是 device slave address）
+    uint8_t owner_lun;
+    uint8_t owner_channel;       // owner 不是 BMC 時要經過哪個 channel 橋接
+    uint8_t sensor_number;
+    uint8_t entity_id;
+    uint8_t entity_instance;
+    uint8_t sensor_type;
+    uint8_t event_type;          // event/reading type，0x01 是 threshold sensor
+    
+    /* 單位 */
+    uint8_t units1;              // [7:6] analog 格式、[2:1] modifier 方式、[0] 百分比
+    uint8_t base_unit;
+    uint8_t modifier_unit;
+    
+    /* 換算：y = L((M * x + B * 10^Bexp) * 10^Rexp)，只有 full sensor record 有 */
+    uint8_t linearization;
+    int16_t m;
+    int16_t b;
+    int8_t b_exp;
+    int8_t r_exp;
+    
+    uint8_t threshold_readable;  // bit i 對應 threshold[i]
+    uint8_t threshold[IPMI_SDR_THRESHOLDS];
+    
+    char name[IPMI_SDR_NAME_MAX + 1];
+} ipmi_sdr_record_t;
+
+typedef struct {
+    ipmi_sdr_record_t* records;
+    size_t count;
+    ipmi_sdr_info_t info;        // 下載時的 repository info
+    int from_cache;              // 1 表示這次沒有重新下載
+} ipmi_sdr_repo_t;
+
+int ipmi_sdr_get_info(ipmi_ctx_t* ctx, ipmi_sdr_info_t* info);
+
+// 解析一筆原始 record（含 5 bytes header）；不認得的 type 回傳 BMC_ERROR_PROTOCOL
+int ipmi_sdr_parse(const uint8_t* raw, size_t len, ipmi_sdr_record_t* rec);
+
+// 從 BMC 下載整個 repository（不看快取）
+int ipmi_sdr_download(ipmi_ctx_t* ctx, ipmi_sdr_repo_t* repo);
+
+/*
+ * 先看快取：時間戳和 record 數都沒變就直接用，不然重新下載再寫回快取
+ * cache_path 為 NULL 時用 bmc_cache_path() 依 host/port 決定；快取讀寫失敗不算錯
+ */
+int ipmi_sdr_load(ipmi_ctx_t* ctx, const char* cache_path, ipmi_sdr_repo_t* repo);
+
+void ipmi_sdr_free(ipmi_sdr_repo_t* repo);
+
+// 依 sensor owner + number 找 record，找不到回傳 NULL
+const ipmi_sdr_record_t* ipmi_sdr_find(const ipmi_sdr_repo_t* repo, uint8_t owner_id,
+                                       uint8_t sensor_number);
+
+// 顯示用字串
+const char* ipmi_sdr_unit_name(uint8_t unit);
+const char* ipmi_sdr_sensor_type_name(uint8_t type);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef BMCTOOL_IPMI_SEL_H
+#define BMCTOOL_IPMI_SEL_H
+
+#include "bmctool/ipmi_context.h"
+
+/*
+ * SEL（System Event Log）增量讀取
+ *
+ * Get SEL Entry 一次只能拿一筆，下一筆的 ID 要等這筆回來才知道，
+ * 所以整個 SEL 讀一遍是「筆數 × RTT」。每台 BMC 在本機留一個 cursor，
+ * 記住讀到哪一筆和當時的新增／清除時間戳：新增時間戳沒變就一筆都不用讀，
+ * 變了就從上次最後一筆的下一筆接著讀；SEL 被清掉或繞回（最後一筆不見了、
+ * 內容變了）就從頭開始。
+ */
+
+/* Storage 命令（NetFn 0x0A），Get SEL Info 在 ipmi.h */
+#define IPMI_CMD_RESERVE_SEL        0x42
+#define IPMI_CMD_GET_SEL_ENTRY      0x43
+
+#define IPMI_SEL_ENTRY_LEN          16
+
+/* Record type */
+#define IPMI_SEL_TYPE_SYSTEM_EVENT  0x02
+#define IPMI_SEL_TYPE_OEM_TS_FIRST  0xC0    // 0xC0~0xDF：有時間戳的 OEM record
+#define IPMI_SEL_TYPE_OEM_TS_LAST   0xDF
+
+// Get SEL Info
+typedef struct {
+    uint8_t version;
+    uint16_t entries;
+    uint16_t free_bytes;
+    uint32_t add_timestamp;
+    uint32_t erase_timestamp;
+    uint8_t support;             // operation support（bit 7：overflow）
+} ipmi_sel_info_t;
+
+// 解碼過的一筆 SEL；OEM record 只有 record_id、type、timestamp 和 raw
+typedef struct {
+    uint16_t record_id;
+    uint8_t type;
+    uint32_t timestamp;          // 0 表示這種 record 沒有時間戳
+    uint16_t generator_id;
+    uint8_t evm_rev;
+    uint8_t sensor_type;
+    uint8_t sensor_number;
+    uint8_t event_type;          // event/reading type code
+    uint8_t deassertion;         // 1 表示 deassertion event
+    uint8_t event_data[3];
+    uint8_t raw[IPMI_SEL_ENTRY_LEN];
+} ipmi_sel_entry_t;
+
+// 讀到哪裡了；valid 為 0 表示從頭讀
+typedef struct {
+    int valid;
+    uint16_t last_record_id;
+    uint32_t add_timestamp;
+    uint32_t erase_timestamp;
+    uint8_t last_raw[IPMI_SEL_ENTRY_LEN];  // 用來發現同一個 ID 被別的 record 重用
+} ipmi_sel_cursor_t;
+
+// 每解出一筆就呼叫一次；回傳非 0 就停下來（cursor 停在這一筆）
+typedef int (*ipmi_sel_cb_t)(const ipmi_sel_entry_t* entry, void* arg);
+
+int ipmi_sel_get_info(ipmi_ctx_t* ctx, ipmi_sel_info_t* info);
+int ipmi_sel_parse(const uint8_t* raw, size_t len, ipmi_sel_entry_t* entry);
+
+/*
+ * 從 cursor 之後讀新的 record，一筆一筆交給 cb，cursor 跟著往前
+ * 中途失敗時 cursor 停在最後一筆成功交出去的 record
+ */
+int ipmi_sel_read_new(ipmi_ctx_t* ctx, ipmi_sel_cursor_t* cursor, ipmi_sel_cb_t cb, void* arg);
+
+// Cursor 檔讀寫；檔案不存在或格式不對時 load 回傳 valid = 0 的 cursor
+void ipmi_sel_cursor_load(const char* path, ipmi_sel_cursor_t* cursor);
+int ipmi_sel_cursor_save(const char* path, const ipmi_sel_cursor_t* cursor);
+
+/*
+ * load + read_new + save；cursor_path 為 NULL 時用 ipmi_ctx_cache_path("sel")
+ * from_start 為 1 時不看舊的 cursor，整個 SEL 重讀一遍
+ */
+int ipmi_sel_stream(ipmi_ctx_t* ctx, const char* cursor_path, int from_start,
+                    ipmi_sel_cb_t cb, void* arg);
+
+// 顯示用：threshold event 的 offset 說明，其他 event type 回傳 NULL
+const char* ipmi_sel_threshold_event_name(uint8_t offset);
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef BMCTOOL_IPMI_SENSOR_H
+#define BMCTOOL_IPMI_SENSOR_H
+
+#include "bmctool/ipmi_sdr.h"
+
+/*
+ * Sensor 讀取
+ *
+ * 每個 sensor 一個 Get Sensor Reading，整批用 ipmi_send_recv_batch 送出，
+ * 並行度由 ctx 的 pipeline depth 決定；owner 是 ME 這類 satellite controller 的
+ * sensor 包成 Send Message 橋接，和 BMC 自己的 sensor 一起送。request、response 和結果陣列在
+ * ipmi_sensor_set_init 時一次配好，之後每次輪詢都重複使用，不再配置記憶體。
+ */
+
+/* 讀值狀態 */
+enum {
+    IPMI_SENSOR_OK = 0,
+    IPMI_SENSOR_UNAVAILABLE,     // BMC 說讀值不可用、scanning 關掉或 sensor 不存在
+    IPMI_SENSOR_ERROR            // 逾時或其他 completion code
+};
+
+/* Threshold 嚴重程度（取最嚴重的那個） */
+enum {
+    IPMI_SENSOR_SEVERITY_OK = 0,
+    IPMI_SENSOR_SEVERITY_NC,     // non-critical
+    IPMI_SENSOR_SEVERITY_CR,     // critical
+    IPMI_SENSOR_SEVERITY_NR      // non-recoverable
+};
+
+// 一個 sensor 的讀值，16 bytes，輪詢時從頭掃到尾
+typedef struct {
+    double value;                // 換算後的值，只有 analog 為 1 時有意義
+    uint16_t sdr_index;          // 對應 repo->records 的 index
+    uint8_t raw;                 // 原始讀值
+    uint8_t status;              // IPMI_SENSOR_OK ...
+    uint8_t analog;              // 1 表示是 threshold sensor，value 可用
+    uint8_t severity;            // IPMI_SENSOR_SEVERITY_*
+    uint16_t state;              // threshold sensor：超過的 threshold（bit 順序同 IPMI_SDR_LNC...）
+                                 // discrete sensor：state bits
+} ipmi_sensor_reading_t;
+
+// 預先算好的換算係數：y = L(m * x + b)
+typedef struct {
+    double m;                    // M * 10^Rexp
+    double b;                    // B * 10^(Bexp + Rexp)
+    uint8_t format;              // units1[7:6]：0 unsigned、1 一補數、2 二補數
+    uint8_t linearization;
+} ipmi_sensor_conv_t;
+
+typedef struct {
+    ipmi_sensor_reading_t* readings;    // count 筆，依 SDR 順序
+    size_t count;
+    const ipmi_sdr_repo_t* repo;        // 要活得比 set 久
+    
+    /* 以下內部用，和 readings 一一對應 */
+    ipmi_sensor_conv_t* conv;
+    ipmi_msg_t* reqs;
+    ipmi_msg_t* rsps;
+    int* status;
+} ipmi_sensor_set_t;
+
+/*
+ * 挑出 repo 裡可以讀的 sensor（full / compact record、owner 是 BMC 或 IPMB 上的 controller），
+ * 配好所有陣列、建好 request
+ */
+int ipmi_sensor_set_init(ipmi_sensor_set_t* set, const ipmi_sdr_repo_t* repo);
+void ipmi_sensor_set_free(ipmi_sensor_set_t* set);
+
+/*
+ * 讀一輪所有 sensor；個別 sensor 讀不到只會反映在 status，
+ * 回傳錯誤表示整批失敗（例如 socket 壞了）
+ */
+int ipmi_sensor_read_all(ipmi_ctx_t* ctx, ipmi_sensor_set_t* set);
+
+// 依 SDR 的 M/B/Bexp/Rexp 和 linearization 把原始讀值換成工程單位
+double ipmi_sensor_convert(const ipmi_sdr_record_t* rec, uint8_t raw);
+
+const char* ipmi_sensor_severity_name(uint8_t severity);
+
+#endif
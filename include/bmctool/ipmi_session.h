@@ -0,0 +1,137 @@
+#ifndef BMCTOOL_IPMI_SESSION_H
+#define BMCTOOL_IPMI_SESSION_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi.h"
+
+/*
+ * RMCP+（IPMI 2.0）session
+ *
+ * Open Session + RAKP 1~4 交換出 SIK，再導出 K1（integrity）和 K2（confidentiality）。
+ * Session 建好之後每個封包都用 K1 做 HMAC、用 K2 做 AES-CBC-128 加密。
+ */
+
+#define IPMI_AUTH_TYPE_RMCPP        0x06
+
+/* RMCP+ payload type（bit 7 = 加密，bit 6 = 有 integrity） */
+#define IPMI_PAYLOAD_IPMI           0x00
+#define IPMI_PAYLOAD_SOL            0x01
+#define IPMI_PAYLOAD_OPEN_SESSION_REQ   0x10
+#define IPMI_PAYLOAD_OPEN_SESSION_RSP   0x11
+#define IPMI_PAYLOAD_RAKP1          0x12
+#define IPMI_PAYLOAD_RAKP2          0x13
+#define IPMI_PAYLOAD_RAKP3          0x14
+#define IPMI_PAYLOAD_RAKP4          0x15
+#define IPMI_PAYLOAD_ENCRYPTED      0x80
+#define IPMI_PAYLOAD_AUTHENTICATED  0x40
+
+/* 演算法編號 */
+#define IPMI_AUTH_RAKP_HMAC_SHA1    0x01
+#define IPMI_AUTH_RAKP_HMAC_SHA256  0x03
+#define IPMI_INTEG_HMAC_SHA1_96     0x01
+#define IPMI_INTEG_HMAC_SHA256_128  0x04
+#define IPMI_CRYPT_AES_CBC_128      0x01
+
+/* Privilege level */
+#define IPMI_PRIV_CALLBACK          0x01
+#define IPMI_PRIV_USER              0x02
+#define IPMI_PRIV_OPERATOR          0x03
+#define IPMI_PRIV_ADMIN             0x04
+
+/* Session 相關命令（NetFn App） */
+#define IPMI_CMD_SET_SESSION_PRIV   0x3B
+#define IPMI_CMD_CLOSE_SESSION      0x3C
+
+#define IPMI_SESSION_KEY_MAX        32      // SHA-256
+#define IPMI_SESSION_CONST_LEN      20      // K1 / K2 的 Const1 / Const2，不管哪種 hash 都是 20 bytes
+#define IPMI_SESSION_SEQ_WINDOW     32
+#define IPMI_SESSION_PASSWORD_LEN   20      // K_UID 固定 20 bytes，不足補 0
+#define IPMI_SESSION_USERNAME_MAX   16
+#define IPMI_LANPLUS_MAX_LEN        400     // 加密後最大封包
+
+typedef struct {
+    int active;
+    uint8_t cipher_suite;    // 3 = SHA1 / SHA1-96 / AES，17 = SHA256 / SHA256-128 / AES
+    uint8_t auth_alg;
+    uint8_t integ_alg;
+    uint8_t crypt_alg;
+    uint8_t privilege;       // 要求的 privilege level
+    
+    uint32_t console_id;     // 我們這端的 session ID（SIDm）
+    uint32_t bmc_id;         // BMC 給的 session ID（SIDc）
+    uint32_t out_seq;        // 下一個送出的 session sequence number
+    uint32_t in_seq;         // 收過最大的 session sequence number
+    uint32_t in_window;      // bit n：in_seq - n 收過了（防 replay，規格的 32 格 window）
+    
+    uint8_t sik[IPMI_SESSION_KEY_MAX];
+    uint8_t k1[IPMI_SESSION_KEY_MAX];
+    uint8_t k2[IPMI_SESSION_KEY_MAX];
+    uint8_t key_len;         // 20 (SHA1) 或 32 (SHA256)
+    uint8_t icv_len;         // integrity 檢查碼長度：12 或 16
+    
+    uint64_t last_used_us;   // 最後一次收到 BMC 回應的時間（keepalive 用）
+} ipmi_session_t;
+
+/*
+ * 握手過程中的暫存狀態
+ * 由 build/parse 系列函式依序填寫；RAKP2 驗證通過時順便導出 SIK、K1、K2
+ */
+typedef struct {
+    uint8_t tag;
+    uint8_t rm[16];          // 我們的亂數
+    uint8_t rc[16];          // BMC 的亂數
+    uint8_t guid[16];        // BMC GUID
+    uint8_t role;            // RAKP1 裡送的 privilege byte
+    char username[IPMI_SESSION_USERNAME_MAX + 1];
+    uint8_t kuid[IPMI_SESSION_PASSWORD_LEN];
+} ipmi_handshake_t;
+
+// 依 cipher suite 設定演算法，目前支援 3 和 17
+int ipmi_session_init(ipmi_session_t* s, int cipher_suite, uint8_t privilege);
+
+// 準備握手狀態（帳號最長 16、密碼最長 20 字元）；用完要 clear，把密碼和亂數清掉
+int ipmi_handshake_init(ipmi_handshake_t* hs, const char* username, const char* password);
+void ipmi_handshake_clear(ipmi_handshake_t* hs);
+
+// 清掉 session 金鑰
+void ipmi_session_clear(ipmi_session_t* s);
+
+/* 握手訊息：build 產生完整封包，parse 驗證 BMC 的回應 */
+int ipmi_session_build_open(ipmi_session_t* s, ipmi_handshake_t* hs,
+                            uint8_t* buf, size_t* len);
+int ipmi_session_parse_open(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                            const uint8_t* buf, size_t len);
+int ipmi_session_build_rakp1(ipmi_session_t* s, ipmi_handshake_t* hs,
+                             uint8_t* buf, size_t* len);
+int ipmi_session_parse_rakp2(ipmi_session_t* s, ipmi_handshake_t* hs,
+                             const uint8_t* buf, size_t len);
+int ipmi_session_build_rakp3(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                             uint8_t* buf, size_t* len);
+int ipmi_session_parse_rakp4(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                             const uint8_t* buf, size_t len);
+
+// 回傳封包是不是握手的某個 payload type，而且 message tag 對得上
+int ipmi_session_is_payload(const uint8_t* buf, size_t len, uint8_t payload_type, uint8_t tag);
+
+/*
+ * 把 IPMI message（從 rsAddr 到 data checksum，也就是 1.5 封包 msg_len 之後那段）
+ * 包成加密、簽章過的 RMCP+ 封包；每包用掉一個 session sequence number
+ */
+int ipmi_session_wrap(ipmi_session_t* s, const uint8_t* msg, size_t msg_len,
+                      uint8_t* buf, size_t* len);
+
+// 同上，包任意 payload type（例如 SOL）
+int ipmi_session_wrap_payload(ipmi_session_t* s, uint8_t payload_type,
+                              const uint8_t* msg, size_t msg_len, uint8_t* buf, size_t* len);
+
+// 驗證並解密 RMCP+ 回應（就地解密，buf 會被改寫），view 指向 buf 裡面
+int ipmi_session_unwrap(ipmi_session_t* s, uint8_t* buf, size_t len, ipmi_rsp_view_t* view);
+
+// 同上，不限 payload type；payload 指向 buf 裡解密後的內容
+int ipmi_session_unwrap_payload(ipmi_session_t* s, uint8_t* buf, size_t len,
+                                uint8_t* payload_type, uint8_t** payload, size_t* payload_len);
+
+// 不驗證，只讀出 RMCP+ 封包裡的 session ID（收到的封包是我們的 console_id），用來找是哪個 session
+int ipmi_session_peek_id(const uint8_t* buf, size_t len, uint32_t* session_id);
+
+#endif
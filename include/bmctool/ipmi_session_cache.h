@@ -0,0 +1,55 @@
+#ifndef BMCTOOL_IPMI_SESSION_CACHE_H
+#define BMCTOOL_IPMI_SESSION_CACHE_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi_session.h"
+
+/*
+ * 跨 process 的 RMCP+ session 快取
+ *
+ * 每次執行 bmctool 都是新的 process，沒有快取的話每個命令都要重新握手。
+ * 快取是一個 mmap 的檔案（預設 bmc_cache_path("ipmi-sessions")），固定數量的 slot，
+ * 每個 slot 存一個 session 的 ID、sequence number 和導出的金鑰，加上到期時間。
+ *
+ * 同一個 session 同時只借給一個 process（checkout 時標成借出，checkin 時還回來），
+ * 不然兩邊的 session sequence number 會打架；所有讀寫都在 flock 保護下進行。
+ * Key 是 host、port、帳號、密碼、cipher suite 和 privilege 的 SHA-256，
+ * 密碼不對就找不到快取，不會直接沿用別人的 session。
+ */
+typedef struct ipmi_session_cache ipmi_session_cache_t;
+
+// BMC 預設 session 閒置 60 秒就關，快取保守一點
+#define IPMI_SESSION_CACHE_TTL      45
+
+// path 為 NULL 時用預設路徑；檔案不是自己的或權限太寬就拒絕使用
+ipmi_session_cache_t* ipmi_session_cache_open(const char* path);
+void ipmi_session_cache_close(ipmi_session_cache_t* cache);
+
+// 閒置多久算過期（秒，預設 IPMI_SESSION_CACHE_TTL）
+int ipmi_session_cache_set_ttl(ipmi_session_cache_t* cache, int ttl_s);
+
+// 快取 key，由連線設定算出來
+typedef struct {
+    uint8_t digest[32];
+} ipmi_session_key_t;
+
+void ipmi_session_cache_key(const char* host, uint16_t port, const char* username,
+                            const char* password, int cipher_suite, uint8_t privilege,
+                            ipmi_session_key_t* key);
+
+/*
+ * 借出一個還沒過期、沒人在用的 session，借到時 s 是可以直接用的 active session
+ * 回傳 1 表示借到，0 表示沒有可用的，負數是錯誤
+ */
+int ipmi_session_cache_checkout(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                                ipmi_session_t* s);
+
+// 還回（或第一次存入）session，更新 sequence number 和到期時間
+int ipmi_session_cache_checkin(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                               const ipmi_session_t* s);
+
+// BMC 已經不認這個 session 了（例如 resume 後 ping 不通），從快取拿掉
+void ipmi_session_cache_drop(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                             uint32_t bmc_id);
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef BMCTOOL_IPMI_SOL_H
+#define BMCTOOL_IPMI_SOL_H
+
+#include "bmctool/common.h"
+#include "bmctool/ipmi.h"
+#include "bmctool/ipmi_resolve.h"
+#include "bmctool/ipmi_session.h"
+#include <signal.h>
+
+/*
+ * Serial-over-LAN 收集
+ *
+ * 一個 process 同時開上百個 SOL session，把每台的 console 輸出寫進各自的 log。
+ * RMCP+ session 由呼叫端先建好（例如 ipmi_pool），manager 用自己的幾個 socket + epoll
+ * 送 Activate Payload、收 SOL payload、回 ACK；同一批收到的封包要回的 ACK 整批 sendmmsg。
+ *
+ * 收到的字元在接收 buffer 就地解密，只複製一次到該台的 log buffer，
+ * 累積到一半或超過 flush 間隔才一次 write()。log buffer 放不下（例如 log 是塞住的 pipe）
+ * 就回 NACK 讓 BMC 晚點重送，不會丟字元。送給 BMC 的字元一次一個封包，等 ACK，逾時重送。
+ */
+
+/* Payload 命令（NetFn App） */
+#define IPMI_CMD_ACTIVATE_PAYLOAD       0x48
+#define IPMI_CMD_DEACTIVATE_PAYLOAD     0x49
+
+#define IPMI_CC_PAYLOAD_ACTIVE          0x80    // 已經被別的 session 開著
+
+#define IPMI_SOL_HDR_LEN                4
+
+/* BMC → console 的 status（byte 4） */
+#define IPMI_SOL_STATUS_NACK            0x40
+#define IPMI_SOL_STATUS_UNAVAILABLE     0x20
+#define IPMI_SOL_STATUS_DEACTIVATED     0x10
+#define IPMI_SOL_STATUS_OVERRUN         0x08    // BMC 的 buffer 滿了，有字元被丟掉
+#define IPMI_SOL_STATUS_BREAK           0x04
+
+/* console → BMC 的 operation（byte 4） */
+#define IPMI_SOL_OP_NACK                0x40
+#define IPMI_SOL_OP_BREAK               0x10
+#define IPMI_SOL_OP_CTS_PAUSE           0x08
+
+// 一個 SOL 封包（payload type 1）
+typedef struct {
+    uint8_t seq;                 // 1 ~ 15，0 表示只有 ACK/NACK
+    uint8_t ack_seq;             // 0 表示沒有 ACK/NACK
+    uint8_t accepted;            // 對方那個封包收下的字元數
+    uint8_t status;              // BMC 送來的是 status，我們送的是 operation
+    const uint8_t* data;
+    size_t data_len;
+} ipmi_sol_pkt_t;
+
+int ipmi_sol_parse(const uint8_t* payload, size_t len, ipmi_sol_pkt_t* pkt);
+
+// buf 至少要 IPMI_SOL_HDR_LEN + pkt->data_len；回傳封包長度
+size_t ipmi_sol_build(const ipmi_sol_pkt_t* pkt, uint8_t* buf);
+
+/* Session 狀態 */
+enum {
+    IPMI_SOL_STATE_ACTIVATING = 0,
+    IPMI_SOL_STATE_ACTIVE,
+    IPMI_SOL_STATE_CLOSING,      // 送了 Deactivate Payload，等回應
+    IPMI_SOL_STATE_CLOSED,       // 正常結束（我們 deactivate 或 BMC 關掉）
+    IPMI_SOL_STATE_FAILED
+};
+
+typedef struct {
+    int state;                   // IPMI_SOL_STATE_*
+    int error;                   // FAILED 時的錯誤碼
+    uint8_t activate_cc;         // Activate Payload 失敗時的 completion code
+    int log_errno;               // 寫 log 失敗的 errno，0 表示沒有
+    unsigned long bytes;         // 寫進 log 的字元數
+    unsigned long packets;       // 收到的 SOL 資料封包（不含重複的）
+    unsigned long duplicates;    // BMC 重送的封包（我們的 ACK 掉了）
+    unsigned long nacks;         // log buffer 滿，回 NACK 的次數
+    unsigned long overruns;      // BMC 回報自己丟了字元
+    unsigned long retransmits;   // 我們送的字元封包重送次數
+    unsigned long writes;        // log 的 write() 次數
+} ipmi_sol_stats_t;
+
+typedef struct ipmi_sol_mgr ipmi_sol_mgr_t;
+
+// num_sockets 為 0 時用預設值（每個 address family 4 個）
+ipmi_sol_mgr_t* ipmi_sol_mgr_create(int num_sockets);
+// 不會 deactivate 也不會關 log fd；要先 ipmi_sol_mgr_close
+void ipmi_sol_mgr_destroy(ipmi_sol_mgr_t* mgr);
+
+// timeout_ms 是每個 request / 字元封包的總時限，期間最多重送 retries 次
+int ipmi_sol_mgr_set_timeout(ipmi_sol_mgr_t* mgr, int timeout_ms);
+int ipmi_sol_mgr_set_retries(ipmi_sol_mgr_t* mgr, int retries);
+// log buffer 最久多久寫出一次（預設 200 ms）
+int ipmi_sol_mgr_set_flush_interval(ipmi_sol_mgr_t* mgr, int flush_ms);
+// SOL 已經被別的 session 開著（0x80）時先 deactivate 再搶過來
+int ipmi_sol_mgr_set_force(ipmi_sol_mgr_t* mgr, int force);
+
+/*
+ * 加一台，回傳 index（>= 0），失敗回傳負的錯誤碼
+ * session 要已經登入，由呼叫端擁有，要活得比 manager 久；console 輸出寫到 log_fd
+ * （manager 不會關它；pipe 要設 O_NONBLOCK 才不會卡住迴圈）。host 只拿來顯示，
+ * 不是預設 port 時會加上 port
+ */
+int ipmi_sol_mgr_add(ipmi_sol_mgr_t* mgr, const char* host, const ipmi_addr_t* addr,
+                     ipmi_session_t* session, int log_fd);
+
+// 送字元給 console：排進佇列，ACTIVE 之後一個封包一個封包送，等 BMC ACK
+int ipmi_sol_mgr_send(ipmi_sol_mgr_t* mgr, int idx, const uint8_t* data, size_t len);
+
+/*
+ * 跑事件迴圈：對還沒開的送 Activate Payload，收 console 輸出寫進 log
+ * 經過 duration_ms（< 0 表示不限）、stop 變成非 0，或全部都結束時回傳
+ * 回傳還在 ACTIVATING / ACTIVE 的台數，負數表示錯誤
+ */
+int ipmi_sol_mgr_run(ipmi_sol_mgr_t* mgr, int duration_ms, const volatile sig_atomic_t* stop);
+
+// deactivate 還開著的 SOL，等回應或逾時，log buffer 全部寫出
+int ipmi_sol_mgr_close(ipmi_sol_mgr_t* mgr);
+
+int ipmi_sol_mgr_count(const ipmi_sol_mgr_t* mgr);
+const char* ipmi_sol_mgr_host(const ipmi_sol_mgr_t* mgr, int idx);
+int ipmi_sol_mgr_get_stats(const ipmi_sol_mgr_t* mgr, int idx, ipmi_sol_stats_t* stats);
+
+const char* ipmi_sol_state_name(int state);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef BMCTOOL_IPMI_URING_H
+#define BMCTOOL_IPMI_URING_H
+
+/*
+ * io_uring 的薄包裝（ipmi_engine 的 io_uring backend 用）
+ *
+ * 不依賴 liburing，直接用 io_uring_setup / io_uring_enter / io_uring_register 三個 syscall，
+ * 只做 engine 需要的部分：
+ *   - socket 註冊成 fixed file，SQE 不用每次查 fd table
+ *   - provided buffer ring：事先註冊一批接收 buffer，multishot recvmsg 收到封包時由 kernel 挑一個填
+ *   - 送出排 SENDMSG SQE，等到下一次 io_uring_enter 和等待一起送出（一個 syscall 送 + 收）
+ *   - 等待的 timeout 用 IORING_ENTER_EXT_ARG 直接給，不另外排 timeout SQE
+ *
+ * 需要 Linux 6.0 以上（multishot recvmsg），只有用 IO_URING=1 編譯時才有。
+ */
+#ifdef BMC_IO_URING
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+typedef struct {
+    int fd;
+    unsigned features;
+    
+    // SQ：sq_tail 是 kernel 看得到的，local_tail 是還沒 submit 的
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned local_tail;
+    struct io_uring_sqe* sqes;
+    
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+    
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+    
+    // provided buffer ring
+    struct io_uring_buf_ring* br;
+    size_t br_size;
+    unsigned br_mask;
+    uint16_t br_tail;
+    uint16_t bgid;
+    uint8_t* bufs;
+    size_t buf_size;
+    
+    unsigned long enters;        // io_uring_enter 呼叫次數
+} ipmi_uring_t;
+
+// entries 是 SQ 大小（2 的次方），num_files 是 fixed file 表的格數（先全部空著）
+int ipmi_uring_init(ipmi_uring_t* ring, unsigned entries, unsigned num_files);
+void ipmi_uring_cleanup(ipmi_uring_t* ring);
+
+// 把 fd 放到 fixed file 表的 slot
+int ipmi_uring_set_file(ipmi_uring_t* ring, unsigned slot, int fd);
+
+// 註冊 count 個（2 的次方）size bytes 的接收 buffer，group id 為 bgid
+int ipmi_uring_setup_buffers(ipmi_uring_t* ring, unsigned count, size_t size, uint16_t bgid);
+uint8_t* ipmi_uring_buffer(ipmi_uring_t* ring, uint16_t bid);
+// 用完的 buffer 還給 kernel
+void ipmi_uring_recycle(ipmi_uring_t* ring, uint16_t bid);
+
+// 拿一個清空的 SQE；SQ 滿了會先 submit，失敗回傳 NULL
+struct io_uring_sqe* ipmi_uring_get_sqe(ipmi_uring_t* ring);
+
+void ipmi_uring_prep_sendmsg(struct io_uring_sqe* sqe, unsigned file, const struct msghdr* msg,
+                             uint64_t user_data);
+// multishot recvmsg：msg 只用來告訴 kernel name / control 各留多少空間
+void ipmi_uring_prep_recvmsg_multishot(struct io_uring_sqe* sqe, unsigned file,
+                                       const struct msghdr* msg, uint16_t bgid,
+                                       uint64_t user_data);
+void ipmi_uring_prep_poll(struct io_uring_sqe* sqe, unsigned file, unsigned events,
+                          uint64_t user_data);
+
+/*
+ * 送出還沒 submit 的 SQE，等到至少 wait_nr 個 completion 或 timeout_us（< 0 表示不限）
+ * 回傳 BMC_SUCCESS（含逾時），錯誤回傳 BMC_ERROR_NETWORK
+ */
+int ipmi_uring_submit_and_wait(ipmi_uring_t* ring, unsigned wait_nr, int64_t timeout_us);
+
+// 依序取 CQE；用完呼叫 ipmi_uring_cqe_seen
+struct io_uring_cqe* ipmi_uring_peek_cqe(ipmi_uring_t* ring);
+void ipmi_uring_cqe_seen(ipmi_uring_t* ring);
+
+/*
+ * 拆 multishot recvmsg 填好的 buffer：name 指向來源位址，payload 指向封包內容
+ * msg 要跟 prep 時給的同一個；封包被截斷或格式不對回傳 BMC_ERROR_PROTOCOL
+ */
+int ipmi_uring_recvmsg_parse(const uint8_t* buf, size_t len, const struct msghdr* msg,
+                             const struct sockaddr** name, const uint8_t** payload,
+                             size_t* payload_len);
+
+#endif
+
+#endif
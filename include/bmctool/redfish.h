@@ -2,14 +2,49 @@
 #define BMCTOOL_REDFISH_H
 
 #include "bmctool/common.h"
+#include "bmctool/redfish_token_cache.h"
+#include "bmctool/redfish_cache.h"
 
-// Redfish context
+struct curl_slist;
+
+// service root 的 ProtocolFeaturesSupported
+#define REDFISH_FEATURE_EXPAND_NOLINKS  0x01    // $expand=.（只展開下層資源）
+#define REDFISH_FEATURE_EXPAND_ALL      0x02    // $expand=*
+#define REDFISH_FEATURE_EXPAND_LEVELS   0x04    // $expand 可以帶 $levels=n
+#define REDFISH_FEATURE_SELECT          0x08    // $select=
+
+/*
+ * Redfish context
+ *
+ * 一個 context 對一台 BMC，curl handle 跟著 context 重複使用：TCP 連線 keep-alive，
+ * TLS session、DNS 結果都留著，走一整棵 Redfish tree 只需要握手一次。
+ * context 不能同時給多個 thread 用。
+ *
+ * 有帳密時預設用 SessionService 登入一次（POST /redfish/v1/SessionService/Sessions），
+ * 之後的 request 帶 X-Auth-Token，不用每次都讓 BMC 驗一次 Basic 帳密。
+ * token 失效（401）會自動重新登入；BMC 沒有 SessionService 就退回 Basic。
+ */
 typedef struct {
     char base_url[256];      // 例如 https://192.168.1.100
     char username[64];
     char password[64];
     int use_https;
     int verify_ssl;
+    
+    void* curl;              // CURL*，create 時建立
+    void* share;             // CURLSH*：DNS / TLS session / 連線快取
+    struct curl_slist* headers;  // 每個 request 都帶的 header
+    
+    int use_session;         // 用 SessionService token（預設開）
+    char auth_token[256];    // 空字串表示還沒登入
+    char session_uri[256];   // 登出時 DELETE 的 session
+    struct curl_slist* token_headers;  // headers 加上 X-Auth-Token
+    redfish_token_cache_t* token_cache;  // 不屬於 context，呼叫端負責關
+    redfish_cache_t* cache;  // ETag 快取，不屬於 context
+    
+    int use_query_options;   // 支援的話用 $expand / $select（預設開）
+    int features;            // REDFISH_FEATURE_*，-1 表示還沒問過 service root
+    int expand_max_levels;   // 0 表示沒說
 } redfish_ctx_t;
 
 // Redfish System 資訊
@@ -30,8 +65,49 @@ void redfish_ctx_destroy(redfish_ctx_t* ctx);
 int redfish_ctx_set_endpoint(redfish_ctx_t* ctx, const char* url);
 int redfish_ctx_set_auth(redfish_ctx_t* ctx, const char* username, const char* password);
 
+// 關掉就每個 request 都送 Basic 帳密
+int redfish_ctx_set_session_auth(redfish_ctx_t* ctx, int enable);
+
+/*
+ * 跨 process 共用 token（NULL 表示不用）
+ * 有快取時 destroy 不刪 BMC 上的 session，留給下一次執行接著用
+ */
+int redfish_ctx_set_token_cache(redfish_ctx_t* ctx, redfish_token_cache_t* cache);
+
+// GET 帶 If-None-Match，304 時用快取裡的回應（NULL 表示不用）
+int redfish_ctx_set_cache(redfish_ctx_t* ctx, redfish_cache_t* cache);
+
+/*
+ * 走 collection 時要不要用 $expand / $select（BMC 有支援才會用）
+ * 關掉就一律一個 member 一個 GET
+ */
+int redfish_ctx_set_query_options(redfish_ctx_t* ctx, int enable);
+
+// 問 service root 支援哪些 query 參數（只問一次），回傳 REDFISH_FEATURE_* 的組合
+int redfish_ctx_get_features(redfish_ctx_t* ctx);
+
+// 刪掉 BMC 上的 session（也從快取拿掉），下一個 request 會重新登入
+int redfish_ctx_logout(redfish_ctx_t* ctx);
+
 // API 呼叫
 int redfish_get_system(redfish_ctx_t* ctx, const char* system_id, redfish_system_t* system);
 int redfish_get_thermal(redfish_ctx_t* ctx, const char* chassis_id);
 
+/*
+ * Collection 走訪
+ *
+ * 一般要先 GET collection 再一個 member 一個 GET。BMC 支援 $expand 時改成
+ * GET collection?$expand=.($levels=n)，member 直接展開在回應裡，一次拿完；
+ * 不支援（或說支援但回錯誤、沒有真的展開）就退回一個一個 GET，
+ * 這時候支援 $select 的話只要 select 列的欄位。有 Members@odata.nextLink 會接著翻頁。
+ */
+typedef void (*redfish_member_cb)(const char* json, void* user_data);
+
+// levels 是要展開幾層（>= 1），超過 BMC 的 MaxLevels 就用 MaxLevels；select 可以是 NULL
+int redfish_get_members(redfish_ctx_t* ctx, const char* collection_path, int levels,
+                        const char* select, redfish_member_cb cb, void* user_data);
+
+// /redfish/v1/Systems 底下所有 system，最多 max 個
+int redfish_list_systems(redfish_ctx_t* ctx, redfish_system_t* systems, size_t max, size_t* count);
+
 #endif
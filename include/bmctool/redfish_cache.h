@@ -0,0 +1,39 @@
+#ifndef BMCTOOL_REDFISH_CACHE_H
+#define BMCTOOL_REDFISH_CACHE_H
+
+#include "bmctool/common.h"
+
+/*
+ * Redfish 回應快取（ETag / If-None-Match）
+ *
+ * Systems/{id}、韌體清單這類資源幾乎不會變，但每次 GET BMC 還是要重新產生整包 JSON，
+ * 我們這邊也要重新 parse。快取用完整 URL 當 key，存 ETag、回應內容和解析好的結果；
+ * 之後的 GET 帶 If-None-Match，BMC 回 304 就直接用快取裡的東西。
+ *
+ * 總大小有上限，超過就從最久沒用的開始丟（LRU）。
+ * 可以存成檔案（預設 bmc_cache_path("redfish-etags")）給下一次執行用，解析結果不存。
+ * 快取可以給好幾個 redfish_ctx_t 共用，但不能同時給多個 thread 用。
+ */
+typedef struct redfish_cache redfish_cache_t;
+
+#define REDFISH_CACHE_DEFAULT_BYTES     (4 * 1024 * 1024)
+
+typedef struct {
+    unsigned long hits;         // 304，用快取
+    unsigned long misses;       // 200，整包重抓
+    unsigned long evictions;
+    size_t entries;
+    size_t bytes;
+} redfish_cache_stats_t;
+
+// max_bytes 為 0 時用 REDFISH_CACHE_DEFAULT_BYTES
+redfish_cache_t* redfish_cache_create(size_t max_bytes);
+void redfish_cache_destroy(redfish_cache_t* cache);
+
+// path 為 NULL 時用預設路徑；檔案不存在、格式不對、不是自己的或別人讀寫得到就當作空的
+int redfish_cache_load(redfish_cache_t* cache, const char* path);
+int redfish_cache_save(const redfish_cache_t* cache, const char* path);
+
+void redfish_cache_get_stats(const redfish_cache_t* cache, redfish_cache_stats_t* stats);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef BMCTOOL_REDFISH_MULTI_H
+#define BMCTOOL_REDFISH_MULTI_H
+
+#include "bmctool/common.h"
+#include "bmctool/redfish.h"
+
+/*
+ * 多台 BMC 並行的 Redfish GET
+ *
+ * 一個 curl multi handle 加 epoll（curl_multi_socket_action）同時跑上千個 GET，
+ * 不是一台一個 thread。BMC 支援 HTTP/2 時同一台的 request 共用一條連線（multiplex），
+ * 只有 HTTP/1.1 時最多開 max_per_host 條。同時在路上的 request 有全域和每台兩個上限，
+ * 超過的在各台的 queue 排隊；DNS、TLS session 和連線在所有 request 之間共用。
+ * 完成時呼叫使用者給的 callback。
+ */
+typedef struct redfish_multi redfish_multi_t;
+
+/*
+ * GET 完成 callback
+ * status 為 BMC_SUCCESS 時表示 HTTP 200，body 是以 '\0' 結尾的回應內容；
+ * 其他狀態 body 可能是錯誤回應或 NULL，http_code 為 0 表示沒拿到回應。
+ * body 只在 callback 執行期間有效；callback 裡可以再排新的 request
+ */
+typedef void (*redfish_multi_cb)(redfish_multi_t* m, int target, int status, long http_code,
+                                 const char* body, size_t len, void* user_data);
+
+// 解析好的 ComputerSystem；status 不是 BMC_SUCCESS 時 system 為 NULL
+typedef void (*redfish_system_cb)(redfish_multi_t* m, int target, int status,
+                                  const redfish_system_t* system, void* user_data);
+
+// 統計
+typedef struct {
+    unsigned long requests;      // 完成的 request（含失敗）
+    unsigned long failed;
+    unsigned long connects;      // 新開的連線（其他都是重用）
+    unsigned long http2;         // 走 HTTP/2 的 request
+    unsigned long bytes;         // 收到的 body bytes
+} redfish_multi_stats_t;
+
+redfish_multi_t* redfish_multi_create(void);
+// 沒完成的 request 直接丟掉，不呼叫 callback
+void redfish_multi_destroy(redfish_multi_t* m);
+
+// 全域同時在路上的 request 上限（預設 256）
+int redfish_multi_set_max_total(redfish_multi_t* m, int max_total);
+// 每台 BMC 同時在路上的 request 上限（預設 8）；HTTP/1.1 時也是每台的連線上限
+int redfish_multi_set_max_per_host(redfish_multi_t* m, int max_per_host);
+// 每個 request 的總時限（預設 10000 ms）
+int redfish_multi_set_timeout(redfish_multi_t* m, int timeout_ms);
+int redfish_multi_set_verify_ssl(redfish_multi_t* m, int verify_ssl);
+
+/*
+ * 加一台 BMC，回傳 target index（>= 0），失敗回傳負的錯誤碼
+ * base_url 例如 https://192.168.1.100；username 為 NULL 表示不帶認證
+ */
+int redfish_multi_add_target(redfish_multi_t* m, const char* base_url,
+                             const char* username, const char* password);
+const char* redfish_multi_target_url(const redfish_multi_t* m, int target);
+int redfish_multi_num_targets(const redfish_multi_t* m);
+
+// 排入一個 GET（path 例如 /redfish/v1/Systems），實際送出由 redfish_multi_run() 負責
+int redfish_multi_get(redfish_multi_t* m, int target, const char* path,
+                      redfish_multi_cb cb, void* user_data);
+// GET /redfish/v1/Systems/<system_id>，解析好再交給 callback
+int redfish_multi_get_system(redfish_multi_t* m, int target, const char* system_id,
+                             redfish_system_cb cb, void* user_data);
+
+/*
+ * 跑事件迴圈直到所有 request 完成，或經過 timeout_ms（< 0 表示不限）
+ * 回傳還沒完成的 request 數，負數表示錯誤
+ */
+int redfish_multi_run(redfish_multi_t* m, int timeout_ms);
+
+size_t redfish_multi_pending(const redfish_multi_t* m);
+void redfish_multi_get_stats(const redfish_multi_t* m, redfish_multi_stats_t* stats);
+
+#endif
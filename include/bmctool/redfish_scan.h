@@ -0,0 +1,43 @@
+#ifndef BMCTOOL_REDFISH_SCAN_H
+#define BMCTOOL_REDFISH_SCAN_H
+
+#include "bmctool/common.h"
+
+/*
+ * 串流、只取指定欄位的 JSON parser
+ *
+ * json_tokener_parse() 會把整包回應建成 DOM，但 redfish_get_system() 之類的呼叫
+ * 只要裡面幾個字串。scanner 在 curl 收到每一塊資料時就處理，不用先存整包 body，
+ * 只記目前的 key path，遇到指定的 path 才把值寫進呼叫端的 buffer；
+ * 不在任何指定 path 上的 object / array 整個跳過，只數括號和引號。
+ *
+ * 限制：只比對 object 裡的 scalar（陣列裡的東西不比對），path 最長 255 bytes、64 層，
+ * 跳過的部分不檢查語法。
+ */
+typedef struct redfish_scan redfish_scan_t;
+
+#define REDFISH_SCAN_MAX_FIELDS     32
+
+typedef struct {
+    const char* path;        // 用 / 分隔，例如 "Status/Health"
+    char* dest;              // 字串處理過 escape；數字、true / false 照原文；null 為空字串
+    size_t dest_size;        // 放不下就截斷
+} redfish_scan_field_t;
+
+// fields 會複製一份，path 和 dest 指向的記憶體要活得比 scanner 久
+redfish_scan_t* redfish_scan_create(const redfish_scan_field_t* fields, size_t num_fields);
+void redfish_scan_destroy(redfish_scan_t* scan);
+
+// 準備 parse 下一份文件（欄位設定不變）
+void redfish_scan_reset(redfish_scan_t* scan);
+
+// 餵一塊資料；語法錯誤回傳 BMC_ERROR_PROTOCOL，之後的資料都不再處理
+int redfish_scan_feed(redfish_scan_t* scan, const char* data, size_t len);
+
+// 資料收完了，文件完整才回傳 BMC_SUCCESS
+int redfish_scan_finish(redfish_scan_t* scan);
+
+// 第 index 個欄位有沒有出現
+int redfish_scan_found(const redfish_scan_t* scan, size_t index);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef BMCTOOL_REDFISH_TOKEN_CACHE_H
+#define BMCTOOL_REDFISH_TOKEN_CACHE_H
+
+#include "bmctool/common.h"
+
+/*
+ * 跨 process 的 Redfish session token 快取
+ *
+ * 每次執行 bmctool 都要 POST SessionService/Sessions 登入一次，BMC 那邊常常
+ * 每次登入都跑一趟 PAM / LDAP。快取是一個 mmap 的檔案（預設 bmc_cache_path("redfish-tokens")），
+ * 固定數量的 slot，每個 slot 存 X-Auth-Token、session 的 URI 和最後使用時間。
+ *
+ * 跟 IPMI session 不一樣，token 沒有 sequence number，同時給好幾個 process 用沒問題，
+ * 所以不用借出／還回。所有讀寫都在 flock 保護下進行。
+ * Key 是 base URL、帳號和密碼的 SHA-256，密碼不對就找不到快取。
+ */
+typedef struct redfish_token_cache redfish_token_cache_t;
+
+// Redfish SessionTimeout 常見是 30 分鐘（閒置），快取保守一點
+#define REDFISH_TOKEN_CACHE_TTL     600
+
+// path 為 NULL 時用預設路徑；檔案不是自己的或權限太寬就拒絕使用
+redfish_token_cache_t* redfish_token_cache_open(const char* path);
+void redfish_token_cache_close(redfish_token_cache_t* cache);
+
+// 閒置多久算過期（秒，預設 REDFISH_TOKEN_CACHE_TTL）
+int redfish_token_cache_set_ttl(redfish_token_cache_t* cache, int ttl_s);
+
+// 快取 key，由連線設定算出來
+typedef struct {
+    uint8_t digest[32];
+} redfish_token_key_t;
+
+void redfish_token_cache_key(const char* base_url, const char* username, const char* password,
+                             redfish_token_key_t* key);
+
+/*
+ * 找還沒過期的 token，順便更新最後使用時間
+ * 回傳 1 表示找到，0 表示沒有，負數是錯誤
+ */
+int redfish_token_cache_lookup(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                               char* token, size_t token_len,
+                               char* session_uri, size_t uri_len);
+
+// 存入新登入的 token（同一個 key 的舊 token 會被取代）
+int redfish_token_cache_store(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                              const char* token, const char* session_uri);
+
+// BMC 已經不認這個 token 了（401）或 session 已經刪掉，從快取拿掉
+void redfish_token_cache_drop(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                              const char* token);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef BMCTOOL_CLI_H
+#define BMCTOOL_CLI_H
+
+#include "bmctool/common.h"
+
+// -D 沒指定時每台 BMC 同時在路上的 request 數
+#define CLI_DEFAULT_PIPELINE_DEPTH  8
+
+// IPMI 相關的命令列設定
+typedef struct {
+    uint16_t port;
+    int timeout_ms;          // 0 表示用預設值
+    int retries;             // < 0 表示用預設值
+    int batch_size;          // 一次 syscall 送收幾個封包，0 表示用預設值
+    int io_backend;          // 多台模式 engine 的 I/O backend（IPMI_ENGINE_IO_*）
+    int lanplus;             // 1 表示用 RMCP+ session
+    int cipher_suite;        // 0 表示用預設值（17）
+    int session_cache;       // 1 表示跨 process 共用 session
+    const char* username;
+    const char* password;
+} cli_ipmi_opts_t;
+
+// power-sample 沒指定間隔時的取樣週期
+#define CLI_DEFAULT_SAMPLE_INTERVAL_MS  1000
+
+// ipmi power-sample 的設定
+typedef struct {
+    int interval_ms;
+    unsigned long count;     // tick 數，0 表示跑到 Ctrl-C
+    int format;              // IPMI_POWER_OUTPUT_CSV / IPMI_POWER_OUTPUT_BINARY
+} cli_sample_opts_t;
+
+// ipmi sol 的設定
+typedef struct {
+    const char* log_dir;     // 每台寫一個 <host>-<port>.log
+    int duration_s;          // 0 表示跑到 Ctrl-C
+    int force;               // SOL 被別的 session 開著時搶過來
+} cli_sol_opts_t;
+
+// redfish 多台模式的設定
+typedef struct {
+    uint16_t port;           // hosts file 沒寫 port 時用，0 表示 443
+    int timeout_ms;          // 0 表示用預設值
+    int max_per_host;        // 每台同時在路上的 GET 數
+    const char* username;
+    const char* password;
+} cli_redfish_opts_t;
+
+// 多台 BMC 一起跑（hosts file 一行一台）
+int cli_fleet_run(const char* hosts_file, const cli_ipmi_opts_t* opts, const char* cmd);
+
+// DCMI 功耗定時取樣，樣本寫到 stdout；hosts_file 不是 NULL 時忽略 host
+int cli_power_sample(const char* host, const char* hosts_file, const cli_ipmi_opts_t* opts,
+                     const cli_sample_opts_t* sopts);
+
+// 同時收多台的 SOL console；hosts_file 不是 NULL 時忽略 host
+int cli_sol_capture(const char* host, const char* hosts_file, const cli_ipmi_opts_t* opts,
+                    const cli_sol_opts_t* sol);
+
+// 對 hosts file 裡每台 BMC 跑 Redfish 命令（目前只有 system <id>），全部並行
+int cli_redfish_fleet(const char* hosts_file, const cli_redfish_opts_t* opts, const char* cmd,
+                      const char* arg);
+
+// 用 ASF Presence Ping 掃一個 IPv4 網段；probe_auth 為 1 時再問回應者的認證能力
+int cli_discover(const char* cidr, const cli_ipmi_opts_t* opts, int rate_pps, int probe_auth);
+
+#endif
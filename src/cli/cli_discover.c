@@ -0,0 +1,163 @@
+#define _GNU_SOURCE
+#include "cli.h"
+#include "bmctool/ipmi_discover.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 依 bit 把名稱用逗號串起來
+static const char* join_bits(uint8_t bits, const uint8_t* masks, const char* const* names,
+                             int n, char* buf, size_t len) {
+    size_t off = 0;
+    
+    buf[0] = '\0';
+    for (int i = 0; i < n; i++) {
+        if (!(bits & masks[i])) {
+            continue;
+        }
+        int w = snprintf(buf + off, len - off, "%s%s", off ? "," : "", names[i]);
+        if (w < 0 || (size_t)w >= len - off) {
+            break;
+        }
+        off += (size_t)w;
+    }
+    
+    return off ? buf : "-";
+}
+
+static const char* auth_types_str(uint8_t types, char* buf, size_t len) {
+    static const uint8_t masks[] = {
+        IPMI_AUTH_CAP_NONE, IPMI_AUTH_CAP_MD2, IPMI_AUTH_CAP_MD5,
+        IPMI_AUTH_CAP_PASSWORD, IPMI_AUTH_CAP_OEM
+    };
+    static const char* const names[] = { "none", "md2", "md5", "password", "oem" };
+    return join_bits(types, masks, names, 5, buf, len);
+}
+
+static const char* login_str(uint8_t login, char* buf, size_t len) {
+    static const uint8_t masks[] = {
+        IPMI_LOGIN_ANONYMOUS, IPMI_LOGIN_NULL_USER, IPMI_LOGIN_NON_NULL_USER
+    };
+    static const char* const names[] = { "anonymous", "null-user", "user" };
+    return join_bits(login, masks, names, 3, buf, len);
+}
+
+static void print_host(const ipmi_discover_host_t* h) {
+    char rtt[16];
+    char versions[16] = "-";
+    char auth[48] = "-";
+    char login[40] = "-";
+    const char* auth_col = auth;
+    const char* login_col = login;
+    
+    snprintf(rtt, sizeof(rtt), "%.1f ms", h->rtt_us / 1000.0);
+    
+    if (h->auth_status == BMC_SUCCESS) {
+        snprintf(versions, sizeof(versions), "%s%s%s",
+                 h->auth.ipmi15 ? "1.5" : "",
+                 h->auth.ipmi15 && h->auth.ipmi20 ? "/" : "",
+                 h->auth.ipmi20 ? "2.0" : "");
+        auth_col = auth_types_str(h->auth.auth_types, auth, sizeof(auth));
+        login_col = login_str(h->auth.login, login, sizeof(login));
+    } else if (h->auth_status != IPMI_DISCOVER_NOT_PROBED) {
+        auth_col = bmc_error_str(h->auth_status);
+    }
+    
+    const char* ipmi = (h->entities & ASF_ENTITY_IPMI) ? "yes" : "no";
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* row[6] = {h->host, rtt, ipmi, versions, auth_col, login_col};
+        table_print_row(row);
+    } else {
+        printf("%-16s %10s %-4s %-8s %-24s %s\n", h->host, rtt, ipmi, versions, auth_col, login_col);
+    }
+}
+
+int cli_discover(const char* cidr, const cli_ipmi_opts_t* opts, int rate_pps, int probe_auth) {
+    ipmi_discover_opts_t dopts = {
+        .port = opts->port,
+        .rate_pps = rate_pps,
+        .timeout_ms = opts->timeout_ms,
+        .rounds = opts->retries >= 0 ? opts->retries + 1 : 0
+    };
+    ipmi_discover_result_t result;
+    uint64_t start = bmc_monotonic_us();
+    
+    if (rate_pps < 0) {
+        fprintf(stderr, "Error: Invalid rate %d\n", rate_pps);
+        return 1;
+    }
+    
+    int ret = ipmi_discover_ping(cidr, &dopts, &result);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    uint64_t ping_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    // 回應的 BMC 一起交給 engine 問，IPMI 1.5 sessionless 就能問
+    if (probe_auth && result.count > 0) {
+        ipmi_engine_t* eng = ipmi_engine_create(0);
+        if (!eng) {
+            fprintf(stderr, "Error: Failed to create IPMI engine\n");
+            ipmi_discover_free(&result);
+            return 1;
+        }
+        if (ipmi_engine_set_io_backend(eng, opts->io_backend) != BMC_SUCCESS) {
+            fprintf(stderr, "Error: I/O backend %s is not available\n",
+                    ipmi_engine_io_backend_name(opts->io_backend));
+            ipmi_engine_destroy(eng);
+            ipmi_discover_free(&result);
+            return 1;
+        }
+        if (opts->timeout_ms > 0) {
+            ipmi_engine_set_timeout(eng, opts->timeout_ms);
+        }
+        if (opts->retries >= 0) {
+            ipmi_engine_set_retries(eng, opts->retries);
+        }
+        if (opts->batch_size > 0) {
+            ipmi_engine_set_batch_size(eng, opts->batch_size);
+        }
+        
+        ret = ipmi_discover_auth(eng, opts->port, &result);
+        ipmi_engine_destroy(eng);
+        if (ret != BMC_SUCCESS) {
+            fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+            ipmi_discover_free(&result);
+            return 1;
+        }
+    }
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Host", "RTT", "IPMI", "Versions", "Auth", "Login"};
+        table_init(6, headers);
+        table_set_col_width(0, 16);
+        table_set_col_width(1, 10);
+        table_set_col_width(3, 8);
+        table_set_col_width(4, 24);
+        table_set_col_width(5, 24);
+        table_print_header();
+    } else {
+        printf("%-16s %10s %-4s %-8s %-24s %s\n", "Host", "RTT", "IPMI", "Versions", "Auth", "Login");
+    }
+    
+    for (size_t i = 0; i < result.count; i++) {
+        print_host(&result.hosts[i]);
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    }
+    
+    printf("\n%zu/%u addresses answered in %llu ms (%lu pings, %llu ms sweep)\n",
+           result.count, result.scanned, (unsigned long long)elapsed_ms,
+           result.pings, (unsigned long long)ping_ms);
+    if (result.invalid) {
+        bmc_log(LOG_LEVEL_DEBUG, "%lu unexpected packets ignored", result.invalid);
+    }
+    
+    ipmi_discover_free(&result);
+    return 0;
+}
@@ -0,0 +1,886 @@
+#define _GNU_SOURCE
+#include "cli.h"
+#include "bmctool/ipmi_engine.h"
+#include "bmctool/ipmi_commands.h"
+#include "bmctool/ipmi_pool.h"
+#include "bmctool/ipmi_power.h"
+#include "bmctool/ipmi_sol.h"
+#include "bmctool/redfish_multi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+typedef struct {
+    const char* cmd;
+    int ok;
+    int failed;
+} fleet_state_t;
+
+static void print_result(const char* host, const char* status, const char* detail) {
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* row[3] = {host, status, detail};
+        table_print_row(row);
+    } else {
+        printf("%-32s %-8s %s\n", host, status, detail);
+    }
+}
+
+static void fleet_done(ipmi_engine_t* eng, int target, int status,
+                       const ipmi_rsp_view_t* rsp, void* user_data) {
+    fleet_state_t* st = (fleet_state_t*)user_data;
+    const char* host = ipmi_engine_target_host(eng, target);
+    char detail[128];
+    
+    if (status != BMC_SUCCESS) {
+        st->failed++;
+        print_result(host, "FAIL", bmc_error_str(status));
+        return;
+    }
+    
+    if (strcmp(st->cmd, "get-device-id") == 0) {
+        ipmi_device_id_t id;
+        if (ipmi_decode_device_id(rsp, &id) != BMC_SUCCESS) {
+            st->failed++;
+            print_result(host, "FAIL", "Bad response");
+            return;
+        }
+        uint32_t mfg = id.manufacturer_id[0] |
+                       (id.manufacturer_id[1] << 8) |
+                       (id.manufacturer_id[2] << 16);
+        snprintf(detail, sizeof(detail), "fw %d.%d, ipmi %d.%d, mfg 0x%06x",
+                 id.firmware_rev1, id.firmware_rev2,
+                 id.ipmi_version & 0x0F, (id.ipmi_version >> 4) & 0x0F, mfg);
+    } else {
+        ipmi_chassis_status_t cs;
+        if (ipmi_decode_chassis_status(rsp, &cs) != BMC_SUCCESS) {
+            st->failed++;
+            print_result(host, "FAIL", "Bad response");
+            return;
+        }
+        snprintf(detail, sizeof(detail), "power %s%s",
+                 (cs.current_power_state & 0x01) ? "ON" : "OFF",
+                 (cs.current_power_state & 0x08) ? ", power fault" : "");
+    }
+    
+    st->ok++;
+    print_result(host, "OK", detail);
+}
+
+// 拆 "host"、"host:port"、"[v6addr]:port"；沒括號的 IPv6 當成沒有 port
+static int parse_host_line(char* line, char** host, uint16_t* port) {
+    *port = 0;
+    
+    if (line[0] == '[') {
+        char* end = strchr(line, ']');
+        if (!end) {
+            return -1;
+        }
+        *end = '\0';
+        *host = line + 1;
+        if (end[1] == ':') {
+            *port = (uint16_t)atoi(end + 2);
+        }
+        return 0;
+    }
+    
+    char* colon = strchr(line, ':');
+    if (colon && !strchr(colon + 1, ':')) {
+        *colon = '\0';
+        *port = (uint16_t)atoi(colon + 1);
+    }
+    *host = line;
+    
+    return 0;
+}
+
+typedef struct {
+    char** hosts;
+    uint16_t* ports;
+    int* linenos;
+    size_t count;
+    size_t cap;
+} host_list_t;
+
+static void host_list_free(host_list_t* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->hosts[i]);
+    }
+    free(list->hosts);
+    free(list->ports);
+    free(list->linenos);
+}
+
+static int host_list_add(host_list_t* list, const char* host, uint16_t port, int lineno) {
+    if (list->count == list->cap) {
+        size_t cap = list->cap ? list->cap * 2 : 64;
+        char** hosts = realloc(list->hosts, cap * sizeof(*hosts));
+        if (!hosts) {
+            return -1;
+        }
+        list->hosts = hosts;
+        uint16_t* ports = realloc(list->ports, cap * sizeof(*ports));
+        if (!ports) {
+            return -1;
+        }
+        list->ports = ports;
+        int* linenos = realloc(list->linenos, cap * sizeof(*linenos));
+        if (!linenos) {
+            return -1;
+        }
+        list->linenos = linenos;
+        list->cap = cap;
+    }
+    
+    list->hosts[list->count] = strdup(host);
+    if (!list->hosts[list->count]) {
+        return -1;
+    }
+    list->ports[list->count] = port;
+    list->linenos[list->count] = lineno;
+    list->count++;
+    
+    return 0;
+}
+
+static int read_hosts(const char* path, uint16_t default_port, host_list_t* list) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open hosts file '%s'\n", path);
+        return -1;
+    }
+    
+    char line[512];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        
+        // 去掉註解和前後空白
+        char* p = strchr(line, '#');
+        if (p) *p = '\0';
+        p = line;
+        while (isspace((unsigned char)*p)) p++;
+        char* end = p + strlen(p);
+        while (end > p && isspace((unsigned char)end[-1])) *--end = '\0';
+        if (*p == '\0') {
+            continue;
+        }
+        
+        char* host;
+        uint16_t port;
+        if (parse_host_line(p, &host, &port) != 0) {
+            fprintf(stderr, "Warning: %s:%d: invalid host '%s'\n", path, lineno, p);
+            continue;
+        }
+        
+        if (host_list_add(list, host, port ? port : default_port, lineno) != 0) {
+            fprintf(stderr, "Error: Out of memory\n");
+            fclose(fp);
+            return -1;
+        }
+    }
+    
+    fclose(fp);
+    return 0;
+}
+
+/*
+ * lanplus：新加的 target 一起透過 pool 登入（握手同時進行，不是一台等完換下一台），
+ * 全部登入完再把 session 交給 engine；addrs[i] 是 targets[i] 的位址，結果記在 login[target]
+ */
+static int login_targets(ipmi_engine_t* eng, ipmi_pool_t* pool, const cli_ipmi_opts_t* opts,
+                         const int* targets, const ipmi_addr_t* addrs, size_t count, int* login) {
+    const char** hosts = calloc(count ? count : 1, sizeof(char*));
+    ipmi_ctx_t** ctxs = calloc(count ? count : 1, sizeof(ipmi_ctx_t*));
+    int* errs = calloc(count ? count : 1, sizeof(int));
+    int ret = hosts && ctxs && errs ? BMC_SUCCESS : BMC_ERROR_MEMORY;
+    
+    for (size_t i = 0; i < count && ret == BMC_SUCCESS; i++) {
+        hosts[i] = ipmi_engine_target_host(eng, targets[i]);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_pool_acquire_bulk(pool, hosts, addrs, count, opts->username, opts->password,
+                                     ctxs, errs);
+    }
+    
+    for (size_t i = 0; i < count && ret == BMC_SUCCESS; i++) {
+        login[targets[i]] = ctxs[i] ?
+                            ipmi_engine_attach_session(eng, targets[i], &ctxs[i]->session) :
+                            errs[i];
+    }
+    
+    free(hosts);
+    free(ctxs);
+    free(errs);
+    
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return -1;
+    }
+    return 0;
+}
+
+// 整批解析（hostname 並行查 DNS）後加進 engine；label 是錯誤訊息裡的來源
+static int add_hosts(ipmi_engine_t* eng, const host_list_t* list, const char* label,
+                     const cli_ipmi_opts_t* opts, ipmi_pool_t* pool, int** login) {
+    ipmi_addr_t* addrs = calloc(list->count ? list->count : 1, sizeof(ipmi_addr_t));
+    int* targets = calloc(list->count ? list->count : 1, sizeof(int));
+    if (!addrs || !targets) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(addrs);
+        free(targets);
+        return -1;
+    }
+    
+    if (pool) {
+        *login = calloc(list->count ? list->count : 1, sizeof(int));
+        if (!*login) {
+            fprintf(stderr, "Error: Out of memory\n");
+            free(addrs);
+            free(targets);
+            return -1;
+        }
+    }
+    
+    ipmi_resolve_bulk((const char* const*)list->hosts, list->ports, list->count, addrs);
+    
+    // 要登入的 target 和位址往前收，順序和 targets 一致
+    size_t fresh = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        int before = ipmi_engine_num_targets(eng);
+        int target = addrs[i].status == BMC_SUCCESS ?
+                     ipmi_engine_add_target_addr(eng, list->hosts[i], &addrs[i]) : -1;
+        if (target < 0) {
+            if (list->linenos[i] > 0) {
+                fprintf(stderr, "Warning: %s:%d: cannot resolve '%s'\n", label,
+                        list->linenos[i], list->hosts[i]);
+            } else {
+                fprintf(stderr, "Warning: cannot resolve '%s'\n", list->hosts[i]);
+            }
+            continue;
+        }
+        
+        // 重複的位址不用再登入一次
+        if (pool && target >= before) {
+            targets[fresh] = target;
+            addrs[fresh++] = addrs[i];
+        }
+    }
+    
+    int ret = pool ? login_targets(eng, pool, opts, targets, addrs, fresh, *login) : 0;
+    
+    free(addrs);
+    free(targets);
+    return ret;
+}
+
+// 先把整個 hosts file 讀進來，再一次加進 engine
+static int load_hosts(ipmi_engine_t* eng, const char* path, const cli_ipmi_opts_t* opts,
+                      ipmi_pool_t* pool, int** login) {
+    host_list_t list = {0};
+    int ret = read_hosts(path, opts->port, &list);
+    if (ret == 0) {
+        ret = add_hosts(eng, &list, path, opts, pool, login);
+    }
+    
+    host_list_free(&list);
+    return ret;
+}
+
+// -H 給的單一台，走和 hosts file 一樣的路
+static int load_host(ipmi_engine_t* eng, const char* host, const cli_ipmi_opts_t* opts,
+                     ipmi_pool_t* pool, int** login) {
+    host_list_t list = {0};
+    int ret = host_list_add(&list, host, opts->port, 0);
+    if (ret == 0) {
+        ret = add_hosts(eng, &list, host, opts, pool, login);
+    } else {
+        fprintf(stderr, "Error: Out of memory\n");
+    }
+    
+    host_list_free(&list);
+    return ret;
+}
+
+static int run_fleet(ipmi_engine_t* eng, ipmi_pool_t* pool, const char* hosts_file,
+                     const cli_ipmi_opts_t* opts, const char* cmd,
+                     uint8_t netfn, uint8_t ipmi_cmd) {
+    int* login = NULL;
+    uint64_t start = bmc_monotonic_us();
+    
+    if (load_hosts(eng, hosts_file, opts, pool, &login) != 0) {
+        return 1;
+    }
+    
+    int num = ipmi_engine_num_targets(eng);
+    if (num == 0) {
+        fprintf(stderr, "Error: No usable hosts in '%s'\n", hosts_file);
+        free(login);
+        return 1;
+    }
+    
+    if (pool) {
+        bmc_log(LOG_LEVEL_DEBUG, "%zu sessions set up in %llu ms", ipmi_pool_size(pool),
+                (unsigned long long)((bmc_monotonic_us() - start) / 1000));
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Host", "Status", "Detail"};
+        table_init(3, headers);
+        table_set_col_width(0, 32);
+        table_set_col_width(2, 40);
+        table_print_header();
+    }
+    
+    fleet_state_t st = { .cmd = cmd };
+    for (int t = 0; t < num; t++) {
+        if (login && login[t] != BMC_SUCCESS) {
+            st.failed++;
+            print_result(ipmi_engine_target_host(eng, t), "FAIL", "Session setup failed");
+            continue;
+        }
+        int ret = ipmi_engine_submitv(eng, t, netfn, ipmi_cmd, NULL, 0, fleet_done, &st);
+        if (ret != BMC_SUCCESS) {
+            st.failed++;
+            print_result(ipmi_engine_target_host(eng, t), "FAIL", bmc_error_str(ret));
+        }
+    }
+    free(login);
+    
+    start = bmc_monotonic_us();
+    ipmi_engine_run(eng, -1);
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    }
+    
+    printf("\n%d/%d hosts responded in %llu ms\n", st.ok, num,
+           (unsigned long long)elapsed_ms);
+    
+    ipmi_engine_stats_t stats;
+    ipmi_engine_get_stats(eng, &stats);
+    bmc_log(LOG_LEVEL_DEBUG, "sent=%lu received=%lu retransmits=%lu timeouts=%lu "
+            "stale=%lu syscalls=%lu", stats.sent, stats.received, stats.retransmits,
+            stats.timeouts, stats.stale, stats.syscalls);
+    
+    return st.failed ? 1 : 0;
+}
+
+// lanplus 的 session pool；cache 是 -S 的跨 process 快取
+static int pool_open(const cli_ipmi_opts_t* opts, ipmi_pool_t** pool, ipmi_session_cache_t** cache) {
+    *pool = ipmi_pool_create(0);
+    if (!*pool || ipmi_pool_set_lanplus(*pool, opts->cipher_suite, 0) != BMC_SUCCESS) {
+        fprintf(stderr, "Error: Invalid lanplus settings\n");
+        return -1;
+    }
+    if (opts->timeout_ms > 0) {
+        ipmi_pool_set_timeout(*pool, opts->timeout_ms);
+    }
+    if (opts->retries >= 0) {
+        ipmi_pool_set_retries(*pool, opts->retries);
+    }
+    
+    if (opts->session_cache) {
+        *cache = ipmi_session_cache_open(NULL);
+        ipmi_pool_set_session_cache(*pool, *cache);
+    }
+    
+    return 0;
+}
+
+// 建 engine；lanplus 時另外建 pool（session 由 pool 擁有，engine 跑完才能關）
+static int fleet_open(const cli_ipmi_opts_t* opts, ipmi_engine_t** eng, ipmi_pool_t** pool,
+                      ipmi_session_cache_t** cache) {
+    *eng = NULL;
+    *pool = NULL;
+    *cache = NULL;
+    
+    *eng = ipmi_engine_create(0);
+    if (!*eng) {
+        fprintf(stderr, "Error: Failed to create IPMI engine\n");
+        return -1;
+    }
+    if (ipmi_engine_set_io_backend(*eng, opts->io_backend) != BMC_SUCCESS) {
+        fprintf(stderr, "Error: I/O backend %s is not available\n",
+                ipmi_engine_io_backend_name(opts->io_backend));
+        return -1;
+    }
+    
+    if (opts->timeout_ms > 0) {
+        ipmi_engine_set_timeout(*eng, opts->timeout_ms);
+    }
+    if (opts->retries >= 0) {
+        ipmi_engine_set_retries(*eng, opts->retries);
+    }
+    if (opts->batch_size > 0 && ipmi_engine_set_batch_size(*eng, opts->batch_size) != BMC_SUCCESS) {
+        fprintf(stderr, "Error: Invalid batch size %d\n", opts->batch_size);
+        return -1;
+    }
+    
+    if (!opts->lanplus) {
+        return 0;
+    }
+    
+    return pool_open(opts, pool, cache);
+}
+
+static void fleet_close(ipmi_engine_t* eng, ipmi_pool_t* pool, ipmi_session_cache_t* cache) {
+    ipmi_engine_destroy(eng);
+    ipmi_pool_destroy(pool);
+    ipmi_session_cache_close(cache);
+}
+
+int cli_fleet_run(const char* hosts_file, const cli_ipmi_opts_t* opts, const char* cmd) {
+    uint8_t netfn;
+    uint8_t ipmi_cmd;
+    
+    if (strcmp(cmd, "get-device-id") == 0) {
+        netfn = IPMI_NETFN_APP;
+        ipmi_cmd = IPMI_CMD_GET_DEVICE_ID;
+    } else if (strcmp(cmd, "chassis-status") == 0) {
+        netfn = IPMI_NETFN_CHASSIS;
+        ipmi_cmd = IPMI_CMD_GET_CHASSIS_STATUS;
+    } else {
+        fprintf(stderr, "Error: '%s' is not supported with --hosts-file\n", cmd);
+        return 1;
+    }
+    
+    ipmi_engine_t* eng;
+    ipmi_pool_t* pool;
+    ipmi_session_cache_t* cache;
+    int ret = 1;
+    
+    if (fleet_open(opts, &eng, &pool, &cache) == 0) {
+        ret = run_fleet(eng, pool, hosts_file, opts, cmd, netfn, ipmi_cmd);
+    }
+    
+    fleet_close(eng, pool, cache);
+    return ret;
+}
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_stop(int sig) {
+    (void)sig;
+    g_stop = 1;
+}
+
+// Ctrl-C / SIGTERM 只讓迴圈停下來，收尾照常做
+static void install_stop_handler(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+static void print_sample_stats(const ipmi_power_stats_t* st, int targets, uint64_t elapsed_ms) {
+    fprintf(stderr, "\n%lu ticks on %d hosts in %llu ms: %lu samples, %lu errors, "
+            "%lu overruns, %lu missed ticks, %lu dropped\n",
+            st->ticks, targets, (unsigned long long)elapsed_ms, st->samples, st->errors,
+            st->overruns, st->missed_ticks, st->dropped);
+    fprintf(stderr, "tick jitter: mean %.1f us, stddev %.1f us, max %.1f us\n",
+            st->jitter_mean_us, st->jitter_stddev_us, st->jitter_max_us);
+    fprintf(stderr, "latency: mean %.2f ms, max %.2f ms\n",
+            st->latency_mean_us / 1000, st->latency_max_us / 1000);
+}
+
+static int run_power_sample(ipmi_engine_t* eng, ipmi_pool_t* pool, const char* host,
+                            const char* hosts_file, const cli_ipmi_opts_t* opts,
+                            const cli_sample_opts_t* sopts) {
+    int* login = NULL;
+    int ret = hosts_file ? load_hosts(eng, hosts_file, opts, pool, &login) :
+                           load_host(eng, host, opts, pool, &login);
+    if (ret != 0) {
+        free(login);
+        return 1;
+    }
+    
+    int num = ipmi_engine_num_targets(eng);
+    if (num == 0) {
+        fprintf(stderr, "Error: No usable hosts\n");
+        free(login);
+        return 1;
+    }
+    
+    ipmi_power_sampler_t* sampler = ipmi_power_sampler_create(eng, sopts->interval_ms, 0);
+    if (!sampler) {
+        fprintf(stderr, "Error: Failed to create power sampler\n");
+        free(login);
+        return 1;
+    }
+    ipmi_power_sampler_set_output(sampler, stdout, sopts->format);
+    
+    for (int t = 0; t < num; t++) {
+        if (login && login[t] != BMC_SUCCESS) {
+            fprintf(stderr, "Warning: %s: session setup failed, not sampled\n",
+                    ipmi_engine_target_host(eng, t));
+            ipmi_power_sampler_disable_target(sampler, t);
+        }
+    }
+    free(login);
+    
+    // ring 裡的樣本在 Ctrl-C 之後照樣寫出
+    install_stop_handler();
+    
+    uint64_t start = bmc_monotonic_us();
+    ipmi_power_sampler_run(sampler, sopts->count, &g_stop);
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    ipmi_power_stats_t stats;
+    ipmi_power_sampler_get_stats(sampler, &stats);
+    ipmi_power_sampler_destroy(sampler);
+    
+    print_sample_stats(&stats, num, elapsed_ms);
+    
+    if (ferror(stdout)) {
+        fprintf(stderr, "Error: Failed to write samples\n");
+        return 1;
+    }
+    
+    return 0;
+}
+
+int cli_power_sample(const char* host, const char* hosts_file, const cli_ipmi_opts_t* opts,
+                     const cli_sample_opts_t* sopts) {
+    if (sopts->interval_ms <= 0) {
+        fprintf(stderr, "Error: Invalid sample interval\n");
+        return 1;
+    }
+    if (sopts->format == IPMI_POWER_OUTPUT_BINARY && isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "Error: Refusing to write binary samples to a terminal\n");
+        return 1;
+    }
+    
+    ipmi_engine_t* eng;
+    ipmi_pool_t* pool;
+    ipmi_session_cache_t* cache;
+    int ret = 1;
+    
+    if (fleet_open(opts, &eng, &pool, &cache) == 0) {
+        ret = run_power_sample(eng, pool, host, hosts_file, opts, sopts);
+    }
+    
+    fleet_close(eng, pool, cache);
+    return ret;
+}
+
+// console 輸出可能有帳密，只給自己讀
+static int open_sol_log(const char* dir, const char* host, uint16_t port) {
+    char name[300];
+    int n = snprintf(name, sizeof(name), "%s-%u.log", host, port);
+    if (n < 0 || (size_t)n >= sizeof(name)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    
+    // hosts file 裡的 / 和 IPv6 位址的 : 之類換掉，不能寫到目錄外面
+    for (char* p = name; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '-' && *p != '.') {
+            *p = '_';
+        }
+    }
+    
+    char path[PATH_MAX];
+    n = snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if (n < 0 || (size_t)n >= sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    return open(path, O_WRONLY | O_CREAT | O_APPEND | O_NONBLOCK | O_CLOEXEC | O_NOFOLLOW, 0600);
+}
+
+static void print_sol_result(const ipmi_sol_mgr_t* mgr, int idx, int* ok, unsigned long* bytes) {
+    ipmi_sol_stats_t st;
+    char detail[160];
+    
+    ipmi_sol_mgr_get_stats(mgr, idx, &st);
+    *bytes += st.bytes;
+    
+    if (st.state == IPMI_SOL_STATE_FAILED) {
+        if (st.activate_cc) {
+            snprintf(detail, sizeof(detail), "Activate Payload failed (cc 0x%02x%s)", st.activate_cc,
+                     st.activate_cc == IPMI_CC_PAYLOAD_ACTIVE ? ", in use; try force" : "");
+        } else {
+            snprintf(detail, sizeof(detail), "%s", bmc_error_str(st.error));
+        }
+        print_result(ipmi_sol_mgr_host(mgr, idx), "FAIL", detail);
+        return;
+    }
+    
+    if (st.log_errno) {
+        snprintf(detail, sizeof(detail), "log write failed: %s", strerror(st.log_errno));
+        print_result(ipmi_sol_mgr_host(mgr, idx), "FAIL", detail);
+        return;
+    }
+    
+    snprintf(detail, sizeof(detail), "%lu bytes, %lu packets, %lu dup, %lu nack, %lu overrun, %lu writes",
+             st.bytes, st.packets, st.duplicates, st.nacks, st.overruns, st.writes);
+    (*ok)++;
+    print_result(ipmi_sol_mgr_host(mgr, idx), "OK", detail);
+}
+
+/*
+ * 所有 host 一起透過 pool 登入，session 交給 SOL manager；console 寫到 <dir>/<host>-<port>.log
+ * ctxs[i] 是借來的 ctx，manager 關掉之後才能還
+ */
+static int run_sol_capture(ipmi_sol_mgr_t* mgr, ipmi_pool_t* pool, const host_list_t* list,
+                           const cli_ipmi_opts_t* opts, const cli_sol_opts_t* sol,
+                           ipmi_ctx_t** ctxs, int* fds) {
+    ipmi_addr_t* addrs = calloc(list->count ? list->count : 1, sizeof(ipmi_addr_t));
+    if (!addrs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        return 1;
+    }
+    
+    int* errs = calloc(list->count ? list->count : 1, sizeof(int));
+    if (!errs) {
+        fprintf(stderr, "Error: Out of memory\n");
+        free(addrs);
+        return 1;
+    }
+    
+    // 解析完所有 session 一起握手
+    ipmi_resolve_bulk((const char* const*)list->hosts, list->ports, list->count, addrs);
+    int ret = ipmi_pool_acquire_bulk(pool, (const char* const*)list->hosts, addrs, list->count,
+                                     opts->username, opts->password, ctxs, errs);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        free(addrs);
+        free(errs);
+        return 1;
+    }
+    
+    for (size_t i = 0; i < list->count; i++) {
+        const char* host = list->hosts[i];
+        if (addrs[i].status != BMC_SUCCESS) {
+            fprintf(stderr, "Warning: cannot resolve '%s'\n", host);
+            continue;
+        }
+        if (!ctxs[i]) {
+            fprintf(stderr, "Warning: %s: session setup failed: %s\n", host, bmc_error_str(errs[i]));
+            continue;
+        }
+        
+        fds[i] = open_sol_log(sol->log_dir, host, list->ports[i] ? list->ports[i] : IPMI_DEFAULT_PORT);
+        if (fds[i] < 0) {
+            fprintf(stderr, "Warning: %s: cannot open log: %s\n", host, strerror(errno));
+            continue;
+        }
+        
+        int idx = ipmi_sol_mgr_add(mgr, host, &ctxs[i]->addr, &ctxs[i]->session, fds[i]);
+        if (idx < 0) {
+            fprintf(stderr, "Warning: %s: %s\n", host, bmc_error_str(idx));
+        }
+    }
+    free(addrs);
+    free(errs);
+    
+    int num = ipmi_sol_mgr_count(mgr);
+    if (num == 0) {
+        fprintf(stderr, "Error: No usable hosts\n");
+        return 1;
+    }
+    
+    install_stop_handler();
+    
+    uint64_t start = bmc_monotonic_us();
+    ipmi_sol_mgr_run(mgr, sol->duration_s > 0 ? sol->duration_s * 1000 : -1, &g_stop);
+    ipmi_sol_mgr_close(mgr);
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Host", "Status", "Detail"};
+        table_init(3, headers);
+        table_set_col_width(0, 32);
+        table_set_col_width(2, 64);
+        table_print_header();
+    }
+    
+    int ok = 0;
+    unsigned long bytes = 0;
+    for (int i = 0; i < num; i++) {
+        print_sol_result(mgr, i, &ok, &bytes);
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    }
+    
+    printf("\n%d/%d consoles captured in %llu ms, %lu bytes\n", ok, num,
+           (unsigned long long)elapsed_ms, bytes);
+    
+    return ok == num ? 0 : 1;
+}
+
+int cli_sol_capture(const char* host, const char* hosts_file, const cli_ipmi_opts_t* opts,
+                    const cli_sol_opts_t* sol) {
+    if (!opts->lanplus) {
+        fprintf(stderr, "Error: SOL requires -I lanplus\n");
+        return 1;
+    }
+    
+    if (mkdir(sol->log_dir, 0700) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Error: Cannot create '%s': %s\n", sol->log_dir, strerror(errno));
+        return 1;
+    }
+    
+    host_list_t list = {0};
+    int ret = hosts_file ? read_hosts(hosts_file, opts->port, &list) :
+                           host_list_add(&list, host, opts->port, 0);
+    if (ret != 0) {
+        host_list_free(&list);
+        return 1;
+    }
+    
+    ipmi_pool_t* pool = NULL;
+    ipmi_session_cache_t* cache = NULL;
+    ipmi_sol_mgr_t* mgr = ipmi_sol_mgr_create(0);
+    ipmi_ctx_t** ctxs = calloc(list.count ? list.count : 1, sizeof(*ctxs));
+    int* fds = malloc((list.count ? list.count : 1) * sizeof(int));
+    
+    ret = 1;
+    if (!mgr || !ctxs || !fds) {
+        fprintf(stderr, "Error: Out of memory\n");
+    } else if (pool_open(opts, &pool, &cache) == 0) {
+        for (size_t i = 0; i < list.count; i++) {
+            fds[i] = -1;
+        }
+        if (opts->timeout_ms > 0) {
+            ipmi_sol_mgr_set_timeout(mgr, opts->timeout_ms);
+        }
+        if (opts->retries >= 0) {
+            ipmi_sol_mgr_set_retries(mgr, opts->retries);
+        }
+        ipmi_sol_mgr_set_force(mgr, sol->force);
+        
+        ret = run_sol_capture(mgr, pool, &list, opts, sol, ctxs, fds);
+    }
+    
+    // manager 先關（它借用 session），再把 ctx 還給 pool
+    ipmi_sol_mgr_destroy(mgr);
+    for (size_t i = 0; ctxs && fds && i < list.count; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+        if (ctxs[i]) {
+            ipmi_pool_release(pool, ctxs[i]);
+        }
+    }
+    free(ctxs);
+    free(fds);
+    ipmi_pool_destroy(pool);
+    ipmi_session_cache_close(cache);
+    host_list_free(&list);
+    return ret;
+}
+
+/* ===== Redfish ===== */
+
+typedef struct {
+    int ok;
+    int failed;
+} redfish_fleet_state_t;
+
+static void redfish_fleet_done(redfish_multi_t* m, int target, int status,
+                               const redfish_system_t* system, void* user_data) {
+    redfish_fleet_state_t* st = user_data;
+    const char* url = redfish_multi_target_url(m, target);
+    char detail[512];
+    
+    if (status != BMC_SUCCESS) {
+        st->failed++;
+        print_result(url, "FAIL", bmc_error_str(status));
+        return;
+    }
+    
+    snprintf(detail, sizeof(detail), "power %s, %s %s, SN %s", system->power_state,
+             system->manufacturer, system->model, system->serial_number);
+    st->ok++;
+    print_result(url, "OK", detail);
+}
+
+int cli_redfish_fleet(const char* hosts_file, const cli_redfish_opts_t* opts, const char* cmd,
+                      const char* arg) {
+    if (strcmp(cmd, "system") != 0) {
+        fprintf(stderr, "Error: Only 'system' is supported with --hosts-file\n");
+        return 1;
+    }
+    
+    host_list_t list = {0};
+    if (read_hosts(hosts_file, opts->port ? opts->port : 443, &list) != 0) {
+        host_list_free(&list);
+        return 1;
+    }
+    
+    redfish_multi_t* m = redfish_multi_create();
+    if (!m) {
+        fprintf(stderr, "Error: Failed to create Redfish multi handle\n");
+        host_list_free(&list);
+        return 1;
+    }
+    if (opts->timeout_ms > 0) {
+        redfish_multi_set_timeout(m, opts->timeout_ms);
+    }
+    if (opts->max_per_host > 0) {
+        redfish_multi_set_max_per_host(m, opts->max_per_host);
+    }
+    
+    redfish_fleet_state_t st = {0};
+    for (size_t i = 0; i < list.count; i++) {
+        char url[256];
+        const char* fmt = strchr(list.hosts[i], ':') ? "https://[%s]" : "https://%s";
+        int len = snprintf(url, sizeof(url), fmt, list.hosts[i]);
+        if (list.ports[i] != 443 && len > 0 && (size_t)len < sizeof(url)) {
+            snprintf(url + len, sizeof(url) - (size_t)len, ":%u", list.ports[i]);
+        }
+        
+        int target = redfish_multi_add_target(m, url, opts->username, opts->password);
+        if (target < 0 || redfish_multi_get_system(m, target, arg, redfish_fleet_done, &st) != 0) {
+            fprintf(stderr, "Warning: %s:%d: cannot add '%s'\n", hosts_file, list.linenos[i],
+                    list.hosts[i]);
+        }
+    }
+    host_list_free(&list);
+    
+    int num = redfish_multi_num_targets(m);
+    if (num == 0) {
+        fprintf(stderr, "Error: No usable hosts in '%s'\n", hosts_file);
+        redfish_multi_destroy(m);
+        return 1;
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Host", "Status", "Detail"};
+        table_init(3, headers);
+        table_set_col_width(0, 32);
+        table_set_col_width(2, 60);
+        table_print_header();
+    }
+    
+    uint64_t start = bmc_monotonic_us();
+    redfish_multi_run(m, -1);
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    }
+    
+    printf("\n%d/%d hosts responded in %llu ms\n", st.ok, num, (unsigned long long)elapsed_ms);
+    
+    redfish_multi_stats_t stats;
+    redfish_multi_get_stats(m, &stats);
+    bmc_log(LOG_LEVEL_DEBUG, "requests=%lu failed=%lu connects=%lu http2=%lu bytes=%lu",
+            stats.requests, stats.failed, stats.connects, stats.http2, stats.bytes);
+    
+    redfish_multi_destroy(m);
+    return st.failed ? 1 : 0;
+}
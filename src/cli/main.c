@@ -1,9 +1,18 @@
 #include "bmctool/ipmi_context.h"
 #include "bmctool/ipmi_commands.h"
+#include "bmctool/ipmi_sdr.h"
+#include "bmctool/ipmi_sensor.h"
+#include "bmctool/ipmi_sel.h"
+#include "bmctool/ipmi_fru.h"
+#include "bmctool/ipmi_power.h"
+#include "bmctool/ipmi_engine.h"
 #include "bmctool/redfish.h"
+#include "cli.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <time.h>
 
 static void print_usage(const char* prog) {
     printf("Usage: %s [options] <protocol> <command>\n", prog);
@@ -11,8 +20,20 @@ static void print_usage(const char* prog) {
     printf("Options:\n");
     printf("  -H, --host <host>      BMC hostname or IP\n");
     printf("  -p, --port <port>      BMC port (IPMI: 623, Redfish: 443)\n");
-    printf("  -U, --user <user>      Username (Redfish)\n");
-    printf("  -P, --password <pass>  Password (Redfish)\n");
+    printf("  -U, --user <user>      Username (Redfish, IPMI lanplus)\n");
+    printf("  -P, --password <pass>  Password (Redfish, IPMI lanplus)\n");
+    printf("  -I, --interface <if>   IPMI interface: lan (IPMI 1.5, default), lanplus\n");
+    printf("  -C, --cipher <n>       RMCP+ cipher suite: 3 or 17 (default)\n");
+    printf("  -S, --session-cache    Reuse lanplus sessions / Redfish tokens across invocations\n");
+    printf("  -e, --etag-cache       Keep Redfish responses on disk and revalidate them with\n");
+    printf("                         If-None-Match on the next run\n");
+    printf("  -F, --hosts-file <f>   Run an IPMI or Redfish command on every host in file\n");
+    printf("  -t, --timeout <ms>     IPMI command timeout, including retries\n");
+    printf("  -R, --retries <n>      IPMI retransmissions per command\n");
+    printf("  -B, --batch-size <n>   Packets per sendmmsg/recvmmsg call (--hosts-file)\n");
+    printf("  -E, --io <backend>     Multi-host I/O: epoll (default), io_uring (IO_URING=1 builds)\n");
+    printf("  -D, --depth <n>        IPMI / Redfish requests in flight per BMC (default 8)\n");
+    printf("  -r, --rate <pps>       Presence Pings per second for discover (default 5000)\n");
     printf("  -f, --format <fmt>     Output format: normal, json, table\n");
     printf("  -v, --verbose          Verbose output\n");
     printf("  -h, --help             Show this help\n");
@@ -20,19 +41,47 @@ static void print_usage(const char* prog) {
     printf("Protocols:\n");
     printf("  ipmi                   Use IPMI protocol\n");
     printf("  redfish                Use Redfish protocol\n");
+    printf("  discover <cidr> [auth] Find BMCs on an IPv4 subnet (up to /16) with ASF\n");
+    printf("                         Presence Ping; auth also queries IPMI versions and\n");
+    printf("                         authentication types (no -H needed)\n");
     printf("\n");
     printf("IPMI Commands:\n");
     printf("  get-device-id          Get BMC device information\n");
     printf("  chassis-status         Get chassis power status\n");
+    printf("  sdr                    List SDR records (cached on disk)\n");
+    printf("  sensors                Read all sensors listed in the SDR\n");
+    printf("  sel [all]              Show SEL entries added since the last run\n");
+    printf("  fru [id]               Show FRU inventory (default FRU 0, cached)\n");
+    printf("  power                  Show DCMI power reading\n");
+    printf("  power-sample [ms] [n] [csv|bin]\n");
+    printf("                         Sample DCMI power every ms (default 1000) for n ticks\n");
+    printf("                         (default: until Ctrl-C), samples to stdout\n");
+    printf("  sol <dir> [seconds] [force]\n");
+    printf("                         Capture Serial-over-LAN consoles into <dir>/<host>-<port>.log\n");
+    printf("                         for seconds (default: until Ctrl-C); lanplus only\n");
     printf("\n");
     printf("Redfish Commands:\n");
     printf("  system <id>            Get system information\n");
     printf("  thermal <id>           Get thermal information\n");
+    printf("  systems                List all systems (one GET with $expand if supported)\n");
+    printf("  members <path> [props] Print every member of a collection as JSON;\n");
+    printf("                         props is a $select list, e.g. CapacityMiB,PartNumber\n");
     printf("\n");
     printf("Examples:\n");
     printf("  %s -H 192.168.1.100 ipmi get-device-id\n", prog);
+    printf("  %s -H 192.168.1.100 -I lanplus -U admin -P pwd ipmi chassis-status\n", prog);
     printf("  %s -H https://bmc.local -U admin -P pwd redfish system 1\n", prog);
     printf("  %s -H 192.168.1.100 -f table ipmi chassis-status\n", prog);
+    printf("  %s -F hosts.txt ipmi chassis-status\n", prog);
+    printf("  %s -H 192.168.1.100 -f table ipmi sdr\n", prog);
+    printf("  %s -H 192.168.1.100 -D 16 ipmi sensors\n", prog);
+    printf("  %s -H 192.168.1.100 ipmi sel\n", prog);
+    printf("  %s -H 192.168.1.100 ipmi fru\n", prog);
+    printf("  %s -F hosts.txt -I lanplus -U admin -P pwd ipmi power-sample 100 600 > power.csv\n", prog);
+    printf("  %s -F hosts.txt -I lanplus -U admin -P pwd ipmi sol /var/log/sol 3600\n", prog);
+    printf("  %s -F hosts.txt -U admin -P pwd redfish system 1\n", prog);
+    printf("  %s -H https://bmc.local -U admin -P pwd redfish members /redfish/v1/Systems/1/Memory\n", prog);
+    printf("  %s -r 20000 discover 10.20.0.0/16 auth\n", prog);
 }
 
 static void print_manufacturer(uint32_t mfg_id) {
@@ -150,6 +199,344 @@ static int cmd_ipmi_chassis_status(ipmi_ctx_t* ctx) {
     return 0;
 }
 
+static int cmd_ipmi_power(ipmi_ctx_t* ctx) {
+    ipmi_dcmi_power_t power;
+    
+    int ret = ipmi_dcmi_get_power_reading(ctx, &power);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    print_section_header("Power Reading");
+    
+    char temp[32];
+    snprintf(temp, sizeof(temp), "%u W", power.current_watts);
+    print_kv("Current", temp);
+    snprintf(temp, sizeof(temp), "%u W", power.min_watts);
+    print_kv("Minimum", temp);
+    snprintf(temp, sizeof(temp), "%u W", power.max_watts);
+    print_kv("Maximum", temp);
+    snprintf(temp, sizeof(temp), "%u W", power.avg_watts);
+    print_kv("Average", temp);
+    snprintf(temp, sizeof(temp), "%u ms", power.period_ms);
+    print_kv("Statistics Period", temp);
+    print_kv("Measurement", power.active ? "Active" : "Not active");
+    
+    return 0;
+}
+
+static const char* sdr_type_name(uint8_t type) {
+    switch (type) {
+        case IPMI_SDR_TYPE_FULL_SENSOR: return "Full";
+        case IPMI_SDR_TYPE_COMPACT_SENSOR: return "Compact";
+        case IPMI_SDR_TYPE_EVENT_ONLY: return "Event";
+        case IPMI_SDR_TYPE_FRU_LOCATOR: return "FRU";
+        case IPMI_SDR_TYPE_MC_LOCATOR: return "MC";
+        default: return "Other";
+    }
+}
+
+static int cmd_ipmi_sdr(ipmi_ctx_t* ctx) {
+    ipmi_sdr_repo_t repo;
+    
+    int ret = ipmi_sdr_load(ctx, NULL, &repo);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Name", "ID", "Type", "Sensor", "Kind", "Unit"};
+        table_init(6, headers);
+        table_set_col_width(0, IPMI_SDR_NAME_MAX);
+        table_set_col_width(1, 6);
+        table_set_col_width(2, 7);
+        table_set_col_width(4, 20);
+        table_set_col_width(5, 16);
+        table_print_header();
+        
+        for (size_t i = 0; i < repo.count; i++) {
+            const ipmi_sdr_record_t* rec = &repo.records[i];
+            char id[8];
+            char num[8];
+            snprintf(id, sizeof(id), "0x%04x", rec->record_id);
+            snprintf(num, sizeof(num), "0x%02x", rec->sensor_number);
+            
+            const char* row[6] = {
+                rec->name, id, sdr_type_name(rec->type), num,
+                rec->type <= IPMI_SDR_TYPE_EVENT_ONLY ?
+                    ipmi_sdr_sensor_type_name(rec->sensor_type) : "-",
+                rec->type <= IPMI_SDR_TYPE_COMPACT_SENSOR ?
+                    ipmi_sdr_unit_name(rec->base_unit) : "-"
+            };
+            table_print_row(row);
+        }
+        
+        table_print_footer();
+    } else {
+        print_section_header("SDR Repository");
+        
+        char temp[64];
+        snprintf(temp, sizeof(temp), "%zu%s", repo.count, repo.from_cache ? " (cached)" : "");
+        print_kv("Records", temp);
+        printf("\n");
+        
+        for (size_t i = 0; i < repo.count; i++) {
+            const ipmi_sdr_record_t* rec = &repo.records[i];
+            printf("%-16s  0x%04x  %-7s  0x%02x  %-20s  %s\n",
+                   rec->name, rec->record_id, sdr_type_name(rec->type), rec->sensor_number,
+                   rec->type <= IPMI_SDR_TYPE_EVENT_ONLY ?
+                       ipmi_sdr_sensor_type_name(rec->sensor_type) : "-",
+                   rec->type <= IPMI_SDR_TYPE_COMPACT_SENSOR ?
+                       ipmi_sdr_unit_name(rec->base_unit) : "-");
+        }
+    }
+    
+    ipmi_sdr_free(&repo);
+    return 0;
+}
+
+static void format_reading(const ipmi_sdr_record_t* rec, const ipmi_sensor_reading_t* r,
+                           char* value, size_t value_len, char* status, size_t status_len) {
+    if (r->status != IPMI_SENSOR_OK) {
+        snprintf(value, value_len, "na");
+        snprintf(status, status_len, "%s", r->status == IPMI_SENSOR_UNAVAILABLE ? "ns" : "error");
+    } else if (r->analog) {
+        snprintf(value, value_len, "%.3f %s", r->value,
+                 (rec->units1 & 0x01) ? "%" : ipmi_sdr_unit_name(rec->base_unit));
+        snprintf(status, status_len, "%s", ipmi_sensor_severity_name(r->severity));
+    } else {
+        snprintf(value, value_len, "0x%04x", r->state);
+        snprintf(status, status_len, "ok");
+    }
+}
+
+static int cmd_ipmi_sensors(ipmi_ctx_t* ctx) {
+    ipmi_sdr_repo_t repo;
+    ipmi_sensor_set_t set;
+    
+    int ret = ipmi_sdr_load(ctx, NULL, &repo);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    ret = ipmi_sensor_set_init(&set, &repo);
+    if (ret == BMC_SUCCESS) {
+        uint64_t start = bmc_monotonic_us();
+        ret = ipmi_sensor_read_all(ctx, &set);
+        bmc_log(LOG_LEVEL_DEBUG, "Read %zu sensors in %llu us", set.count,
+                (unsigned long long)(bmc_monotonic_us() - start));
+    }
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        ipmi_sensor_set_free(&set);
+        ipmi_sdr_free(&repo);
+        return 1;
+    }
+    
+    char value[48];
+    char status[16];
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Name", "Type", "Value", "Status"};
+        table_init(4, headers);
+        table_set_col_width(0, IPMI_SDR_NAME_MAX);
+        table_set_col_width(1, 20);
+        table_set_col_width(2, 24);
+        table_print_header();
+        
+        for (size_t i = 0; i < set.count; i++) {
+            const ipmi_sensor_reading_t* r = &set.readings[i];
+            const ipmi_sdr_record_t* rec = &repo.records[r->sdr_index];
+            format_reading(rec, r, value, sizeof(value), status, sizeof(status));
+            
+            const char* row[4] = {
+                rec->name, ipmi_sdr_sensor_type_name(rec->sensor_type), value, status
+            };
+            table_print_row(row);
+        }
+        
+        table_print_footer();
+    } else {
+        print_section_header("Sensors");
+        
+        for (size_t i = 0; i < set.count; i++) {
+            const ipmi_sensor_reading_t* r = &set.readings[i];
+            const ipmi_sdr_record_t* rec = &repo.records[r->sdr_index];
+            format_reading(rec, r, value, sizeof(value), status, sizeof(status));
+            printf("%-16s | %-20s | %s\n", rec->name, value, status);
+        }
+    }
+    
+    ipmi_sensor_set_free(&set);
+    ipmi_sdr_free(&repo);
+    return 0;
+}
+
+// SEL 時間戳：0xFFFFFFFF 是沒設，小於 0x20000000 是開機後的相對秒數
+static void format_sel_time(uint32_t ts, char* buf, size_t len) {
+    if (ts == 0xFFFFFFFF) {
+        snprintf(buf, len, "unspecified");
+    } else if (ts < 0x20000000) {
+        snprintf(buf, len, "pre-init +%us", ts);
+    } else {
+        time_t t = (time_t)ts;
+        strftime(buf, len, "%Y-%m-%d %H:%M:%S", localtime(&t));
+    }
+}
+
+static void format_sel_event(const ipmi_sel_entry_t* e, char* buf, size_t len) {
+    const char* name = e->event_type == 0x01 ?
+                       ipmi_sel_threshold_event_name(e->event_data[0] & 0x0F) : NULL;
+    if (name) {
+        snprintf(buf, len, "%s%s", name, e->deassertion ? " (deasserted)" : "");
+    } else {
+        snprintf(buf, len, "type 0x%02x offset 0x%x%s", e->event_type, e->event_data[0] & 0x0F,
+                 e->deassertion ? " (deasserted)" : "");
+    }
+}
+
+// 一筆一筆印出來，不等整個 SEL 讀完
+static int print_sel_entry(const ipmi_sel_entry_t* e, void* arg) {
+    int* count = arg;
+    char id[8];
+    char when[32];
+    char sensor[48];
+    char event[64];
+    
+    snprintf(id, sizeof(id), "0x%04x", e->record_id);
+    if (e->type == IPMI_SEL_TYPE_SYSTEM_EVENT) {
+        format_sel_time(e->timestamp, when, sizeof(when));
+        snprintf(sensor, sizeof(sensor), "%s #0x%02x",
+                 ipmi_sdr_sensor_type_name(e->sensor_type), e->sensor_number);
+        format_sel_event(e, event, sizeof(event));
+    } else {
+        if (e->type >= IPMI_SEL_TYPE_OEM_TS_FIRST && e->type <= IPMI_SEL_TYPE_OEM_TS_LAST) {
+            format_sel_time(e->timestamp, when, sizeof(when));
+        } else {
+            snprintf(when, sizeof(when), "-");
+        }
+        snprintf(sensor, sizeof(sensor), "OEM record 0x%02x", e->type);
+        snprintf(event, sizeof(event), "-");
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* row[4] = {id, when, sensor, event};
+        table_print_row(row);
+    } else {
+        printf("%s | %-19s | %-28s | %s\n", id, when, sensor, event);
+    }
+    fflush(stdout);
+    
+    (*count)++;
+    return 0;
+}
+
+static int cmd_ipmi_sel(ipmi_ctx_t* ctx, int all) {
+    int count = 0;
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"ID", "Time", "Sensor", "Event"};
+        table_init(4, headers);
+        table_set_col_width(0, 6);
+        table_set_col_width(1, 19);
+        table_set_col_width(2, 28);
+        table_set_col_width(3, 42);
+        table_print_header();
+    } else {
+        print_section_header(all ? "System Event Log" : "New SEL Entries");
+    }
+    
+    int ret = ipmi_sel_stream(ctx, NULL, all, print_sel_entry, &count);
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    } else if (count == 0 && ret == BMC_SUCCESS) {
+        printf("No new entries\n");
+    }
+    
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    return 0;
+}
+
+// 空的欄位不印
+static void fru_row(const char* key, const char* value) {
+    if (!value || !value[0]) {
+        return;
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* row[2] = {key, value};
+        table_print_row(row);
+    } else {
+        print_kv(key, value);
+    }
+}
+
+static int cmd_ipmi_fru(ipmi_ctx_t* ctx, uint8_t fru_id) {
+    ipmi_fru_t fru;
+    
+    int ret = ipmi_fru_load(ctx, fru_id, NULL, 0, &fru);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    char title[64];
+    snprintf(title, sizeof(title), "FRU Device %d%s", fru_id, fru.from_cache ? " (cached)" : "");
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"Property", "Value"};
+        table_init(2, headers);
+        table_set_col_width(0, 20);
+        table_set_col_width(1, IPMI_FRU_FIELD_MAX);
+        table_print_header();
+    } else {
+        print_section_header(title);
+    }
+    
+    if (fru.has_chassis) {
+        fru_row("Chassis Type", ipmi_fru_chassis_type_name(fru.chassis_type));
+        fru_row("Chassis Part", fru.chassis_part);
+        fru_row("Chassis Serial", fru.chassis_serial);
+    }
+    
+    if (fru.has_board) {
+        char date[32] = "";
+        if (fru.board_mfg_time) {
+            // 從 1996-01-01 00:00 UTC 起算的分鐘數
+            time_t t = 820454400 + (time_t)fru.board_mfg_time * 60;
+            strftime(date, sizeof(date), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+        }
+        fru_row("Board Mfg Date", date);
+        fru_row("Board Mfg", fru.board_mfg);
+        fru_row("Board Product", fru.board_product);
+        fru_row("Board Serial", fru.board_serial);
+        fru_row("Board Part", fru.board_part);
+    }
+    
+    if (fru.has_product) {
+        fru_row("Product Mfg", fru.product_mfg);
+        fru_row("Product Name", fru.product_name);
+        fru_row("Product Part", fru.product_part);
+        fru_row("Product Version", fru.product_version);
+        fru_row("Product Serial", fru.product_serial);
+        fru_row("Product Asset Tag", fru.product_asset);
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        table_print_footer();
+    }
+    
+    return 0;
+}
+
 static int cmd_redfish_system(redfish_ctx_t* ctx, const char* system_id) {
     redfish_system_t system;
     memset(&system, 0, sizeof(system));
@@ -188,11 +575,87 @@ static int cmd_redfish_thermal(redfish_ctx_t* ctx, const char* chassis_id) {
     return 0;
 }
 
+#define CLI_MAX_SYSTEMS     256
+
+static int cmd_redfish_systems(redfish_ctx_t* ctx) {
+    redfish_system_t* systems = calloc(CLI_MAX_SYSTEMS, sizeof(redfish_system_t));
+    if (!systems) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(BMC_ERROR_MEMORY));
+        return 1;
+    }
+    
+    size_t count = 0;
+    int ret = redfish_list_systems(ctx, systems, CLI_MAX_SYSTEMS, &count);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        free(systems);
+        return 1;
+    }
+    
+    if (g_output_format == OUTPUT_FORMAT_TABLE) {
+        const char* headers[] = {"ID", "Name", "Model", "Serial Number", "Power"};
+        table_init(5, headers);
+        table_set_col_width(0, 12);
+        table_set_col_width(1, 20);
+        table_set_col_width(2, 24);
+        table_set_col_width(3, 20);
+        table_set_col_width(4, 10);
+        table_print_header();
+        
+        for (size_t i = 0; i < count; i++) {
+            const redfish_system_t* sys = &systems[i];
+            const char* row[5] = {
+                sys->id, sys->name, sys->model, sys->serial_number, sys->power_state
+            };
+            table_print_row(row);
+        }
+        
+        table_print_footer();
+    } else {
+        print_section_header("Systems");
+        
+        for (size_t i = 0; i < count; i++) {
+            const redfish_system_t* sys = &systems[i];
+            printf("%-12s  %-20s  %-24s  %-20s  %s\n", sys->id, sys->name, sys->model,
+                   sys->serial_number, sys->power_state);
+        }
+    }
+    
+    free(systems);
+    return 0;
+}
+
+static void print_member(const char* json, void* user_data) {
+    (void)user_data;
+    printf("%s\n", json);
+}
+
+static int cmd_redfish_members(redfish_ctx_t* ctx, const char* path, const char* select) {
+    int ret = redfish_get_members(ctx, path, 1, select, print_member, NULL);
+    if (ret != BMC_SUCCESS) {
+        fprintf(stderr, "Error: %s\n", bmc_error_str(ret));
+        return 1;
+    }
+    
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     const char* host = NULL;
+    const char* hosts_file = NULL;
     uint16_t port = 0;
+    int timeout_ms = 0;
+    int retries = -1;
+    int batch_size = 0;
+    int io_backend = IPMI_ENGINE_IO_EPOLL;
+    int depth = CLI_DEFAULT_PIPELINE_DEPTH;
+    int rate = 0;
     const char* username = NULL;
     const char* password = NULL;
+    const char* interface = "lan";
+    int cipher_suite = 0;
+    int session_cache = 0;
+    int etag_cache = 0;
     int verbose = 0;
     const char* format = "normal";
     
@@ -201,6 +664,17 @@ int main(int argc, char* argv[]) {
         {"port",     required_argument, 0, 'p'},
         {"user",     required_argument, 0, 'U'},
         {"password", required_argument, 0, 'P'},
+        {"interface", required_argument, 0, 'I'},
+        {"cipher",   required_argument, 0, 'C'},
+        {"session-cache", no_argument,  0, 'S'},
+        {"etag-cache", no_argument,     0, 'e'},
+        {"hosts-file", required_argument, 0, 'F'},
+        {"timeout",  required_argument, 0, 't'},
+        {"retries",  required_argument, 0, 'R'},
+        {"batch-size", required_argument, 0, 'B'},
+        {"io",       required_argument, 0, 'E'},
+        {"depth",    required_argument, 0, 'D'},
+        {"rate",     required_argument, 0, 'r'},
         {"format",   required_argument, 0, 'f'},
         {"verbose",  no_argument,       0, 'v'},
         {"help",     no_argument,       0, 'h'},
@@ -208,7 +682,7 @@ int main(int argc, char* argv[]) {
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "H:p:U:P:f:vh", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "H:p:U:P:I:C:SeF:t:R:B:E:D:r:f:vh", long_options, NULL)) != -1) {
         switch (opt) {
             case 'H':
                 host = optarg;
@@ -222,6 +696,46 @@ int main(int argc, char* argv[]) {
             case 'P':
                 password = optarg;
                 break;
+            case 'I':
+                interface = optarg;
+                break;
+            case 'C':
+                cipher_suite = atoi(optarg);
+                break;
+            case 'S':
+                session_cache = 1;
+                break;
+            case 'e':
+                etag_cache = 1;
+                break;
+            case 'F':
+                hosts_file = optarg;
+                break;
+            case 't':
+                timeout_ms = atoi(optarg);
+                break;
+            case 'R':
+                retries = atoi(optarg);
+                break;
+            case 'B':
+                batch_size = atoi(optarg);
+                break;
+            case 'E':
+                if (strcmp(optarg, "io_uring") == 0 || strcmp(optarg, "uring") == 0) {
+                    io_backend = IPMI_ENGINE_IO_URING;
+                } else if (strcmp(optarg, "epoll") == 0) {
+                    io_backend = IPMI_ENGINE_IO_EPOLL;
+                } else {
+                    fprintf(stderr, "Error: Unknown I/O backend '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'D':
+                depth = atoi(optarg);
+                break;
+            case 'r':
+                rate = atoi(optarg);
+                break;
             case 'f':
                 format = optarg;
                 if (strcmp(format, "json") == 0) {
@@ -245,7 +759,10 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    if (!host) {
+    // discover 掃的是整個網段，不用 -H
+    int discover = optind < argc && strcmp(argv[optind], "discover") == 0;
+    
+    if (!host && !hosts_file && !discover) {
         fprintf(stderr, "Error: Host required\n\n");
         print_usage(argv[0]);
         return 1;
@@ -259,7 +776,32 @@ int main(int argc, char* argv[]) {
     
     const char* protocol = argv[optind];
     
-    if (strcmp(protocol, "ipmi") == 0) {
+    if (discover) {
+        if (optind + 1 >= argc) {
+            fprintf(stderr, "Error: Subnet (CIDR) required\n\n");
+            print_usage(argv[0]);
+            return 1;
+        }
+        
+        int probe_auth = 0;
+        if (optind + 2 < argc) {
+            if (strcmp(argv[optind + 2], "auth") != 0) {
+                fprintf(stderr, "Error: Unknown discover option '%s'\n", argv[optind + 2]);
+                return 1;
+            }
+            probe_auth = 1;
+        }
+        
+        cli_ipmi_opts_t opts = {
+            .port = port ? port : IPMI_DEFAULT_PORT,
+            .timeout_ms = timeout_ms,
+            .retries = retries,
+            .batch_size = batch_size,
+            .io_backend = io_backend
+        };
+        return cli_discover(argv[optind + 1], &opts, rate, probe_auth);
+        
+    } else if (strcmp(protocol, "ipmi") == 0) {
         if (optind + 1 >= argc) {
             fprintf(stderr, "Error: IPMI command required\n\n");
             print_usage(argv[0]);
@@ -272,6 +814,80 @@ int main(int argc, char* argv[]) {
             port = IPMI_DEFAULT_PORT;
         }
         
+        int lanplus = 0;
+        if (strcmp(interface, "lanplus") == 0) {
+            lanplus = 1;
+        } else if (strcmp(interface, "lan") != 0) {
+            fprintf(stderr, "Error: Unknown IPMI interface '%s'\n", interface);
+            return 1;
+        }
+        
+        if (lanplus && (!username || !password)) {
+            fprintf(stderr, "Error: lanplus requires -U and -P\n");
+            return 1;
+        }
+        
+        cli_ipmi_opts_t opts = {
+            .port = port,
+            .timeout_ms = timeout_ms,
+            .retries = retries,
+            .batch_size = batch_size,
+            .io_backend = io_backend,
+            .lanplus = lanplus,
+            .cipher_suite = cipher_suite,
+            .session_cache = session_cache,
+            .username = username,
+            .password = password
+        };
+        
+        // 取樣不管幾台都走 engine
+        if (strcmp(cmd, "power-sample") == 0) {
+            cli_sample_opts_t sopts = {
+                .interval_ms = CLI_DEFAULT_SAMPLE_INTERVAL_MS,
+                .count = 0,
+                .format = IPMI_POWER_OUTPUT_CSV
+            };
+            if (optind + 2 < argc) {
+                sopts.interval_ms = atoi(argv[optind + 2]);
+            }
+            if (optind + 3 < argc) {
+                sopts.count = strtoul(argv[optind + 3], NULL, 10);
+            }
+            if (optind + 4 < argc) {
+                if (strcmp(argv[optind + 4], "bin") == 0) {
+                    sopts.format = IPMI_POWER_OUTPUT_BINARY;
+                } else if (strcmp(argv[optind + 4], "csv") != 0) {
+                    fprintf(stderr, "Error: Unknown sample format '%s'\n", argv[optind + 4]);
+                    return 1;
+                }
+            }
+            return cli_power_sample(host, hosts_file, &opts, &sopts);
+        }
+        
+        if (strcmp(cmd, "sol") == 0) {
+            if (optind + 2 >= argc) {
+                fprintf(stderr, "Error: sol requires a log directory\n");
+                return 1;
+            }
+            cli_sol_opts_t sol = {
+                .log_dir = argv[optind + 2],
+                .duration_s = 0,
+                .force = 0
+            };
+            for (int i = optind + 3; i < argc; i++) {
+                if (strcmp(argv[i], "force") == 0) {
+                    sol.force = 1;
+                } else {
+                    sol.duration_s = atoi(argv[i]);
+                }
+            }
+            return cli_sol_capture(host, hosts_file, &opts, &sol);
+        }
+        
+        if (hosts_file) {
+            return cli_fleet_run(hosts_file, &opts, cmd);
+        }
+        
         ipmi_ctx_t* ctx = ipmi_ctx_create();
         if (!ctx) {
             fprintf(stderr, "Error: Failed to create IPMI context\n");
@@ -279,10 +895,35 @@ int main(int argc, char* argv[]) {
         }
         
         ipmi_ctx_set_target(ctx, host, port);
+        if (timeout_ms > 0) {
+            ipmi_ctx_set_timeout(ctx, timeout_ms);
+        }
+        if (retries >= 0) {
+            ipmi_ctx_set_retries(ctx, retries);
+        }
+        if (ipmi_ctx_set_pipeline_depth(ctx, depth) != BMC_SUCCESS) {
+            fprintf(stderr, "Error: Depth must be 1-%d\n", IPMI_SEQ_MAX_DEPTH);
+            ipmi_ctx_destroy(ctx);
+            return 1;
+        }
+        if (lanplus && (ipmi_ctx_set_auth(ctx, username, password) != BMC_SUCCESS ||
+                        ipmi_ctx_set_lanplus(ctx, cipher_suite, 0) != BMC_SUCCESS)) {
+            fprintf(stderr, "Error: Invalid lanplus settings\n");
+            ipmi_ctx_destroy(ctx);
+            return 1;
+        }
+        
+        // 快取開不起來就照常握手，不算錯
+        ipmi_session_cache_t* cache = NULL;
+        if (lanplus && session_cache) {
+            cache = ipmi_session_cache_open(NULL);
+            ipmi_ctx_set_session_cache(ctx, cache);
+        }
         
         if (ipmi_ctx_open(ctx) != BMC_SUCCESS) {
             fprintf(stderr, "Error: Failed to connect to %s:%d\n", host, port);
             ipmi_ctx_destroy(ctx);
+            ipmi_session_cache_close(cache);
             return 1;
         }
         
@@ -291,6 +932,18 @@ int main(int argc, char* argv[]) {
             ret = cmd_ipmi_get_device_id(ctx);
         } else if (strcmp(cmd, "chassis-status") == 0) {
             ret = cmd_ipmi_chassis_status(ctx);
+        } else if (strcmp(cmd, "sdr") == 0) {
+            ret = cmd_ipmi_sdr(ctx);
+        } else if (strcmp(cmd, "sensors") == 0) {
+            ret = cmd_ipmi_sensors(ctx);
+        } else if (strcmp(cmd, "sel") == 0) {
+            int all = optind + 2 < argc && strcmp(argv[optind + 2], "all") == 0;
+            ret = cmd_ipmi_sel(ctx, all);
+        } else if (strcmp(cmd, "fru") == 0) {
+            int fru_id = optind + 2 < argc ? atoi(argv[optind + 2]) : 0;
+            ret = cmd_ipmi_fru(ctx, (uint8_t)fru_id);
+        } else if (strcmp(cmd, "power") == 0) {
+            ret = cmd_ipmi_power(ctx);
         } else {
             fprintf(stderr, "Error: Unknown IPMI command '%s'\n", cmd);
             ret = 1;
@@ -298,6 +951,7 @@ int main(int argc, char* argv[]) {
         
         ipmi_ctx_close(ctx);
         ipmi_ctx_destroy(ctx);
+        ipmi_session_cache_close(cache);
         return ret;
         
     } else if (strcmp(protocol, "redfish") == 0) {
@@ -309,6 +963,26 @@ int main(int argc, char* argv[]) {
         
         const char* cmd = argv[optind + 1];
         
+        if (hosts_file) {
+            if (optind + 2 >= argc) {
+                fprintf(stderr, "Error: System ID required\n");
+                return 1;
+            }
+            cli_redfish_opts_t ropts = {
+                .port = port,
+                .timeout_ms = timeout_ms,
+                .max_per_host = depth,
+                .username = username,
+                .password = password
+            };
+            return cli_redfish_fleet(hosts_file, &ropts, cmd, argv[optind + 2]);
+        }
+        
+        if (!host) {
+            fprintf(stderr, "Error: Host required for Redfish\n");
+            return 1;
+        }
+        
         redfish_ctx_t* ctx = redfish_ctx_create();
         if (!ctx) {
             fprintf(stderr, "Error: Failed to create Redfish context\n");
@@ -321,6 +995,19 @@ int main(int argc, char* argv[]) {
             redfish_ctx_set_auth(ctx, username, password);
         }
         
+        redfish_token_cache_t* token_cache = NULL;
+        if (session_cache) {
+            token_cache = redfish_token_cache_open(NULL);
+            redfish_ctx_set_token_cache(ctx, token_cache);
+        }
+        
+        // 有指定才留在本機，下次帶 If-None-Match，沒變就不用重抓
+        redfish_cache_t* cache = etag_cache ? redfish_cache_create(0) : NULL;
+        if (cache) {
+            redfish_cache_load(cache, NULL);
+            redfish_ctx_set_cache(ctx, cache);
+        }
+        
         int ret = 0;
         if (strcmp(cmd, "system") == 0) {
             if (optind + 2 >= argc) {
@@ -336,12 +1023,32 @@ int main(int argc, char* argv[]) {
             } else {
                 ret = cmd_redfish_thermal(ctx, argv[optind + 2]);
             }
+        } else if (strcmp(cmd, "systems") == 0) {
+            ret = cmd_redfish_systems(ctx);
+        } else if (strcmp(cmd, "members") == 0) {
+            if (optind + 2 >= argc) {
+                fprintf(stderr, "Error: Collection path required\n");
+                ret = 1;
+            } else {
+                ret = cmd_redfish_members(ctx, argv[optind + 2],
+                                          optind + 3 < argc ? argv[optind + 3] : NULL);
+            }
         } else {
             fprintf(stderr, "Error: Unknown Redfish command '%s'\n", cmd);
             ret = 1;
         }
         
         redfish_ctx_destroy(ctx);
+        redfish_token_cache_close(token_cache);
+        
+        if (cache) {
+            redfish_cache_stats_t st;
+            redfish_cache_get_stats(cache, &st);
+            bmc_log(LOG_LEVEL_DEBUG, "Redfish cache: %lu not modified, %lu fetched, %zu entries",
+                    st.hits, st.misses, st.entries);
+            redfish_cache_save(cache, NULL);
+            redfish_cache_destroy(cache);
+        }
         return ret;
         
     } else {
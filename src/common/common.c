@@ -1,8 +1,13 @@
+#define _GNU_SOURCE
 #include "bmctool/common.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 log_level_t g_log_level = LOG_LEVEL_INFO;
 output_format_t g_output_format = OUTPUT_FORMAT_NORMAL;
@@ -69,3 +74,66 @@ void bmc_hexdump(const uint8_t* data, size_t len) {
         printf("|\n");
     }
 }
+
+// Monotonic clock，不受系統時間調整影響
+uint64_t bmc_monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// 一層一層建目錄（已經存在不算錯）
+static int mkdir_p(char* path, mode_t mode) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') {
+            continue;
+        }
+        *p = '\0';
+        int ret = mkdir(path, mode);
+        *p = '/';
+        if (ret < 0 && errno != EEXIST) {
+            return -1;
+        }
+    }
+    
+    return (mkdir(path, mode) < 0 && errno != EEXIST) ? -1 : 0;
+}
+
+int bmc_cache_path(const char* name, char* buf, size_t len) {
+    if (!name || !buf || len == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char dir[4096];
+    const char* env = getenv("BMCTOOL_CACHE_DIR");
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int n;
+    
+    if (env && *env) {
+        n = snprintf(dir, sizeof(dir), "%s", env);
+    } else if (xdg && *xdg) {
+        n = snprintf(dir, sizeof(dir), "%s/bmctool", xdg);
+    } else if (home && *home) {
+        n = snprintf(dir, sizeof(dir), "%s/.cache/bmctool", home);
+    } else {
+        bmc_log(LOG_LEVEL_ERROR, "No cache directory: set BMCTOOL_CACHE_DIR or HOME");
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    if (n < 0 || (size_t)n >= sizeof(dir)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // 快取裡會有 session 金鑰之類的東西，目錄只給自己
+    if (mkdir_p(dir, 0700) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "Cannot create cache directory %s: %s", dir, strerror(errno));
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    n = snprintf(buf, len, "%s/%s", dir, name);
+    if (n < 0 || (size_t)n >= len) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    return BMC_SUCCESS;
+}
@@ -25,6 +25,14 @@ void table_init(int num_cols, const char* headers[]) {
     }
 }
 
+// 串流輸出時沒辦法先看過所有資料，由呼叫端指定欄寬
+void table_set_col_width(int col, int width) {
+    if (col < 0 || col >= g_table.num_cols || width < g_table.col_widths[col]) {
+        return;
+    }
+    g_table.col_widths[col] = width;
+}
+
 void table_print_header(void) {
     // 上框線
     printf("┌");
@@ -95,4 +103,3 @@ void print_section_header(const char* title) {
     for (int i = 0; i < len + 2; i++) printf("═");
     printf("╝\n");
 }
-uchen
@@ -1,6 +1,50 @@
 #include "bmctool/ipmi_commands.h"
 #include <string.h>
 
+int ipmi_decode_device_id(const ipmi_rsp_view_t* rsp, ipmi_device_id_t* device_id) {
+    if (!rsp || !device_id) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // 檢查 completion code
+    if (rsp->data_len < 1) {
+        bmc_log(LOG_LEVEL_ERROR, "Response too short");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    uint8_t cc = rsp->data[0];
+    if (cc != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "Command failed: completion code 0x%02x", cc);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // 解析回應（最少需要 12 bytes：cc + 11 bytes data）
+    if (rsp->data_len < 12) {
+        bmc_log(LOG_LEVEL_ERROR, "Response data too short: %zu bytes", rsp->data_len);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // 填入結構
+    device_id->device_id = rsp->data[1];
+    device_id->device_revision = rsp->data[2] & 0x0F;
+    device_id->firmware_rev1 = rsp->data[3] & 0x7F;
+    device_id->firmware_rev2 = rsp->data[4];
+    device_id->ipmi_version = rsp->data[5];
+    device_id->additional_support = rsp->data[6];
+    
+    memcpy(device_id->manufacturer_id, &rsp->data[7], 3);
+    memcpy(device_id->product_id, &rsp->data[10], 2);
+    
+    // aux firmware rev 是 optional
+    if (rsp->data_len >= 16) {
+        memcpy(device_id->aux_firmware_rev, &rsp->data[12], 4);
+    } else {
+        memset(device_id->aux_firmware_rev, 0, 4);
+    }
+    
+    return BMC_SUCCESS;
+}
+
 int ipmi_cmd_get_device_id(ipmi_ctx_t* ctx, ipmi_device_id_t* device_id) {
     if (!ctx || !device_id) {
         return BMC_ERROR_INVALID_PARAM;
@@ -22,41 +66,34 @@ int ipmi_cmd_get_device_id(ipmi_ctx_t* ctx, ipmi_device_id_t* device_id) {
         return ret;
     }
     
-    // 檢查 completion code
-    if (rsp.data_len < 1) {
-        bmc_log(LOG_LEVEL_ERROR, "Response too short");
-        return BMC_ERROR_PROTOCOL;
+    ipmi_rsp_view_t view;
+    ipmi_msg_as_view(&rsp, &view);
+    
+    return ipmi_decode_device_id(&view, device_id);
+}
+
+int ipmi_decode_chassis_status(const ipmi_rsp_view_t* rsp, ipmi_chassis_status_t* status) {
+    if (!rsp || !status) {
+        return BMC_ERROR_INVALID_PARAM;
     }
     
-    uint8_t cc = rsp.data[0];
-    if (cc != 0x00) {
-        bmc_log(LOG_LEVEL_ERROR, "Command failed: completion code 0x%02x", cc);
+    // 檢查 completion code
+    if (rsp->data_len < 1 || rsp->data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "Command failed: completion code 0x%02x", 
+                rsp->data_len > 0 ? rsp->data[0] : 0xFF);
         return BMC_ERROR_PROTOCOL;
     }
     
-    // 解析回應（最少需要 12 bytes：cc + 11 bytes data）
-    if (rsp.data_len < 12) {
-        bmc_log(LOG_LEVEL_ERROR, "Response data too short: %zu bytes", rsp.data_len);
+    // 解析回應（至少需要 4 bytes）
+    if (rsp->data_len < 4) {
+        bmc_log(LOG_LEVEL_ERROR, "Response too short: %zu bytes", rsp->data_len);
         return BMC_ERROR_PROTOCOL;
     }
     
-    // 填入結構
-    device_id->device_id = rsp.data[1];
-    device_id->device_revision = rsp.data[2] & 0x0F;
-    device_id->firmware_rev1 = rsp.data[3] & 0x7F;
-    device_id->firmware_rev2 = rsp.data[4];
-    device_id->ipmi_version = rsp.data[5];
-    device_id->additional_support = rsp.data[6];
-    
-    memcpy(device_id->manufacturer_id, &rsp.data[7], 3);
-    memcpy(device_id->product_id, &rsp.data[10], 2);
-    
-    // aux firmware rev 是 optional
-    if (rsp.data_len >= 16) {
-        memcpy(device_id->aux_firmware_rev, &rsp.data[12], 4);
-    } else {
-        memset(device_id->aux_firmware_rev, 0, 4);
-    }
+    status->current_power_state = rsp->data[1];
+    status->last_power_event = rsp->data[2];
+    status->misc_chassis_state = rsp->data[3];
+    status->front_panel_button = (rsp->data_len >= 5) ? rsp->data[4] : 0;
     
     return BMC_SUCCESS;
 }
@@ -81,23 +118,70 @@ int ipmi_cmd_get_chassis_status(ipmi_ctx_t* ctx, ipmi_chassis_status_t* status)
         return ret;
     }
     
-    // 檢查 completion code
-    if (rsp.data_len < 1 || rsp.data[0] != 0x00) {
-        bmc_log(LOG_LEVEL_ERROR, "Command failed: completion code 0x%02x", 
-                rsp.data_len > 0 ? rsp.data[0] : 0xFF);
-        return BMC_ERROR_PROTOCOL;
-    }
+    ipmi_rsp_view_t view;
+    ipmi_msg_as_view(&rsp, &view);
     
-    // 解析回應（至少需要 4 bytes）
-    if (rsp.data_len < 4) {
-        bmc_log(LOG_LEVEL_ERROR, "Response too short: %zu bytes", rsp.data_len);
-        return BMC_ERROR_PROTOCOL;
+    return ipmi_decode_chassis_status(&view, status);
+}
+
+/* ===== 非同步版本 ===== */
+
+static void async_done(ipmi_async_t* op, int status) {
+    op->status = status;
+    op->done = 1;
+    
+    if (op->cb) {
+        op->cb(op, op->user_data);
+    }
+}
+
+static void on_device_id(ipmi_engine_t* eng, int target, int status,
+                         const ipmi_rsp_view_t* rsp, void* user_data) {
+    ipmi_async_t* op = user_data;
+    (void)eng;
+    (void)target;
+    
+    if (status == BMC_SUCCESS) {
+        status = ipmi_decode_device_id(rsp, &op->result.device_id);
+    }
+    async_done(op, status);
+}
+
+static void on_chassis_status(ipmi_engine_t* eng, int target, int status,
+                              const ipmi_rsp_view_t* rsp, void* user_data) {
+    ipmi_async_t* op = user_data;
+    (void)eng;
+    (void)target;
+    
+    if (status == BMC_SUCCESS) {
+        status = ipmi_decode_chassis_status(rsp, &op->result.chassis_status);
+    }
+    async_done(op, status);
+}
+
+static int async_submit(ipmi_engine_t* eng, int target, uint8_t netfn, uint8_t cmd,
+                        ipmi_engine_cb engine_cb, ipmi_async_t* op,
+                        ipmi_async_cb cb, void* user_data) {
+    if (!eng || !op) {
+        return BMC_ERROR_INVALID_PARAM;
     }
     
-    status->current_power_state = rsp.data[1];
-    status->last_power_event = rsp.data[2];
-    status->misc_chassis_state = rsp.data[3];
-    status->front_panel_button = (rsp.data_len >= 5) ? rsp.data[4] : 0;
+    memset(op, 0, sizeof(*op));
+    op->target = target;
+    op->cb = cb;
+    op->user_data = user_data;
     
-    return BMC_SUCCESS;
+    return ipmi_engine_submitv(eng, target, netfn, cmd, NULL, 0, engine_cb, op);
+}
+
+int ipmi_cmd_get_device_id_async(ipmi_engine_t* eng, int target, ipmi_async_t* op,
+                                 ipmi_async_cb cb, void* user_data) {
+    return async_submit(eng, target, IPMI_NETFN_APP, IPMI_CMD_GET_DEVICE_ID,
+                        on_device_id, op, cb, user_data);
+}
+
+int ipmi_cmd_get_chassis_status_async(ipmi_engine_t* eng, int target, ipmi_async_t* op,
+                                      ipmi_async_cb cb, void* user_data) {
+    return async_submit(eng, target, IPMI_NETFN_CHASSIS, 0x01,  // Get Chassis Status
+                        on_chassis_status, op, cb, user_data);
 }
@@ -1,13 +1,14 @@
 #include "bmctool/ipmi_context.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <netdb.h>
 #include <errno.h>
-#include <sys/time.h>
+#include <poll.h>
 
 ipmi_ctx_t* ipmi_ctx_create(void) {
     ipmi_ctx_t* ctx = calloc(1, sizeof(ipmi_ctx_t));
@@ -20,6 +21,10 @@ ipmi_ctx_t* ipmi_ctx_create(void) {
     ctx->seq = 1;
     ctx->timeout_ms = 5000;  // 5 秒
     ctx->retries = 3;
+    ctx->pipeline_depth = 1;
+    ctx->cipher_suite = 17;
+    ctx->privilege = IPMI_PRIV_ADMIN;
+    ipmi_rtt_init(&ctx->rtt);
     
     return ctx;
 }
@@ -29,10 +34,10 @@ void ipmi_ctx_destroy(ipmi_ctx_t* ctx) {
         return;
     }
     
-    if (ctx->sockfd >= 0) {
-        close(ctx->sockfd);
-    }
+    ipmi_ctx_close(ctx);
     
+    // 密碼不要留在釋放掉的記憶體裡
+    memset(ctx->password, 0, sizeof(ctx->password));
     free(ctx);
 }
 
@@ -48,6 +53,31 @@ int ipmi_ctx_set_target(ipmi_ctx_t* ctx, const char* host, uint16_t port) {
         ctx->port = port;
     }
     
+    // 換了目標，之前解析的位址作廢
+    ctx->addr.addrlen = 0;
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_set_target_addr(ipmi_ctx_t* ctx, const char* host, const ipmi_addr_t* addr) {
+    if (!ctx || !addr || addr->addrlen == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (host) {
+        strncpy(ctx->host, host, sizeof(ctx->host) - 1);
+        ctx->host[sizeof(ctx->host) - 1] = '\0';
+    } else {
+        ipmi_addr_str(addr, ctx->host, sizeof(ctx->host));
+    }
+    
+    ctx->addr = *addr;
+    if (addr->addr.ss_family == AF_INET6) {
+        ctx->port = ntohs(((const struct sockaddr_in6*)&addr->addr)->sin6_port);
+    } else {
+        ctx->port = ntohs(((const struct sockaddr_in*)&addr->addr)->sin_port);
+    }
+    
     return BMC_SUCCESS;
 }
 
@@ -60,33 +90,608 @@ int ipmi_ctx_set_timeout(ipmi_ctx_t* ctx, int timeout_ms) {
     return BMC_SUCCESS;
 }
 
-int ipmi_ctx_open(ipmi_ctx_t* ctx) {
+int ipmi_ctx_set_retries(ipmi_ctx_t* ctx, int retries) {
+    if (!ctx || retries < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->retries = retries;
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_set_pipeline_depth(ipmi_ctx_t* ctx, int depth) {
+    if (!ctx || depth <= 0 || depth > IPMI_SEQ_MAX_DEPTH) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->pipeline_depth = depth;
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_set_auth(ipmi_ctx_t* ctx, const char* username, const char* password) {
+    if (!ctx || !username || !password) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // RAKP 的 username 最長 16，K_UID 是 20 bytes
+    if (strlen(username) > IPMI_SESSION_USERNAME_MAX ||
+        strlen(password) > IPMI_SESSION_PASSWORD_LEN) {
+        bmc_log(LOG_LEVEL_ERROR, "IPMI username max %d, password max %d characters",
+                IPMI_SESSION_USERNAME_MAX, IPMI_SESSION_PASSWORD_LEN);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    strncpy(ctx->username, username, sizeof(ctx->username) - 1);
+    strncpy(ctx->password, password, sizeof(ctx->password) - 1);
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_set_lanplus(ipmi_ctx_t* ctx, int cipher_suite, uint8_t privilege) {
     if (!ctx) {
         return BMC_ERROR_INVALID_PARAM;
     }
     
-    if (ctx->sockfd >= 0) {
-        bmc_log(LOG_LEVEL_WARN, "Socket already open");
-        return BMC_SUCCESS;
+    if (cipher_suite == 0) {
+        cipher_suite = 17;
+    }
+    if (cipher_suite != 3 && cipher_suite != 17) {
+        bmc_log(LOG_LEVEL_ERROR, "Unsupported cipher suite %d (use 3 or 17)", cipher_suite);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    if (privilege > IPMI_PRIV_ADMIN) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->lanplus = 1;
+    ctx->cipher_suite = cipher_suite;
+    ctx->privilege = privilege ? privilege : IPMI_PRIV_ADMIN;
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_set_session_cache(ipmi_ctx_t* ctx, ipmi_session_cache_t* cache) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->session_cache = cache;
+    return BMC_SUCCESS;
+}
+
+/*
+ * 從快取借 session；閒置超過 RESUME_PING_US 的先 ping 一下，
+ * BMC 可能已經把它關掉了（重開機、被別的工具擠掉）
+ * 回傳 1 表示接續成功，0 表示要重新握手
+ */
+#define RESUME_PING_US  (5 * 1000000ULL)
+
+static int resume_session(ipmi_ctx_t* ctx) {
+    ipmi_session_cache_key(ctx->host, ctx->port, ctx->username, ctx->password,
+                           ctx->cipher_suite, ctx->privilege, &ctx->session_key);
+    
+    if (ipmi_session_cache_checkout(ctx->session_cache, &ctx->session_key, &ctx->session) != 1) {
+        return 0;
+    }
+    
+    if (bmc_monotonic_us() - ctx->session.last_used_us > RESUME_PING_US) {
+        ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = IPMI_CMD_GET_DEVICE_ID };
+        ipmi_msg_t rsp;
+        int retries = ctx->retries;
+        
+        // 失敗就重新握手，不用等滿所有重送
+        ctx->retries = 0;
+        int ret = ipmi_send_recv(ctx, &req, &rsp);
+        ctx->retries = retries;
+        
+        if (ret != BMC_SUCCESS) {
+            bmc_log(LOG_LEVEL_DEBUG, "Cached session 0x%08x is gone", ctx->session.bmc_id);
+            ipmi_session_cache_drop(ctx->session_cache, &ctx->session_key, ctx->session.bmc_id);
+            ipmi_session_clear(&ctx->session);
+            ctx->session_stale = 0;
+            return 0;
+        }
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Resumed RMCP+ session 0x%08x from cache", ctx->session.bmc_id);
+    ctx->session_resumed = 1;
+    return 1;
+}
+
+/*
+ * RMCP+ 握手：Open Session -> RAKP1/2 -> RAKP3/4，再把 privilege 拉到要求的等級
+ * 每一步都依 RTT 估計重送，BMC 回錯誤狀態就直接失敗
+ */
+static int open_session(ipmi_ctx_t* ctx) {
+    ipmi_session_t* s = &ctx->session;
+    ipmi_handshake_t hs;
+    uint8_t req[IPMI_LANPLUS_MAX_LEN];
+    uint8_t rsp[IPMI_LANPLUS_MAX_LEN];
+    size_t req_len;
+    size_t rsp_len;
+    
+    int ret = ipmi_session_init(s, ctx->cipher_suite, ctx->privilege);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    ret = ipmi_handshake_init(&hs, ctx->username, ctx->password);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    req_len = sizeof(req);
+    ret = ipmi_session_build_open(s, &hs, req, &req_len);
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_ctx_exchange(ctx, req, req_len, IPMI_PAYLOAD_OPEN_SESSION_RSP, hs.tag,
+                                rsp, sizeof(rsp), &rsp_len);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_session_parse_open(s, &hs, rsp, rsp_len);
+    }
+    
+    if (ret == BMC_SUCCESS) {
+        hs.tag++;
+        req_len = sizeof(req);
+        ret = ipmi_session_build_rakp1(s, &hs, req, &req_len);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_ctx_exchange(ctx, req, req_len, IPMI_PAYLOAD_RAKP2, hs.tag,
+                                rsp, sizeof(rsp), &rsp_len);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_session_parse_rakp2(s, &hs, rsp, rsp_len);
+    }
+    
+    if (ret == BMC_SUCCESS) {
+        hs.tag++;
+        req_len = sizeof(req);
+        ret = ipmi_session_build_rakp3(s, &hs, req, &req_len);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_ctx_exchange(ctx, req, req_len, IPMI_PAYLOAD_RAKP4, hs.tag,
+                                rsp, sizeof(rsp), &rsp_len);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_session_parse_rakp4(s, &hs, rsp, rsp_len);
+    }
+    
+    ipmi_handshake_clear(&hs);
+    
+    if (ret != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "RMCP+ session setup with %s failed", ctx->host);
+        ipmi_session_clear(s);
+        return ret;
+    }
+    
+    // Session 一開始是 USER，要 ADMIN/OPERATOR 得另外要
+    if (s->privilege > IPMI_PRIV_USER) {
+        ipmi_msg_t priv_req = {
+            .netfn = IPMI_NETFN_APP,
+            .cmd = IPMI_CMD_SET_SESSION_PRIV,
+            .data = { s->privilege },
+            .data_len = 1
+        };
+        ipmi_msg_t priv_rsp;
+        
+        ret = ipmi_send_recv(ctx, &priv_req, &priv_rsp);
+        if (ret == BMC_SUCCESS && (priv_rsp.data_len < 1 || priv_rsp.data[0] != 0x00)) {
+            bmc_log(LOG_LEVEL_ERROR, "Set Session Privilege Level failed: completion code 0x%02x",
+                    priv_rsp.data_len ? priv_rsp.data[0] : 0xFF);
+            ret = BMC_ERROR_PROTOCOL;
+        }
+        if (ret != BMC_SUCCESS) {
+            ipmi_session_clear(s);
+            return ret;
+        }
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "RMCP+ session 0x%08x open (cipher suite %d)",
+            s->bmc_id, s->cipher_suite);
+    return BMC_SUCCESS;
+}
+
+// 解析（第一次才做）、建 socket、connect() 到 BMC；不握手
+static int open_socket(ipmi_ctx_t* ctx) {
+    // 只在第一次 open 時解析，之後重開直接用快取的位址
+    if (ctx->addr.addrlen == 0) {
+        int ret = ipmi_resolve(ctx->host, ctx->port, &ctx->addr);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
     }
     
     // 建立 UDP socket
-    ctx->sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    ctx->sockfd = socket(ctx->addr.addr.ss_family, SOCK_DGRAM, 0);
     if (ctx->sockfd < 0) {
         bmc_log(LOG_LEVEL_ERROR, "socket() failed: %s", strerror(errno));
         return BMC_ERROR_NETWORK;
     }
     
-    // 設定 timeout
-    struct timeval tv;
-    tv.tv_sec = ctx->timeout_ms / 1000;
-    tv.tv_usec = (ctx->timeout_ms % 1000) * 1000;
+    // connect() 之後 kernel 只收這台 BMC 的封包，送收也不用每次帶位址
+    if (connect(ctx->sockfd, (const struct sockaddr*)&ctx->addr.addr, ctx->addr.addrlen) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "connect() failed: %s", strerror(errno));
+        close(ctx->sockfd);
+        ctx->sockfd = -1;
+        return BMC_ERROR_NETWORK;
+    }
+    
+    // Timeout 和重送由 ipmi_send_recv 依 RTT 估計自己處理，不用 SO_RCVTIMEO
     
-    if (setsockopt(ctx->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
-        bmc_log(LOG_LEVEL_WARN, "setsockopt() failed: %s", strerror(errno));
+    char addr_str[INET6_ADDRSTRLEN + 8];
+    bmc_log(LOG_LEVEL_DEBUG, "Socket opened: fd=%d, peer=%s", ctx->sockfd,
+            ipmi_addr_str(&ctx->addr, addr_str, sizeof(addr_str)));
+    
+    ctx->session_resumed = 0;
+    ctx->session_stale = 0;
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_open(ipmi_ctx_t* ctx) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (ctx->sockfd >= 0) {
+        bmc_log(LOG_LEVEL_WARN, "Socket already open");
+        return BMC_SUCCESS;
     }
     
-    bmc_log(LOG_LEVEL_DEBUG, "Socket opened: fd=%d", ctx->sockfd);
+    int ret = open_socket(ctx);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (ctx->lanplus && !(ctx->session_cache && resume_session(ctx))) {
+        ret = open_session(ctx);
+        if (ret != BMC_SUCCESS) {
+            close(ctx->sockfd);
+            ctx->sockfd = -1;
+            return ret;
+        }
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/*
+ * 多台一起握手
+ *
+ * 每台 BMC 一個狀態（Open Session -> RAKP1 -> RAKP3 -> Set Session Privilege），
+ * 所有 socket 放進同一個 poll()：收到回應就往下一步，逾時依各自的 RTT 估計重送。
+ * 握手的內容和 open_session 一樣，只是不會一台卡住其他台。
+ */
+enum {
+    BULK_OPEN,               // 等 Open Session Response
+    BULK_RAKP1,              // 等 RAKP2
+    BULK_RAKP3,              // 等 RAKP4
+    BULK_PRIV,               // 等 Set Session Privilege Level 的回應
+    BULK_DONE
+};
+
+typedef struct {
+    ipmi_ctx_t* ctx;
+    ipmi_handshake_t hs;
+    int state;
+    int status;              // BULK_DONE 時的結果
+    uint8_t pkt[IPMI_LANPLUS_MAX_LEN];
+    size_t pkt_len;
+    uint8_t seq;             // BULK_PRIV 的 rqSeq
+    int attempts;            // 這一步已經重送幾次
+    uint64_t sent_us;
+    uint64_t retry_us;       // 下次重送（或放棄）的時間
+    uint64_t deadline_us;    // 這一步的總 timeout
+} bulk_hs_t;
+
+static void bulk_finish(bulk_hs_t* b, int status) {
+    ipmi_ctx_t* ctx = b->ctx;
+    
+    ipmi_handshake_clear(&b->hs);
+    b->state = BULK_DONE;
+    b->status = status;
+    
+    if (status != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "RMCP+ session setup with %s failed", ctx->host);
+        ipmi_session_clear(&ctx->session);
+        close(ctx->sockfd);
+        ctx->sockfd = -1;
+        return;
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "RMCP+ session 0x%08x open with %s (cipher suite %d)",
+            ctx->session.bmc_id, ctx->host, ctx->session.cipher_suite);
+}
+
+// Set Session Privilege Level 每次送出都要新的 session seq，重送時也重新包
+static int bulk_build_priv(bulk_hs_t* b) {
+    ipmi_session_t* s = &b->ctx->session;
+    uint8_t data = s->privilege;
+    struct iovec iov = { .iov_base = &data, .iov_len = 1 };
+    uint8_t plain[IPMI_REQ_MAX_LEN];
+    size_t plain_len = sizeof(plain);
+    
+    int ret = ipmi_req_build(ipmi_req_tmpl_get(IPMI_NETFN_APP, IPMI_CMD_SET_SESSION_PRIV),
+                             b->seq, &iov, 1, plain, &plain_len);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    b->pkt_len = sizeof(b->pkt);
+    return ipmi_session_wrap(s, plain + IPMI_REQ_MSG_LEN_OFF + 1, plain[IPMI_REQ_MSG_LEN_OFF],
+                             b->pkt, &b->pkt_len);
+}
+
+static void bulk_send(bulk_hs_t* b, uint64_t now) {
+    ipmi_ctx_t* ctx = b->ctx;
+    
+    if (b->state == BULK_PRIV) {
+        int ret = bulk_build_priv(b);
+        if (ret != BMC_SUCCESS) {
+            bulk_finish(b, ret);
+            return;
+        }
+    }
+    
+    if (send(ctx->sockfd, b->pkt, b->pkt_len, 0) != (ssize_t)b->pkt_len) {
+        bmc_log(LOG_LEVEL_ERROR, "send() to %s failed: %s", ctx->host, strerror(errno));
+        bulk_finish(b, BMC_ERROR_NETWORK);
+        return;
+    }
+    
+    b->sent_us = now;
+    b->retry_us = now + ipmi_rtt_rto(&ctx->rtt);
+    if (b->retry_us > b->deadline_us) {
+        b->retry_us = b->deadline_us;
+    }
+}
+
+// 進到下一步：建好這一步的封包送出去，重送計數和 timeout 重新算
+static void bulk_step(bulk_hs_t* b, int state, uint64_t now) {
+    ipmi_ctx_t* ctx = b->ctx;
+    int ret = BMC_SUCCESS;
+    
+    b->state = state;
+    b->attempts = 0;
+    b->deadline_us = now + (uint64_t)ctx->timeout_ms * 1000;
+    b->pkt_len = sizeof(b->pkt);
+    
+    switch (state) {
+        case BULK_OPEN:
+            ret = ipmi_session_build_open(&ctx->session, &b->hs, b->pkt, &b->pkt_len);
+            break;
+        case BULK_RAKP1:
+            b->hs.tag++;
+            ret = ipmi_session_build_rakp1(&ctx->session, &b->hs, b->pkt, &b->pkt_len);
+            break;
+        case BULK_RAKP3:
+            b->hs.tag++;
+            ret = ipmi_session_build_rakp3(&ctx->session, &b->hs, b->pkt, &b->pkt_len);
+            break;
+        case BULK_PRIV:
+            // Session 一開始是 USER，要 ADMIN/OPERATOR 得另外要
+            b->seq = ctx->seq;
+            ctx->seq = (ctx->seq + 1) & 0x3F;
+            break;
+        default:
+            break;
+    }
+    
+    if (ret != BMC_SUCCESS) {
+        bulk_finish(b, ret);
+        return;
+    }
+    
+    bulk_send(b, now);
+}
+
+// 這一步的回應：payload type / tag（握手）或 seq / cmd（privilege）對不上的丟掉
+static void bulk_recv(bulk_hs_t* b, uint8_t* buf, size_t len, uint64_t now) {
+    static const uint8_t rsp_type[] = {
+        [BULK_OPEN] = IPMI_PAYLOAD_OPEN_SESSION_RSP,
+        [BULK_RAKP1] = IPMI_PAYLOAD_RAKP2,
+        [BULK_RAKP3] = IPMI_PAYLOAD_RAKP4,
+    };
+    ipmi_ctx_t* ctx = b->ctx;
+    ipmi_session_t* s = &ctx->session;
+    int ret;
+    
+    if (b->state == BULK_PRIV) {
+        ipmi_rsp_view_t view;
+        if (ipmi_session_unwrap(s, buf, len, &view) != BMC_SUCCESS ||
+            view.seq != b->seq || view.cmd != IPMI_CMD_SET_SESSION_PRIV) {
+            bmc_log(LOG_LEVEL_DEBUG, "Dropping unexpected packet from %s", ctx->host);
+            return;
+        }
+        if (b->attempts == 0) {
+            ipmi_rtt_sample(&ctx->rtt, (uint32_t)(now - b->sent_us));
+        }
+        if (view.data_len < 1 || view.data[0] != 0x00) {
+            bmc_log(LOG_LEVEL_ERROR, "Set Session Privilege Level failed: completion code 0x%02x",
+                    view.data_len ? view.data[0] : 0xFF);
+            bulk_finish(b, BMC_ERROR_PROTOCOL);
+            return;
+        }
+        bulk_finish(b, BMC_SUCCESS);
+        return;
+    }
+    
+    if (!ipmi_session_is_payload(buf, len, rsp_type[b->state], b->hs.tag)) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping unexpected handshake packet from %s", ctx->host);
+        return;
+    }
+    if (b->attempts == 0) {
+        ipmi_rtt_sample(&ctx->rtt, (uint32_t)(now - b->sent_us));
+    }
+    
+    switch (b->state) {
+        case BULK_OPEN:
+            ret = ipmi_session_parse_open(s, &b->hs, buf, len);
+            if (ret == BMC_SUCCESS) {
+                bulk_step(b, BULK_RAKP1, now);
+            }
+            break;
+        case BULK_RAKP1:
+            ret = ipmi_session_parse_rakp2(s, &b->hs, buf, len);
+            if (ret == BMC_SUCCESS) {
+                bulk_step(b, BULK_RAKP3, now);
+            }
+            break;
+        default:
+            ret = ipmi_session_parse_rakp4(s, &b->hs, buf, len);
+            if (ret == BMC_SUCCESS && s->privilege > IPMI_PRIV_USER) {
+                bulk_step(b, BULK_PRIV, now);
+            } else if (ret == BMC_SUCCESS) {
+                bulk_finish(b, BMC_SUCCESS);
+            }
+            break;
+    }
+    
+    if (ret != BMC_SUCCESS) {
+        bulk_finish(b, ret);
+    }
+}
+
+// socket 裡的封包全部收完
+static void bulk_drain(bulk_hs_t* b, uint64_t now) {
+    uint8_t buf[IPMI_LANPLUS_MAX_LEN];
+    
+    while (b->state != BULK_DONE) {
+        ssize_t n = recv(b->ctx->sockfd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            // connected UDP socket 會把 ICMP port unreachable 回報成 ECONNREFUSED
+            bmc_log(LOG_LEVEL_ERROR, "%s:%d: recv() failed: %s", b->ctx->host, b->ctx->port,
+                    strerror(errno));
+            bulk_finish(b, BMC_ERROR_NETWORK);
+            return;
+        }
+        
+        bulk_recv(b, buf, (size_t)n, now);
+    }
+}
+
+static void bulk_timeout(bulk_hs_t* b, uint64_t now) {
+    ipmi_ctx_t* ctx = b->ctx;
+    
+    ipmi_rtt_timeout(&ctx->rtt, b->sent_us, now);
+    
+    if (b->attempts >= ctx->retries || now >= b->deadline_us) {
+        bmc_log(LOG_LEVEL_ERROR, "%s: timeout waiting for handshake response", ctx->host);
+        bulk_finish(b, BMC_ERROR_TIMEOUT);
+        return;
+    }
+    
+    b->attempts++;
+    ctx->retransmits++;
+    bulk_send(b, now);
+}
+
+// 開 socket、試快取；要握手的送出第一個封包，回傳 1 表示還在握手
+static int bulk_start(bulk_hs_t* b, ipmi_ctx_t* ctx, uint64_t now) {
+    b->ctx = ctx;
+    b->state = BULK_DONE;
+    b->status = BMC_SUCCESS;
+    
+    if (ctx->sockfd >= 0) {
+        bmc_log(LOG_LEVEL_WARN, "Socket already open");
+        return 0;
+    }
+    
+    b->status = open_socket(ctx);
+    if (b->status != BMC_SUCCESS || !ctx->lanplus ||
+        (ctx->session_cache && resume_session(ctx))) {
+        return 0;
+    }
+    
+    b->status = ipmi_session_init(&ctx->session, ctx->cipher_suite, ctx->privilege);
+    if (b->status == BMC_SUCCESS) {
+        b->status = ipmi_handshake_init(&b->hs, ctx->username, ctx->password);
+    }
+    if (b->status != BMC_SUCCESS) {
+        close(ctx->sockfd);
+        ctx->sockfd = -1;
+        return 0;
+    }
+    
+    bulk_step(b, BULK_OPEN, now);
+    return b->state != BULK_DONE;
+}
+
+int ipmi_ctx_open_bulk(ipmi_ctx_t* const* ctxs, size_t count, int* status) {
+    if ((!ctxs || !status) && count > 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    bulk_hs_t* hs = calloc(count ? count : 1, sizeof(bulk_hs_t));
+    struct pollfd* pfds = calloc(count ? count : 1, sizeof(struct pollfd));
+    size_t* idx = calloc(count ? count : 1, sizeof(size_t));
+    if (!hs || !pfds || !idx) {
+        free(hs);
+        free(pfds);
+        free(idx);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    size_t active = 0;
+    uint64_t now = bmc_monotonic_us();
+    for (size_t i = 0; i < count; i++) {
+        active += (size_t)bulk_start(&hs[i], ctxs[i], now);
+    }
+    
+    while (active > 0) {
+        // 還在握手的 socket 和最早的重送時間
+        size_t n = 0;
+        uint64_t next = UINT64_MAX;
+        for (size_t i = 0; i < count; i++) {
+            if (hs[i].state == BULK_DONE) {
+                continue;
+            }
+            pfds[n] = (struct pollfd){ .fd = hs[i].ctx->sockfd, .events = POLLIN };
+            idx[n++] = i;
+            if (hs[i].retry_us < next) {
+                next = hs[i].retry_us;
+            }
+        }
+        
+        now = bmc_monotonic_us();
+        int wait_ms = next > now ? (int)((next - now + 999) / 1000) : 0;
+        if (poll(pfds, n, wait_ms) < 0 && errno != EINTR) {
+            bmc_log(LOG_LEVEL_ERROR, "poll() failed: %s", strerror(errno));
+            for (size_t k = 0; k < n; k++) {
+                bulk_finish(&hs[idx[k]], BMC_ERROR_NETWORK);
+            }
+            break;
+        }
+        
+        now = bmc_monotonic_us();
+        for (size_t k = 0; k < n; k++) {
+            bulk_hs_t* b = &hs[idx[k]];
+            if (pfds[k].revents) {
+                bulk_drain(b, now);
+            }
+            if (b->state != BULK_DONE && now >= b->retry_us) {
+                bulk_timeout(b, now);
+            }
+        }
+        
+        active = 0;
+        for (size_t k = 0; k < n; k++) {
+            active += hs[idx[k]].state != BULK_DONE;
+        }
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        status[i] = hs[i].status;
+    }
+    
+    free(hs);
+    free(pfds);
+    free(idx);
     return BMC_SUCCESS;
 }
 
@@ -95,8 +700,53 @@ void ipmi_ctx_close(ipmi_ctx_t* ctx) {
         return;
     }
     
+    // 有快取就把 session 留給下一個 process
+    if (ctx->session.active && ctx->session_cache && !ctx->session_stale &&
+        ipmi_session_cache_checkin(ctx->session_cache, &ctx->session_key,
+                                   &ctx->session) == BMC_SUCCESS) {
+        ipmi_session_clear(&ctx->session);
+    }
+    
+    if (ctx->session.active && ctx->session_resumed) {
+        ipmi_session_cache_drop(ctx->session_cache, &ctx->session_key, ctx->session.bmc_id);
+    }
+    
+    // 主動關掉 session 釋出 BMC 的 slot；只送一次不等回應，漏掉的 BMC 會自己 timeout
+    if (ctx->session.active) {
+        ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = IPMI_CMD_CLOSE_SESSION, .data_len = 4 };
+        
+        req.data[0] = ctx->session.bmc_id & 0xFF;
+        req.data[1] = (ctx->session.bmc_id >> 8) & 0xFF;
+        req.data[2] = (ctx->session.bmc_id >> 16) & 0xFF;
+        req.data[3] = (ctx->session.bmc_id >> 24) & 0xFF;
+        
+        ipmi_send_oneway(ctx, &req);
+        ipmi_session_clear(&ctx->session);
+    }
+    
     close(ctx->sockfd);
     ctx->sockfd = -1;
     
     bmc_log(LOG_LEVEL_DEBUG, "Socket closed");
 }
+
+int ipmi_ctx_cache_path(const ipmi_ctx_t* ctx, const char* prefix, char* buf, size_t len) {
+    if (!ctx || !prefix) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char name[300];
+    int n = snprintf(name, sizeof(name), "%s-%s-%u", prefix, ctx->host, ctx->port);
+    if (n < 0 || (size_t)n >= sizeof(name)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // hostname / IPv6 位址裡的特殊字元換掉
+    for (char* p = name; *p; p++) {
+        if (!isalnum((unsigned char)*p) && *p != '-' && *p != '.') {
+            *p = '_';
+        }
+    }
+    
+    return bmc_cache_path(name, buf, len);
+}
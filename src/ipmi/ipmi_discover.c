@@ -0,0 +1,549 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_discover.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#define ASF_PING_LEN            12      // RMCP(4) + IANA(4) + type + tag + reserved + data length
+#define ASF_PONG_DATA_LEN       16
+#define ASF_PONG_LEN            (ASF_PING_LEN + ASF_PONG_DATA_LEN)
+
+#define DISCOVER_BATCH          64
+#define DISCOVER_RX_LEN         64      // Presence Pong 只有 28 bytes，更長的一定不是
+#define DISCOVER_RCVBUF_SIZE    (4 * 1024 * 1024)
+#define DISCOVER_MAX_RATE       1000000
+#define DISCOVER_BLOCKED_WAIT_MS 100
+
+#define DISCOVER_DEFAULT_TIMEOUT_MS 1000
+#define DISCOVER_DEFAULT_ROUNDS     2
+
+#define CC_INVALID_DATA_FIELD   0xCC
+
+// Get Channel Authentication Capabilities：目前的 channel、ADMIN；bit 7 要 IPMI 2.0 的 extended 資料
+static const uint8_t g_auth_req[] = { 0x8E, 0x04 };
+static const uint8_t g_auth_req_v15[] = { 0x0E, 0x04 };
+
+typedef struct {
+    int fd;
+    uint16_t port;
+    uint32_t first;
+    uint32_t count;
+    uint64_t start_us;
+    uint32_t* sent_us;           // 每個位址最後一次送 ping 的時間（從 start_us 算）
+    uint8_t* seen;
+    size_t cap_hosts;
+    ipmi_discover_result_t* result;
+    
+    uint8_t ping[ASF_PING_LEN];
+    struct iovec tx_iov;
+    struct mmsghdr tx_msgs[DISCOVER_BATCH];
+    struct sockaddr_in tx_to[DISCOVER_BATCH];
+    uint32_t tx_idx[DISCOVER_BATCH];
+    
+    struct mmsghdr rx_msgs[DISCOVER_BATCH];
+    struct iovec rx_iov[DISCOVER_BATCH];
+    struct sockaddr_in rx_from[DISCOVER_BATCH];
+    uint8_t rx_bufs[DISCOVER_BATCH][DISCOVER_RX_LEN];
+} discover_scan_t;
+
+static uint32_t get_be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+int ipmi_discover_parse_cidr(const char* cidr, uint32_t* first, uint32_t* count) {
+    if (!cidr || !first || !count) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char ip[INET_ADDRSTRLEN];
+    const char* slash = strchr(cidr, '/');
+    size_t ip_len = slash ? (size_t)(slash - cidr) : strlen(cidr);
+    if (ip_len == 0 || ip_len >= sizeof(ip)) {
+        bmc_log(LOG_LEVEL_ERROR, "Invalid CIDR: %s", cidr);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    memcpy(ip, cidr, ip_len);
+    ip[ip_len] = '\0';
+    
+    struct in_addr in;
+    if (inet_pton(AF_INET, ip, &in) != 1) {
+        bmc_log(LOG_LEVEL_ERROR, "Invalid CIDR: %s (only IPv4 is supported)", cidr);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int prefix = 32;
+    if (slash) {
+        char* end;
+        long n = strtol(slash + 1, &end, 10);
+        if (end == slash + 1 || *end != '\0' || n < 0 || n > 32) {
+            bmc_log(LOG_LEVEL_ERROR, "Invalid CIDR prefix: %s", cidr);
+            return BMC_ERROR_INVALID_PARAM;
+        }
+        prefix = (int)n;
+    }
+    
+    if (prefix < IPMI_DISCOVER_MIN_PREFIX) {
+        bmc_log(LOG_LEVEL_ERROR, "CIDR %s is too large (at most /%d per scan)",
+                cidr, IPMI_DISCOVER_MIN_PREFIX);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    uint32_t host_bits = 32 - (uint32_t)prefix;
+    uint32_t mask = host_bits == 32 ? 0 : ~((1u << host_bits) - 1);
+    uint32_t net = ntohl(in.s_addr) & mask;
+    uint32_t size = 1u << host_bits;
+    
+    // /31、/32 沒有 network / broadcast 位址
+    if (host_bits >= 2) {
+        *first = net + 1;
+        *count = size - 2;
+    } else {
+        *first = net;
+        *count = size;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+static ipmi_discover_host_t* add_host(discover_scan_t* s) {
+    ipmi_discover_result_t* r = s->result;
+    
+    if (r->count == s->cap_hosts) {
+        size_t cap = s->cap_hosts ? s->cap_hosts * 2 : 64;
+        ipmi_discover_host_t* hosts = realloc(r->hosts, cap * sizeof(*hosts));
+        if (!hosts) {
+            return NULL;
+        }
+        r->hosts = hosts;
+        s->cap_hosts = cap;
+    }
+    
+    ipmi_discover_host_t* h = &r->hosts[r->count++];
+    memset(h, 0, sizeof(*h));
+    return h;
+}
+
+static void handle_pong(discover_scan_t* s, const uint8_t* buf, size_t len,
+                        const struct sockaddr_in* from, uint64_t now) {
+    uint32_t ip = ntohl(from->sin_addr.s_addr);
+    uint32_t idx = ip - s->first;
+    
+    if (from->sin_family != AF_INET || ntohs(from->sin_port) != s->port || idx >= s->count) {
+        s->result->invalid++;
+        return;
+    }
+    
+    if (len < ASF_PONG_LEN || buf[0] != RMCP_VERSION_1_0 || buf[3] != RMCP_CLASS_ASF ||
+        get_be32(buf + 4) != ASF_IANA || buf[8] != ASF_TYPE_PRESENCE_PONG ||
+        buf[11] < ASF_PONG_DATA_LEN) {
+        s->result->invalid++;
+        return;
+    }
+    
+    // 前一輪的 pong 晚到，這一輪又回一次
+    if (s->seen[idx]) {
+        return;
+    }
+    
+    ipmi_discover_host_t* h = add_host(s);
+    if (!h) {
+        bmc_log(LOG_LEVEL_ERROR, "Out of memory recording discovered hosts");
+        return;
+    }
+    s->seen[idx] = 1;
+    
+    h->ipv4 = ip;
+    inet_ntop(AF_INET, &from->sin_addr, h->host, sizeof(h->host));
+    h->rtt_us = (uint32_t)(now - s->start_us) - s->sent_us[idx];
+    h->iana = get_be32(buf + 12);
+    h->oem = get_be32(buf + 16);
+    h->entities = buf[20];
+    h->interactions = buf[21];
+    h->auth_status = IPMI_DISCOVER_NOT_PROBED;
+}
+
+// 把 socket 裡的 pong 收乾淨
+static void scan_drain(discover_scan_t* s) {
+    for (;;) {
+        for (int i = 0; i < DISCOVER_BATCH; i++) {
+            s->rx_msgs[i].msg_hdr.msg_namelen = sizeof(s->rx_from[i]);
+        }
+        
+        int n = recvmmsg(s->fd, s->rx_msgs, DISCOVER_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                bmc_log(LOG_LEVEL_WARN, "recvmmsg() failed: %s", strerror(errno));
+            }
+            return;
+        }
+        
+        uint64_t now = bmc_monotonic_us();
+        for (int i = 0; i < n; i++) {
+            handle_pong(s, s->rx_bufs[i], s->rx_msgs[i].msg_len, &s->rx_from[i], now);
+        }
+        
+        if (n < DISCOVER_BATCH) {
+            return;
+        }
+    }
+}
+
+/*
+ * 從 *next 開始，把還沒回應的位址最多 max 個排進一批用 sendmmsg 送出
+ * 回傳 1 表示 socket 滿了，*next 停在第一個沒送出去的位址
+ */
+static int scan_send(discover_scan_t* s, uint32_t* next, int max, unsigned long* sent) {
+    int n = 0;
+    uint32_t idx = *next;
+    
+    while (n < max && idx < s->count) {
+        if (!s->seen[idx]) {
+            s->tx_to[n].sin_addr.s_addr = htonl(s->first + idx);
+            s->tx_idx[n] = idx;
+            n++;
+        }
+        idx++;
+    }
+    *next = idx;
+    
+    if (n == 0) {
+        return 0;
+    }
+    
+    int done = sendmmsg(s->fd, s->tx_msgs, (unsigned int)n, 0);
+    uint32_t now = (uint32_t)(bmc_monotonic_us() - s->start_us);
+    
+    if (done < 0) {
+        int err = errno;
+        if (err == EINTR) {
+            *next = s->tx_idx[0];
+            return 0;
+        }
+        if (err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS) {
+            *next = s->tx_idx[0];
+            return 1;
+        }
+        
+        // 單一位址送不出去（例如路由不到），跳過它，其他的下次再排
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &s->tx_to[0].sin_addr, ip, sizeof(ip));
+        bmc_log(LOG_LEVEL_DEBUG, "sendmmsg(%s) failed: %s", ip, strerror(err));
+        *next = s->tx_idx[0] + 1;
+        return 0;
+    }
+    
+    for (int i = 0; i < done; i++) {
+        s->sent_us[s->tx_idx[i]] = now;
+    }
+    *sent += (unsigned long)done;
+    s->result->pings += (unsigned long)done;
+    
+    if (done < n) {
+        *next = s->tx_idx[done];
+    }
+    return 0;
+}
+
+/*
+ * 一輪：依速率把 ping 打給所有還沒回應的位址，同時收 pong；
+ * 最後一個送出後再等 timeout_ms
+ */
+static void scan_round(discover_scan_t* s, int rate, int timeout_ms) {
+    uint64_t round_start = bmc_monotonic_us();
+    uint64_t deadline = 0;
+    uint32_t next = 0;
+    unsigned long sent = 0;
+    
+    for (;;) {
+        uint64_t now = bmc_monotonic_us();
+        int blocked = 0;
+        
+        if (next < s->count) {
+            // 到現在為止依速率可以送幾個
+            unsigned long allowed = (unsigned long)((now - round_start) * (uint64_t)rate / 1000000) + 1;
+            
+            while (next < s->count && sent < allowed && !blocked) {
+                unsigned long room = allowed - sent;
+                int max = room < DISCOVER_BATCH ? (int)room : DISCOVER_BATCH;
+                blocked = scan_send(s, &next, max, &sent);
+            }
+            
+            if (next >= s->count) {
+                deadline = bmc_monotonic_us() + (uint64_t)timeout_ms * 1000;
+            }
+        }
+        
+        // 全部都回了
+        if (s->result->count == s->count) {
+            return;
+        }
+        
+        now = bmc_monotonic_us();
+        int wait_ms;
+        if (next < s->count) {
+            uint64_t due = round_start + (uint64_t)sent * 1000000 / (uint64_t)rate;
+            wait_ms = due > now ? (int)((due - now + 999) / 1000) : 0;
+            // socket 滿了就等 POLLOUT，不要空轉
+            if (blocked && wait_ms < DISCOVER_BLOCKED_WAIT_MS) {
+                wait_ms = DISCOVER_BLOCKED_WAIT_MS;
+            }
+        } else {
+            if (now >= deadline) {
+                scan_drain(s);
+                return;
+            }
+            wait_ms = (int)((deadline - now + 999) / 1000);
+        }
+        
+        struct pollfd pfd = { .fd = s->fd, .events = POLLIN | (blocked ? POLLOUT : 0) };
+        int ret = poll(&pfd, 1, wait_ms);
+        if (ret < 0 && errno != EINTR) {
+            bmc_log(LOG_LEVEL_ERROR, "poll() failed: %s", strerror(errno));
+            return;
+        }
+        if (ret > 0 && (pfd.revents & POLLIN)) {
+            scan_drain(s);
+        }
+    }
+}
+
+static int cmp_host(const void* a, const void* b) {
+    uint32_t x = ((const ipmi_discover_host_t*)a)->ipv4;
+    uint32_t y = ((const ipmi_discover_host_t*)b)->ipv4;
+    return (x > y) - (x < y);
+}
+
+int ipmi_discover_ping(const char* cidr, const ipmi_discover_opts_t* opts,
+                       ipmi_discover_result_t* result) {
+    if (!cidr || !result) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(result, 0, sizeof(*result));
+    
+    uint16_t port = opts && opts->port ? opts->port : IPMI_DEFAULT_PORT;
+    int rate = opts && opts->rate_pps > 0 ? opts->rate_pps : IPMI_DISCOVER_DEFAULT_RATE;
+    int timeout_ms = opts && opts->timeout_ms > 0 ? opts->timeout_ms : DISCOVER_DEFAULT_TIMEOUT_MS;
+    int rounds = opts && opts->rounds > 0 ? opts->rounds : DISCOVER_DEFAULT_ROUNDS;
+    if (rate > DISCOVER_MAX_RATE) {
+        rate = DISCOVER_MAX_RATE;
+    }
+    
+    uint32_t first, count;
+    int ret = ipmi_discover_parse_cidr(cidr, &first, &count);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    discover_scan_t* s = calloc(1, sizeof(*s));
+    if (!s) {
+        return BMC_ERROR_MEMORY;
+    }
+    s->sent_us = calloc(count, sizeof(*s->sent_us));
+    s->seen = calloc(count, 1);
+    if (!s->sent_us || !s->seen) {
+        free(s->sent_us);
+        free(s->seen);
+        free(s);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    s->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->fd < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "socket() failed: %s", strerror(errno));
+        free(s->sent_us);
+        free(s->seen);
+        free(s);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    // 整個網段的 pong 會在幾百 ms 內一起回來
+    int rcvbuf = DISCOVER_RCVBUF_SIZE;
+    if (setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        bmc_log(LOG_LEVEL_WARN, "setsockopt(SO_RCVBUF) failed: %s", strerror(errno));
+    }
+    
+    s->port = port;
+    s->first = first;
+    s->count = count;
+    s->result = result;
+    result->scanned = count;
+    
+    // 每一批都送同一個 ping，只有目的位址不同
+    const uint8_t ping[ASF_PING_LEN] = {
+        RMCP_VERSION_1_0, 0x00, RMCP_SEQUENCE_NO_ACK, RMCP_CLASS_ASF,
+        0x00, 0x00, 0x11, 0xBE,
+        ASF_TYPE_PRESENCE_PING, 0x00, 0x00, 0x00
+    };
+    memcpy(s->ping, ping, sizeof(ping));
+    s->tx_iov.iov_base = s->ping;
+    s->tx_iov.iov_len = sizeof(s->ping);
+    
+    for (int i = 0; i < DISCOVER_BATCH; i++) {
+        s->tx_to[i].sin_family = AF_INET;
+        s->tx_to[i].sin_port = htons(port);
+        s->tx_msgs[i].msg_hdr.msg_name = &s->tx_to[i];
+        s->tx_msgs[i].msg_hdr.msg_namelen = sizeof(s->tx_to[i]);
+        s->tx_msgs[i].msg_hdr.msg_iov = &s->tx_iov;
+        s->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+        
+        s->rx_iov[i].iov_base = s->rx_bufs[i];
+        s->rx_iov[i].iov_len = DISCOVER_RX_LEN;
+        s->rx_msgs[i].msg_hdr.msg_name = &s->rx_from[i];
+        s->rx_msgs[i].msg_hdr.msg_iov = &s->rx_iov[i];
+        s->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Discover %s: %u addresses, %d pings/s, %d rounds",
+            cidr, count, rate, rounds);
+    
+    s->start_us = bmc_monotonic_us();
+    for (int r = 0; r < rounds && result->count < count; r++) {
+        // tag 每輪不同，只是方便抓封包時分辨
+        s->ping[9] = (uint8_t)r;
+        scan_round(s, rate, timeout_ms);
+    }
+    
+    close(s->fd);
+    free(s->sent_us);
+    free(s->seen);
+    free(s);
+    
+    qsort(result->hosts, result->count, sizeof(*result->hosts), cmp_host);
+    return BMC_SUCCESS;
+}
+
+int ipmi_decode_auth_caps(const ipmi_rsp_view_t* rsp, ipmi_auth_caps_t* caps) {
+    if (!rsp || !caps) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (rsp->data_len < 1) {
+        bmc_log(LOG_LEVEL_ERROR, "Response too short");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (rsp->data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_DEBUG, "Get Channel Authentication Capabilities failed: completion code 0x%02x",
+                rsp->data[0]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // cc + channel + auth types + status + extended caps + OEM ID(3)
+    if (rsp->data_len < 8) {
+        bmc_log(LOG_LEVEL_ERROR, "Response data too short: %zu bytes", rsp->data_len);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    const uint8_t* d = rsp->data;
+    
+    memset(caps, 0, sizeof(*caps));
+    caps->channel = d[1] & 0x0F;
+    caps->auth_types = d[2] & 0x3F;
+    caps->login = d[3] & 0x07;
+    caps->per_msg_auth_disabled = (d[3] >> 4) & 1;
+    
+    // byte 3 bit 7 沒設表示只有 IPMI 1.5，byte 5 沒有意義
+    if (d[2] & 0x80) {
+        caps->ipmi15 = d[4] & 0x01;
+        caps->ipmi20 = (d[4] >> 1) & 0x01;
+    } else {
+        caps->ipmi15 = 1;
+    }
+    caps->oem_id = (uint32_t)d[5] | ((uint32_t)d[6] << 8) | ((uint32_t)d[7] << 16);
+    
+    return BMC_SUCCESS;
+}
+
+static void auth_done(ipmi_engine_t* eng, int target, int status,
+                      const ipmi_rsp_view_t* rsp, void* user_data);
+
+static int submit_auth(ipmi_engine_t* eng, int target, ipmi_discover_host_t* h,
+                       const uint8_t* req, size_t len) {
+    struct iovec iov = { .iov_base = (void*)req, .iov_len = len };
+    return ipmi_engine_submitv(eng, target, IPMI_NETFN_APP, IPMI_CMD_GET_CHANNEL_AUTH_CAP,
+                               &iov, 1, auth_done, h);
+}
+
+static void auth_done(ipmi_engine_t* eng, int target, int status,
+                      const ipmi_rsp_view_t* rsp, void* user_data) {
+    ipmi_discover_host_t* h = user_data;
+    
+    if (status != BMC_SUCCESS) {
+        h->auth_status = status;
+        return;
+    }
+    
+    // 只懂 IPMI 1.5 的 BMC 不認 bit 7，回 0xCC；改用 1.5 的問法再問一次
+    if (h->auth_status != IPMI_DISCOVER_PROBING_V15 &&
+        rsp->data_len >= 1 && rsp->data[0] == CC_INVALID_DATA_FIELD) {
+        h->auth_status = IPMI_DISCOVER_PROBING_V15;
+        int ret = submit_auth(eng, target, h, g_auth_req_v15, sizeof(g_auth_req_v15));
+        if (ret != BMC_SUCCESS) {
+            h->auth_status = ret;
+        }
+        return;
+    }
+    
+    h->auth_status = ipmi_decode_auth_caps(rsp, &h->auth);
+}
+
+int ipmi_discover_auth(ipmi_engine_t* eng, uint16_t port, ipmi_discover_result_t* result) {
+    if (!eng || !result) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (port == 0) {
+        port = IPMI_DEFAULT_PORT;
+    }
+    
+    for (size_t i = 0; i < result->count; i++) {
+        ipmi_discover_host_t* h = &result->hosts[i];
+        h->auth_status = IPMI_DISCOVER_NOT_PROBED;
+        
+        // 只有 ASF 的網卡（沒有 BMC）不用問
+        if (!(h->entities & ASF_ENTITY_IPMI)) {
+            continue;
+        }
+        
+        ipmi_addr_t addr;
+        memset(&addr, 0, sizeof(addr));
+        struct sockaddr_in* sin = (struct sockaddr_in*)&addr.addr;
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        sin->sin_addr.s_addr = htonl(h->ipv4);
+        addr.addrlen = sizeof(*sin);
+        
+        int target = ipmi_engine_add_target_addr(eng, h->host, &addr);
+        if (target < 0) {
+            return target;
+        }
+        
+        int ret = submit_auth(eng, target, h, g_auth_req, sizeof(g_auth_req));
+        if (ret != BMC_SUCCESS) {
+            h->auth_status = ret;
+        }
+    }
+    
+    int pending = ipmi_engine_run(eng, -1);
+    return pending < 0 ? pending : BMC_SUCCESS;
+}
+
+void ipmi_discover_free(ipmi_discover_result_t* result) {
+    if (!result) {
+        return;
+    }
+    
+    free(result->hosts);
+    result->hosts = NULL;
+    result->count = 0;
+}
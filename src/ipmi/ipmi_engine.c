@@ -0,0 +1,1538 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_engine.h"
+#include "bmctool/ipmi_uring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define ENGINE_DEFAULT_SOCKETS      4
+#define ENGINE_DEFAULT_TIMEOUT_MS   5000
+#define ENGINE_DEFAULT_OUTSTANDING  1024
+#define ENGINE_DEFAULT_DEPTH        1
+#define ENGINE_DEFAULT_RETRIES      3
+#define ENGINE_RCVBUF_SIZE          (4 * 1024 * 1024)
+#define ENGINE_MAX_EVENTS           64
+#define ENGINE_PKT_SIZE             512
+#define ENGINE_DEFAULT_BATCH        64
+#define ENGINE_MAX_BATCH            1024    // UIO_MAXIOV
+#define ENGINE_URING_ENTRIES        4096    // SQ 大小，flush_sends 一輪排得下
+#define ENGINE_URING_BUFFERS        4096    // 接收 buffer 數，約等於 SO_RCVBUF 能放的封包
+#define ENGINE_URING_BUF_SIZE       (sizeof(struct io_uring_recvmsg_out) + \
+                                     sizeof(struct sockaddr_storage) + ENGINE_PKT_SIZE)
+
+/* io_uring user_data 的低 3 bits 是種類，其他是 request 指標或 index << 3 */
+enum {
+    URING_UD_SEND = 1,           // 首次送出，高位是 engine_req_t*
+    URING_UD_RESEND,             // 重送，高位是 target（request 可能已經完成）
+    URING_UD_RECV,               // multishot recvmsg，高位是 socket index
+    URING_UD_POLLOUT             // socket 滿了，等可寫
+};
+#define URING_UD_KIND(ud)           ((int)((ud) & 7))
+#define URING_UD_INDEX(ud)          ((int)((ud) >> 3))
+
+// 一個排隊中或在路上的 request
+typedef struct engine_req {
+    struct engine_req* next;     // target queue / free list
+    uint8_t pkt[IPMI_REQ_MAX_LEN];  // submit 時就建好的封包，送出時只改 seq
+    uint16_t pkt_len;
+    uint8_t wire[IPMI_LANPLUS_MAX_LEN];  // RMCP+ target：每次送出前把 pkt 包成加密封包
+    uint16_t wire_len;
+    uint8_t cmd;
+    uint8_t seq;
+    uint8_t bridge_addr;         // 橋接的 satellite 位址，0 表示直接給 BMC
+    uint8_t bridge_cmd;          // 橋接時 satellite 的命令（cmd 是外層的 Send Message）
+    ipmi_engine_cb cb;
+    void* user_data;
+    int target;
+    int attempts;                // 已經重送幾次
+    uint64_t sent_us;            // 最後一次送出的時間
+    uint64_t expire_us;          // 整體 timeout
+    uint64_t deadline_us;        // heap key：下次重送或逾時的時間
+    size_t heap_idx;
+#ifdef BMC_IO_URING
+    struct msghdr msg;           // io_uring：SENDMSG SQE 指向這裡，submit 之前不能動
+    struct iovec iov;
+#endif
+} engine_req_t;
+
+typedef struct {
+    char host[256];
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    int sock;                    // eng->socks 的 index
+    ipmi_seq_window_t window;    // 在路上的 request，用 rqSeq 索引
+    ipmi_rtt_t rtt;              // 這台 BMC 的 RTT 估計
+    ipmi_session_t* session;     // attach 的 RMCP+ session，NULL 表示 IPMI 1.5
+    engine_req_t* queue_head;
+    engine_req_t* queue_tail;
+    int on_sendq;
+} engine_target_t;
+
+typedef struct {
+    int fd;
+    int want_out;                // 送出時遇到 EAGAIN，等 EPOLLOUT
+    int tx_len;                  // 已排進這個 socket 的 sendmmsg 批次、還沒送的封包數
+} engine_sock_t;
+
+// sendmmsg 批次裡的一筆
+typedef struct {
+    engine_req_t* req;
+    int retransmit;              // 重送失敗不用處理，等下一次 deadline
+} engine_tx_t;
+
+struct ipmi_engine {
+    int epfd;
+    int io_backend;              // IPMI_ENGINE_IO_*
+#ifdef BMC_IO_URING
+    ipmi_uring_t ring;
+    struct msghdr rx_msg;        // multishot recvmsg 的樣板：只告訴 kernel 來源位址留多少空間
+#endif
+    
+    // socks[0..n-1] 給 IPv4，socks[n..2n-1] 給 IPv6，用到才建立
+    engine_sock_t* socks;
+    int sockets_per_family;
+    
+    engine_target_t* targets;
+    int num_targets;
+    int cap_targets;
+    
+    // 來源位址 -> target 的 open addressing hash（-1 表示空位）
+    int* addr_table;
+    size_t addr_table_size;
+    
+    // 有東西要送的 target（ring buffer）
+    int* sendq;
+    size_t sendq_head;
+    size_t sendq_len;
+    
+    // 在路上的 request，依 deadline 排的 min-heap
+    engine_req_t** heap;
+    size_t heap_len;
+    size_t heap_cap;
+    
+    engine_req_t* free_list;
+    
+    size_t pending;              // 排隊中 + 在路上
+    size_t outstanding;          // 在路上
+    int max_outstanding;
+    int depth;                   // 每台 BMC 同時在路上的上限
+    int timeout_ms;
+    int retries;
+    
+    // sendmmsg / recvmmsg 的緩衝區，一次配好重複使用
+    // 送：每個 socket batch_cap 格（指向 request 的封包）；收：batch_cap 格的 ring，所有 socket 共用
+    int batch_size;
+    int batch_cap;
+    struct mmsghdr* tx_msgs;
+    struct iovec* tx_iov;
+    engine_tx_t* tx;
+    struct mmsghdr* rx_msgs;
+    struct iovec* rx_iov;
+    uint8_t* rx_bufs;
+    struct sockaddr_storage* rx_from;
+    
+    ipmi_engine_stats_t stats;
+};
+
+/* ===== 位址 hash ===== */
+
+static int addr_equal(const struct sockaddr* a, const struct sockaddr* b) {
+    if (a->sa_family != b->sa_family) {
+        return 0;
+    }
+    
+    if (a->sa_family == AF_INET) {
+        const struct sockaddr_in* a4 = (const struct sockaddr_in*)a;
+        const struct sockaddr_in* b4 = (const struct sockaddr_in*)b;
+        return a4->sin_port == b4->sin_port &&
+               a4->sin_addr.s_addr == b4->sin_addr.s_addr;
+    }
+    
+    if (a->sa_family == AF_INET6) {
+        const struct sockaddr_in6* a6 = (const struct sockaddr_in6*)a;
+        const struct sockaddr_in6* b6 = (const struct sockaddr_in6*)b;
+        return a6->sin6_port == b6->sin6_port &&
+               memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) == 0;
+    }
+    
+    return 0;
+}
+
+// FNV-1a，只 hash 位址和 port
+static size_t addr_hash(const struct sockaddr* sa) {
+    const uint8_t* p;
+    size_t n;
+    uint16_t port;
+    
+    if (sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6* s6 = (const struct sockaddr_in6*)sa;
+        p = (const uint8_t*)&s6->sin6_addr;
+        n = sizeof(s6->sin6_addr);
+        port = s6->sin6_port;
+    } else {
+        const struct sockaddr_in* s4 = (const struct sockaddr_in*)sa;
+        p = (const uint8_t*)&s4->sin_addr;
+        n = sizeof(s4->sin_addr);
+        port = s4->sin_port;
+    }
+    
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    h = (h ^ (port & 0xFF)) * 16777619u;
+    h = (h ^ (port >> 8)) * 16777619u;
+    
+    return h;
+}
+
+static int addr_lookup(const ipmi_engine_t* eng, const struct sockaddr* sa) {
+    if (eng->addr_table_size == 0) {
+        return -1;
+    }
+    
+    size_t mask = eng->addr_table_size - 1;
+    for (size_t i = addr_hash(sa) & mask; ; i = (i + 1) & mask) {
+        int t = eng->addr_table[i];
+        if (t < 0) {
+            return -1;
+        }
+        if (addr_equal((const struct sockaddr*)&eng->targets[t].addr, sa)) {
+            return t;
+        }
+    }
+}
+
+static void addr_insert(ipmi_engine_t* eng, int target) {
+    size_t mask = eng->addr_table_size - 1;
+    const struct sockaddr* sa = (const struct sockaddr*)&eng->targets[target].addr;
+    
+    size_t i = addr_hash(sa) & mask;
+    while (eng->addr_table[i] >= 0) {
+        i = (i + 1) & mask;
+    }
+    eng->addr_table[i] = target;
+}
+
+// 維持 load factor <= 0.5
+static int addr_table_reserve(ipmi_engine_t* eng, int num_targets) {
+    if ((size_t)num_targets * 2 <= eng->addr_table_size) {
+        return BMC_SUCCESS;
+    }
+    
+    size_t size = eng->addr_table_size ? eng->addr_table_size : 64;
+    while (size < (size_t)num_targets * 2) {
+        size *= 2;
+    }
+    
+    int* table = malloc(size * sizeof(int));
+    if (!table) {
+        return BMC_ERROR_MEMORY;
+    }
+    memset(table, 0xFF, size * sizeof(int));
+    
+    free(eng->addr_table);
+    eng->addr_table = table;
+    eng->addr_table_size = size;
+    
+    for (int t = 0; t < eng->num_targets; t++) {
+        addr_insert(eng, t);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== Deadline heap ===== */
+
+static void heap_swap(ipmi_engine_t* eng, size_t a, size_t b) {
+    engine_req_t* tmp = eng->heap[a];
+    eng->heap[a] = eng->heap[b];
+    eng->heap[b] = tmp;
+    eng->heap[a]->heap_idx = a;
+    eng->heap[b]->heap_idx = b;
+}
+
+static void heap_up(ipmi_engine_t* eng, size_t i) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (eng->heap[parent]->deadline_us <= eng->heap[i]->deadline_us) {
+            break;
+        }
+        heap_swap(eng, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_down(ipmi_engine_t* eng, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1;
+        size_t r = l + 1;
+        size_t min = i;
+        
+        if (l < eng->heap_len && eng->heap[l]->deadline_us < eng->heap[min]->deadline_us) {
+            min = l;
+        }
+        if (r < eng->heap_len && eng->heap[r]->deadline_us < eng->heap[min]->deadline_us) {
+            min = r;
+        }
+        if (min == i) {
+            break;
+        }
+        heap_swap(eng, i, min);
+        i = min;
+    }
+}
+
+static int heap_push(ipmi_engine_t* eng, engine_req_t* req) {
+    if (eng->heap_len == eng->heap_cap) {
+        size_t cap = eng->heap_cap ? eng->heap_cap * 2 : 256;
+        engine_req_t** heap = realloc(eng->heap, cap * sizeof(*heap));
+        if (!heap) {
+            return BMC_ERROR_MEMORY;
+        }
+        eng->heap = heap;
+        eng->heap_cap = cap;
+    }
+    
+    req->heap_idx = eng->heap_len;
+    eng->heap[eng->heap_len++] = req;
+    heap_up(eng, req->heap_idx);
+    
+    return BMC_SUCCESS;
+}
+
+static void heap_remove(ipmi_engine_t* eng, engine_req_t* req) {
+    size_t i = req->heap_idx;
+    size_t last = --eng->heap_len;
+    
+    if (i != last) {
+        heap_swap(eng, i, last);
+        heap_down(eng, i);
+        heap_up(eng, i);
+    }
+}
+
+/* ===== Send queue ===== */
+
+static void sendq_push(ipmi_engine_t* eng, int target) {
+    engine_target_t* t = &eng->targets[target];
+    if (t->on_sendq) {
+        return;
+    }
+    
+    // 容量等於 cap_targets，每個 target 最多排一次，不會滿
+    size_t tail = (eng->sendq_head + eng->sendq_len) % (size_t)eng->cap_targets;
+    eng->sendq[tail] = target;
+    eng->sendq_len++;
+    t->on_sendq = 1;
+}
+
+static void sendq_pop(ipmi_engine_t* eng) {
+    eng->targets[eng->sendq[eng->sendq_head]].on_sendq = 0;
+    eng->sendq_head = (eng->sendq_head + 1) % (size_t)eng->cap_targets;
+    eng->sendq_len--;
+}
+
+/* ===== Request 生命週期 ===== */
+
+static engine_req_t* req_alloc(ipmi_engine_t* eng) {
+    engine_req_t* req = eng->free_list;
+    if (req) {
+        eng->free_list = req->next;
+    } else {
+        req = malloc(sizeof(*req));
+        if (!req) {
+            return NULL;
+        }
+    }
+    
+    req->next = NULL;
+    return req;
+}
+
+static void req_free(ipmi_engine_t* eng, engine_req_t* req) {
+    req->next = eng->free_list;
+    eng->free_list = req;
+}
+
+// 完成一個在路上的 request：先從所有結構拿掉再呼叫 callback，callback 裡可以再 submit
+static void complete_inflight(ipmi_engine_t* eng, engine_req_t* req, int status,
+                              const ipmi_rsp_view_t* rsp) {
+    engine_target_t* t = &eng->targets[req->target];
+    
+    heap_remove(eng, req);
+    ipmi_seq_take(&t->window, req->seq);
+    eng->outstanding--;
+    eng->pending--;
+    
+    if (t->queue_head) {
+        sendq_push(eng, req->target);
+    }
+    
+    if (req->cb) {
+        req->cb(eng, req->target, status, rsp, req->user_data);
+    }
+    
+    req_free(eng, req);
+}
+
+// 送出前就失敗（例如網路不通）
+static void complete_unsent(ipmi_engine_t* eng, engine_req_t* req, int status) {
+    eng->pending--;
+    
+    if (req->cb) {
+        req->cb(eng, req->target, status, NULL, req->user_data);
+    }
+    
+    req_free(eng, req);
+}
+
+/* ===== Socket ===== */
+
+#ifdef BMC_IO_URING
+// multishot recvmsg：一個 SQE 一直收，buffer 由 kernel 從 provided buffer ring 挑
+static void uring_arm_recv(ipmi_engine_t* eng, int idx) {
+    struct io_uring_sqe* sqe = ipmi_uring_get_sqe(&eng->ring);
+    if (!sqe) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring SQ full, cannot arm receive");
+        return;
+    }
+    
+    ipmi_uring_prep_recvmsg_multishot(sqe, (unsigned)idx, &eng->rx_msg, eng->ring.bgid,
+                                      ((uint64_t)idx << 3) | URING_UD_RECV);
+}
+#endif
+
+static int engine_socket(ipmi_engine_t* eng, int family, int slot) {
+    int idx = (family == AF_INET6 ? eng->sockets_per_family : 0) + slot;
+    engine_sock_t* s = &eng->socks[idx];
+    
+    if (s->fd >= 0) {
+        return idx;
+    }
+    
+    int fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "socket() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    // 一次對很多台發 request，回應會集中湧入
+    int rcvbuf = ENGINE_RCVBUF_SIZE;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        bmc_log(LOG_LEVEL_WARN, "setsockopt(SO_RCVBUF) failed: %s", strerror(errno));
+    }
+    
+#ifdef BMC_IO_URING
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        // fixed file 的 slot 就用 socket index
+        if (ipmi_uring_set_file(&eng->ring, (unsigned)idx, fd) != BMC_SUCCESS) {
+            close(fd);
+            return BMC_ERROR_NETWORK;
+        }
+        s->fd = fd;
+        uring_arm_recv(eng, idx);
+        return idx;
+    }
+#endif
+    
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)idx };
+    if (epoll_ctl(eng->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "epoll_ctl() failed: %s", strerror(errno));
+        close(fd);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    s->fd = fd;
+    bmc_log(LOG_LEVEL_DEBUG, "Engine socket opened: fd=%d family=%s", fd,
+            family == AF_INET6 ? "IPv6" : "IPv4");
+    
+    return idx;
+}
+
+static void engine_want_out(ipmi_engine_t* eng, int idx, int want) {
+    engine_sock_t* s = &eng->socks[idx];
+    if (s->want_out == want) {
+        return;
+    }
+    
+#ifdef BMC_IO_URING
+    // 一次性的 POLL_ADD，completion 回來就是可寫了
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        struct io_uring_sqe* sqe = want ? ipmi_uring_get_sqe(&eng->ring) : NULL;
+        if (sqe) {
+            ipmi_uring_prep_poll(sqe, (unsigned)idx, POLLOUT,
+                                 ((uint64_t)idx << 3) | URING_UD_POLLOUT);
+        }
+        s->want_out = sqe ? want : 0;
+        return;
+    }
+#endif
+    
+    struct epoll_event ev = {
+        .events = EPOLLIN | (want ? EPOLLOUT : 0),
+        .data.u32 = (uint32_t)idx
+    };
+    epoll_ctl(eng->epfd, EPOLL_CTL_MOD, s->fd, &ev);
+    s->want_out = want;
+}
+
+// 依 batch_size 配置 sendmmsg/recvmmsg 的緩衝區；只在批次都送完時呼叫
+static int batch_reserve(ipmi_engine_t* eng) {
+    if (eng->batch_cap == eng->batch_size) {
+        return BMC_SUCCESS;
+    }
+    
+    size_t cap = (size_t)eng->batch_size;
+    size_t tx_slots = cap * 2 * (size_t)eng->sockets_per_family;
+    
+    struct mmsghdr* tx_msgs = calloc(tx_slots, sizeof(*tx_msgs));
+    struct iovec* tx_iov = calloc(tx_slots, sizeof(*tx_iov));
+    engine_tx_t* tx = calloc(tx_slots, sizeof(*tx));
+    struct mmsghdr* rx_msgs = calloc(cap, sizeof(*rx_msgs));
+    struct iovec* rx_iov = calloc(cap, sizeof(*rx_iov));
+    uint8_t* rx_bufs = malloc(cap * ENGINE_PKT_SIZE);
+    struct sockaddr_storage* rx_from = calloc(cap, sizeof(*rx_from));
+    
+    if (!tx_msgs || !tx_iov || !tx || !rx_msgs || !rx_iov || !rx_bufs || !rx_from) {
+        free(tx_msgs);
+        free(tx_iov);
+        free(tx);
+        free(rx_msgs);
+        free(rx_iov);
+        free(rx_bufs);
+        free(rx_from);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    // 送出的 iovec 指向 request 自己的封包；收的 iovec 固定指向 ring 裡的 buffer
+    for (size_t i = 0; i < tx_slots; i++) {
+        tx_msgs[i].msg_hdr.msg_iov = &tx_iov[i];
+        tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    for (size_t i = 0; i < cap; i++) {
+        rx_iov[i].iov_base = rx_bufs + i * ENGINE_PKT_SIZE;
+        rx_iov[i].iov_len = ENGINE_PKT_SIZE;
+        rx_msgs[i].msg_hdr.msg_iov = &rx_iov[i];
+        rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        rx_msgs[i].msg_hdr.msg_name = &rx_from[i];
+    }
+    
+    free(eng->tx_msgs);
+    free(eng->tx_iov);
+    free(eng->tx);
+    free(eng->rx_msgs);
+    free(eng->rx_iov);
+    free(eng->rx_bufs);
+    free(eng->rx_from);
+    
+    eng->tx_msgs = tx_msgs;
+    eng->tx_iov = tx_iov;
+    eng->tx = tx;
+    eng->rx_msgs = rx_msgs;
+    eng->rx_iov = rx_iov;
+    eng->rx_bufs = rx_bufs;
+    eng->rx_from = rx_from;
+    eng->batch_cap = eng->batch_size;
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== Public API ===== */
+
+ipmi_engine_t* ipmi_engine_create(int num_sockets) {
+    if (num_sockets <= 0) {
+        num_sockets = ENGINE_DEFAULT_SOCKETS;
+    }
+    
+    ipmi_engine_t* eng = calloc(1, sizeof(ipmi_engine_t));
+    if (!eng) {
+        return NULL;
+    }
+    
+    eng->socks = calloc(2 * num_sockets, sizeof(engine_sock_t));
+    if (!eng->socks) {
+        free(eng);
+        return NULL;
+    }
+    for (int i = 0; i < 2 * num_sockets; i++) {
+        eng->socks[i].fd = -1;
+    }
+    eng->sockets_per_family = num_sockets;
+    
+    eng->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (eng->epfd < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "epoll_create1() failed: %s", strerror(errno));
+        free(eng->socks);
+        free(eng);
+        return NULL;
+    }
+    
+    eng->timeout_ms = ENGINE_DEFAULT_TIMEOUT_MS;
+    eng->max_outstanding = ENGINE_DEFAULT_OUTSTANDING;
+    eng->depth = ENGINE_DEFAULT_DEPTH;
+    eng->retries = ENGINE_DEFAULT_RETRIES;
+    eng->batch_size = ENGINE_DEFAULT_BATCH;
+    
+    return eng;
+}
+
+void ipmi_engine_destroy(ipmi_engine_t* eng) {
+    if (!eng) {
+        return;
+    }
+    
+    // 沒完成的 request 直接丟掉，不呼叫 callback
+    for (int t = 0; t < eng->num_targets; t++) {
+        engine_req_t* req = eng->targets[t].queue_head;
+        while (req) {
+            engine_req_t* next = req->next;
+            free(req);
+            req = next;
+        }
+        for (int s = 0; s < IPMI_SEQ_SPACE; s++) {
+            free(eng->targets[t].window.slots[s]);
+        }
+    }
+    
+    engine_req_t* req = eng->free_list;
+    while (req) {
+        engine_req_t* next = req->next;
+        free(req);
+        req = next;
+    }
+    
+    for (int i = 0; i < 2 * eng->sockets_per_family; i++) {
+        if (eng->socks[i].fd >= 0) {
+            close(eng->socks[i].fd);
+        }
+    }
+    close(eng->epfd);
+#ifdef BMC_IO_URING
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        ipmi_uring_cleanup(&eng->ring);
+    }
+#endif
+    
+    free(eng->socks);
+    free(eng->targets);
+    free(eng->addr_table);
+    free(eng->sendq);
+    free(eng->heap);
+    free(eng->tx_msgs);
+    free(eng->tx_iov);
+    free(eng->tx);
+    free(eng->rx_msgs);
+    free(eng->rx_iov);
+    free(eng->rx_bufs);
+    free(eng->rx_from);
+    free(eng);
+}
+
+int ipmi_engine_set_timeout(ipmi_engine_t* eng, int timeout_ms) {
+    if (!eng || timeout_ms <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->timeout_ms = timeout_ms;
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_set_max_outstanding(ipmi_engine_t* eng, int max_outstanding) {
+    if (!eng || max_outstanding <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->max_outstanding = max_outstanding;
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_set_retries(ipmi_engine_t* eng, int retries) {
+    if (!eng || retries < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->retries = retries;
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_set_depth(ipmi_engine_t* eng, int depth) {
+    if (!eng || depth <= 0 || depth > IPMI_SEQ_MAX_DEPTH) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->depth = depth;
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_set_io_backend(ipmi_engine_t* eng, int backend) {
+    if (!eng || (backend != IPMI_ENGINE_IO_EPOLL && backend != IPMI_ENGINE_IO_URING)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // socket 是加 target 時才建、才註冊的，之後不能換
+    if (eng->num_targets > 0) {
+        bmc_log(LOG_LEVEL_ERROR, "I/O backend must be set before adding targets");
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (backend == eng->io_backend) {
+        return BMC_SUCCESS;
+    }
+    
+#ifdef BMC_IO_URING
+    if (backend == IPMI_ENGINE_IO_URING) {
+        int ret = ipmi_uring_init(&eng->ring, ENGINE_URING_ENTRIES,
+                                  (unsigned)(2 * eng->sockets_per_family));
+        if (ret == BMC_SUCCESS) {
+            ret = ipmi_uring_setup_buffers(&eng->ring, ENGINE_URING_BUFFERS,
+                                           ENGINE_URING_BUF_SIZE, 0);
+            if (ret != BMC_SUCCESS) {
+                ipmi_uring_cleanup(&eng->ring);
+            }
+        }
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        memset(&eng->rx_msg, 0, sizeof(eng->rx_msg));
+        eng->rx_msg.msg_namelen = sizeof(struct sockaddr_storage);
+    } else {
+        ipmi_uring_cleanup(&eng->ring);
+    }
+    
+    eng->io_backend = backend;
+    return BMC_SUCCESS;
+#else
+    bmc_log(LOG_LEVEL_ERROR, "Built without io_uring support (rebuild with make IO_URING=1)");
+    return BMC_ERROR_INVALID_PARAM;
+#endif
+}
+
+const char* ipmi_engine_io_backend_name(int backend) {
+    return backend == IPMI_ENGINE_IO_URING ? "io_uring" : "epoll";
+}
+
+int ipmi_engine_set_batch_size(ipmi_engine_t* eng, int batch_size) {
+    if (!eng || batch_size <= 0 || batch_size > ENGINE_MAX_BATCH) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->batch_size = batch_size;
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_add_target(ipmi_engine_t* eng, const char* host, uint16_t port) {
+    if (!eng || !host) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_addr_t addr;
+    int ret = ipmi_resolve(host, port, &addr);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    return ipmi_engine_add_target_addr(eng, host, &addr);
+}
+
+int ipmi_engine_add_target_addr(ipmi_engine_t* eng, const char* host, const ipmi_addr_t* addr) {
+    if (!eng || !addr || addr->addrlen == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    const struct sockaddr* sa = (const struct sockaddr*)&addr->addr;
+    
+    // 同一個位址只留一個 target，不然回應沒辦法分辨
+    int existing = addr_lookup(eng, sa);
+    if (existing >= 0) {
+        return existing;
+    }
+    
+    if (eng->num_targets == eng->cap_targets) {
+        int cap = eng->cap_targets ? eng->cap_targets * 2 : 64;
+        
+        engine_target_t* targets = realloc(eng->targets, cap * sizeof(*targets));
+        if (!targets) {
+            return BMC_ERROR_MEMORY;
+        }
+        eng->targets = targets;
+        
+        // sendq 是 ring buffer，換容量時要攤平
+        int* sendq = malloc(cap * sizeof(int));
+        if (!sendq) {
+            return BMC_ERROR_MEMORY;
+        }
+        for (size_t i = 0; i < eng->sendq_len; i++) {
+            sendq[i] = eng->sendq[(eng->sendq_head + i) % (size_t)eng->cap_targets];
+        }
+        free(eng->sendq);
+        eng->sendq = sendq;
+        eng->sendq_head = 0;
+        eng->cap_targets = cap;
+    }
+    
+    if (addr_table_reserve(eng, eng->num_targets + 1) != BMC_SUCCESS) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    int idx = eng->num_targets;
+    int sock = engine_socket(eng, sa->sa_family, idx % eng->sockets_per_family);
+    if (sock < 0) {
+        return sock;
+    }
+    
+    engine_target_t* t = &eng->targets[idx];
+    memset(t, 0, sizeof(*t));
+    
+    // 顯示名稱：預設 port 只秀 host，其他加上 port
+    uint16_t port = ntohs(sa->sa_family == AF_INET6 ?
+                          ((const struct sockaddr_in6*)sa)->sin6_port :
+                          ((const struct sockaddr_in*)sa)->sin_port);
+    if (!host) {
+        ipmi_addr_str(addr, t->host, sizeof(t->host));
+    } else if (port == IPMI_DEFAULT_PORT) {
+        snprintf(t->host, sizeof(t->host), "%s", host);
+    } else {
+        snprintf(t->host, sizeof(t->host), strchr(host, ':') ? "[%s]:%u" : "%s:%u",
+                 host, port);
+    }
+    memcpy(&t->addr, &addr->addr, addr->addrlen);
+    t->addrlen = addr->addrlen;
+    t->sock = sock;
+    ipmi_seq_init(&t->window, 1);
+    ipmi_rtt_init(&t->rtt);
+    
+    eng->num_targets++;
+    addr_insert(eng, idx);
+    
+    return idx;
+}
+
+int ipmi_engine_attach_session(ipmi_engine_t* eng, int target, ipmi_session_t* session) {
+    if (!eng || target < 0 || target >= eng->num_targets ||
+        (session && !session->active)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    eng->targets[target].session = session;
+    return BMC_SUCCESS;
+}
+
+const char* ipmi_engine_target_host(const ipmi_engine_t* eng, int target) {
+    if (!eng || target < 0 || target >= eng->num_targets) {
+        return NULL;
+    }
+    return eng->targets[target].host;
+}
+
+int ipmi_engine_num_targets(const ipmi_engine_t* eng) {
+    return eng ? eng->num_targets : 0;
+}
+
+size_t ipmi_engine_pending(const ipmi_engine_t* eng) {
+    return eng ? eng->pending : 0;
+}
+
+void ipmi_engine_get_stats(const ipmi_engine_t* eng, ipmi_engine_stats_t* stats) {
+    if (!eng || !stats) {
+        return;
+    }
+    *stats = eng->stats;
+#ifdef BMC_IO_URING
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        stats->syscalls += eng->ring.enters;
+    }
+#endif
+}
+
+// 排進 target 的 queue，window 還有空位就讓它上 sendq
+static void req_enqueue(ipmi_engine_t* eng, engine_req_t* r) {
+    engine_target_t* t = &eng->targets[r->target];
+    if (t->queue_tail) {
+        t->queue_tail->next = r;
+    } else {
+        t->queue_head = r;
+    }
+    t->queue_tail = r;
+    
+    eng->pending++;
+    
+    if (t->window.count < eng->depth) {
+        sendq_push(eng, r->target);
+    }
+}
+
+/*
+ * 橋接的 request 整個包成 Send Message 建好；內層的 seq 也是送出時才補，
+ * 回應先拆外層對上 seq，再拆出 satellite 的回應交給 callback
+ */
+static int submit_bridged(ipmi_engine_t* eng, int target, const ipmi_msg_t* req,
+                          ipmi_engine_cb cb, void* user_data) {
+    if (!eng || target < 0 || target >= eng->num_targets) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    engine_req_t* r = req_alloc(eng);
+    if (!r) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    size_t len = sizeof(r->pkt);
+    int ret = ipmi_req_build_bridged(req, 0, r->pkt, &len);
+    if (ret != BMC_SUCCESS) {
+        req_free(eng, r);
+        return ret;
+    }
+    
+    r->pkt_len = (uint16_t)len;
+    r->cmd = IPMI_CMD_SEND_MESSAGE;
+    r->bridge_addr = req->target_addr;
+    r->bridge_cmd = req->cmd;
+    r->cb = cb;
+    r->user_data = user_data;
+    r->target = target;
+    
+    req_enqueue(eng, r);
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_submit(ipmi_engine_t* eng, int target, const ipmi_msg_t* req,
+                       ipmi_engine_cb cb, void* user_data) {
+    if (!req) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (ipmi_msg_is_bridged(req)) {
+        return submit_bridged(eng, target, req, cb, user_data);
+    }
+    
+    struct iovec iov = { .iov_base = (void*)req->data, .iov_len = req->data_len };
+    
+    return ipmi_engine_submitv(eng, target, req->netfn, req->cmd, &iov, 1, cb, user_data);
+}
+
+int ipmi_engine_submitv(ipmi_engine_t* eng, int target, uint8_t netfn, uint8_t cmd,
+                        const struct iovec* iov, size_t iovcnt,
+                        ipmi_engine_cb cb, void* user_data) {
+    if (!eng || target < 0 || target >= eng->num_targets) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    engine_req_t* r = req_alloc(eng);
+    if (!r) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    // 封包直接建在 request 裡，seq 等真的送出時再補
+    size_t len = sizeof(r->pkt);
+    int ret = ipmi_req_build(ipmi_req_tmpl_get(netfn, cmd), 0, iov, iovcnt, r->pkt, &len);
+    if (ret != BMC_SUCCESS) {
+        req_free(eng, r);
+        return ret;
+    }
+    
+    r->pkt_len = (uint16_t)len;
+    r->cmd = cmd;
+    r->bridge_addr = 0;
+    r->cb = cb;
+    r->user_data = user_data;
+    r->target = target;
+    
+    req_enqueue(eng, r);
+    return BMC_SUCCESS;
+}
+
+/* ===== 事件迴圈 ===== */
+
+// 送不出去的首次 request 退回 target 的 queue 前面，等 socket 可寫再送
+static void tx_requeue(ipmi_engine_t* eng, const engine_tx_t* tx) {
+    if (tx->retransmit) {
+        return;
+    }
+    
+    engine_req_t* req = tx->req;
+    engine_target_t* t = &eng->targets[req->target];
+    
+    heap_remove(eng, req);
+    ipmi_seq_take(&t->window, req->seq);
+    eng->outstanding--;
+    
+    req->next = t->queue_head;
+    t->queue_head = req;
+    if (!t->queue_tail) {
+        t->queue_tail = req;
+    }
+    sendq_push(eng, req->target);
+}
+
+static void tx_failed(ipmi_engine_t* eng, const engine_tx_t* tx, int err) {
+    engine_req_t* req = tx->req;
+    engine_target_t* t = &eng->targets[req->target];
+    
+    bmc_log(LOG_LEVEL_ERROR, "sendmmsg(%s) failed: %s", t->host, strerror(err));
+    
+    // 重送失敗就留在 heap 裡，下一次 deadline 再試或逾時
+    if (!tx->retransmit) {
+        complete_inflight(eng, req, BMC_ERROR_NETWORK, NULL);
+    }
+}
+
+/*
+ * 把 socket 上排好的批次用 sendmmsg 送出去
+ * 回傳 1 表示 socket 滿了，沒送出去的已經退回 queue
+ */
+static int flush_socket(ipmi_engine_t* eng, int idx) {
+    engine_sock_t* s = &eng->socks[idx];
+    struct mmsghdr* msgs = &eng->tx_msgs[(size_t)idx * eng->batch_cap];
+    engine_tx_t* tx = &eng->tx[(size_t)idx * eng->batch_cap];
+    int len = s->tx_len;
+    int sent = 0;
+    int blocked = 0;
+    
+    // callback 可能會 submit，但不會往批次裡加東西，先歸零
+    s->tx_len = 0;
+    
+    while (sent < len) {
+        int n = sendmmsg(s->fd, msgs + sent, (unsigned int)(len - sent), 0);
+        eng->stats.syscalls++;
+        if (n > 0) {
+            eng->stats.sent += (unsigned long)n;
+            sent += n;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            blocked = 1;
+            break;
+        }
+        
+        // 第一筆就失敗，跳過它繼續送後面的
+        tx_failed(eng, &tx[sent], errno);
+        sent++;
+    }
+    
+    if (blocked) {
+        // 倒著退回去，同一台 BMC 的 request 才會維持原本的順序
+        for (int i = len - 1; i >= sent; i--) {
+            tx_requeue(eng, &tx[i]);
+        }
+        engine_want_out(eng, idx, 1);
+    }
+    
+    return blocked;
+}
+
+static void flush_all(ipmi_engine_t* eng) {
+    for (int i = 0; i < 2 * eng->sockets_per_family; i++) {
+        if (eng->socks[i].tx_len > 0) {
+            flush_socket(eng, i);
+        }
+    }
+}
+
+#ifdef BMC_IO_URING
+/*
+ * io_uring：每個封包一個 SENDMSG SQE，msghdr 放在 request 裡，
+ * 等下一次 io_uring_enter 跟等待一起送出；結果在 completion 裡處理
+ */
+static int uring_stage(ipmi_engine_t* eng, engine_target_t* t, engine_req_t* req,
+                       uint8_t* pkt, size_t pkt_len, int retransmit) {
+    struct io_uring_sqe* sqe = ipmi_uring_get_sqe(&eng->ring);
+    if (!sqe) {
+        engine_tx_t tx = { .req = req, .retransmit = retransmit };
+        tx_requeue(eng, &tx);
+        return 1;
+    }
+    
+    req->iov.iov_base = pkt;
+    req->iov.iov_len = pkt_len;
+    memset(&req->msg, 0, sizeof(req->msg));
+    req->msg.msg_name = &t->addr;
+    req->msg.msg_namelen = t->addrlen;
+    req->msg.msg_iov = &req->iov;
+    req->msg.msg_iovlen = 1;
+    
+    uint64_t ud = retransmit ? (((uint64_t)req->target << 3) | URING_UD_RESEND)
+                             : ((uint64_t)(uintptr_t)req | URING_UD_SEND);
+    ipmi_uring_prep_sendmsg(sqe, (unsigned)t->sock, &req->msg, ud);
+    
+    return 0;
+}
+#endif
+
+/*
+ * 把 req（首次或重送）排進 target socket 的 sendmmsg 批次，批次滿了就送
+ * iovec 直接指向 req->pkt（RMCP+ 時是 req->wire），不另外複製
+ * 回傳 1 表示 socket 滿了
+ */
+static int stage_packet(ipmi_engine_t* eng, engine_target_t* t, engine_req_t* req,
+                        int retransmit) {
+    engine_sock_t* s = &eng->socks[t->sock];
+    size_t slot = (size_t)t->sock * eng->batch_cap + s->tx_len;
+    uint8_t* pkt = req->pkt;
+    size_t pkt_len = req->pkt_len;
+    
+    // RMCP+：每次送（含重送）都用新的 session seq 重新加密
+    if (t->session) {
+        size_t len = sizeof(req->wire);
+        int ret = ipmi_session_wrap(t->session, req->pkt + IPMI_REQ_MSG_LEN_OFF + 1,
+                                    req->pkt[IPMI_REQ_MSG_LEN_OFF], req->wire, &len);
+        if (ret != BMC_SUCCESS) {
+            bmc_log(LOG_LEVEL_ERROR, "Cannot wrap request for %s", t->host);
+            if (!retransmit) {
+                complete_inflight(eng, req, ret, NULL);
+            }
+            return 0;
+        }
+        req->wire_len = (uint16_t)len;
+        pkt = req->wire;
+        pkt_len = len;
+    }
+    
+#ifdef BMC_IO_URING
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        return uring_stage(eng, t, req, pkt, pkt_len, retransmit);
+    }
+#endif
+    
+    struct msghdr* hdr = &eng->tx_msgs[slot].msg_hdr;
+    hdr->msg_name = &t->addr;
+    hdr->msg_namelen = t->addrlen;
+    eng->tx_iov[slot].iov_base = pkt;
+    eng->tx_iov[slot].iov_len = pkt_len;
+    eng->tx[slot].req = req;
+    eng->tx[slot].retransmit = retransmit;
+    
+    if (++s->tx_len < eng->batch_size) {
+        return BMC_SUCCESS;
+    }
+    
+    return flush_socket(eng, t->sock);
+}
+
+// 依這台 BMC 目前的 RTO 排下一次重送時間（不超過整體 timeout）
+static void arm_retry(engine_target_t* t, engine_req_t* req, uint64_t now) {
+    req->sent_us = now;
+    req->deadline_us = now + ipmi_rtt_rto(&t->rtt);
+    if (req->deadline_us > req->expire_us) {
+        req->deadline_us = req->expire_us;
+    }
+}
+
+// 回傳 0 表示已排進批次或已處理，1 表示 socket 滿了要等
+static int send_one(ipmi_engine_t* eng, int target, uint64_t now) {
+    engine_target_t* t = &eng->targets[target];
+    engine_req_t* req = t->queue_head;
+    
+    // 排進批次時就當作送出；真的送不出去由 flush_socket 退回
+    t->queue_head = req->next;
+    if (!t->queue_head) {
+        t->queue_tail = NULL;
+    }
+    req->next = NULL;
+    
+    req->seq = (uint8_t)ipmi_seq_alloc(&t->window, req);
+    if (req->bridge_addr) {
+        ipmi_req_set_seq_bridged(req->pkt, req->pkt_len, req->seq);
+    } else {
+        ipmi_req_set_seq(req->pkt, req->pkt_len, req->seq);
+    }
+    req->attempts = 0;
+    req->expire_us = now + (uint64_t)eng->timeout_ms * 1000;
+    arm_retry(t, req, now);
+    
+    int ret = heap_push(eng, req);
+    if (ret != BMC_SUCCESS) {
+        ipmi_seq_take(&t->window, req->seq);
+        complete_unsent(eng, req, ret);
+        return 0;
+    }
+    eng->outstanding++;
+    
+    return stage_packet(eng, t, req, 0);
+}
+
+static void flush_sends(ipmi_engine_t* eng) {
+    uint64_t now = bmc_monotonic_us();
+    
+    while (eng->sendq_len > 0 && eng->outstanding < (size_t)eng->max_outstanding) {
+        int target = eng->sendq[eng->sendq_head];
+        engine_target_t* t = &eng->targets[target];
+        
+        if (t->window.count >= eng->depth || !t->queue_head) {
+            sendq_pop(eng);
+            continue;
+        }
+        
+        if (send_one(eng, target, now) != 0) {
+            break;
+        }
+        
+        // 還有空位就排回隊尾，讓每台 BMC 輪流送
+        sendq_pop(eng);
+        if (t->queue_head && t->window.count < eng->depth) {
+            sendq_push(eng, target);
+        }
+    }
+    
+    flush_all(eng);
+}
+
+static void handle_packet(ipmi_engine_t* eng, uint8_t* buf, size_t len,
+                          const struct sockaddr* from) {
+    int target = addr_lookup(eng, from);
+    if (target < 0) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping %zu bytes from unknown source", len);
+        return;
+    }
+    
+    engine_target_t* t = &eng->targets[target];
+    
+    // 直接在 ring buffer 上驗證（RMCP+ 就地解密），callback 拿到的 view 也指向同一塊
+    ipmi_rsp_view_t rsp;
+    int ret = t->session ? ipmi_session_unwrap(t->session, buf, len, &rsp)
+                         : ipmi_rsp_view(buf, len, &rsp);
+    if (ret != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping malformed response from %s", t->host);
+        return;
+    }
+    
+    // 空的 slot 是重複或逾時後才到的回應；cmd 不同代表 seq 已被重用
+    engine_req_t* req = t->window.slots[rsp.seq & 0x3F];
+    if (!req || req->cmd != rsp.cmd) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping stale response from %s (seq=%d)",
+                t->host, rsp.seq);
+        eng->stats.stale++;
+        return;
+    }
+    
+    // 橋接：BMC 的 ack 不算完成，繼續等；satellite 的回應拆出來給 callback
+    if (req->bridge_addr) {
+        ipmi_msg_t sent = { .cmd = req->bridge_cmd, .target_addr = req->bridge_addr };
+        ipmi_rsp_view_t inner;
+        ret = ipmi_bridge_unwrap(&rsp, &sent, req->seq, &inner);
+        if (ret == IPMI_BRIDGE_PENDING) {
+            return;
+        }
+        if (ret != BMC_SUCCESS) {
+            bmc_log(LOG_LEVEL_DEBUG, "Dropping mismatched bridged response from %s (seq=%d)",
+                    t->host, rsp.seq);
+            eng->stats.stale++;
+            return;
+        }
+        rsp = inner;
+    }
+    
+    // Karn：重送過的分不出是回哪一次，不取樣
+    if (req->attempts == 0) {
+        ipmi_rtt_sample(&t->rtt, (uint32_t)(bmc_monotonic_us() - req->sent_us));
+    }
+    
+    eng->stats.received++;
+    complete_inflight(eng, req, BMC_SUCCESS, &rsp);
+}
+
+// 用 recvmmsg 一次收一批，收到的比 ring 小代表 socket 已經空了
+static void drain_socket(ipmi_engine_t* eng, int idx) {
+    for (;;) {
+        for (int i = 0; i < eng->batch_size; i++) {
+            eng->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        }
+        
+        int n = recvmmsg(eng->socks[idx].fd, eng->rx_msgs, (unsigned int)eng->batch_size,
+                         MSG_DONTWAIT, NULL);
+        eng->stats.syscalls++;
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                bmc_log(LOG_LEVEL_WARN, "recvmmsg() failed: %s", strerror(errno));
+            }
+            return;
+        }
+        
+        for (int i = 0; i < n; i++) {
+            handle_packet(eng, eng->rx_iov[i].iov_base, eng->rx_msgs[i].msg_len,
+                          (const struct sockaddr*)&eng->rx_from[i]);
+        }
+        
+        if (n < eng->batch_size) {
+            return;
+        }
+    }
+}
+
+#ifdef BMC_IO_URING
+static void uring_send_done(ipmi_engine_t* eng, uint64_t ud, int res) {
+    if (res >= 0) {
+        eng->stats.sent++;
+        return;
+    }
+    
+    // 重送失敗不用處理，等下一次 deadline；request 可能已經完成了，不碰它
+    if (URING_UD_KIND(ud) == URING_UD_RESEND) {
+        bmc_log(LOG_LEVEL_DEBUG, "sendmsg(%s) failed: %s",
+                eng->targets[URING_UD_INDEX(ud)].host, strerror(-res));
+        return;
+    }
+    
+    engine_tx_t tx = { .req = (engine_req_t*)(uintptr_t)(ud & ~(uint64_t)7), .retransmit = 0 };
+    if (res == -EAGAIN || res == -EWOULDBLOCK || res == -ENOBUFS) {
+        int sock = eng->targets[tx.req->target].sock;
+        tx_requeue(eng, &tx);
+        engine_want_out(eng, sock, 1);
+        return;
+    }
+    
+    tx_failed(eng, &tx, -res);
+}
+
+static void uring_recv_done(ipmi_engine_t* eng, int idx, int res, unsigned flags) {
+    if (res >= 0 && (flags & IORING_CQE_F_BUFFER)) {
+        uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t* buf = ipmi_uring_buffer(&eng->ring, bid);
+        const struct sockaddr* from;
+        const uint8_t* payload;
+        size_t len;
+        
+        if (ipmi_uring_recvmsg_parse(buf, (size_t)res, &eng->rx_msg, &from, &payload, &len) ==
+            BMC_SUCCESS) {
+            handle_packet(eng, (uint8_t*)payload, len, from);
+        }
+        ipmi_uring_recycle(&eng->ring, bid);
+    } else if (res < 0 && res != -ENOBUFS) {
+        bmc_log(LOG_LEVEL_WARN, "recvmsg() failed: %s", strerror(-res));
+    }
+    
+    // multishot 停了（buffer 用完或出錯）就重新掛上去
+    if (!(flags & IORING_CQE_F_MORE) && eng->socks[idx].fd >= 0) {
+        uring_arm_recv(eng, idx);
+    }
+}
+
+// 送出排好的 SQE，同一個 syscall 等 completion，再把 CQ 收乾淨
+static int uring_poll(ipmi_engine_t* eng, int64_t wait_us) {
+    if (ipmi_uring_submit_and_wait(&eng->ring, 1, wait_us) != BMC_SUCCESS) {
+        return BMC_ERROR_NETWORK;
+    }
+    
+    struct io_uring_cqe* cqe;
+    while ((cqe = ipmi_uring_peek_cqe(&eng->ring)) != NULL) {
+        // 先標記看過再處理，callback 裡 submit 不會影響 CQ
+        uint64_t ud = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        ipmi_uring_cqe_seen(&eng->ring);
+        
+        switch (URING_UD_KIND(ud)) {
+            case URING_UD_SEND:
+            case URING_UD_RESEND:
+                uring_send_done(eng, ud, res);
+                break;
+            case URING_UD_RECV:
+                uring_recv_done(eng, URING_UD_INDEX(ud), res, flags);
+                break;
+            case URING_UD_POLLOUT:
+                eng->socks[URING_UD_INDEX(ud)].want_out = 0;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    return BMC_SUCCESS;
+}
+#endif
+
+static int epoll_poll(ipmi_engine_t* eng, int64_t wait_us) {
+    struct epoll_event events[ENGINE_MAX_EVENTS];
+    int wait_ms = wait_us < 0 ? -1 : (int)((wait_us + 999) / 1000);
+    
+    int n = epoll_wait(eng->epfd, events, ENGINE_MAX_EVENTS, wait_ms);
+    if (n < 0 && errno != EINTR) {
+        bmc_log(LOG_LEVEL_ERROR, "epoll_wait() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        int idx = (int)events[i].data.u32;
+        if (events[i].events & EPOLLOUT) {
+            engine_want_out(eng, idx, 0);
+        }
+        if (events[i].events & (EPOLLIN | EPOLLERR)) {
+            drain_socket(eng, idx);
+        }
+    }
+    
+    return BMC_SUCCESS;
+}
+
+static void expire_timeouts(ipmi_engine_t* eng, uint64_t now) {
+    while (eng->heap_len > 0 && eng->heap[0]->deadline_us <= now) {
+        engine_req_t* req = eng->heap[0];
+        engine_target_t* t = &eng->targets[req->target];
+        
+        ipmi_rtt_timeout(&t->rtt, req->sent_us, now);
+        
+        // 同一個 seq 重送，BMC 才認得出是重複的 request；重送也走 sendmmsg 批次
+        if (req->attempts < eng->retries && now < req->expire_us) {
+            req->attempts++;
+            eng->stats.retransmits++;
+            arm_retry(t, req, now);
+            heap_down(eng, 0);
+            bmc_log(LOG_LEVEL_DEBUG, "Retransmitting to %s (seq=%d, attempt %d)",
+                    t->host, req->seq, req->attempts);
+            stage_packet(eng, t, req, 1);
+            continue;
+        }
+        
+        bmc_log(LOG_LEVEL_DEBUG, "Timeout waiting for %s", t->host);
+        eng->stats.timeouts++;
+        complete_inflight(eng, req, BMC_ERROR_TIMEOUT, NULL);
+    }
+    
+    flush_all(eng);
+}
+
+// 等最多 wait_us，處理收到的回應和到期的重送 / 逾時
+static int engine_poll(ipmi_engine_t* eng, int64_t wait_us) {
+#ifdef BMC_IO_URING
+    int ret = eng->io_backend == IPMI_ENGINE_IO_URING ? uring_poll(eng, wait_us)
+                                                      : epoll_poll(eng, wait_us);
+#else
+    int ret = epoll_poll(eng, wait_us);
+#endif
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    expire_timeouts(eng, bmc_monotonic_us());
+    return BMC_SUCCESS;
+}
+
+int ipmi_engine_run(ipmi_engine_t* eng, int timeout_ms) {
+    if (!eng) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // io_uring 不用 sendmmsg / recvmmsg 的緩衝區
+    if (eng->io_backend == IPMI_ENGINE_IO_EPOLL && batch_reserve(eng) != BMC_SUCCESS) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    uint64_t run_deadline = 0;
+    if (timeout_ms >= 0) {
+        run_deadline = bmc_monotonic_us() + (uint64_t)timeout_ms * 1000;
+    }
+    
+    while (eng->pending > 0) {
+        flush_sends(eng);
+        
+        // 等到最近的 deadline 為止
+        uint64_t now = bmc_monotonic_us();
+        uint64_t wake = run_deadline;
+        if (eng->heap_len > 0 && (wake == 0 || eng->heap[0]->deadline_us < wake)) {
+            wake = eng->heap[0]->deadline_us;
+        }
+        
+        int64_t wait_us = -1;
+        if (wake != 0) {
+            wait_us = wake > now ? (int64_t)(wake - now) : 0;
+        }
+        
+        int ret = engine_poll(eng, wait_us);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        if (run_deadline != 0 && bmc_monotonic_us() >= run_deadline) {
+            break;
+        }
+    }
+    
+    return (int)eng->pending;
+}
+
+/* ===== 嵌入別人的事件迴圈 ===== */
+
+int ipmi_engine_get_fd(const ipmi_engine_t* eng) {
+    if (!eng) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+#ifdef BMC_IO_URING
+    // ring fd 在 CQ 有東西時可讀
+    if (eng->io_backend == IPMI_ENGINE_IO_URING) {
+        return eng->ring.fd;
+    }
+#endif
+    return eng->epfd;
+}
+
+int ipmi_engine_next_timeout(const ipmi_engine_t* eng) {
+    if (!eng) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // 有排隊沒送的（剛 submit 或被 max_outstanding 擋住後又有空位）要馬上處理；
+    // socket 滿了在等可寫的話，fd 會通知，不用空轉
+    if (eng->sendq_len > 0 && eng->outstanding < (size_t)eng->max_outstanding) {
+        int blocked = 0;
+        for (int i = 0; i < 2 * eng->sockets_per_family; i++) {
+            blocked |= eng->socks[i].want_out;
+        }
+        if (!blocked) {
+            return 0;
+        }
+    }
+    if (eng->heap_len == 0) {
+        return -1;
+    }
+    
+    uint64_t now = bmc_monotonic_us();
+    uint64_t deadline = eng->heap[0]->deadline_us;
+    if (deadline <= now) {
+        return 0;
+    }
+    
+    // 無條件進位，免得 deadline 還沒到就醒來空轉
+    uint64_t ms = (deadline - now + 999) / 1000;
+    return ms > INT_MAX ? INT_MAX : (int)ms;
+}
+
+int ipmi_engine_dispatch(ipmi_engine_t* eng) {
+    if (!eng) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (eng->io_backend == IPMI_ENGINE_IO_EPOLL && batch_reserve(eng) != BMC_SUCCESS) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    flush_sends(eng);
+    
+    int ret = engine_poll(eng, 0);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    // callback 裡 submit 的這一輪就送出去，呼叫端等 fd 時不會卡著沒送的
+    flush_sends(eng);
+#ifdef BMC_IO_URING
+    if (eng->io_backend == IPMI_ENGINE_IO_URING &&
+        ipmi_uring_submit_and_wait(&eng->ring, 0, 0) != BMC_SUCCESS) {
+        return BMC_ERROR_NETWORK;
+    }
+#endif
+    
+    return (int)eng->pending;
+}
@@ -0,0 +1,541 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_fru.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#define FRU_MAX_CHUNK           224     // 第一次試的大小，留空間給 response header
+#define FRU_MIN_CHUNK           8
+#define FRU_BATCH               32      // 一次 ipmi_send_recv_batch 最多幾個 request
+#define FRU_CACHE_MAX           32      // 每台 BMC 最多記幾個 FRU
+
+#define FRU_TL_END              0xC1    // type/length 結束標記
+
+/* Completion code */
+#define CC_REQ_LEN_INVALID      0xC7
+#define CC_REQ_LEN_EXCEEDED     0xC8
+#define CC_CANNOT_RETURN_LEN    0xCA
+#define CC_UNSPECIFIED          0xFF
+
+#define FRU_CACHE_MAGIC         0x31555246      // "FRU1"
+#define FRU_CACHE_VERSION       1
+
+typedef struct {
+    uint16_t off;
+    uint16_t len;
+} fru_range_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint8_t chunk;               // 上次試出來的 Read FRU Data 大小
+    uint8_t reserved[3];
+    uint32_t count;
+} fru_cache_header_t;
+
+typedef struct {
+    uint64_t fingerprint;
+    ipmi_fru_t fru;
+} fru_cache_entry_t;
+
+typedef struct {
+    uint8_t chunk;
+    size_t count;
+    fru_cache_entry_t entries[FRU_CACHE_MAX];
+} fru_cache_t;
+
+int ipmi_fru_get_info(ipmi_ctx_t* ctx, uint8_t fru_id, uint16_t* size, int* word_access) {
+    if (!ctx || !size) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_GET_FRU_INVENTORY_INFO,
+                       .data = { fru_id }, .data_len = 1 };
+    ipmi_msg_t rsp;
+    
+    int ret = ipmi_send_recv(ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (rsp.data_len < 4 || rsp.data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "Get FRU Inventory Area Info (FRU %d) failed: completion code 0x%02x",
+                fru_id, rsp.data_len > 0 ? rsp.data[0] : 0xFF);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    *size = rsp.data[1] | (rsp.data[2] << 8);
+    if (word_access) {
+        *word_access = rsp.data[3] & 0x01;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+// BMC 一次吐不出這麼多資料時回的 completion code
+static int cc_too_long(uint8_t cc) {
+    return cc == CC_CANNOT_RETURN_LEN || cc == CC_REQ_LEN_INVALID ||
+           cc == CC_REQ_LEN_EXCEEDED || cc == CC_UNSPECIFIED;
+}
+
+/*
+ * 待讀的範圍放在 todo，每輪從裡面切出最多 FRU_BATCH 個 chunk 一起送；
+ * BMC 嫌太長的範圍放回去並把 chunk 減半，回得比要求少的把剩下的放回去
+ */
+int ipmi_fru_read(ipmi_ctx_t* ctx, uint8_t fru_id, uint16_t offset, uint16_t len,
+                  int word_access, uint8_t* buf) {
+    if (!ctx || (len > 0 && !buf) || (size_t)offset + len > 0x10000) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int unit = word_access ? 2 : 1;
+    if (word_access && ((offset | len) & 1)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    if (len == 0) {
+        return BMC_SUCCESS;
+    }
+    if (ctx->fru_chunk < FRU_MIN_CHUNK) {
+        ctx->fru_chunk = FRU_MAX_CHUNK;
+    }
+    
+    // 範圍彼此不重疊也不為空，最多 len 個
+    fru_range_t* todo = malloc(((size_t)len + 1) * sizeof(fru_range_t));
+    if (!todo) {
+        return BMC_ERROR_MEMORY;
+    }
+    size_t ntodo = 1;
+    todo[0] = (fru_range_t){ offset, len };
+    
+    ipmi_msg_t reqs[FRU_BATCH];
+    ipmi_msg_t rsps[FRU_BATCH];
+    int status[FRU_BATCH];
+    fru_range_t sent[FRU_BATCH];
+    int ret = BMC_SUCCESS;
+    
+    while (ntodo > 0 && ret == BMC_SUCCESS) {
+        size_t n = 0;
+        while (n < FRU_BATCH && ntodo > 0) {
+            fru_range_t* r = &todo[ntodo - 1];
+            uint16_t want = r->len < ctx->fru_chunk ? r->len : ctx->fru_chunk;
+            uint16_t woff = r->off / unit;
+            
+            sent[n] = (fru_range_t){ r->off, want };
+            reqs[n] = (ipmi_msg_t){ .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_READ_FRU_DATA };
+            reqs[n].data[0] = fru_id;
+            reqs[n].data[1] = woff & 0xFF;
+            reqs[n].data[2] = woff >> 8;
+            reqs[n].data[3] = (uint8_t)(want / unit);
+            reqs[n].data_len = 4;
+            n++;
+            
+            r->off += want;
+            r->len -= want;
+            if (r->len == 0) {
+                ntodo--;
+            }
+        }
+        
+        ret = ipmi_send_recv_batch(ctx, reqs, rsps, status, n);
+        if (ret != BMC_SUCCESS) {
+            break;
+        }
+        
+        int shrink = 0;
+        for (size_t i = 0; i < n && ret == BMC_SUCCESS; i++) {
+            const ipmi_msg_t* rsp = &rsps[i];
+            uint8_t cc = rsp->data_len > 0 ? rsp->data[0] : CC_UNSPECIFIED;
+            
+            if (status[i] != BMC_SUCCESS) {
+                ret = status[i];
+            } else if (cc_too_long(cc)) {
+                todo[ntodo++] = sent[i];
+                shrink = 1;
+            } else if (cc != 0x00 || rsp->data_len < 2) {
+                bmc_log(LOG_LEVEL_ERROR, "Read FRU Data (FRU %d, offset %u) failed: completion code 0x%02x",
+                        fru_id, sent[i].off, cc);
+                ret = BMC_ERROR_PROTOCOL;
+            } else {
+                size_t got = (size_t)rsp->data[1] * unit;
+                if (got == 0 || got > sent[i].len || rsp->data_len < 2 + got) {
+                    bmc_log(LOG_LEVEL_ERROR, "Read FRU Data returned %zu of %u bytes", got, sent[i].len);
+                    ret = BMC_ERROR_PROTOCOL;
+                    break;
+                }
+                
+                memcpy(buf + (sent[i].off - offset), rsp->data + 2, got);
+                if (got < sent[i].len) {
+                    todo[ntodo++] = (fru_range_t){ (uint16_t)(sent[i].off + got),
+                                                   (uint16_t)(sent[i].len - got) };
+                }
+            }
+        }
+        
+        if (ret == BMC_SUCCESS && shrink) {
+            if (ctx->fru_chunk <= FRU_MIN_CHUNK) {
+                bmc_log(LOG_LEVEL_ERROR, "Read FRU Data failed even with %d-byte chunks", ctx->fru_chunk);
+                ret = BMC_ERROR_PROTOCOL;
+            } else {
+                // 減半後取偶數（word access 的裝置要整數個 word），最小到 FRU_MIN_CHUNK
+                int chunk = (ctx->fru_chunk / 2) & ~1;
+                ctx->fru_chunk = (uint8_t)(chunk > FRU_MIN_CHUNK ? chunk : FRU_MIN_CHUNK);
+                bmc_log(LOG_LEVEL_DEBUG, "Reducing FRU chunk size to %d", ctx->fru_chunk);
+            }
+        }
+    }
+    
+    free(todo);
+    return ret;
+}
+
+/* ===== 解析 ===== */
+
+static uint8_t sum8(const uint8_t* p, size_t len) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+/*
+ * 解一個 type/length 欄位，回傳用掉的 bytes；碰到結束標記或超出範圍回傳 0
+ * 8-bit ASCII 照抄，6-bit packed 和 BCD plus 展開，binary 轉成 hex
+ */
+static size_t parse_field(const uint8_t* p, size_t left, char* out) {
+    out[0] = '\0';
+    if (left < 1 || p[0] == FRU_TL_END) {
+        return 0;
+    }
+    
+    uint8_t type = p[0] >> 6;
+    size_t n = p[0] & 0x3F;
+    if (n + 1 > left) {
+        return 0;
+    }
+    p++;
+    
+    size_t o = 0;
+    switch (type) {
+        case 3:
+            for (size_t i = 0; i < n && o < IPMI_FRU_FIELD_MAX; i++) {
+                out[o++] = isprint(p[i]) ? (char)p[i] : '.';
+            }
+            break;
+        
+        case 2:
+            for (size_t bit = 0; bit + 6 <= n * 8 && o < IPMI_FRU_FIELD_MAX; bit += 6) {
+                size_t byte = bit / 8;
+                unsigned v = p[byte] | (byte + 1 < n ? p[byte + 1] << 8 : 0);
+                out[o++] = (char)(((v >> (bit % 8)) & 0x3F) + 0x20);
+            }
+            break;
+        
+        case 1:
+            for (size_t i = 0; i < n * 2 && o < IPMI_FRU_FIELD_MAX; i++) {
+                uint8_t d = (i & 1) ? (p[i / 2] & 0x0F) : (p[i / 2] >> 4);
+                out[o++] = d <= 9 ? (char)('0' + d) : (d == 0xA ? ' ' : (d == 0xB ? '-' : '.'));
+            }
+            break;
+        
+        default:
+            for (size_t i = 0; i < n && o + 2 <= IPMI_FRU_FIELD_MAX; i++) {
+                o += snprintf(out + o, 3, "%02x", p[i]);
+            }
+            break;
+    }
+    
+    while (o > 0 && out[o - 1] == ' ') {
+        o--;
+    }
+    out[o] = '\0';
+    
+    return n + 1;
+}
+
+// 找出 area 的位置和長度並檢查 checksum；沒有這個 area 或壞掉回傳 0
+static size_t area_bounds(const uint8_t* data, size_t len, uint8_t off8, const char* name,
+                          const uint8_t** area) {
+    size_t off = (size_t)off8 * 8;
+    if (off8 == 0 || off + 2 > len) {
+        return 0;
+    }
+    
+    size_t alen = (size_t)data[off + 1] * 8;
+    if (alen < 3 || off + alen > len) {
+        bmc_log(LOG_LEVEL_WARN, "FRU %s area overruns the inventory", name);
+        return 0;
+    }
+    if (sum8(data + off, alen) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "FRU %s area checksum mismatch", name);
+        return 0;
+    }
+    
+    *area = data + off;
+    return alen;
+}
+
+// 依序填 fields，碰到結束標記就停
+static void parse_fields(const uint8_t* p, size_t left, char* const fields[], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t used = parse_field(p, left, fields[i]);
+        if (used == 0) {
+            break;
+        }
+        p += used;
+        left -= used;
+    }
+}
+
+int ipmi_fru_parse(const uint8_t* data, size_t len, ipmi_fru_t* fru) {
+    if (!data || !fru || len < IPMI_FRU_HEADER_LEN) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(fru, 0, sizeof(*fru));
+    
+    if ((data[0] & 0x0F) != 0x01 || sum8(data, IPMI_FRU_HEADER_LEN) != 0) {
+        bmc_log(LOG_LEVEL_ERROR, "Invalid FRU common header");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    const uint8_t* area;
+    size_t alen;
+    
+    alen = area_bounds(data, len, data[2], "chassis", &area);
+    if (alen) {
+        char* fields[] = { fru->chassis_part, fru->chassis_serial };
+        fru->has_chassis = 1;
+        fru->chassis_type = area[2];
+        parse_fields(area + 3, alen - 3, fields, 2);
+    }
+    
+    alen = area_bounds(data, len, data[3], "board", &area);
+    if (alen >= 6) {
+        char* fields[] = { fru->board_mfg, fru->board_product, fru->board_serial, fru->board_part };
+        fru->has_board = 1;
+        fru->board_mfg_time = area[3] | (area[4] << 8) | (area[5] << 16);
+        parse_fields(area + 6, alen - 6, fields, 4);
+    }
+    
+    alen = area_bounds(data, len, data[4], "product", &area);
+    if (alen) {
+        char* fields[] = { fru->product_mfg, fru->product_name, fru->product_part,
+                           fru->product_version, fru->product_serial, fru->product_asset };
+        fru->has_product = 1;
+        parse_fields(area + 3, alen - 3, fields, 6);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== 快取 ===== */
+
+// FNV-1a：inventory 大小 + common header
+static uint64_t fingerprint(uint16_t size, const uint8_t* header) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint8_t bytes[2 + IPMI_FRU_HEADER_LEN] = { size & 0xFF, size >> 8 };
+    memcpy(bytes + 2, header, IPMI_FRU_HEADER_LEN);
+    
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        h ^= bytes[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void cache_read(const char* path, fru_cache_t* cache) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return;
+    }
+    
+    fru_cache_header_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.magic == FRU_CACHE_MAGIC &&
+        hdr.version == FRU_CACHE_VERSION && hdr.entry_size == sizeof(fru_cache_entry_t) &&
+        hdr.count <= FRU_CACHE_MAX &&
+        fread(cache->entries, sizeof(fru_cache_entry_t), hdr.count, fp) == hdr.count) {
+        cache->chunk = hdr.chunk;
+        cache->count = hdr.count;
+    }
+    
+    fclose(fp);
+}
+
+// 先寫暫存檔再 rename，同時跑的 process 不會讀到寫一半的檔案
+static void cache_write(const char* path, const fru_cache_t* cache) {
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write FRU cache %s", tmp);
+        return;
+    }
+    
+    fru_cache_header_t hdr = {
+        .magic = FRU_CACHE_MAGIC,
+        .version = FRU_CACHE_VERSION,
+        .entry_size = sizeof(fru_cache_entry_t),
+        .chunk = cache->chunk,
+        .count = (uint32_t)cache->count
+    };
+    
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             fwrite(cache->entries, sizeof(fru_cache_entry_t), cache->count, fp) == cache->count;
+    ok = (fclose(fp) == 0) && ok;
+    
+    if (!ok || rename(tmp, path) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write FRU cache %s", path);
+        unlink(tmp);
+    }
+}
+
+static fru_cache_entry_t* cache_find(fru_cache_t* cache, uint8_t fru_id) {
+    for (size_t i = 0; i < cache->count; i++) {
+        if (cache->entries[i].fru.fru_id == fru_id) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void cache_store(fru_cache_t* cache, uint64_t fp, const ipmi_fru_t* fru) {
+    fru_cache_entry_t* e = cache_find(cache, fru->fru_id);
+    if (!e) {
+        // 滿了就擠掉最舊的那筆
+        if (cache->count == FRU_CACHE_MAX) {
+            memmove(cache->entries, cache->entries + 1,
+                    (FRU_CACHE_MAX - 1) * sizeof(fru_cache_entry_t));
+            cache->count--;
+        }
+        e = &cache->entries[cache->count++];
+    }
+    
+    e->fingerprint = fp;
+    e->fru = *fru;
+    e->fru.from_cache = 0;
+}
+
+// 要讀到哪裡：有 multi-record area 就讀到它前面為止，不然整個讀
+static size_t read_end(const uint8_t* header, uint16_t size) {
+    size_t end = size;
+    size_t multi = (size_t)header[5] * 8;
+    
+    if (multi > (size_t)header[2] * 8 && multi > (size_t)header[3] * 8 &&
+        multi > (size_t)header[4] * 8 && multi < end) {
+        end = multi;
+    }
+    return end;
+}
+
+static int load_fru(ipmi_ctx_t* ctx, uint8_t fru_id, int refresh, fru_cache_t* cache,
+                    const char* cache_path, ipmi_fru_t* fru) {
+    uint16_t size;
+    int word_access = 0;
+    uint8_t header[IPMI_FRU_HEADER_LEN];
+    
+    int ret = ipmi_fru_get_info(ctx, fru_id, &size, &word_access);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    if (size < IPMI_FRU_HEADER_LEN) {
+        bmc_log(LOG_LEVEL_ERROR, "FRU %d is empty", fru_id);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    ret = ipmi_fru_read(ctx, fru_id, 0, IPMI_FRU_HEADER_LEN, word_access, header);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    uint64_t fp = fingerprint(size, header);
+    fru_cache_entry_t* e = cache_find(cache, fru_id);
+    if (!refresh && e && e->fingerprint == fp) {
+        *fru = e->fru;
+        fru->from_cache = 1;
+        bmc_log(LOG_LEVEL_DEBUG, "FRU %d unchanged, using cache", fru_id);
+        return BMC_SUCCESS;
+    }
+    
+    size_t end = read_end(header, size);
+    if (word_access) {
+        end &= ~(size_t)1;
+    }
+    
+    uint8_t* data = malloc(end);
+    if (!data) {
+        return BMC_ERROR_MEMORY;
+    }
+    memcpy(data, header, IPMI_FRU_HEADER_LEN);
+    
+    uint64_t start = bmc_monotonic_us();
+    ret = ipmi_fru_read(ctx, fru_id, IPMI_FRU_HEADER_LEN, (uint16_t)(end - IPMI_FRU_HEADER_LEN),
+                        word_access, data + IPMI_FRU_HEADER_LEN);
+    if (ret == BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "Read %zu bytes of FRU %d in %llu us (chunk %d)", end, fru_id,
+                (unsigned long long)(bmc_monotonic_us() - start), ctx->fru_chunk);
+        ret = ipmi_fru_parse(data, end, fru);
+    }
+    free(data);
+    
+    if (ret == BMC_SUCCESS) {
+        fru->fru_id = fru_id;
+        fru->size = size;
+        if (cache_path) {
+            cache_store(cache, fp, fru);
+            cache->chunk = ctx->fru_chunk;
+            cache_write(cache_path, cache);
+        }
+    }
+    
+    return ret;
+}
+
+int ipmi_fru_load(ipmi_ctx_t* ctx, uint8_t fru_id, const char* cache_path, int refresh,
+                  ipmi_fru_t* fru) {
+    if (!ctx || !fru) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char path[4096];
+    if (!cache_path && ipmi_ctx_cache_path(ctx, "fru", path, sizeof(path)) == BMC_SUCCESS) {
+        cache_path = path;
+    }
+    
+    fru_cache_t* cache = calloc(1, sizeof(fru_cache_t));
+    if (!cache) {
+        return BMC_ERROR_MEMORY;
+    }
+    if (cache_path) {
+        cache_read(cache_path, cache);
+    }
+    
+    // 上次試出來的 chunk 大小直接拿來用，不用再從大的開始試
+    if (ctx->fru_chunk == 0 && cache->chunk >= FRU_MIN_CHUNK) {
+        ctx->fru_chunk = cache->chunk;
+    }
+    
+    int ret = load_fru(ctx, fru_id, refresh, cache, cache_path, fru);
+    
+    free(cache);
+    return ret;
+}
+
+const char* ipmi_fru_chassis_type_name(uint8_t type) {
+    static const char* const names[] = {
+        "Unspecified", "Other", "Unknown", "Desktop", "Low Profile Desktop", "Pizza Box",
+        "Mini Tower", "Tower", "Portable", "Laptop", "Notebook", "Hand Held",
+        "Docking Station", "All in One", "Sub Notebook", "Space-saving", "Lunch Box",
+        "Main Server Chassis", "Expansion Chassis", "SubChassis", "Bus Expansion Chassis",
+        "Peripheral Chassis", "RAID Chassis", "Rack Mount Chassis", "Sealed-case PC",
+        "Multi-system Chassis", "Compact PCI", "Advanced TCA", "Blade", "Blade Enclosure",
+        "Tablet", "Convertible", "Detachable", "IoT Gateway", "Embedded PC", "Mini PC",
+        "Stick PC"
+    };
+    
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "Unknown";
+}
@@ -1,33 +1,22 @@
 #include "bmctool/ipmi.h"
 #include <string.h>
+#include <pthread.h>
 #include <arpa/inet.h>  // for htonl
 
+// 每個 (netfn, cmd) 一個樣板；pool 和 engine 可能在不同 thread 建第一個封包，
+// 所以用 pthread_once 一次全部填好（約 340 KB），之後只讀不寫
+static ipmi_req_tmpl_t g_tmpl_cache[64 * 256];
+static pthread_once_t g_tmpl_once = PTHREAD_ONCE_INIT;
+
 /**
- * 建構 IPMI request 封包
- * 
- * @param msg - IPMI 訊息（包含 netfn, cmd, data）
- * @param buffer - 輸出緩衝區
- * @param len - 輸入時為緩衝區大小，輸出時為實際封包長度
- * @return 0 成功，負數失敗
+ * 預先算好 (netfn, cmd) 的 request 樣板
+ *
+ * RMCP header、session header（無認證）、message header 和 header checksum
+ * 對同一個命令永遠一樣，只需要算一次
  */
-int ipmi_build_request(const ipmi_msg_t* msg, uint8_t* buffer, size_t* len) {
-    if (!msg || !buffer || !len) {
-        return BMC_ERROR_INVALID_PARAM;
-    }
-    
-    // 檢查緩衝區是否足夠
-    size_t required_size = sizeof(rmcp_header_t) + 
-                          sizeof(ipmi_session_header_t) +
-                          1 +  // msg_len
-                          sizeof(ipmi_msg_header_t) +
-                          msg->data_len +
-                          1;   // data_checksum
-    
-    if (*len < required_size) {
-        return BMC_ERROR_MEMORY;
-    }
-    
-    uint8_t* ptr = buffer;
+void ipmi_req_tmpl_init(ipmi_req_tmpl_t* tmpl, uint8_t netfn, uint8_t cmd) {
+    uint8_t* ptr = tmpl->hdr;
+    memset(tmpl->hdr, 0, sizeof(tmpl->hdr));
     
     /* 1. RMCP Header */
     rmcp_header_t* rmcp = (rmcp_header_t*)ptr;
@@ -37,131 +26,387 @@ int ipmi_build_request(const ipmi_msg_t* msg, uint8_t* buffer, size_t* len) {
     rmcp->class = RMCP_CLASS_IPMI;
     ptr += sizeof(rmcp_header_t);
     
-    /* 2. Session Header (無認證) */
-    ipmi_session_header_t* session = (ipmi_session_header_t*)ptr;
-    session->auth_type = IPMI_AUTH_TYPE_NONE;
-    session->sequence = 0;  // 暫時用 0，實際應該遞增
-    session->id = 0;        // Session ID = 0 表示無 session
+    /* 2. Session Header (無認證，sequence 和 session ID 都是 0) */
     ptr += sizeof(ipmi_session_header_t);
     
-    /* 3. Message Length */
-    size_t msg_body_len = sizeof(ipmi_msg_header_t) + msg->data_len + 1;
-    *ptr++ = (uint8_t)msg_body_len;
+    /* 3. Message Length，建封包時依 payload 長度填 */
+    ptr++;
     
-    /* 4. IPMI Message Header */
+    /* 4. IPMI Message Header，seq 建封包時填 */
     ipmi_msg_header_t* msg_hdr = (ipmi_msg_header_t*)ptr;
     msg_hdr->target_addr = IPMI_BMC_SLAVE_ADDR;
-    msg_hdr->target_lun = (msg->netfn << 2);  // NetFn in upper 6 bits, LUN=0
+    msg_hdr->target_lun = (uint8_t)((netfn & 0x3F) << 2);  // NetFn in upper 6 bits, LUN=0
+    msg_hdr->header_checksum = ipmi_checksum(&msg_hdr->target_addr, 2);
+    msg_hdr->source_addr = IPMI_REMOTE_SWID;
+    msg_hdr->source_lun = 0;
+    msg_hdr->cmd = cmd;
+    
+    // data checksum 裡固定的部分：source_addr + cmd
+    tmpl->sum = (uint8_t)(IPMI_REMOTE_SWID + cmd);
+}
+
+static void tmpl_cache_init(void) {
+    for (size_t idx = 0; idx < sizeof(g_tmpl_cache) / sizeof(g_tmpl_cache[0]); idx++) {
+        ipmi_req_tmpl_init(&g_tmpl_cache[idx], (uint8_t)(idx >> 8), (uint8_t)idx);
+    }
+}
+
+const ipmi_req_tmpl_t* ipmi_req_tmpl_get(uint8_t netfn, uint8_t cmd) {
+    pthread_once(&g_tmpl_once, tmpl_cache_init);
+    
+    return &g_tmpl_cache[((size_t)(netfn & 0x3F) << 8) | cmd];
+}
+
+/**
+ * 用樣板建構 request 封包
+ *
+ * 樣板整段複製過去，再補 msg_len、seq、payload 和 data checksum；
+ * payload 用 iovec 給，複製的同時就把 checksum 算完，不用先湊成 ipmi_msg_t
+ *
+ * @param tmpl - ipmi_req_tmpl_init / ipmi_req_tmpl_get 取得的樣板
+ * @param seq - rqSeq（6 bits）
+ * @param iov - payload 片段，可為 NULL（iovcnt 為 0）
+ * @param iovcnt - 片段數
+ * @param buffer - 輸出緩衝區
+ * @param len - 輸入時為緩衝區大小，輸出時為實際封包長度
+ * @return 0 成功，負數失敗
+ */
+int ipmi_req_build(const ipmi_req_tmpl_t* tmpl, uint8_t seq,
+                   const struct iovec* iov, size_t iovcnt,
+                   uint8_t* buffer, size_t* len) {
+    if (!tmpl || !buffer || !len || (iovcnt > 0 && !iov)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
     
-    // 計算 header checksum
-    uint8_t header_data[2];
-    header_data[0] = msg_hdr->target_addr;
-    header_data[1] = msg_hdr->target_lun;
-    msg_hdr->header_checksum = ipmi_checksum(header_data, 2);
+    size_t data_len = 0;
+    for (size_t i = 0; i < iovcnt; i++) {
+        data_len += iov[i].iov_len;
+    }
     
-    msg_hdr->source_addr = IPMI_REMOTE_SWID;
-    msg_hdr->source_lun = (msg->seq << 2);    // Seq in upper 6 bits, LUN=0
-    msg_hdr->cmd = msg->cmd;
-    ptr += sizeof(ipmi_msg_header_t);
+    // msg_len 只有一個 byte
+    size_t msg_body_len = sizeof(ipmi_msg_header_t) + data_len + 1;
+    if (data_len > IPMI_MAX_DATA_SIZE || msg_body_len > 0xFF) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
     
-    /* 5. Data */
-    if (msg->data_len > 0) {
-        memcpy(ptr, msg->data, msg->data_len);
-        ptr += msg->data_len;
+    if (*len < IPMI_REQ_HDR_LEN + data_len + 1) {
+        return BMC_ERROR_MEMORY;
     }
     
-    /* 6. Data Checksum */
-    // Checksum 包含：source_addr, source_lun, cmd, data
-    size_t checksum_data_len = 3 + msg->data_len;  // 3 = source_addr + source_lun + cmd
-    uint8_t* checksum_start = (uint8_t*)&msg_hdr->source_addr;
-    *ptr++ = ipmi_checksum(checksum_start, checksum_data_len);
+    memcpy(buffer, tmpl->hdr, IPMI_REQ_HDR_LEN);
+    buffer[IPMI_REQ_MSG_LEN_OFF] = (uint8_t)msg_body_len;
+    
+    uint8_t seq_lun = (uint8_t)((seq & 0x3F) << 2);  // Seq in upper 6 bits, LUN=0
+    buffer[IPMI_REQ_SEQ_OFF] = seq_lun;
     
-    /* 更新實際長度 */
-    *len = ptr - buffer;
+    // 用 32-bit 累加，最後只取低 8 bits
+    uint32_t sum = (uint32_t)tmpl->sum + seq_lun;
+    uint8_t* ptr = buffer + IPMI_REQ_HDR_LEN;
+    for (size_t i = 0; i < iovcnt; i++) {
+        const uint8_t* src = iov[i].iov_base;
+        for (size_t j = 0; j < iov[i].iov_len; j++) {
+            sum += src[j];
+            ptr[j] = src[j];
+        }
+        ptr += iov[i].iov_len;
+    }
+    
+    /* Data Checksum：source_addr, source_lun, cmd, data 的 two's complement */
+    *ptr++ = (uint8_t)(-sum);
+    
+    *len = (size_t)(ptr - buffer);
     
     return BMC_SUCCESS;
 }
 
 /**
- * 解析 IPMI response 封包
+ * 直接改已經建好的封包的 seq，data checksum 跟著補差值
+ *
+ * 封包可以先建好放著，真正送出（拿到 seq）時才呼叫
+ */
+void ipmi_req_set_seq(uint8_t* packet, size_t len, uint8_t seq) {
+    if (!packet || len <= IPMI_REQ_HDR_LEN) {
+        return;
+    }
+    
+    uint8_t old = packet[IPMI_REQ_SEQ_OFF];
+    uint8_t now = (uint8_t)(((seq & 0x3F) << 2) | (old & 0x03));
+    
+    packet[IPMI_REQ_SEQ_OFF] = now;
+    packet[len - 1] = (uint8_t)(packet[len - 1] - (uint8_t)(now - old));
+}
+
+int ipmi_msg_is_bridged(const ipmi_msg_t* msg) {
+    return msg->target_addr != 0 && msg->target_addr != IPMI_BMC_SLAVE_ADDR;
+}
+
+/**
+ * 建構橋接 request：外層是給 BMC 的 Send Message，data 是 channel byte 加上整個 IPMB message
+ *
+ * IPMB message 的 rqSA 是 BMC（satellite 回給 BMC，BMC 再轉回來），
+ * rqSeq 和外層一樣；兩層各自有 header checksum 和 data checksum
+ *
+ * @param msg - 要轉送的 request，target_addr / target_lun / channel 決定送給誰
+ * @param seq - rqSeq（6 bits），內外層共用
+ * @param buffer - 輸出緩衝區
+ * @param len - 輸入時為緩衝區大小，輸出時為實際封包長度
+ * @return 0 成功，負數失敗
+ */
+int ipmi_req_build_bridged(const ipmi_msg_t* msg, uint8_t seq, uint8_t* buffer, size_t* len) {
+    if (!msg || !buffer || !len) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (msg->data_len + IPMI_BRIDGE_OVERHEAD > IPMI_MAX_DATA_SIZE) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    uint8_t head[7];
+    head[0] = (uint8_t)(IPMI_SEND_MSG_TRACK | (msg->channel & 0x0F));
+    head[1] = msg->target_addr;
+    head[2] = (uint8_t)(((msg->netfn & 0x3F) << 2) | (msg->target_lun & 0x03));
+    head[3] = ipmi_checksum(&head[1], 2);
+    head[4] = IPMI_BMC_SLAVE_ADDR;
+    head[5] = (uint8_t)((seq & 0x3F) << 2);
+    head[6] = msg->cmd;
+    
+    // 內層 data checksum：rqSA、rqSeq、cmd 和 data 的 two's complement
+    uint32_t sum = (uint32_t)head[4] + head[5] + head[6];
+    for (size_t i = 0; i < msg->data_len; i++) {
+        sum += msg->data[i];
+    }
+    uint8_t tail = (uint8_t)(-sum);
+    
+    struct iovec iov[3] = {
+        { .iov_base = head, .iov_len = sizeof(head) },
+        { .iov_base = (void*)msg->data, .iov_len = msg->data_len },
+        { .iov_base = &tail, .iov_len = 1 }
+    };
+    
+    return ipmi_req_build(ipmi_req_tmpl_get(IPMI_NETFN_APP, IPMI_CMD_SEND_MESSAGE), seq,
+                          iov, 3, buffer, len);
+}
+
+/**
+ * 直接改已經建好的橋接封包的 seq
+ *
+ * 內層 rqSeq 在 data 的第 6 個 byte（channel、rsSA、netFn、chk、rqSA 之後），
+ * 內層 data checksum 是倒數第二個 byte。兩個一起改、總和不變，外層 checksum 不用動，
+ * 最後再交給 ipmi_req_set_seq 改外層
+ */
+void ipmi_req_set_seq_bridged(uint8_t* packet, size_t len, uint8_t seq) {
+    if (!packet || len < IPMI_REQ_HDR_LEN + IPMI_BRIDGE_OVERHEAD + 1) {
+        return;
+    }
+    
+    uint8_t* inner_seq = packet + IPMI_REQ_HDR_LEN + 5;
+    uint8_t old = *inner_seq;
+    uint8_t now = (uint8_t)(((seq & 0x3F) << 2) | (old & 0x03));
+    
+    *inner_seq = now;
+    packet[len - 2] = (uint8_t)(packet[len - 2] - (uint8_t)(now - old));
+    
+    ipmi_req_set_seq(packet, len, seq);
+}
+
+int ipmi_bridge_unwrap(const ipmi_rsp_view_t* outer, const ipmi_msg_t* req, uint8_t seq,
+                       ipmi_rsp_view_t* inner) {
+    if (!outer || !req || !inner) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (outer->cmd != IPMI_CMD_SEND_MESSAGE || outer->data_len < 1) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // BMC 沒轉送成功（0x80 逾時、0x81 仲裁失敗、0x82 NAK on write ...）
+    if (outer->data[0] != 0x00) {
+        *inner = *outer;
+        return BMC_SUCCESS;
+    }
+    
+    if (outer->data_len == 1) {
+        return IPMI_BRIDGE_PENDING;
+    }
+    
+    // 後面是完整的 IPMB response：rqSA, netFn/rqLUN, chk, rsSA, rqSeq/rsLUN, cmd, cc, data, chk
+    int ret = ipmi_msg_view(outer->data + 1, outer->data_len - 1, inner);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    uint8_t rs_addr = outer->data[1 + 3];
+    if (rs_addr != req->target_addr || inner->cmd != req->cmd || inner->seq != (seq & 0x3F) ||
+        inner->data_len < 1) {
+        bmc_log(LOG_LEVEL_DEBUG, "Bridged response mismatch: addr=0x%02x cmd=0x%02x seq=%d",
+                rs_addr, inner->cmd, inner->seq);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/**
+ * 建構 IPMI request 封包
  * 
+ * @param msg - IPMI 訊息（包含 netfn, cmd, data；target_addr 不是 BMC 時包成 Send Message）
+ * @param buffer - 輸出緩衝區
+ * @param len - 輸入時為緩衝區大小，輸出時為實際封包長度
+ * @return 0 成功，負數失敗
+ */
+int ipmi_build_request(const ipmi_msg_t* msg, uint8_t* buffer, size_t* len) {
+    if (!msg || !buffer || !len) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (ipmi_msg_is_bridged(msg)) {
+        return ipmi_req_build_bridged(msg, msg->seq, buffer, len);
+    }
+    
+    struct iovec iov = { .iov_base = (void*)msg->data, .iov_len = msg->data_len };
+    
+    return ipmi_req_build(ipmi_req_tmpl_get(msg->netfn, msg->cmd), msg->seq,
+                          &iov, 1, buffer, len);
+}
+
+/**
+ * 在收到的 buffer 上直接驗證並解析 IPMI response，不複製任何資料
+ *
+ * RMCP header、session header、header checksum 和 data checksum 都在
+ * 同一次走訪裡檢查完；view->data 指向 buffer 裡的 payload，
+ * 只在 buffer 還有效的期間能用
+ *
  * @param buffer - 接收到的封包
  * @param len - 封包長度
- * @param msg - 輸出的 IPMI 訊息
+ * @param view - 輸出，指向 buffer 內部
  * @return 0 成功，負數失敗
  */
-int ipmi_parse_response(const uint8_t* buffer, size_t len, ipmi_msg_t* msg) {
-    if (!buffer || !msg || len < 20) {  // 最小封包大小
+int ipmi_rsp_view(const uint8_t* buffer, size_t len, ipmi_rsp_view_t* view) {
+    if (!buffer || !view) {
         return BMC_ERROR_INVALID_PARAM;
     }
     
-    const uint8_t* ptr = buffer;
-    
-    /* 1. 驗證 RMCP Header */
-    const rmcp_header_t* rmcp = (const rmcp_header_t*)ptr;
+    /* 1. RMCP Header */
+    if (len < sizeof(rmcp_header_t) + 1) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    const rmcp_header_t* rmcp = (const rmcp_header_t*)buffer;
     if (rmcp->version != RMCP_VERSION_1_0 || rmcp->class != RMCP_CLASS_IPMI) {
-        bmc_log(LOG_LEVEL_ERROR, "Invalid RMCP header");
+        bmc_log(LOG_LEVEL_DEBUG, "Invalid RMCP header");
         return BMC_ERROR_PROTOCOL;
     }
-    ptr += sizeof(rmcp_header_t);
     
-    /* 2. Session Header */
-    const ipmi_session_header_t* session = (const ipmi_session_header_t*)ptr;
-    if (session->auth_type != IPMI_AUTH_TYPE_NONE) {
-        bmc_log(LOG_LEVEL_WARN, "Authentication not supported yet");
+    /* 2. Session Header：有認證的話後面多 16 bytes 的 auth code */
+    size_t off = sizeof(rmcp_header_t);
+    uint8_t auth_type = buffer[off];
+    size_t session_len = sizeof(ipmi_session_header_t);
+    if (auth_type == IPMI_AUTH_TYPE_MD2 || auth_type == IPMI_AUTH_TYPE_MD5 ||
+        auth_type == IPMI_AUTH_TYPE_PASSWORD) {
+        session_len += 16;
+    } else if (auth_type != IPMI_AUTH_TYPE_NONE) {
+        bmc_log(LOG_LEVEL_DEBUG, "Unsupported auth type 0x%02x", auth_type);
+        return BMC_ERROR_PROTOCOL;
     }
-    ptr += sizeof(ipmi_session_header_t);
+    off += session_len;
     
-    /* 3. Message Length */
-    uint8_t msg_len = *ptr++;
-    if (ptr + msg_len > buffer + len) {
-        bmc_log(LOG_LEVEL_ERROR, "Invalid message length");
+    /* 3. Message Length：至少要有 header (6) + data checksum (1) */
+    if (len < off + 1) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    size_t msg_len = buffer[off++];
+    if (msg_len < sizeof(ipmi_msg_header_t) + 1 || msg_len > len - off) {
+        bmc_log(LOG_LEVEL_DEBUG, "Invalid message length %zu (packet %zu bytes)", msg_len, len);
         return BMC_ERROR_PROTOCOL;
     }
     
-    /* 4. IPMI Message Header */
-    const ipmi_msg_header_t* msg_hdr = (const ipmi_msg_header_t*)ptr;
+    /* 4. IPMI Message */
+    return ipmi_msg_view(buffer + off, msg_len, view);
+}
+
+/**
+ * 驗證 IPMI message（rsAddr 到 data checksum）並填 view
+ *
+ * 一次走完：前 3 bytes 的和是 header checksum，之後到結尾的和是 data checksum。
+ * RMCP 和 RMCP+ 的 IPMI payload 格式一樣，兩邊共用。
+ */
+int ipmi_msg_view(const uint8_t* msg, size_t msg_len, ipmi_rsp_view_t* view) {
+    if (msg_len < sizeof(ipmi_msg_header_t) + 1) {
+        bmc_log(LOG_LEVEL_DEBUG, "Message too short: %zu bytes", msg_len);
+        return BMC_ERROR_PROTOCOL;
+    }
     
-    // 驗證 header checksum
-    uint8_t header_data[2];
-    header_data[0] = msg_hdr->target_addr;
-    header_data[1] = msg_hdr->target_lun;
-    uint8_t expected_header_checksum = ipmi_checksum(header_data, 2);
-    if (msg_hdr->header_checksum != expected_header_checksum) {
-        bmc_log(LOG_LEVEL_ERROR, "Header checksum mismatch: expected 0x%02x, got 0x%02x",
-                expected_header_checksum, msg_hdr->header_checksum);
+    // RMCP+ 的 payload 長度是 16 bits，payload 比 ipmi_msg_t 放得下的還長就不收
+    if (msg_len - sizeof(ipmi_msg_header_t) - 1 > IPMI_MAX_DATA_SIZE) {
+        bmc_log(LOG_LEVEL_DEBUG, "Message too long: %zu bytes", msg_len);
         return BMC_ERROR_PROTOCOL;
     }
     
-    ptr += sizeof(ipmi_msg_header_t);
+    uint8_t header_sum = (uint8_t)(msg[0] + msg[1] + msg[2]);
+    uint32_t data_sum = 0;
+    for (size_t i = 3; i < msg_len; i++) {
+        data_sum += msg[i];
+    }
     
-    /* 5. 提取資料 */
-    msg->netfn = (msg_hdr->target_lun >> 2);  // Response 的 NetFn = Request NetFn | 1
-    msg->cmd = msg_hdr->cmd;
-    msg->seq = (msg_hdr->source_lun >> 2);
+    if (header_sum != 0) {
+        bmc_log(LOG_LEVEL_DEBUG, "Header checksum mismatch: got 0x%02x", msg[2]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    if ((data_sum & 0xFF) != 0) {
+        bmc_log(LOG_LEVEL_DEBUG, "Data checksum mismatch: got 0x%02x", msg[msg_len - 1]);
+        return BMC_ERROR_PROTOCOL;
+    }
     
-    // Data length = msg_len - header - data_checksum
-    msg->data_len = msg_len - sizeof(ipmi_msg_header_t) - 1;
+    const ipmi_msg_header_t* msg_hdr = (const ipmi_msg_header_t*)msg;
+    view->netfn = msg_hdr->target_lun >> 2;  // Response 的 NetFn = Request NetFn | 1
+    view->seq = msg_hdr->source_lun >> 2;
+    view->cmd = msg_hdr->cmd;
+    view->data = msg + sizeof(ipmi_msg_header_t);
+    view->data_len = msg_len - sizeof(ipmi_msg_header_t) - 1;
     
-    if (msg->data_len > 0) {
-        if (msg->data_len > IPMI_MAX_DATA_SIZE) {
-            bmc_log(LOG_LEVEL_ERROR, "Data too large: %zu bytes", msg->data_len);
-            return BMC_ERROR_PROTOCOL;
-        }
-        memcpy(msg->data, ptr, msg->data_len);
-        ptr += msg->data_len;
-    }
-    
-    /* 6. 驗證 data checksum */
-    uint8_t data_checksum = *ptr;
-    size_t checksum_data_len = 3 + msg->data_len;
-    const uint8_t* checksum_start = (const uint8_t*)&msg_hdr->source_addr;
-    uint8_t expected_data_checksum = ipmi_checksum(checksum_start, checksum_data_len);
-    if (data_checksum != expected_data_checksum) {
-        bmc_log(LOG_LEVEL_ERROR, "Data checksum mismatch: expected 0x%02x, got 0x%02x",
-                expected_data_checksum, data_checksum);
-        return BMC_ERROR_PROTOCOL;
+    return BMC_SUCCESS;
+}
+
+// 把 view 的內容複製到 ipmi_msg_t（給需要自己保存回應的呼叫端）
+// ipmi_msg_view 出來的不會超過 IPMI_MAX_DATA_SIZE，自己組的 view 超過就截斷
+void ipmi_rsp_copy(const ipmi_rsp_view_t* view, ipmi_msg_t* msg) {
+    size_t len = view->data_len > IPMI_MAX_DATA_SIZE ? IPMI_MAX_DATA_SIZE : view->data_len;
+    
+    msg->netfn = view->netfn;
+    msg->cmd = view->cmd;
+    msg->seq = view->seq;
+    msg->data_len = len;
+    memcpy(msg->data, view->data, len);
+}
+
+// 反過來，讓存在 ipmi_msg_t 裡的回應也能交給吃 view 的解碼函式
+void ipmi_msg_as_view(const ipmi_msg_t* msg, ipmi_rsp_view_t* view) {
+    view->netfn = msg->netfn;
+    view->cmd = msg->cmd;
+    view->seq = msg->seq;
+    view->data = msg->data;
+    view->data_len = msg->data_len;
+}
+
+/**
+ * 解析 IPMI response 封包
+ * 
+ * @param buffer - 接收到的封包
+ * @param len - 封包長度
+ * @param msg - 輸出的 IPMI 訊息
+ * @return 0 成功，負數失敗
+ */
+int ipmi_parse_response(const uint8_t* buffer, size_t len, ipmi_msg_t* msg) {
+    if (!buffer || !msg) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_rsp_view_t view;
+    int ret = ipmi_rsp_view(buffer, len, &view);
+    if (ret != BMC_SUCCESS) {
+        return ret;
     }
     
+    ipmi_rsp_copy(&view, msg);
+    
     return BMC_SUCCESS;
 }
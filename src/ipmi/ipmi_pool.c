@@ -0,0 +1,423 @@
+#include "bmctool/ipmi_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_DEFAULT_KEEPALIVE_MS   30000
+
+typedef struct {
+    ipmi_ctx_t* ctx;
+    ipmi_session_key_t key;  // 同 session 快取的 key：連線、帳密、cipher suite、privilege
+    int in_use;
+} pool_entry_t;
+
+struct ipmi_pool {
+    pool_entry_t* entries;
+    size_t count;
+    size_t cap;
+    
+    int keepalive_ms;
+    int cipher_suite;
+    uint8_t privilege;
+    int timeout_ms;          // 0 表示用 ctx 預設值
+    int retries;             // < 0 表示用 ctx 預設值
+    ipmi_session_cache_t* session_cache;
+};
+
+ipmi_pool_t* ipmi_pool_create(int keepalive_ms) {
+    ipmi_pool_t* pool = calloc(1, sizeof(ipmi_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    
+    pool->keepalive_ms = keepalive_ms > 0 ? keepalive_ms : POOL_DEFAULT_KEEPALIVE_MS;
+    pool->cipher_suite = 17;
+    pool->privilege = IPMI_PRIV_ADMIN;
+    pool->retries = -1;
+    
+    return pool;
+}
+
+void ipmi_pool_destroy(ipmi_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+    
+    for (size_t i = 0; i < pool->count; i++) {
+        ipmi_ctx_destroy(pool->entries[i].ctx);
+    }
+    
+    free(pool->entries);
+    free(pool);
+}
+
+int ipmi_pool_set_lanplus(ipmi_pool_t* pool, int cipher_suite, uint8_t privilege) {
+    if (!pool || (cipher_suite != 0 && cipher_suite != 3 && cipher_suite != 17) ||
+        privilege > IPMI_PRIV_ADMIN) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    pool->cipher_suite = cipher_suite ? cipher_suite : 17;
+    pool->privilege = privilege ? privilege : IPMI_PRIV_ADMIN;
+    return BMC_SUCCESS;
+}
+
+int ipmi_pool_set_timeout(ipmi_pool_t* pool, int timeout_ms) {
+    if (!pool || timeout_ms <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    pool->timeout_ms = timeout_ms;
+    return BMC_SUCCESS;
+}
+
+int ipmi_pool_set_retries(ipmi_pool_t* pool, int retries) {
+    if (!pool || retries < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    pool->retries = retries;
+    return BMC_SUCCESS;
+}
+
+int ipmi_pool_set_session_cache(ipmi_pool_t* pool, ipmi_session_cache_t* cache) {
+    if (!pool) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    pool->session_cache = cache;
+    return BMC_SUCCESS;
+}
+
+size_t ipmi_pool_size(const ipmi_pool_t* pool) {
+    return pool ? pool->count : 0;
+}
+
+static void remove_entry(ipmi_pool_t* pool, size_t i) {
+    ipmi_ctx_destroy(pool->entries[i].ctx);
+    pool->entries[i] = pool->entries[--pool->count];
+}
+
+static int find_entry(const ipmi_pool_t* pool, const ipmi_ctx_t* ctx) {
+    for (size_t i = 0; i < pool->count; i++) {
+        if (pool->entries[i].ctx == ctx) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// 閒置太久的先 ping 一下，BMC 可能已經把 session timeout 掉了
+static int session_alive(ipmi_pool_t* pool, ipmi_ctx_t* ctx) {
+    uint64_t idle_us = bmc_monotonic_us() - ctx->session.last_used_us;
+    if (idle_us < (uint64_t)pool->keepalive_ms * 1000) {
+        return 1;
+    }
+    
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = IPMI_CMD_GET_DEVICE_ID };
+    ipmi_msg_t rsp;
+    
+    if (ipmi_send_recv(ctx, &req, &rsp) != BMC_SUCCESS ||
+        rsp.data_len < 1 || rsp.data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_DEBUG, "Session to %s went stale", ctx->host);
+        return 0;
+    }
+    
+    return 1;
+}
+
+/*
+ * key 要連密碼一起比，不然密碼錯的人也能借到別人登入好的 session；
+ * cipher suite 和 privilege 不同的 session 也不能混用
+ */
+static void pool_key(const ipmi_pool_t* pool, const char* host, uint16_t port,
+                     const char* username, const char* password, ipmi_session_key_t* key) {
+    ipmi_session_cache_key(host, port, username, password, pool->cipher_suite, pool->privilege, key);
+}
+
+static ipmi_ctx_t* find_idle(ipmi_pool_t* pool, const ipmi_session_key_t* key) {
+    size_t i = 0;
+    while (i < pool->count) {
+        pool_entry_t* e = &pool->entries[i];
+        if (e->in_use || memcmp(e->key.digest, key->digest, sizeof(key->digest)) != 0) {
+            i++;
+            continue;
+        }
+        
+        // 死掉的移掉之後 i 換成原本最後一筆，繼續找
+        if (!session_alive(pool, e->ctx)) {
+            remove_entry(pool, i);
+            continue;
+        }
+        
+        e->in_use = 1;
+        return e->ctx;
+    }
+    
+    return NULL;
+}
+
+// entries 至少放得下 need 筆
+static int reserve(ipmi_pool_t* pool, size_t need) {
+    if (need <= pool->cap) {
+        return BMC_SUCCESS;
+    }
+    
+    size_t cap = pool->cap ? pool->cap : 16;
+    while (cap < need) {
+        cap *= 2;
+    }
+    pool_entry_t* entries = realloc(pool->entries, cap * sizeof(*entries));
+    if (!entries) {
+        return BMC_ERROR_MEMORY;
+    }
+    pool->entries = entries;
+    pool->cap = cap;
+    
+    return BMC_SUCCESS;
+}
+
+static int grow(ipmi_pool_t* pool) {
+    return reserve(pool, pool->count + 1);
+}
+
+// 新建的 ctx 套上 pool 的設定（還沒登入）
+static int ctx_setup(ipmi_pool_t* pool, ipmi_ctx_t* ctx, const char* username, const char* password) {
+    if (pool->timeout_ms > 0) {
+        ipmi_ctx_set_timeout(ctx, pool->timeout_ms);
+    }
+    if (pool->retries >= 0) {
+        ipmi_ctx_set_retries(ctx, pool->retries);
+    }
+    ipmi_ctx_set_session_cache(ctx, pool->session_cache);
+    
+    int ret = ipmi_ctx_set_auth(ctx, username, password);
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_ctx_set_lanplus(ctx, pool->cipher_suite, pool->privilege);
+    }
+    
+    return ret;
+}
+
+// 登入好的 ctx 放進 pool，標成借出（呼叫端先 grow 過）
+static void pool_insert(ipmi_pool_t* pool, ipmi_ctx_t* ctx, const ipmi_session_key_t* key) {
+    pool->entries[pool->count].ctx = ctx;
+    pool->entries[pool->count].key = *key;
+    pool->entries[pool->count].in_use = 1;
+    pool->count++;
+}
+
+// 新建的 ctx 登入，成功就放進 pool（標成借出），失敗就銷毀
+static ipmi_ctx_t* open_new(ipmi_pool_t* pool, ipmi_ctx_t* ctx, const ipmi_session_key_t* key,
+                            const char* username, const char* password, int* err) {
+    int ret = grow(pool);
+    if (ret == BMC_SUCCESS) {
+        ret = ctx_setup(pool, ctx, username, password);
+    }
+    if (ret == BMC_SUCCESS) {
+        ret = ipmi_ctx_open(ctx);
+    }
+    if (ret != BMC_SUCCESS) {
+        ipmi_ctx_destroy(ctx);
+        if (err) {
+            *err = ret;
+        }
+        return NULL;
+    }
+    
+    pool_insert(pool, ctx, key);
+    return ctx;
+}
+
+ipmi_ctx_t* ipmi_pool_acquire(ipmi_pool_t* pool, const char* host, uint16_t port,
+                              const char* username, const char* password, int* err) {
+    if (!pool || !host || !username || !password) {
+        if (err) {
+            *err = BMC_ERROR_INVALID_PARAM;
+        }
+        return NULL;
+    }
+    
+    if (port == 0) {
+        port = IPMI_DEFAULT_PORT;
+    }
+    
+    ipmi_session_key_t key;
+    pool_key(pool, host, port, username, password, &key);
+    
+    ipmi_ctx_t* ctx = find_idle(pool, &key);
+    if (ctx) {
+        return ctx;
+    }
+    
+    ctx = ipmi_ctx_create();
+    if (!ctx) {
+        if (err) {
+            *err = BMC_ERROR_MEMORY;
+        }
+        return NULL;
+    }
+    ipmi_ctx_set_target(ctx, host, port);
+    
+    return open_new(pool, ctx, &key, username, password, err);
+}
+
+ipmi_ctx_t* ipmi_pool_acquire_addr(ipmi_pool_t* pool, const char* host, const ipmi_addr_t* addr,
+                                   const char* username, const char* password, int* err) {
+    if (!pool || !addr || addr->addrlen == 0 || !username || !password) {
+        if (err) {
+            *err = BMC_ERROR_INVALID_PARAM;
+        }
+        return NULL;
+    }
+    
+    // 先建 ctx 拿到正規化的 host/port 再找，key 和 ipmi_pool_acquire 一致
+    ipmi_ctx_t* ctx = ipmi_ctx_create();
+    if (!ctx) {
+        if (err) {
+            *err = BMC_ERROR_MEMORY;
+        }
+        return NULL;
+    }
+    ipmi_ctx_set_target_addr(ctx, host, addr);
+    
+    ipmi_session_key_t key;
+    pool_key(pool, ctx->host, ctx->port, username, password, &key);
+    
+    ipmi_ctx_t* idle = find_idle(pool, &key);
+    if (idle) {
+        ipmi_ctx_destroy(ctx);
+        return idle;
+    }
+    
+    return open_new(pool, ctx, &key, username, password, err);
+}
+
+/*
+ * 一批新建的 ctx 一起登入（ipmi_ctx_open_bulk），成功的放進 pool
+ * fresh[k] 對應 ctxs[slot[k]]；全部交出去（放進 pool 或銷毀），失敗的錯誤碼寫到 errs
+ */
+static int open_fresh(ipmi_pool_t* pool, ipmi_ctx_t* const* fresh, const ipmi_session_key_t* keys,
+                      const size_t* slot, size_t n, ipmi_ctx_t** ctxs, int* errs) {
+    int* status = calloc(n ? n : 1, sizeof(int));
+    int ret = status ? ipmi_ctx_open_bulk(fresh, n, status) : BMC_ERROR_MEMORY;
+    for (size_t k = 0; k < n; k++) {
+        if (ret == BMC_SUCCESS && status[k] == BMC_SUCCESS) {
+            pool_insert(pool, fresh[k], &keys[k]);
+            ctxs[slot[k]] = fresh[k];
+        } else {
+            ipmi_ctx_destroy(fresh[k]);
+            errs[slot[k]] = ret == BMC_SUCCESS ? status[k] : ret;
+        }
+    }
+    
+    free(status);
+    return ret;
+}
+
+int ipmi_pool_acquire_bulk(ipmi_pool_t* pool, const char* const* hosts, const ipmi_addr_t* addrs,
+                           size_t count, const char* username, const char* password,
+                           ipmi_ctx_t** ctxs, int* errs) {
+    if (!pool || ((!hosts || !addrs || !ctxs || !errs) && count > 0) || !username || !password) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_ctx_t** fresh = calloc(count ? count : 1, sizeof(ipmi_ctx_t*));
+    ipmi_session_key_t* keys = calloc(count ? count : 1, sizeof(ipmi_session_key_t));
+    size_t* slot = calloc(count ? count : 1, sizeof(size_t));
+    if (!fresh || !keys || !slot) {
+        free(fresh);
+        free(keys);
+        free(slot);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    // 先把 pool 的空間留夠，登入完放進去時就不會失敗
+    int ret = reserve(pool, pool->count + count);
+    if (ret != BMC_SUCCESS) {
+        free(fresh);
+        free(keys);
+        free(slot);
+        return ret;
+    }
+    
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        ctxs[i] = NULL;
+        errs[i] = addrs[i].status;
+        if (addrs[i].status != BMC_SUCCESS || addrs[i].addrlen == 0) {
+            continue;
+        }
+        
+        ipmi_ctx_t* ctx = ipmi_ctx_create();
+        if (!ctx) {
+            errs[i] = BMC_ERROR_MEMORY;
+            continue;
+        }
+        ipmi_ctx_set_target_addr(ctx, hosts[i], &addrs[i]);
+        pool_key(pool, ctx->host, ctx->port, username, password, &keys[n]);
+        
+        // 有閒置的就直接借
+        ctxs[i] = find_idle(pool, &keys[n]);
+        if (ctxs[i]) {
+            ipmi_ctx_destroy(ctx);
+            continue;
+        }
+        
+        errs[i] = ctx_setup(pool, ctx, username, password);
+        if (errs[i] != BMC_SUCCESS) {
+            ipmi_ctx_destroy(ctx);
+            continue;
+        }
+        fresh[n] = ctx;
+        slot[n++] = i;
+    }
+    
+    ret = open_fresh(pool, fresh, keys, slot, n, ctxs, errs);
+    
+    free(fresh);
+    free(keys);
+    free(slot);
+    return ret;
+}
+
+void ipmi_pool_release(ipmi_pool_t* pool, ipmi_ctx_t* ctx) {
+    if (!pool || !ctx) {
+        return;
+    }
+    
+    int i = find_entry(pool, ctx);
+    if (i >= 0) {
+        pool->entries[i].in_use = 0;
+    }
+}
+
+void ipmi_pool_discard(ipmi_pool_t* pool, ipmi_ctx_t* ctx) {
+    if (!pool || !ctx) {
+        return;
+    }
+    
+    int i = find_entry(pool, ctx);
+    if (i >= 0) {
+        remove_entry(pool, (size_t)i);
+    }
+}
+
+int ipmi_pool_keepalive(ipmi_pool_t* pool) {
+    if (!pool) {
+        return 0;
+    }
+    
+    int dropped = 0;
+    size_t i = 0;
+    while (i < pool->count) {
+        pool_entry_t* e = &pool->entries[i];
+        if (!e->in_use && !session_alive(pool, e->ctx)) {
+            remove_entry(pool, i);
+            dropped++;
+            continue;
+        }
+        i++;
+    }
+    
+    return dropped;
+}
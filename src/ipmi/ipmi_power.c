@@ -0,0 +1,451 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_power.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#define POWER_RSP_LEN           19      // cc + group ID + 17 bytes
+#define POWER_STATE_ACTIVE      0x40
+
+#define POWER_RING_MIN          1024
+#define POWER_RING_PER_TARGET   64      // 預設每台留 64 筆，寫出前大約可以累積 32 個 tick
+
+static const uint8_t g_power_req[] = {
+    IPMI_DCMI_GROUP_ID, IPMI_DCMI_POWER_MODE_SYSTEM, 0x00, 0x00
+};
+
+static uint16_t get_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int ipmi_decode_dcmi_power_reading(const ipmi_rsp_view_t* rsp, ipmi_dcmi_power_t* power) {
+    if (!rsp || !power) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (rsp->data_len < 1) {
+        bmc_log(LOG_LEVEL_ERROR, "Response too short");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (rsp->data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_DEBUG, "Get Power Reading failed: completion code 0x%02x", rsp->data[0]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (rsp->data_len < POWER_RSP_LEN || rsp->data[1] != IPMI_DCMI_GROUP_ID) {
+        bmc_log(LOG_LEVEL_ERROR, "Bad Get Power Reading response (%zu bytes)", rsp->data_len);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    const uint8_t* d = rsp->data + 2;
+    power->current_watts = get_le16(d);
+    power->min_watts = get_le16(d + 2);
+    power->max_watts = get_le16(d + 4);
+    power->avg_watts = get_le16(d + 6);
+    power->timestamp = get_le32(d + 8);
+    power->period_ms = get_le32(d + 12);
+    power->active = (d[16] & POWER_STATE_ACTIVE) != 0;
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_dcmi_get_power_reading(ipmi_ctx_t* ctx, ipmi_dcmi_power_t* power) {
+    if (!ctx || !power) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_msg_t req = {
+        .netfn = IPMI_NETFN_DCGRP,
+        .cmd = IPMI_CMD_DCMI_GET_POWER_READING,
+        .data_len = sizeof(g_power_req)
+    };
+    memcpy(req.data, g_power_req, sizeof(g_power_req));
+    
+    ipmi_msg_t rsp;
+    int ret = ipmi_send_recv(ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    ipmi_rsp_view_t view;
+    ipmi_msg_as_view(&rsp, &view);
+    
+    return ipmi_decode_dcmi_power_reading(&view, power);
+}
+
+/* Ring buffer */
+
+int ipmi_power_ring_init(ipmi_power_ring_t* ring, size_t capacity) {
+    if (!ring || capacity == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(ring, 0, sizeof(*ring));
+    ring->samples = calloc(capacity, sizeof(ipmi_power_sample_t));
+    if (!ring->samples) {
+        return BMC_ERROR_MEMORY;
+    }
+    ring->capacity = capacity;
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_power_ring_free(ipmi_power_ring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    
+    free(ring->samples);
+    memset(ring, 0, sizeof(*ring));
+}
+
+ipmi_power_sample_t* ipmi_power_ring_push(ipmi_power_ring_t* ring) {
+    size_t pos;
+    
+    if (ring->count == ring->capacity) {
+        pos = ring->head;
+        ring->head = (ring->head + 1) % ring->capacity;
+        ring->dropped++;
+    } else {
+        pos = (ring->head + ring->count) % ring->capacity;
+        ring->count++;
+    }
+    
+    return &ring->samples[pos];
+}
+
+static const char* sample_status_name(uint8_t status) {
+    switch (status) {
+        case IPMI_POWER_SAMPLE_OK: return "ok";
+        case IPMI_POWER_SAMPLE_INACTIVE: return "inactive";
+        default: return "error";
+    }
+}
+
+static void write_csv(FILE* fp, const ipmi_power_sample_t* s, size_t n, const ipmi_engine_t* eng) {
+    for (size_t i = 0; i < n; i++) {
+        const char* host = eng ? ipmi_engine_target_host(eng, s[i].target) : NULL;
+        if (host) {
+            fprintf(fp, "%llu,%u,%s,", (unsigned long long)s[i].t_us, s[i].tick, host);
+        } else {
+            fprintf(fp, "%llu,%u,%u,", (unsigned long long)s[i].t_us, s[i].tick, s[i].target);
+        }
+        fprintf(fp, "%u,%s,0x%02x,%u\n", s[i].watts, sample_status_name(s[i].status),
+                s[i].cc, s[i].latency_us);
+    }
+}
+
+long ipmi_power_ring_flush(ipmi_power_ring_t* ring, FILE* fp, int format,
+                           const ipmi_engine_t* eng) {
+    if (!ring || !fp) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // 繞回時分成兩段，各寫一次
+    size_t n = ring->count;
+    size_t first = ring->capacity - ring->head;
+    if (first > n) {
+        first = n;
+    }
+    
+    if (format == IPMI_POWER_OUTPUT_BINARY) {
+        fwrite(ring->samples + ring->head, sizeof(ipmi_power_sample_t), first, fp);
+        fwrite(ring->samples, sizeof(ipmi_power_sample_t), n - first, fp);
+    } else {
+        write_csv(fp, ring->samples + ring->head, first, eng);
+        write_csv(fp, ring->samples, n - first, eng);
+    }
+    
+    ring->head = 0;
+    ring->count = 0;
+    
+    if (fflush(fp) != 0 || ferror(fp)) {
+        return -1;
+    }
+    
+    return (long)n;
+}
+
+/* Sampler */
+
+typedef struct {
+    ipmi_power_sampler_t* sampler;
+    int disabled;
+    int busy;                    // request 還在路上
+    uint32_t tick;               // 這個 request 是哪個 tick 送的
+    uint64_t sent_us;
+} power_slot_t;
+
+struct ipmi_power_sampler {
+    ipmi_engine_t* eng;
+    uint64_t interval_us;
+    FILE* out;
+    int format;
+    int write_failed;
+    
+    ipmi_power_ring_t ring;
+    power_slot_t* slots;
+    int num_targets;
+    uint64_t start_us;
+    
+    ipmi_power_stats_t stats;
+    unsigned long jitter_n;
+    double jitter_m2;            // Welford 的平方差累計
+    unsigned long latency_n;
+    double latency_sum;
+};
+
+ipmi_power_sampler_t* ipmi_power_sampler_create(ipmi_engine_t* eng, int interval_ms,
+                                                size_t ring_capacity) {
+    if (!eng || interval_ms <= 0) {
+        return NULL;
+    }
+    
+    ipmi_power_sampler_t* s = calloc(1, sizeof(ipmi_power_sampler_t));
+    if (!s) {
+        return NULL;
+    }
+    
+    s->eng = eng;
+    s->interval_us = (uint64_t)interval_ms * 1000;
+    s->out = stdout;
+    s->format = IPMI_POWER_OUTPUT_CSV;
+    s->num_targets = ipmi_engine_num_targets(eng);
+    
+    if (ring_capacity == 0) {
+        ring_capacity = (size_t)s->num_targets * POWER_RING_PER_TARGET;
+        if (ring_capacity < POWER_RING_MIN) {
+            ring_capacity = POWER_RING_MIN;
+        }
+    }
+    
+    s->slots = calloc(s->num_targets ? s->num_targets : 1, sizeof(power_slot_t));
+    if (!s->slots || ipmi_power_ring_init(&s->ring, ring_capacity) != BMC_SUCCESS) {
+        ipmi_power_sampler_destroy(s);
+        return NULL;
+    }
+    
+    for (int t = 0; t < s->num_targets; t++) {
+        s->slots[t].sampler = s;
+    }
+    
+    return s;
+}
+
+void ipmi_power_sampler_destroy(ipmi_power_sampler_t* sampler) {
+    if (!sampler) {
+        return;
+    }
+    
+    ipmi_power_ring_free(&sampler->ring);
+    free(sampler->slots);
+    free(sampler);
+}
+
+int ipmi_power_sampler_set_output(ipmi_power_sampler_t* sampler, FILE* fp, int format) {
+    if (!sampler || !fp ||
+        (format != IPMI_POWER_OUTPUT_CSV && format != IPMI_POWER_OUTPUT_BINARY)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    sampler->out = fp;
+    sampler->format = format;
+    return BMC_SUCCESS;
+}
+
+int ipmi_power_sampler_disable_target(ipmi_power_sampler_t* sampler, int target) {
+    if (!sampler || target < 0 || target >= sampler->num_targets) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    sampler->slots[target].disabled = 1;
+    return BMC_SUCCESS;
+}
+
+static void power_done(ipmi_engine_t* eng, int target, int status,
+                       const ipmi_rsp_view_t* rsp, void* user_data) {
+    (void)eng;
+    power_slot_t* slot = (power_slot_t*)user_data;
+    ipmi_power_sampler_t* s = slot->sampler;
+    uint64_t now = bmc_monotonic_us();
+    
+    slot->busy = 0;
+    
+    ipmi_power_sample_t* sample = ipmi_power_ring_push(&s->ring);
+    memset(sample, 0, sizeof(*sample));
+    sample->t_us = now - s->start_us;
+    sample->tick = slot->tick;
+    sample->latency_us = (uint32_t)(now - slot->sent_us);
+    sample->target = (uint16_t)target;
+    sample->status = IPMI_POWER_SAMPLE_ERROR;
+    
+    ipmi_dcmi_power_t power;
+    if (status == BMC_SUCCESS) {
+        sample->cc = rsp->data_len > 0 ? rsp->data[0] : 0;
+        if (ipmi_decode_dcmi_power_reading(rsp, &power) == BMC_SUCCESS) {
+            sample->status = power.active ? IPMI_POWER_SAMPLE_OK : IPMI_POWER_SAMPLE_INACTIVE;
+            sample->watts = power.active ? power.current_watts : 0;
+        }
+        
+        s->latency_n++;
+        s->latency_sum += sample->latency_us;
+        if (sample->latency_us > s->stats.latency_max_us) {
+            s->stats.latency_max_us = sample->latency_us;
+        }
+    }
+    
+    s->stats.samples++;
+    if (sample->status == IPMI_POWER_SAMPLE_ERROR) {
+        s->stats.errors++;
+    }
+}
+
+static void jitter_add(ipmi_power_sampler_t* s, double x) {
+    s->jitter_n++;
+    double d = x - s->stats.jitter_mean_us;
+    s->stats.jitter_mean_us += d / s->jitter_n;
+    s->jitter_m2 += d * (x - s->stats.jitter_mean_us);
+    if (x > s->stats.jitter_max_us) {
+        s->stats.jitter_max_us = x;
+    }
+}
+
+static void start_tick(ipmi_power_sampler_t* s, uint32_t tick, uint64_t now) {
+    struct iovec iov = { .iov_base = (void*)g_power_req, .iov_len = sizeof(g_power_req) };
+    
+    for (int t = 0; t < s->num_targets; t++) {
+        power_slot_t* slot = &s->slots[t];
+        if (slot->disabled) {
+            continue;
+        }
+        // 上一個還沒回來就跳過這次，不讓慢的 BMC 越積越多
+        if (slot->busy) {
+            s->stats.overruns++;
+            continue;
+        }
+        
+        slot->tick = tick;
+        slot->sent_us = now;
+        if (ipmi_engine_submitv(s->eng, t, IPMI_NETFN_DCGRP, IPMI_CMD_DCMI_GET_POWER_READING,
+                                &iov, 1, power_done, slot) == BMC_SUCCESS) {
+            slot->busy = 1;
+        }
+    }
+}
+
+static void sleep_until(uint64_t deadline_us) {
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_us / 1000000),
+        .tv_nsec = (long)(deadline_us % 1000000) * 1000
+    };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+// 一邊收回應一邊等到 deadline；engine 的 timeout 只到 ms，剩下不到 1 ms 用 sleep 補
+static void wait_until(ipmi_power_sampler_t* s, uint64_t deadline_us,
+                       const volatile sig_atomic_t* stop) {
+    for (;;) {
+        if (stop && *stop) {
+            return;
+        }
+        
+        uint64_t now = bmc_monotonic_us();
+        if (now >= deadline_us) {
+            return;
+        }
+        
+        int ms = (int)((deadline_us - now) / 1000);
+        if (ms == 0 || ipmi_engine_pending(s->eng) == 0) {
+            sleep_until(deadline_us);
+            continue;
+        }
+        
+        if (ipmi_engine_run(s->eng, ms) < 0) {
+            sleep_until(deadline_us);
+        }
+    }
+}
+
+static void flush_ring(ipmi_power_sampler_t* s) {
+    if (s->ring.count == 0 || s->write_failed) {
+        return;
+    }
+    
+    if (ipmi_power_ring_flush(&s->ring, s->out, s->format, s->eng) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "Failed to write samples: %s", strerror(errno));
+        s->write_failed = 1;
+    }
+}
+
+int ipmi_power_sampler_run(ipmi_power_sampler_t* sampler, unsigned long ticks,
+                           const volatile sig_atomic_t* stop) {
+    if (!sampler) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_power_sampler_t* s = sampler;
+    
+    if (s->format == IPMI_POWER_OUTPUT_CSV) {
+        fprintf(s->out, "t_us,tick,host,watts,status,cc,latency_us\n");
+    }
+    
+    s->start_us = bmc_monotonic_us();
+    uint64_t next = s->start_us;
+    unsigned long tick = 0;
+    
+    while (!(stop && *stop) && !s->write_failed) {
+        uint64_t now = bmc_monotonic_us();
+        
+        // 落後超過一整個 interval（例如被暫停過）就跳過錯過的 tick，不要一口氣補送
+        if (now >= next + s->interval_us) {
+            uint64_t missed = (now - next) / s->interval_us;
+            next += missed * s->interval_us;
+            tick += missed;
+            s->stats.missed_ticks += missed;
+        }
+        if (ticks && tick >= ticks) {
+            break;
+        }
+        
+        jitter_add(s, (double)(now - next));
+        start_tick(s, (uint32_t)tick, now);
+        s->stats.ticks++;
+        tick++;
+        
+        // 寫檔放在送完之後，回應在路上時順便做
+        if (s->ring.count >= s->ring.capacity / 2) {
+            flush_ring(s);
+        }
+        
+        next += s->interval_us;
+        if (!ticks || tick < ticks) {
+            wait_until(s, next, stop);
+        }
+    }
+    
+    // 最後一輪的回應
+    ipmi_engine_run(s->eng, -1);
+    flush_ring(s);
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_power_sampler_get_stats(const ipmi_power_sampler_t* sampler, ipmi_power_stats_t* stats) {
+    if (!sampler || !stats) {
+        return;
+    }
+    
+    *stats = sampler->stats;
+    stats->dropped = sampler->ring.dropped;
+    stats->jitter_stddev_us = sampler->jitter_n > 1 ?
+                              sqrt(sampler->jitter_m2 / (sampler->jitter_n - 1)) : 0;
+    stats->latency_mean_us = sampler->latency_n ?
+                             sampler->latency_sum / sampler->latency_n : 0;
+}
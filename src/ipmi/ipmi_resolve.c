@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_resolve.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// getaddrinfo_a 一次送出的查詢數，避免一口氣塞爆 resolver
+#define RESOLVE_CHUNK   256
+
+static void fill_result(ipmi_addr_t* out, const struct addrinfo* ai) {
+    memcpy(&out->addr, ai->ai_addr, ai->ai_addrlen);
+    out->addrlen = ai->ai_addrlen;
+    out->status = BMC_SUCCESS;
+}
+
+static void init_hints(struct addrinfo* hints, int flags) {
+    memset(hints, 0, sizeof(*hints));
+    hints->ai_family = AF_UNSPEC;
+    hints->ai_socktype = SOCK_DGRAM;
+    hints->ai_flags = flags;
+}
+
+int ipmi_resolve(const char* host, uint16_t port, ipmi_addr_t* out) {
+    if (!host || !out) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", port ? port : IPMI_DEFAULT_PORT);
+    
+    struct addrinfo hints;
+    init_hints(&hints, AI_ADDRCONFIG);
+    
+    struct addrinfo* res = NULL;
+    int gai = getaddrinfo(host, port_str, &hints, &res);
+    if (gai != 0) {
+        bmc_log(LOG_LEVEL_ERROR, "getaddrinfo(%s) failed: %s", host, gai_strerror(gai));
+        out->addrlen = 0;
+        out->status = BMC_ERROR_NETWORK;
+        return BMC_ERROR_NETWORK;
+    }
+    
+    fill_result(out, res);
+    freeaddrinfo(res);
+    
+    return BMC_SUCCESS;
+}
+
+static size_t count_in_progress(struct gaicb* reqs, size_t n) {
+    size_t in_progress = 0;
+    for (size_t k = 0; k < n; k++) {
+        if (gai_error(&reqs[k]) == EAI_INPROGRESS) {
+            in_progress++;
+        }
+    }
+    return in_progress;
+}
+
+/*
+ * 等這一批全部查完
+ * gai_suspend 出錯就取消剩下的；取消不掉（EAI_NOTCANCELED）的 worker thread 之後
+ * 還會寫 reqs 和 port_strs，所以不管怎樣都要等到沒有 EAI_INPROGRESS 才能重用或 free
+ */
+static void wait_chunk(struct gaicb* reqs, struct gaicb** list, size_t n) {
+    int cancelled = 0;
+    
+    while (count_in_progress(reqs, n) > 0) {
+        int ret = gai_suspend((const struct gaicb* const*)list, (int)n, NULL);
+        if (ret == 0 || ret == EAI_ALLDONE || ret == EAI_INTR || cancelled) {
+            continue;
+        }
+        
+        bmc_log(LOG_LEVEL_ERROR, "gai_suspend() failed: %s", gai_strerror(ret));
+        for (size_t k = 0; k < n; k++) {
+            if (gai_error(&reqs[k]) == EAI_INPROGRESS &&
+                gai_cancel(&reqs[k]) == EAI_NOTCANCELED) {
+                bmc_log(LOG_LEVEL_DEBUG, "Waiting for lookup of %s to finish", reqs[k].ar_name);
+            }
+        }
+        cancelled = 1;
+    }
+}
+
+int ipmi_resolve_bulk(const char* const* hosts, const uint16_t* ports,
+                      size_t count, ipmi_addr_t* out) {
+    if (!hosts || !out) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    struct gaicb* reqs = calloc(RESOLVE_CHUNK, sizeof(struct gaicb));
+    struct gaicb** list = calloc(RESOLVE_CHUNK, sizeof(struct gaicb*));
+    size_t* index = calloc(RESOLVE_CHUNK, sizeof(size_t));
+    char (*port_strs)[8] = calloc(RESOLVE_CHUNK, sizeof(*port_strs));
+    if (!reqs || !list || !index || !port_strs) {
+        free(reqs);
+        free(list);
+        free(index);
+        free(port_strs);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    struct addrinfo numeric_hints;
+    init_hints(&numeric_hints, AI_NUMERICHOST | AI_NUMERICSERV);
+    struct addrinfo name_hints;
+    init_hints(&name_hints, AI_ADDRCONFIG | AI_NUMERICSERV);
+    
+    int resolved = 0;
+    size_t i = 0;
+    
+    while (i < count) {
+        size_t n = 0;
+        
+        // IP literal 直接解決，hostname 收集起來一起查
+        for (; i < count && n < RESOLVE_CHUNK; i++) {
+            uint16_t port = (ports && ports[i]) ? ports[i] : IPMI_DEFAULT_PORT;
+            char port_str[8];
+            snprintf(port_str, sizeof(port_str), "%u", port);
+            
+            out[i].addrlen = 0;
+            out[i].status = BMC_ERROR_NETWORK;
+            
+            struct addrinfo* res = NULL;
+            if (getaddrinfo(hosts[i], port_str, &numeric_hints, &res) == 0) {
+                fill_result(&out[i], res);
+                freeaddrinfo(res);
+                resolved++;
+                continue;
+            }
+            
+            memcpy(port_strs[n], port_str, sizeof(port_str));
+            memset(&reqs[n], 0, sizeof(reqs[n]));
+            reqs[n].ar_name = hosts[i];
+            reqs[n].ar_service = port_strs[n];
+            reqs[n].ar_request = &name_hints;
+            list[n] = &reqs[n];
+            index[n] = i;
+            n++;
+        }
+        
+        if (n == 0) {
+            continue;
+        }
+        
+        // 失敗時可能已經送出一部分，一樣要等；沒送出的沒有 ar_result
+        int ret = getaddrinfo_a(GAI_NOWAIT, list, (int)n, NULL);
+        if (ret != 0) {
+            bmc_log(LOG_LEVEL_ERROR, "getaddrinfo_a() failed: %s", gai_strerror(ret));
+        }
+        wait_chunk(reqs, list, n);
+        
+        for (size_t k = 0; k < n; k++) {
+            int err = gai_error(&reqs[k]);
+            if (err == 0 && !reqs[k].ar_result) {
+                err = EAI_SYSTEM;
+            }
+            if (err != 0) {
+                bmc_log(LOG_LEVEL_WARN, "Cannot resolve %s: %s", reqs[k].ar_name,
+                        gai_strerror(err));
+                continue;
+            }
+            
+            fill_result(&out[index[k]], reqs[k].ar_result);
+            freeaddrinfo(reqs[k].ar_result);
+            resolved++;
+        }
+    }
+    
+    free(reqs);
+    free(list);
+    free(index);
+    free(port_strs);
+    
+    return resolved;
+}
+
+const char* ipmi_addr_str(const ipmi_addr_t* addr, char* buf, size_t len) {
+    char ip[INET6_ADDRSTRLEN] = "?";
+    uint16_t port = 0;
+    
+    if (addr->addr.ss_family == AF_INET6) {
+        const struct sockaddr_in6* s6 = (const struct sockaddr_in6*)&addr->addr;
+        inet_ntop(AF_INET6, &s6->sin6_addr, ip, sizeof(ip));
+        port = ntohs(s6->sin6_port);
+        snprintf(buf, len, "[%s]:%u", ip, port);
+    } else {
+        const struct sockaddr_in* s4 = (const struct sockaddr_in*)&addr->addr;
+        inet_ntop(AF_INET, &s4->sin_addr, ip, sizeof(ip));
+        port = ntohs(s4->sin_port);
+        snprintf(buf, len, "%s:%u", ip, port);
+    }
+    
+    return buf;
+}
@@ -0,0 +1,61 @@
+#include "bmctool/ipmi_rtt.h"
+#include <string.h>
+
+void ipmi_rtt_init(ipmi_rtt_t* rtt) {
+    memset(rtt, 0, sizeof(*rtt));
+    rtt->rto_us = IPMI_RTO_INITIAL_US;
+}
+
+/**
+ * 加入一個 RTT 樣本（只能來自沒重送過的 request）
+ * 
+ * 第一個樣本：SRTT = R, RTTVAR = R / 2
+ * 之後：RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+ */
+void ipmi_rtt_sample(ipmi_rtt_t* rtt, uint32_t rtt_us) {
+    if (!rtt->has_sample) {
+        rtt->srtt_us = rtt_us;
+        rtt->rttvar_us = rtt_us / 2;
+        rtt->has_sample = 1;
+    } else {
+        uint32_t delta = rtt->srtt_us > rtt_us ? rtt->srtt_us - rtt_us
+                                               : rtt_us - rtt->srtt_us;
+        rtt->rttvar_us = (3 * rtt->rttvar_us + delta) / 4;
+        rtt->srtt_us = (7 * rtt->srtt_us + rtt_us) / 8;
+    }
+    
+    uint32_t rto = rtt->srtt_us + 4 * rtt->rttvar_us;
+    if (rto < IPMI_RTO_MIN_US) {
+        rto = IPMI_RTO_MIN_US;
+    }
+    if (rto > IPMI_RTO_MAX_US) {
+        rto = IPMI_RTO_MAX_US;
+    }
+    
+    rtt->rto_us = rto;
+    rtt->backoff = 0;
+}
+
+/**
+ * 逾時一次：下一次等兩倍久
+ * 
+ * Pipelining 時同一次網路抖動會讓好幾個 request 一起逾時，
+ * 只有在上次 backoff 之後才送出的 request 逾時才再加倍，
+ * 不然 RTO 會一口氣衝到上限。
+ */
+void ipmi_rtt_timeout(ipmi_rtt_t* rtt, uint64_t sent_us, uint64_t now_us) {
+    if (sent_us < rtt->backoff_at_us) {
+        return;
+    }
+    
+    if (rtt->backoff < 16) {
+        rtt->backoff++;
+    }
+    rtt->backoff_at_us = now_us;
+}
+
+// 目前該等多久（含 exponential backoff，有上限）
+uint32_t ipmi_rtt_rto(const ipmi_rtt_t* rtt) {
+    uint64_t rto = (uint64_t)rtt->rto_us << rtt->backoff;
+    return rto > IPMI_RTO_MAX_US ? IPMI_RTO_MAX_US : (uint32_t)rto;
+}
@@ -0,0 +1,674 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_sdr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#define SDR_READ_ENTIRE         0xFF
+#define SDR_FIRST_CHUNK         32      // 整筆讀失敗後的起始 chunk
+#define SDR_MIN_CHUNK           4
+#define SDR_MAX_CHUNKS          64      // 255 / SDR_MIN_CHUNK
+#define SDR_MAX_RESERVE         8       // reservation 連續被取消幾次就放棄
+#define SDR_LAST_RECORD         0xFFFF
+
+#define SDR_RESERVATION_LOST    1       // read_record 內部用：要重新 reserve
+
+/* Completion code */
+#define CC_RESERVATION_CANCELED 0xC5
+#define CC_REQ_LEN_INVALID      0xC7
+#define CC_REQ_LEN_EXCEEDED     0xC8
+#define CC_CANNOT_RETURN_LEN    0xCA
+#define CC_UNSPECIFIED          0xFF
+
+#define SDR_CACHE_MAGIC         0x31524453      // "SDR1"
+#define SDR_CACHE_VERSION       2
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;        // sizeof(ipmi_sdr_record_t)，結構改了就作廢
+    uint32_t count;
+    uint32_t add_timestamp;
+    uint32_t erase_timestamp;
+    uint16_t repo_count;         // Get SDR Repository Info 的 record 數
+    uint16_t reserved;
+} sdr_cache_header_t;
+
+// 下載過程的狀態
+typedef struct {
+    ipmi_ctx_t* ctx;
+    uint16_t reservation;
+    int whole;                   // 還能用 0xFF 一次讀整筆
+    uint8_t chunk;               // 分段讀時每段的大小，讀失敗就減半
+    ipmi_msg_t* reqs;            // 分段讀的 batch，SDR_MAX_CHUNKS 格
+    ipmi_msg_t* rsps;
+    int* status;
+} sdr_reader_t;
+
+static int check_cc(const ipmi_msg_t* rsp, size_t min_len, const char* what) {
+    if (rsp->data_len < 1 || rsp->data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "%s failed: completion code 0x%02x", what,
+                rsp->data_len > 0 ? rsp->data[0] : 0xFF);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (rsp->data_len < min_len) {
+        bmc_log(LOG_LEVEL_ERROR, "%s response too short: %zu bytes", what, rsp->data_len);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_sdr_get_info(ipmi_ctx_t* ctx, ipmi_sdr_info_t* info) {
+    if (!ctx || !info) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_GET_SDR_REPO_INFO };
+    ipmi_msg_t rsp;
+    
+    int ret = ipmi_send_recv(ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    ret = check_cc(&rsp, 15, "Get SDR Repository Info");
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    const uint8_t* d = rsp.data;
+    info->version = d[1];
+    info->record_count = d[2] | (d[3] << 8);
+    info->add_timestamp = d[6] | (d[7] << 8) | (d[8] << 16) | ((uint32_t)d[9] << 24);
+    info->erase_timestamp = d[10] | (d[11] << 8) | (d[12] << 16) | ((uint32_t)d[13] << 24);
+    info->support = d[14];
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== Record 解析 ===== */
+
+// 10 bits 二補數
+static int16_t sign10(int v) {
+    return (int16_t)((v & 0x200) ? v - 0x400 : v);
+}
+
+static int8_t sign4(int v) {
+    return (int8_t)((v & 0x8) ? v - 0x10 : v);
+}
+
+// ID string：type/length byte 後面接字串，支援 8-bit ASCII 和 6-bit packed ASCII
+static void parse_name(const uint8_t* raw, size_t len, size_t off, char* name) {
+    name[0] = '\0';
+    if (off >= len) {
+        return;
+    }
+    
+    uint8_t type = raw[off] >> 6;
+    size_t n = raw[off] & 0x1F;
+    const uint8_t* p = raw + off + 1;
+    if (n > len - off - 1) {
+        n = len - off - 1;
+    }
+    
+    size_t out = 0;
+    if (type == 2) {
+        // 6-bit packed：每 3 bytes 4 個字元，0x20 開始
+        for (size_t bit = 0; bit + 6 <= n * 8 && out < IPMI_SDR_NAME_MAX; bit += 6) {
+            size_t byte = bit / 8;
+            unsigned v = p[byte] | (byte + 1 < n ? p[byte + 1] << 8 : 0);
+            name[out++] = (char)(((v >> (bit % 8)) & 0x3F) + 0x20);
+        }
+    } else {
+        for (size_t i = 0; i < n && out < IPMI_SDR_NAME_MAX; i++) {
+            name[out++] = isprint(p[i]) ? (char)p[i] : '.';
+        }
+    }
+    
+    // 尾巴的空白和 NUL 去掉
+    while (out > 0 && (name[out - 1] == ' ' || name[out - 1] == '\0')) {
+        out--;
+    }
+    name[out] = '\0';
+}
+
+int ipmi_sdr_parse(const uint8_t* raw, size_t len, ipmi_sdr_record_t* rec) {
+    if (!raw || !rec || len < IPMI_SDR_HEADER_LEN) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(rec, 0, sizeof(*rec));
+    rec->record_id = raw[0] | (raw[1] << 8);
+    rec->type = raw[3];
+    
+    switch (rec->type) {
+        case IPMI_SDR_TYPE_FULL_SENSOR:
+            if (len < 48) {
+                return BMC_ERROR_PROTOCOL;
+            }
+            rec->owner_id = raw[5];
+            rec->owner_lun = raw[6] & 0x03;
+            rec->owner_channel = raw[6] >> 4;
+            rec->sensor_number = raw[7];
+            rec->entity_id = raw[8];
+            rec->entity_instance = raw[9];
+            rec->sensor_type = raw[12];
+            rec->event_type = raw[13];
+            rec->threshold_readable = raw[18] & 0x3F;
+            rec->units1 = raw[20];
+            rec->base_unit = raw[21];
+            rec->modifier_unit = raw[22];
+            rec->linearization = raw[23] & 0x7F;
+            rec->m = sign10(raw[24] | ((raw[25] & 0xC0) << 2));
+            rec->b = sign10(raw[26] | ((raw[27] & 0xC0) << 2));
+            rec->r_exp = sign4(raw[29] >> 4);
+            rec->b_exp = sign4(raw[29] & 0x0F);
+            // record 裡的順序是 UNR, UCR, UNC, LNR, LCR, LNC
+            rec->threshold[IPMI_SDR_UNR] = raw[36];
+            rec->threshold[IPMI_SDR_UCR] = raw[37];
+            rec->threshold[IPMI_SDR_UNC] = raw[38];
+            rec->threshold[IPMI_SDR_LNR] = raw[39];
+            rec->threshold[IPMI_SDR_LCR] = raw[40];
+            rec->threshold[IPMI_SDR_LNC] = raw[41];
+            parse_name(raw, len, 47, rec->name);
+            break;
+        
+        case IPMI_SDR_TYPE_COMPACT_SENSOR:
+            if (len < 32) {
+                return BMC_ERROR_PROTOCOL;
+            }
+            rec->owner_id = raw[5];
+            rec->owner_lun = raw[6] & 0x03;
+            rec->owner_channel = raw[6] >> 4;
+            rec->sensor_number = raw[7];
+            rec->entity_id = raw[8];
+            rec->entity_instance = raw[9];
+            rec->sensor_type = raw[12];
+            rec->event_type = raw[13];
+            rec->units1 = raw[20];
+            rec->base_unit = raw[21];
+            rec->modifier_unit = raw[22];
+            parse_name(raw, len, 31, rec->name);
+            break;
+        
+        case IPMI_SDR_TYPE_EVENT_ONLY:
+            if (len < 17) {
+                return BMC_ERROR_PROTOCOL;
+            }
+            rec->owner_id = raw[5];
+            rec->owner_lun = raw[6] & 0x03;
+            rec->owner_channel = raw[6] >> 4;
+            rec->sensor_number = raw[7];
+            rec->entity_id = raw[8];
+            rec->entity_instance = raw[9];
+            rec->sensor_type = raw[10];
+            rec->event_type = raw[11];
+            parse_name(raw, len, 16, rec->name);
+            break;
+        
+        case IPMI_SDR_TYPE_FRU_LOCATOR:
+            if (len < 16) {
+                return BMC_ERROR_PROTOCOL;
+            }
+            rec->owner_id = raw[5];
+            rec->sensor_number = raw[6];             // FRU device ID
+            rec->owner_lun = (raw[7] >> 3) & 0x03;
+            rec->sensor_type = raw[7] & 0x80;        // bit 7：logical FRU device
+            rec->entity_id = raw[12];
+            rec->entity_instance = raw[13];
+            parse_name(raw, len, 15, rec->name);
+            break;
+        
+        case IPMI_SDR_TYPE_MC_LOCATOR:
+            if (len < 16) {
+                return BMC_ERROR_PROTOCOL;
+            }
+            rec->owner_id = raw[5];
+            rec->entity_id = raw[12];
+            rec->entity_instance = raw[13];
+            parse_name(raw, len, 15, rec->name);
+            break;
+        
+        default:
+            return BMC_ERROR_PROTOCOL;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== 下載 ===== */
+
+static int reserve(sdr_reader_t* r) {
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_RESERVE_SDR_REPO };
+    ipmi_msg_t rsp;
+    
+    int ret = ipmi_send_recv(r->ctx, &req, &rsp);
+    if (ret == BMC_SUCCESS) {
+        ret = check_cc(&rsp, 3, "Reserve SDR Repository");
+    }
+    if (ret == BMC_SUCCESS) {
+        r->reservation = rsp.data[1] | (rsp.data[2] << 8);
+    }
+    
+    return ret;
+}
+
+static void get_sdr_req(const sdr_reader_t* r, uint16_t id, uint8_t offset, uint8_t count,
+                        ipmi_msg_t* req) {
+    *req = (ipmi_msg_t){ .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_GET_SDR };
+    req->data[0] = r->reservation & 0xFF;
+    req->data[1] = r->reservation >> 8;
+    req->data[2] = id & 0xFF;
+    req->data[3] = id >> 8;
+    req->data[4] = offset;
+    req->data[5] = count;
+    req->data_len = 6;
+}
+
+// BMC 一次吐不出這麼多資料時回的 completion code
+static int cc_too_long(uint8_t cc) {
+    return cc == CC_CANNOT_RETURN_LEN || cc == CC_REQ_LEN_INVALID ||
+           cc == CC_REQ_LEN_EXCEEDED || cc == CC_UNSPECIFIED;
+}
+
+/*
+ * 先試 0xFF 一次讀整筆；BMC 不支援就改成先讀 5 bytes header，
+ * 再把剩下的分段用 ipmi_send_recv_batch 一起送（ctx 的 pipeline depth 決定並行度），
+ * 有段落說太長就把 chunk 減半重讀
+ */
+static int read_record(sdr_reader_t* r, uint16_t id, uint8_t* raw, size_t* raw_len,
+                       uint16_t* next) {
+    ipmi_msg_t req;
+    ipmi_msg_t rsp;
+    int ret;
+    
+    if (r->whole) {
+        get_sdr_req(r, id, 0, SDR_READ_ENTIRE, &req);
+        ret = ipmi_send_recv(r->ctx, &req, &rsp);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        uint8_t cc = rsp.data_len > 0 ? rsp.data[0] : CC_UNSPECIFIED;
+        if (cc == CC_RESERVATION_CANCELED) {
+            return SDR_RESERVATION_LOST;
+        }
+        if (cc == 0x00 && rsp.data_len >= 3 + IPMI_SDR_HEADER_LEN &&
+            rsp.data_len == (size_t)(3 + IPMI_SDR_HEADER_LEN + rsp.data[3 + 4])) {
+            *next = rsp.data[1] | (rsp.data[2] << 8);
+            *raw_len = rsp.data_len - 3;
+            memcpy(raw, rsp.data + 3, *raw_len);
+            return BMC_SUCCESS;
+        }
+        if (cc != 0x00 && !cc_too_long(cc)) {
+            return check_cc(&rsp, 0, "Get SDR");
+        }
+        
+        bmc_log(LOG_LEVEL_DEBUG, "BMC cannot return whole SDR records (cc=0x%02x), "
+                "reading in %d-byte chunks", cc, SDR_FIRST_CHUNK);
+        r->whole = 0;
+    }
+    
+    // Header：record ID、版本、type、長度
+    get_sdr_req(r, id, 0, IPMI_SDR_HEADER_LEN, &req);
+    ret = ipmi_send_recv(r->ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    if (rsp.data_len > 0 && rsp.data[0] == CC_RESERVATION_CANCELED) {
+        return SDR_RESERVATION_LOST;
+    }
+    ret = check_cc(&rsp, 3 + IPMI_SDR_HEADER_LEN, "Get SDR");
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    *next = rsp.data[1] | (rsp.data[2] << 8);
+    memcpy(raw, rsp.data + 3, IPMI_SDR_HEADER_LEN);
+    size_t body = raw[4];
+    *raw_len = IPMI_SDR_HEADER_LEN + body;
+    
+    for (;;) {
+        // Get SDR 的 offset 只有一個 byte，超過 0xFF 的部分分段讀不到
+        size_t last = body > 0 ? (body - 1) / r->chunk * r->chunk : 0;
+        if (IPMI_SDR_HEADER_LEN + last > 0xFF) {
+            bmc_log(LOG_LEVEL_ERROR, "SDR 0x%04x is %zu bytes, too long to read in %d-byte chunks",
+                    id, *raw_len, r->chunk);
+            return BMC_ERROR_PROTOCOL;
+        }
+        
+        size_t n = 0;
+        for (size_t off = 0; off < body; off += r->chunk) {
+            size_t len = body - off < r->chunk ? body - off : r->chunk;
+            get_sdr_req(r, id, (uint8_t)(IPMI_SDR_HEADER_LEN + off), (uint8_t)len, &r->reqs[n++]);
+        }
+        
+        ret = ipmi_send_recv_batch(r->ctx, r->reqs, r->rsps, r->status, n);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        int shrink = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (r->status[i] != BMC_SUCCESS) {
+                return r->status[i];
+            }
+            
+            const ipmi_msg_t* c = &r->rsps[i];
+            uint8_t cc = c->data_len > 0 ? c->data[0] : CC_UNSPECIFIED;
+            size_t want = r->reqs[i].data[5];
+            if (cc == CC_RESERVATION_CANCELED) {
+                return SDR_RESERVATION_LOST;
+            }
+            if (cc_too_long(cc)) {
+                shrink = 1;
+                break;
+            }
+            ret = check_cc(c, 3 + want, "Get SDR");
+            if (ret != BMC_SUCCESS) {
+                return ret;
+            }
+            memcpy(raw + r->reqs[i].data[4], c->data + 3, want);
+        }
+        
+        if (!shrink) {
+            return BMC_SUCCESS;
+        }
+        if (r->chunk <= SDR_MIN_CHUNK) {
+            bmc_log(LOG_LEVEL_ERROR, "Get SDR failed even with %d-byte chunks", r->chunk);
+            return BMC_ERROR_PROTOCOL;
+        }
+        
+        r->chunk /= 2;
+        bmc_log(LOG_LEVEL_DEBUG, "Reducing SDR chunk size to %d", r->chunk);
+    }
+}
+
+static int repo_append(ipmi_sdr_repo_t* repo, size_t* cap, const ipmi_sdr_record_t* rec) {
+    if (repo->count == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 64;
+        ipmi_sdr_record_t* records = realloc(repo->records, new_cap * sizeof(*records));
+        if (!records) {
+            return BMC_ERROR_MEMORY;
+        }
+        repo->records = records;
+        *cap = new_cap;
+    }
+    
+    repo->records[repo->count++] = *rec;
+    return BMC_SUCCESS;
+}
+
+/*
+ * 用已經問到的 repository info 下載；*modified 設成下載途中 reservation 有沒有被取消過
+ * （repository 被改了，info 的時間戳可能已經不對）
+ */
+static int download(ipmi_ctx_t* ctx, const ipmi_sdr_info_t* info, ipmi_sdr_repo_t* repo,
+                    int* modified) {
+    memset(repo, 0, sizeof(*repo));
+    repo->info = *info;
+    *modified = 0;
+    
+    int ret;
+    sdr_reader_t r = {
+        .ctx = ctx,
+        .whole = 1,
+        .chunk = SDR_FIRST_CHUNK,
+        .reqs = calloc(SDR_MAX_CHUNKS, sizeof(ipmi_msg_t)),
+        .rsps = calloc(SDR_MAX_CHUNKS, sizeof(ipmi_msg_t)),
+        .status = calloc(SDR_MAX_CHUNKS, sizeof(int))
+    };
+    if (!r.reqs || !r.rsps || !r.status) {
+        ret = BMC_ERROR_MEMORY;
+    } else {
+        ret = reserve(&r);
+    }
+    
+    uint8_t raw[IPMI_SDR_HEADER_LEN + 0xFF];
+    size_t cap = 0;
+    uint16_t id = 0;
+    int lost = 0;
+    unsigned int reads = 0;
+    uint64_t start = bmc_monotonic_us();
+    
+    while (ret == BMC_SUCCESS && id != SDR_LAST_RECORD) {
+        size_t raw_len = 0;
+        uint16_t next = SDR_LAST_RECORD;
+        
+        ret = read_record(&r, id, raw, &raw_len, &next);
+        if (ret == SDR_RESERVATION_LOST) {
+            // 下載途中 repository 被改了，重新 reserve 從這筆繼續
+            *modified = 1;
+            if (++lost > SDR_MAX_RESERVE) {
+                bmc_log(LOG_LEVEL_ERROR, "SDR reservation keeps getting canceled");
+                ret = BMC_ERROR_PROTOCOL;
+                break;
+            }
+            ret = reserve(&r);
+            continue;
+        }
+        if (ret != BMC_SUCCESS) {
+            break;
+        }
+        lost = 0;
+        
+        ipmi_sdr_record_t rec;
+        if (ipmi_sdr_parse(raw, raw_len, &rec) == BMC_SUCCESS) {
+            ret = repo_append(repo, &cap, &rec);
+        }
+        
+        // 壞掉的 BMC 可能讓 next 繞圈
+        if (next == id || ++reads > 0xFFFF) {
+            bmc_log(LOG_LEVEL_ERROR, "SDR record chain does not terminate");
+            ret = BMC_ERROR_PROTOCOL;
+            break;
+        }
+        id = next;
+    }
+    
+    free(r.reqs);
+    free(r.rsps);
+    free(r.status);
+    
+    if (ret != BMC_SUCCESS) {
+        ipmi_sdr_free(repo);
+        return ret;
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Downloaded %u SDRs (%zu kept) in %llu ms", reads, repo->count,
+            (unsigned long long)((bmc_monotonic_us() - start) / 1000));
+    return BMC_SUCCESS;
+}
+
+int ipmi_sdr_download(ipmi_ctx_t* ctx, ipmi_sdr_repo_t* repo) {
+    if (!ctx || !repo) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_sdr_info_t info;
+    int ret = ipmi_sdr_get_info(ctx, &info);
+    if (ret != BMC_SUCCESS) {
+        memset(repo, 0, sizeof(*repo));
+        return ret;
+    }
+    
+    int modified;
+    return download(ctx, &info, repo, &modified);
+}
+
+void ipmi_sdr_free(ipmi_sdr_repo_t* repo) {
+    if (!repo) {
+        return;
+    }
+    
+    free(repo->records);
+    repo->records = NULL;
+    repo->count = 0;
+}
+
+/* ===== 快取 ===== */
+
+static int cache_matches(const sdr_cache_header_t* hdr, const ipmi_sdr_info_t* info) {
+    return hdr->magic == SDR_CACHE_MAGIC && hdr->version == SDR_CACHE_VERSION &&
+           hdr->record_size == sizeof(ipmi_sdr_record_t) &&
+           hdr->add_timestamp == info->add_timestamp &&
+           hdr->erase_timestamp == info->erase_timestamp &&
+           hdr->repo_count == info->record_count;
+}
+
+static int cache_read(const char* path, const ipmi_sdr_info_t* info, ipmi_sdr_repo_t* repo) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    sdr_cache_header_t hdr;
+    int ret = BMC_ERROR_PROTOCOL;
+    if (fread(&hdr, sizeof(hdr), 1, fp) == 1 && cache_matches(&hdr, info) &&
+        hdr.count <= 0xFFFF) {
+        repo->records = malloc((hdr.count ? hdr.count : 1) * sizeof(ipmi_sdr_record_t));
+        if (repo->records &&
+            fread(repo->records, sizeof(ipmi_sdr_record_t), hdr.count, fp) == hdr.count) {
+            repo->count = hdr.count;
+            repo->info = *info;
+            repo->from_cache = 1;
+            ret = BMC_SUCCESS;
+        } else {
+            ipmi_sdr_free(repo);
+        }
+    }
+    
+    fclose(fp);
+    return ret;
+}
+
+// 先寫暫存檔再 rename，同時跑的 process 不會讀到寫一半的檔案
+static void cache_write(const char* path, const ipmi_sdr_repo_t* repo) {
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write SDR cache %s", tmp);
+        return;
+    }
+    
+    sdr_cache_header_t hdr = {
+        .magic = SDR_CACHE_MAGIC,
+        .version = SDR_CACHE_VERSION,
+        .record_size = sizeof(ipmi_sdr_record_t),
+        .count = (uint32_t)repo->count,
+        .add_timestamp = repo->info.add_timestamp,
+        .erase_timestamp = repo->info.erase_timestamp,
+        .repo_count = repo->info.record_count
+    };
+    
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 &&
+             fwrite(repo->records, sizeof(ipmi_sdr_record_t), repo->count, fp) == repo->count;
+    ok = (fclose(fp) == 0) && ok;
+    
+    if (!ok || rename(tmp, path) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write SDR cache %s", path);
+        unlink(tmp);
+    }
+}
+
+int ipmi_sdr_load(ipmi_ctx_t* ctx, const char* cache_path, ipmi_sdr_repo_t* repo) {
+    if (!ctx || !repo) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(repo, 0, sizeof(*repo));
+    
+    char path[4096];
+    if (!cache_path && ipmi_ctx_cache_path(ctx, "sdr", path, sizeof(path)) == BMC_SUCCESS) {
+        cache_path = path;
+    }
+    
+    // 一個來回確認時間戳，對得上就不用下載
+    ipmi_sdr_info_t info;
+    int ret = ipmi_sdr_get_info(ctx, &info);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (cache_path && cache_read(cache_path, &info, repo) == BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "Using cached SDR (%zu records) from %s", repo->count, cache_path);
+        return BMC_SUCCESS;
+    }
+    
+    // 同一份 info 直接拿來下載，不用再問一次
+    int modified;
+    ret = download(ctx, &info, repo, &modified);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    // 下載期間 repository 被改過的話，時間戳會跟內容對不上，就不存
+    if (cache_path && !modified) {
+        cache_write(cache_path, repo);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+const ipmi_sdr_record_t* ipmi_sdr_find(const ipmi_sdr_repo_t* repo, uint8_t owner_id,
+                                       uint8_t sensor_number) {
+    if (!repo) {
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < repo->count; i++) {
+        const ipmi_sdr_record_t* rec = &repo->records[i];
+        if (rec->type <= IPMI_SDR_TYPE_EVENT_ONLY && rec->owner_id == owner_id &&
+            rec->sensor_number == sensor_number) {
+            return rec;
+        }
+    }
+    
+    return NULL;
+}
+
+/* ===== 顯示用字串 ===== */
+
+const char* ipmi_sdr_unit_name(uint8_t unit) {
+    static const char* const names[] = {
+        "unspecified", "degrees C", "degrees F", "degrees K", "Volts", "Amps", "Watts",
+        "Joules", "Coulombs", "VA", "Nits", "lumen", "lux", "Candela", "kPa", "PSI",
+        "Newton", "CFM", "RPM", "Hz", "microsecond", "millisecond", "second", "minute",
+        "hour", "day", "week", "mil", "inches", "feet", "cu in", "cu feet", "mm", "cm",
+        "m", "cu cm", "cu m", "liters", "fluid ounce", "radians", "steradians",
+        "revolutions", "cycles", "gravities", "ounce", "pound", "ft-lb", "oz-in", "gauss",
+        "gilberts", "henry", "millihenry", "farad", "microfarad", "ohms", "siemens", "mole",
+        "becquerel", "PPM", "reserved", "Decibels", "DbA", "DbC", "gray", "sievert",
+        "color temp deg K", "bit", "kilobit", "megabit", "gigabit", "byte", "kilobyte",
+        "megabyte", "gigabyte", "word", "dword", "qword", "line", "hit", "miss", "retry",
+        "reset", "overflow", "underrun", "collision", "packets", "messages", "characters",
+        "error", "correctable error", "uncorrectable error", "fatal error", "grams"
+    };
+    
+    return unit < sizeof(names) / sizeof(names[0]) ? names[unit] : "unknown";
+}
+
+const char* ipmi_sdr_sensor_type_name(uint8_t type) {
+    static const char* const names[] = {
+        "reserved", "Temperature", "Voltage", "Current", "Fan", "Physical Security",
+        "Platform Security", "Processor", "Power Supply", "Power Unit", "Cooling Device",
+        "Other Units", "Memory", "Drive Slot", "POST Memory Resize", "System Firmware",
+        "Event Logging Disabled", "Watchdog 1", "System Event", "Critical Interrupt",
+        "Button/Switch", "Module/Board", "Microcontroller", "Add-in Card", "Chassis",
+        "Chip Set", "Other FRU", "Cable/Interconnect", "Terminator", "System Boot",
+        "Boot Error", "OS Boot", "OS Critical Stop", "Slot/Connector", "ACPI Power State",
+        "Watchdog 2", "Platform Alert", "Entity Presence", "Monitor ASIC", "LAN",
+        "Mgmt Subsys Health", "Battery", "Session Audit", "Version Change", "FRU State"
+    };
+    
+    if (type >= 0xC0) {
+        return "OEM";
+    }
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "unknown";
+}
@@ -0,0 +1,419 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_sel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SEL_FIRST_ENTRY         0x0000
+#define SEL_LAST_ENTRY          0xFFFF
+#define SEL_MAX_RESERVE         8
+#define SEL_READ_ENTIRE         0xFF
+#define SEL_PARTIAL_CHUNK       8       // 整筆讀失敗後每段的大小，16 bytes 分兩次
+
+#define SEL_NOT_PRESENT         1       // get_entry 內部用：這個 record ID 不存在
+#define SEL_RESERVATION_LOST    2       // get_entry 內部用：分段讀到一半 reservation 被 cancel
+
+/* Completion code */
+#define CC_INVALID_COMMAND      0xC1
+#define CC_RESERVATION_CANCELED 0xC5
+#define CC_REQ_LEN_INVALID      0xC7
+#define CC_REQ_LEN_EXCEEDED     0xC8
+#define CC_CANNOT_RETURN_LEN    0xCA
+#define CC_NOT_PRESENT          0xCB
+
+#define SEL_CURSOR_MAGIC        0x314C4553      // "SEL1"
+#define SEL_CURSOR_VERSION      1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    ipmi_sel_cursor_t cursor;
+} sel_cursor_file_t;
+
+typedef struct {
+    ipmi_ctx_t* ctx;
+    uint16_t reservation;
+    int reserved;                // 已經 reserve 過（或 BMC 不支援，用 0）
+    int whole;                   // 還在用 0xFF 一次讀整筆
+} sel_reader_t;
+
+static uint32_t get_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int ipmi_sel_get_info(ipmi_ctx_t* ctx, ipmi_sel_info_t* info) {
+    if (!ctx || !info) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_GET_SEL_INFO };
+    ipmi_msg_t rsp;
+    
+    int ret = ipmi_send_recv(ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (rsp.data_len < 15 || rsp.data[0] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "Get SEL Info failed: completion code 0x%02x",
+                rsp.data_len > 0 ? rsp.data[0] : 0xFF);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    info->version = rsp.data[1];
+    info->entries = rsp.data[2] | (rsp.data[3] << 8);
+    info->free_bytes = rsp.data[4] | (rsp.data[5] << 8);
+    info->add_timestamp = get_le32(rsp.data + 6);
+    info->erase_timestamp = get_le32(rsp.data + 10);
+    info->support = rsp.data[14];
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_sel_parse(const uint8_t* raw, size_t len, ipmi_sel_entry_t* entry) {
+    if (!raw || !entry || len < IPMI_SEL_ENTRY_LEN) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->raw, raw, IPMI_SEL_ENTRY_LEN);
+    entry->record_id = raw[0] | (raw[1] << 8);
+    entry->type = raw[2];
+    
+    if (entry->type == IPMI_SEL_TYPE_SYSTEM_EVENT) {
+        entry->timestamp = get_le32(raw + 3);
+        entry->generator_id = raw[7] | (raw[8] << 8);
+        entry->evm_rev = raw[9];
+        entry->sensor_type = raw[10];
+        entry->sensor_number = raw[11];
+        entry->event_type = raw[12] & 0x7F;
+        entry->deassertion = raw[12] >> 7;
+        memcpy(entry->event_data, raw + 13, 3);
+    } else if (entry->type >= IPMI_SEL_TYPE_OEM_TS_FIRST &&
+               entry->type <= IPMI_SEL_TYPE_OEM_TS_LAST) {
+        entry->timestamp = get_le32(raw + 3);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+// BMC 不支援 Reserve SEL 時用 reservation 0（整筆讀本來就不需要）
+static int reserve(sel_reader_t* r) {
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_RESERVE_SEL };
+    ipmi_msg_t rsp;
+    
+    int ret = ipmi_send_recv(r->ctx, &req, &rsp);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (rsp.data_len >= 3 && rsp.data[0] == 0x00) {
+        r->reservation = rsp.data[1] | (rsp.data[2] << 8);
+    } else if (rsp.data_len >= 1 && rsp.data[0] == CC_INVALID_COMMAND) {
+        r->reservation = 0;
+    } else {
+        bmc_log(LOG_LEVEL_ERROR, "Reserve SEL failed: completion code 0x%02x",
+                rsp.data_len > 0 ? rsp.data[0] : 0xFF);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    r->reserved = 1;
+    return BMC_SUCCESS;
+}
+
+static void get_entry_req(const sel_reader_t* r, uint16_t id, uint8_t offset, uint8_t count,
+                          ipmi_msg_t* req) {
+    *req = (ipmi_msg_t){ .netfn = IPMI_NETFN_STORAGE, .cmd = IPMI_CMD_GET_SEL_ENTRY, .data_len = 6 };
+    req->data[0] = r->reservation & 0xFF;
+    req->data[1] = r->reservation >> 8;
+    req->data[2] = id & 0xFF;
+    req->data[3] = id >> 8;
+    req->data[4] = offset;
+    req->data[5] = count;
+}
+
+// BMC 一次吐不出整筆時回的 completion code
+static int cc_too_long(uint8_t cc) {
+    return cc == CC_CANNOT_RETURN_LEN || cc == CC_REQ_LEN_INVALID || cc == CC_REQ_LEN_EXCEEDED;
+}
+
+/*
+ * 分段讀一筆：spec 只有分段讀才需要 reservation，所以到這裡才 reserve。
+ * 回傳 SEL_RESERVATION_LOST 表示途中被 cancel，要重新 reserve 整筆重讀
+ */
+static int get_entry_partial(sel_reader_t* r, uint16_t id, uint8_t* raw, uint16_t* next) {
+    if (!r->reserved) {
+        int ret = reserve(r);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+    }
+    
+    for (uint8_t off = 0; off < IPMI_SEL_ENTRY_LEN; off += SEL_PARTIAL_CHUNK) {
+        ipmi_msg_t req;
+        ipmi_msg_t rsp;
+        get_entry_req(r, id, off, SEL_PARTIAL_CHUNK, &req);
+        
+        int ret = ipmi_send_recv(r->ctx, &req, &rsp);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        uint8_t cc = rsp.data_len > 0 ? rsp.data[0] : 0xFF;
+        if (cc == CC_RESERVATION_CANCELED) {
+            r->reserved = 0;
+            return SEL_RESERVATION_LOST;
+        }
+        if (cc == CC_NOT_PRESENT) {
+            return SEL_NOT_PRESENT;
+        }
+        if (cc != 0x00 || rsp.data_len < 3 + SEL_PARTIAL_CHUNK) {
+            bmc_log(LOG_LEVEL_ERROR, "Get SEL Entry 0x%04x offset %d failed: completion code 0x%02x",
+                    id, off, cc);
+            return BMC_ERROR_PROTOCOL;
+        }
+        
+        *next = rsp.data[1] | (rsp.data[2] << 8);
+        memcpy(raw + off, rsp.data + 3, SEL_PARTIAL_CHUNK);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/*
+ * 先用 0xFF 一次讀整筆，不用 reserve（reservation 填 0，BMC 會忽略），
+ * 一筆一個來回；BMC 說太長才改成 reserve 後分段讀，之後的每一筆也都分段
+ */
+static int get_entry(sel_reader_t* r, uint16_t id, uint8_t* raw, uint16_t* next) {
+    if (r->whole) {
+        ipmi_msg_t req;
+        ipmi_msg_t rsp;
+        get_entry_req(r, id, 0, SEL_READ_ENTIRE, &req);
+        
+        int ret = ipmi_send_recv(r->ctx, &req, &rsp);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        uint8_t cc = rsp.data_len > 0 ? rsp.data[0] : 0xFF;
+        if (cc == CC_NOT_PRESENT) {
+            return SEL_NOT_PRESENT;
+        }
+        if (cc == 0x00 && rsp.data_len >= 3 + IPMI_SEL_ENTRY_LEN) {
+            *next = rsp.data[1] | (rsp.data[2] << 8);
+            memcpy(raw, rsp.data + 3, IPMI_SEL_ENTRY_LEN);
+            return BMC_SUCCESS;
+        }
+        if (cc != 0x00 && !cc_too_long(cc)) {
+            bmc_log(LOG_LEVEL_ERROR, "Get SEL Entry 0x%04x failed: completion code 0x%02x", id, cc);
+            return BMC_ERROR_PROTOCOL;
+        }
+        
+        bmc_log(LOG_LEVEL_DEBUG, "BMC cannot return whole SEL entries (cc=0x%02x), "
+                "reading in %d-byte chunks", cc, SEL_PARTIAL_CHUNK);
+        r->whole = 0;
+    }
+    
+    for (int attempt = 0; attempt <= SEL_MAX_RESERVE; attempt++) {
+        // 讀的途中有新 event 進來或被清掉，重新 reserve 再讀一次
+        int ret = get_entry_partial(r, id, raw, next);
+        if (ret != SEL_RESERVATION_LOST) {
+            return ret;
+        }
+    }
+    
+    bmc_log(LOG_LEVEL_ERROR, "SEL reservation keeps getting canceled");
+    return BMC_ERROR_PROTOCOL;
+}
+
+int ipmi_sel_read_new(ipmi_ctx_t* ctx, ipmi_sel_cursor_t* cursor, ipmi_sel_cb_t cb, void* arg) {
+    if (!ctx || !cursor) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ipmi_sel_info_t info;
+    int ret = ipmi_sel_get_info(ctx, &info);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (cursor->valid && cursor->erase_timestamp != info.erase_timestamp) {
+        bmc_log(LOG_LEVEL_DEBUG, "SEL was cleared, reading from the start");
+        cursor->valid = 0;
+    }
+    
+    // 最常見的情況：上次之後沒有新 event，一個來回就結束
+    if (cursor->valid && cursor->add_timestamp == info.add_timestamp) {
+        return BMC_SUCCESS;
+    }
+    
+    cursor->erase_timestamp = info.erase_timestamp;
+    if (info.entries == 0) {
+        cursor->valid = 0;
+        cursor->add_timestamp = info.add_timestamp;
+        return BMC_SUCCESS;
+    }
+    
+    sel_reader_t r = { .ctx = ctx, .whole = 1 };
+    uint8_t raw[IPMI_SEL_ENTRY_LEN];
+    uint16_t id = SEL_FIRST_ENTRY;
+    uint16_t next = SEL_LAST_ENTRY;
+    
+    if (cursor->valid) {
+        // 重讀上次最後一筆拿它的 next；不見了或內容不同表示 SEL 繞回蓋掉了
+        ret = get_entry(&r, cursor->last_record_id, raw, &next);
+        if (ret == SEL_NOT_PRESENT ||
+            (ret == BMC_SUCCESS && memcmp(raw, cursor->last_raw, sizeof(raw)) != 0)) {
+            bmc_log(LOG_LEVEL_DEBUG, "SEL record 0x%04x is gone, reading from the start",
+                    cursor->last_record_id);
+            cursor->valid = 0;
+            ret = BMC_SUCCESS;
+        } else if (ret == BMC_SUCCESS) {
+            id = next;
+        } else {
+            return ret;
+        }
+    }
+    
+    unsigned int count = 0;
+    int stopped = 0;
+    
+    while (id != SEL_LAST_ENTRY) {
+        ret = get_entry(&r, id, raw, &next);
+        if (ret == SEL_NOT_PRESENT && id == SEL_FIRST_ENTRY) {
+            // Get SEL Info 之後被清空了
+            ret = BMC_SUCCESS;
+            break;
+        }
+        if (ret != BMC_SUCCESS) {
+            if (ret == SEL_NOT_PRESENT) {
+                bmc_log(LOG_LEVEL_ERROR, "SEL record 0x%04x disappeared while reading", id);
+                ret = BMC_ERROR_PROTOCOL;
+            }
+            break;
+        }
+        
+        ipmi_sel_entry_t entry;
+        ipmi_sel_parse(raw, sizeof(raw), &entry);
+        
+        cursor->valid = 1;
+        cursor->last_record_id = entry.record_id;
+        memcpy(cursor->last_raw, raw, sizeof(raw));
+        count++;
+        
+        if (cb && cb(&entry, arg) != 0) {
+            stopped = 1;
+            break;
+        }
+        
+        if (next == id || count > 0xFFFF) {
+            bmc_log(LOG_LEVEL_ERROR, "SEL record chain does not terminate");
+            ret = BMC_ERROR_PROTOCOL;
+            break;
+        }
+        id = next;
+    }
+    
+    // 讀到底才記新增時間戳，中途停下來的話下次還會接著讀
+    if (ret == BMC_SUCCESS && !stopped) {
+        cursor->add_timestamp = info.add_timestamp;
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Read %u new SEL entries", count);
+    return ret;
+}
+
+void ipmi_sel_cursor_load(const char* path, ipmi_sel_cursor_t* cursor) {
+    if (!cursor) {
+        return;
+    }
+    
+    memset(cursor, 0, sizeof(*cursor));
+    if (!path) {
+        return;
+    }
+    
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return;
+    }
+    
+    sel_cursor_file_t file;
+    if (fread(&file, sizeof(file), 1, fp) == 1 && file.magic == SEL_CURSOR_MAGIC &&
+        file.version == SEL_CURSOR_VERSION) {
+        *cursor = file.cursor;
+    }
+    
+    fclose(fp);
+}
+
+// 先寫暫存檔再 rename，中途被殺掉也不會留下寫一半的 cursor
+int ipmi_sel_cursor_save(const char* path, const ipmi_sel_cursor_t* cursor) {
+    if (!path || !cursor) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    
+    sel_cursor_file_t file = {
+        .magic = SEL_CURSOR_MAGIC,
+        .version = SEL_CURSOR_VERSION,
+        .cursor = *cursor
+    };
+    
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write SEL cursor %s", tmp);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ok = fwrite(&file, sizeof(file), 1, fp) == 1;
+    ok = (fclose(fp) == 0) && ok;
+    
+    if (!ok || rename(tmp, path) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write SEL cursor %s", path);
+        unlink(tmp);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_sel_stream(ipmi_ctx_t* ctx, const char* cursor_path, int from_start,
+                    ipmi_sel_cb_t cb, void* arg) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char path[4096];
+    if (!cursor_path && ipmi_ctx_cache_path(ctx, "sel", path, sizeof(path)) == BMC_SUCCESS) {
+        cursor_path = path;
+    }
+    
+    ipmi_sel_cursor_t cursor;
+    ipmi_sel_cursor_load(from_start ? NULL : cursor_path, &cursor);
+    
+    int ret = ipmi_sel_read_new(ctx, &cursor, cb, arg);
+    
+    // 失敗也存：已經交出去的 record 下次不要再給一次
+    if (cursor_path) {
+        ipmi_sel_cursor_save(cursor_path, &cursor);
+    }
+    
+    return ret;
+}
+
+const char* ipmi_sel_threshold_event_name(uint8_t offset) {
+    static const char* const names[] = {
+        "Lower Non-critical going low", "Lower Non-critical going high",
+        "Lower Critical going low", "Lower Critical going high",
+        "Lower Non-recoverable going low", "Lower Non-recoverable going high",
+        "Upper Non-critical going low", "Upper Non-critical going high",
+        "Upper Critical going low", "Upper Critical going high",
+        "Upper Non-recoverable going low", "Upper Non-recoverable going high"
+    };
+    
+    return offset < sizeof(names) / sizeof(names[0]) ? names[offset] : NULL;
+}
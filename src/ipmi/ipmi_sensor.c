@@ -0,0 +1,238 @@
+#include "bmctool/ipmi_sensor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define SENSOR_EVENT_THRESHOLD  0x01    // event/reading type：threshold sensor
+#define SENSOR_FORMAT_NONE      3       // units1[7:6]：沒有 analog 讀值
+
+/* Get Sensor Reading response byte 2 */
+#define SENSOR_SCANNING_ENABLED 0x40
+#define SENSOR_READING_INVALID  0x20
+
+#define CC_NOT_PRESENT          0xCB
+
+static void conv_init(const ipmi_sdr_record_t* rec, ipmi_sensor_conv_t* conv) {
+    conv->m = rec->m * pow(10, rec->r_exp);
+    conv->b = rec->b * pow(10, rec->b_exp + rec->r_exp);
+    conv->format = rec->units1 >> 6;
+    conv->linearization = rec->linearization;
+}
+
+static double conv_apply(const ipmi_sensor_conv_t* conv, uint8_t raw) {
+    double x;
+    switch (conv->format) {
+        case 1:  x = (raw & 0x80) ? -(double)(~raw & 0x7F) : raw; break;
+        case 2:  x = (int8_t)raw; break;
+        default: x = raw; break;
+    }
+    
+    double y = conv->m * x + conv->b;
+    
+    switch (conv->linearization) {
+        case 1:  return log(y);
+        case 2:  return log10(y);
+        case 3:  return log2(y);
+        case 4:  return exp(y);
+        case 5:  return pow(10, y);
+        case 6:  return exp2(y);
+        case 7:  return y != 0 ? 1.0 / y : 0;
+        case 8:  return y * y;
+        case 9:  return y * y * y;
+        case 10: return sqrt(y);
+        case 11: return cbrt(y);
+        default: return y;
+    }
+}
+
+double ipmi_sensor_convert(const ipmi_sdr_record_t* rec, uint8_t raw) {
+    if (!rec) {
+        return 0;
+    }
+    
+    ipmi_sensor_conv_t conv;
+    conv_init(rec, &conv);
+    return conv_apply(&conv, raw);
+}
+
+// 可以用 Get Sensor Reading 問的 sensor：BMC 自己的直接問，IPMB 上其他 controller 的（例如 ME）橋接
+static int readable(const ipmi_sdr_record_t* rec) {
+    if (rec->type != IPMI_SDR_TYPE_FULL_SENSOR && rec->type != IPMI_SDR_TYPE_COMPACT_SENSOR) {
+        return 0;
+    }
+    if (rec->owner_id == IPMI_BMC_SLAVE_ADDR) {
+        return rec->owner_lun == 0;
+    }
+    
+    // owner ID bit 0 為 1 是 system software ID，不在 IPMB 上
+    return !(rec->owner_id & 0x01);
+}
+
+int ipmi_sensor_set_init(ipmi_sensor_set_t* set, const ipmi_sdr_repo_t* repo) {
+    if (!set || !repo) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(set, 0, sizeof(*set));
+    set->repo = repo;
+    
+    size_t n = 0;
+    for (size_t i = 0; i < repo->count; i++) {
+        n += readable(&repo->records[i]);
+    }
+    
+    // 至少配一格，n 為 0 時也不用特別處理
+    set->readings = calloc(n ? n : 1, sizeof(ipmi_sensor_reading_t));
+    set->conv = calloc(n ? n : 1, sizeof(ipmi_sensor_conv_t));
+    set->reqs = calloc(n ? n : 1, sizeof(ipmi_msg_t));
+    set->rsps = calloc(n ? n : 1, sizeof(ipmi_msg_t));
+    set->status = calloc(n ? n : 1, sizeof(int));
+    if (!set->readings || !set->conv || !set->reqs || !set->rsps || !set->status) {
+        ipmi_sensor_set_free(set);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    for (size_t i = 0; i < repo->count && set->count < n; i++) {
+        const ipmi_sdr_record_t* rec = &repo->records[i];
+        if (!readable(rec)) {
+            continue;
+        }
+        
+        size_t k = set->count++;
+        set->readings[k].sdr_index = (uint16_t)i;
+        set->readings[k].analog = rec->type == IPMI_SDR_TYPE_FULL_SENSOR &&
+                                  rec->event_type == SENSOR_EVENT_THRESHOLD &&
+                                  (rec->units1 >> 6) != SENSOR_FORMAT_NONE;
+        conv_init(rec, &set->conv[k]);
+        
+        set->reqs[k].netfn = IPMI_NETFN_SENSOR;
+        set->reqs[k].cmd = IPMI_CMD_GET_SENSOR_READING;
+        set->reqs[k].data[0] = rec->sensor_number;
+        set->reqs[k].data_len = 1;
+        if (rec->owner_id != IPMI_BMC_SLAVE_ADDR) {
+            set->reqs[k].target_addr = rec->owner_id;
+            set->reqs[k].target_lun = rec->owner_lun;
+            set->reqs[k].channel = rec->owner_channel;
+        }
+    }
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_sensor_set_free(ipmi_sensor_set_t* set) {
+    if (!set) {
+        return;
+    }
+    
+    free(set->readings);
+    free(set->conv);
+    free(set->reqs);
+    free(set->rsps);
+    free(set->status);
+    memset(set, 0, sizeof(*set));
+}
+
+// BMC 沒回 threshold 比較結果時，用 SDR 裡的 threshold 自己比
+static uint16_t compare_thresholds(const ipmi_sdr_record_t* rec, const ipmi_sensor_conv_t* conv,
+                                   double value) {
+    uint16_t state = 0;
+    
+    for (int t = 0; t < IPMI_SDR_THRESHOLDS; t++) {
+        if (!(rec->threshold_readable & (1 << t))) {
+            continue;
+        }
+        
+        double limit = conv_apply(conv, rec->threshold[t]);
+        int upper = t >= IPMI_SDR_UNC;
+        if ((upper && value >= limit) || (!upper && value <= limit)) {
+            state |= (uint16_t)(1 << t);
+        }
+    }
+    
+    return state;
+}
+
+static uint8_t severity_of(uint16_t state) {
+    if (state & ((1 << IPMI_SDR_LNR) | (1 << IPMI_SDR_UNR))) {
+        return IPMI_SENSOR_SEVERITY_NR;
+    }
+    if (state & ((1 << IPMI_SDR_LCR) | (1 << IPMI_SDR_UCR))) {
+        return IPMI_SENSOR_SEVERITY_CR;
+    }
+    if (state & ((1 << IPMI_SDR_LNC) | (1 << IPMI_SDR_UNC))) {
+        return IPMI_SENSOR_SEVERITY_NC;
+    }
+    return IPMI_SENSOR_SEVERITY_OK;
+}
+
+static void decode(const ipmi_sensor_set_t* set, size_t k) {
+    ipmi_sensor_reading_t* r = &set->readings[k];
+    const ipmi_msg_t* rsp = &set->rsps[k];
+    
+    r->raw = 0;
+    r->value = 0;
+    r->state = 0;
+    r->severity = IPMI_SENSOR_SEVERITY_OK;
+    
+    if (set->status[k] != BMC_SUCCESS || rsp->data_len < 1) {
+        r->status = IPMI_SENSOR_ERROR;
+        return;
+    }
+    if (rsp->data[0] == CC_NOT_PRESENT) {
+        r->status = IPMI_SENSOR_UNAVAILABLE;
+        return;
+    }
+    if (rsp->data[0] != 0x00 || rsp->data_len < 3) {
+        r->status = IPMI_SENSOR_ERROR;
+        return;
+    }
+    if ((rsp->data[2] & SENSOR_READING_INVALID) || !(rsp->data[2] & SENSOR_SCANNING_ENABLED)) {
+        r->status = IPMI_SENSOR_UNAVAILABLE;
+        return;
+    }
+    
+    r->status = IPMI_SENSOR_OK;
+    r->raw = rsp->data[1];
+    
+    if (!r->analog) {
+        // Discrete sensor：byte 3、4 是 state bits（byte 4 可以省略）
+        r->state = (rsp->data_len > 3 ? rsp->data[3] : 0) |
+                   (rsp->data_len > 4 ? (rsp->data[4] & 0x7F) << 8 : 0);
+        return;
+    }
+    
+    r->value = conv_apply(&set->conv[k], r->raw);
+    if (rsp->data_len > 3) {
+        r->state = rsp->data[3] & 0x3F;
+    } else {
+        r->state = compare_thresholds(&set->repo->records[r->sdr_index], &set->conv[k], r->value);
+    }
+    r->severity = severity_of(r->state);
+}
+
+int ipmi_sensor_read_all(ipmi_ctx_t* ctx, ipmi_sensor_set_t* set) {
+    if (!ctx || !set || !set->readings) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = ipmi_send_recv_batch(ctx, set->reqs, set->rsps, set->status, set->count);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    for (size_t k = 0; k < set->count; k++) {
+        decode(set, k);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+const char* ipmi_sensor_severity_name(uint8_t severity) {
+    switch (severity) {
+        case IPMI_SENSOR_SEVERITY_OK: return "ok";
+        case IPMI_SENSOR_SEVERITY_NC: return "nc";
+        case IPMI_SENSOR_SEVERITY_CR: return "cr";
+        case IPMI_SENSOR_SEVERITY_NR: return "nr";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,50 @@
+#include "bmctool/ipmi.h"
+#include <string.h>
+
+void ipmi_seq_init(ipmi_seq_window_t* win, uint8_t first) {
+    memset(win, 0, sizeof(*win));
+    win->next = first & 0x3F;
+}
+
+/**
+ * 分配一個沒在用的 rqSeq 給 owner
+ * 
+ * @return 分配到的 seq（0-63），視窗滿了回傳 -1
+ */
+int ipmi_seq_alloc(ipmi_seq_window_t* win, void* owner) {
+    if (!win || !owner || win->count >= IPMI_SEQ_SPACE) {
+        return -1;
+    }
+    
+    // 6-bit wraparound，跳過還在路上的 seq
+    while (win->slots[win->next]) {
+        win->next = (win->next + 1) & 0x3F;
+    }
+    
+    int seq = win->next;
+    win->slots[seq] = owner;
+    win->count++;
+    win->next = (win->next + 1) & 0x3F;
+    
+    return seq;
+}
+
+/**
+ * 用回應的 rqSeq 取回 owner 並釋放該 seq
+ * 
+ * 回傳 NULL 表示沒有對應的 request（重複或過期的回應），呼叫端應該丟掉
+ */
+void* ipmi_seq_take(ipmi_seq_window_t* win, uint8_t seq) {
+    if (!win) {
+        return NULL;
+    }
+    
+    seq &= 0x3F;
+    void* owner = win->slots[seq];
+    if (owner) {
+        win->slots[seq] = NULL;
+        win->count--;
+    }
+    
+    return owner;
+}
@@ -0,0 +1,600 @@
+#include "bmctool/ipmi_session.h"
+#include <string.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/crypto.h>
+
+/*
+ * RMCP+ 封包的固定位置
+ *
+ * RMCP(4) | auth type(1) | payload type(1) | session ID(4) | session seq(4) |
+ * payload length(2) | payload | [integrity pad | pad length | next header | auth code]
+ */
+#define LANPLUS_AUTH_OFF        4
+#define LANPLUS_PTYPE_OFF       5
+#define LANPLUS_SID_OFF         6
+#define LANPLUS_SEQ_OFF         10
+#define LANPLUS_LEN_OFF         14
+#define LANPLUS_PAYLOAD_OFF     16
+
+#define AES_BLOCK               16
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// RAKP 用的 HMAC（SHA1 或 SHA256，依 auth 演算法）
+static const EVP_MD* auth_md(const ipmi_session_t* s) {
+    return s->auth_alg == IPMI_AUTH_RAKP_HMAC_SHA256 ? EVP_sha256() : EVP_sha1();
+}
+
+// 每個封包的 integrity HMAC
+static const EVP_MD* integ_md(const ipmi_session_t* s) {
+    return s->integ_alg == IPMI_INTEG_HMAC_SHA256_128 ? EVP_sha256() : EVP_sha1();
+}
+
+static void hmac(const EVP_MD* md, const uint8_t* key, size_t key_len,
+                 const uint8_t* data, size_t len, uint8_t* out) {
+    unsigned int out_len = 0;
+    HMAC(md, key, (int)key_len, data, len, out, &out_len);
+}
+
+// 寫 pre-session（還沒有 session）的 RMCP+ header，回傳 payload 開始的位置
+static uint8_t* presession_header(uint8_t* buf, uint8_t payload_type, size_t payload_len) {
+    buf[0] = RMCP_VERSION_1_0;
+    buf[1] = 0x00;
+    buf[2] = RMCP_SEQUENCE_NO_ACK;
+    buf[3] = RMCP_CLASS_IPMI;
+    buf[LANPLUS_AUTH_OFF] = IPMI_AUTH_TYPE_RMCPP;
+    buf[LANPLUS_PTYPE_OFF] = payload_type;
+    put_le32(buf + LANPLUS_SID_OFF, 0);
+    put_le32(buf + LANPLUS_SEQ_OFF, 0);
+    buf[LANPLUS_LEN_OFF] = payload_len & 0xFF;
+    buf[LANPLUS_LEN_OFF + 1] = (payload_len >> 8) & 0xFF;
+    
+    return buf + LANPLUS_PAYLOAD_OFF;
+}
+
+// 取出 pre-session 回應的 payload，檢查 payload type
+static const uint8_t* presession_payload(const uint8_t* buf, size_t len,
+                                         uint8_t payload_type, size_t* payload_len) {
+    if (len < LANPLUS_PAYLOAD_OFF || buf[LANPLUS_AUTH_OFF] != IPMI_AUTH_TYPE_RMCPP ||
+        (buf[LANPLUS_PTYPE_OFF] & 0x3F) != payload_type) {
+        return NULL;
+    }
+    
+    size_t plen = buf[LANPLUS_LEN_OFF] | (buf[LANPLUS_LEN_OFF + 1] << 8);
+    if (plen > len - LANPLUS_PAYLOAD_OFF) {
+        return NULL;
+    }
+    
+    *payload_len = plen;
+    return buf + LANPLUS_PAYLOAD_OFF;
+}
+
+int ipmi_session_init(ipmi_session_t* s, int cipher_suite, uint8_t privilege) {
+    if (!s) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(s, 0, sizeof(*s));
+    
+    switch (cipher_suite) {
+        case 3:
+            s->auth_alg = IPMI_AUTH_RAKP_HMAC_SHA1;
+            s->integ_alg = IPMI_INTEG_HMAC_SHA1_96;
+            s->key_len = 20;
+            s->icv_len = 12;
+            break;
+        case 17:
+            s->auth_alg = IPMI_AUTH_RAKP_HMAC_SHA256;
+            s->integ_alg = IPMI_INTEG_HMAC_SHA256_128;
+            s->key_len = 32;
+            s->icv_len = 16;
+            break;
+        default:
+            bmc_log(LOG_LEVEL_ERROR, "Unsupported cipher suite %d (use 3 or 17)", cipher_suite);
+            return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    s->cipher_suite = (uint8_t)cipher_suite;
+    s->crypt_alg = IPMI_CRYPT_AES_CBC_128;
+    s->privilege = privilege ? privilege : IPMI_PRIV_ADMIN;
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_session_clear(ipmi_session_t* s) {
+    if (s) {
+        OPENSSL_cleanse(s, sizeof(*s));
+    }
+}
+
+int ipmi_handshake_init(ipmi_handshake_t* hs, const char* username, const char* password) {
+    if (!hs) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    username = username ? username : "";
+    password = password ? password : "";
+    
+    if (strlen(username) > IPMI_SESSION_USERNAME_MAX ||
+        strlen(password) > IPMI_SESSION_PASSWORD_LEN) {
+        bmc_log(LOG_LEVEL_ERROR, "Username or password too long for IPMI");
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(hs, 0, sizeof(*hs));
+    memcpy(hs->username, username, strlen(username));
+    memcpy(hs->kuid, password, strlen(password));  // 不足 20 bytes 補 0
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_handshake_clear(ipmi_handshake_t* hs) {
+    if (hs) {
+        OPENSSL_cleanse(hs, sizeof(*hs));
+    }
+}
+
+int ipmi_session_is_payload(const uint8_t* buf, size_t len, uint8_t payload_type, uint8_t tag) {
+    size_t plen;
+    const uint8_t* p = presession_payload(buf, len, payload_type, &plen);
+    
+    return p && plen >= 1 && p[0] == tag;
+}
+
+/* ===== Open Session ===== */
+
+int ipmi_session_build_open(ipmi_session_t* s, ipmi_handshake_t* hs,
+                            uint8_t* buf, size_t* len) {
+    if (*len < LANPLUS_PAYLOAD_OFF + 32) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    // 我們這端的 session ID 隨便挑，不能是 0
+    do {
+        if (RAND_bytes((uint8_t*)&s->console_id, sizeof(s->console_id)) != 1) {
+            return BMC_ERROR_PROTOCOL;
+        }
+    } while (s->console_id == 0);
+    
+    uint8_t* p = presession_header(buf, IPMI_PAYLOAD_OPEN_SESSION_REQ, 32);
+    memset(p, 0, 32);
+    p[0] = hs->tag;
+    p[1] = s->privilege;
+    put_le32(p + 4, s->console_id);
+    
+    // auth / integrity / confidentiality 三個演算法 payload，各 8 bytes
+    p[8] = 0x00;  p[11] = 0x08;  p[12] = s->auth_alg;
+    p[16] = 0x01; p[19] = 0x08;  p[20] = s->integ_alg;
+    p[24] = 0x02; p[27] = 0x08;  p[28] = s->crypt_alg;
+    
+    *len = LANPLUS_PAYLOAD_OFF + 32;
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_parse_open(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                            const uint8_t* buf, size_t len) {
+    size_t plen;
+    const uint8_t* p = presession_payload(buf, len, IPMI_PAYLOAD_OPEN_SESSION_RSP, &plen);
+    if (!p || plen < 2 || p[0] != hs->tag) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (p[1] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "Open Session rejected: status 0x%02x", p[1]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (plen < 36 || get_le32(p + 4) != s->console_id) {
+        bmc_log(LOG_LEVEL_ERROR, "Malformed Open Session response");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (p[16] != s->auth_alg || p[24] != s->integ_alg || p[32] != s->crypt_alg) {
+        bmc_log(LOG_LEVEL_ERROR, "BMC picked different algorithms (%d/%d/%d)",
+                p[16], p[24], p[32]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    s->bmc_id = get_le32(p + 8);
+    return BMC_SUCCESS;
+}
+
+/* ===== RAKP ===== */
+
+int ipmi_session_build_rakp1(ipmi_session_t* s, ipmi_handshake_t* hs,
+                             uint8_t* buf, size_t* len) {
+    size_t ulen = strlen(hs->username);
+    size_t plen = 28 + ulen;
+    if (*len < LANPLUS_PAYLOAD_OFF + plen) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    if (RAND_bytes(hs->rm, sizeof(hs->rm)) != 1) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // bit 4：只用 username 找帳號，不看 privilege
+    hs->role = 0x10 | s->privilege;
+    
+    uint8_t* p = presession_header(buf, IPMI_PAYLOAD_RAKP1, plen);
+    memset(p, 0, plen);
+    p[0] = hs->tag;
+    put_le32(p + 4, s->bmc_id);
+    memcpy(p + 8, hs->rm, 16);
+    p[24] = hs->role;
+    p[27] = (uint8_t)ulen;
+    memcpy(p + 28, hs->username, ulen);
+    
+    *len = LANPLUS_PAYLOAD_OFF + plen;
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_parse_rakp2(ipmi_session_t* s, ipmi_handshake_t* hs,
+                             const uint8_t* buf, size_t len) {
+    size_t plen;
+    const uint8_t* p = presession_payload(buf, len, IPMI_PAYLOAD_RAKP2, &plen);
+    if (!p || plen < 2 || p[0] != hs->tag) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (p[1] != 0x00) {
+        // 0x0D：帳號不存在，0x12：privilege 不符
+        bmc_log(LOG_LEVEL_ERROR, "RAKP2 rejected: status 0x%02x", p[1]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (plen < 40u + s->key_len || get_le32(p + 4) != s->console_id) {
+        bmc_log(LOG_LEVEL_ERROR, "Malformed RAKP2");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    memcpy(hs->rc, p + 8, 16);
+    memcpy(hs->guid, p + 24, 16);
+    
+    size_t ulen = strlen(hs->username);
+    uint8_t data[4 + 4 + 16 + 16 + 16 + 2 + IPMI_SESSION_USERNAME_MAX];
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    
+    // BMC 證明它知道密碼：HMAC_Kuid(SIDm, SIDc, Rm, Rc, GUIDc, ROLEm, ULENGTHm, UNAMEm)
+    put_le32(data, s->console_id);
+    put_le32(data + 4, s->bmc_id);
+    memcpy(data + 8, hs->rm, 16);
+    memcpy(data + 24, hs->rc, 16);
+    memcpy(data + 40, hs->guid, 16);
+    data[56] = hs->role;
+    data[57] = (uint8_t)ulen;
+    memcpy(data + 58, hs->username, ulen);
+    hmac(auth_md(s), hs->kuid, sizeof(hs->kuid), data, 58 + ulen, mac);
+    
+    if (CRYPTO_memcmp(mac, p + 40, s->key_len) != 0) {
+        bmc_log(LOG_LEVEL_ERROR, "RAKP2 auth code mismatch (wrong password?)");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // SIK = HMAC_KG(Rm, Rc, ROLEm, ULENGTHm, UNAMEm)，沒設 BMC key 時 KG = Kuid
+    memcpy(data, hs->rm, 16);
+    memcpy(data + 16, hs->rc, 16);
+    data[32] = hs->role;
+    data[33] = (uint8_t)ulen;
+    memcpy(data + 34, hs->username, ulen);
+    hmac(auth_md(s), hs->kuid, sizeof(hs->kuid), data, 34 + ulen, s->sik);
+    
+    // K1 = HMAC_SIK(Const1)，K2 = HMAC_SIK(Const2)；常數固定 20 bytes，輸出是 hash 長度
+    uint8_t konst[IPMI_SESSION_CONST_LEN];
+    memset(konst, 0x01, sizeof(konst));
+    hmac(auth_md(s), s->sik, s->key_len, konst, sizeof(konst), s->k1);
+    memset(konst, 0x02, sizeof(konst));
+    hmac(auth_md(s), s->sik, s->key_len, konst, sizeof(konst), s->k2);
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_build_rakp3(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                             uint8_t* buf, size_t* len) {
+    size_t plen = 8 + s->key_len;
+    if (*len < LANPLUS_PAYLOAD_OFF + plen) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    size_t ulen = strlen(hs->username);
+    uint8_t data[16 + 4 + 2 + IPMI_SESSION_USERNAME_MAX];
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    
+    // 我們證明知道密碼：HMAC_Kuid(Rc, SIDm, ROLEm, ULENGTHm, UNAMEm)
+    memcpy(data, hs->rc, 16);
+    put_le32(data + 16, s->console_id);
+    data[20] = hs->role;
+    data[21] = (uint8_t)ulen;
+    memcpy(data + 22, hs->username, ulen);
+    hmac(auth_md(s), hs->kuid, sizeof(hs->kuid), data, 22 + ulen, mac);
+    
+    uint8_t* p = presession_header(buf, IPMI_PAYLOAD_RAKP3, plen);
+    memset(p, 0, 8);
+    p[0] = hs->tag;
+    put_le32(p + 4, s->bmc_id);
+    memcpy(p + 8, mac, s->key_len);
+    
+    *len = LANPLUS_PAYLOAD_OFF + plen;
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_parse_rakp4(ipmi_session_t* s, const ipmi_handshake_t* hs,
+                             const uint8_t* buf, size_t len) {
+    size_t plen;
+    const uint8_t* p = presession_payload(buf, len, IPMI_PAYLOAD_RAKP4, &plen);
+    if (!p || plen < 2 || p[0] != hs->tag) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (p[1] != 0x00) {
+        bmc_log(LOG_LEVEL_ERROR, "RAKP4 rejected: status 0x%02x", p[1]);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (plen < 8u + s->icv_len || get_le32(p + 4) != s->console_id) {
+        bmc_log(LOG_LEVEL_ERROR, "Malformed RAKP4");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // ICV = HMAC_SIK(Rm, SIDc, GUIDc)，截到 integrity 演算法的長度
+    uint8_t data[16 + 4 + 16];
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    memcpy(data, hs->rm, 16);
+    put_le32(data + 16, s->bmc_id);
+    memcpy(data + 20, hs->guid, 16);
+    hmac(auth_md(s), s->sik, s->key_len, data, sizeof(data), mac);
+    
+    if (CRYPTO_memcmp(mac, p + 8, s->icv_len) != 0) {
+        bmc_log(LOG_LEVEL_ERROR, "RAKP4 integrity check mismatch");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    s->out_seq = 1;
+    s->in_seq = 0;
+    s->in_window = 0;
+    s->active = 1;
+    s->last_used_us = bmc_monotonic_us();
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== Session 封包 ===== */
+
+int ipmi_session_wrap_payload(ipmi_session_t* s, uint8_t payload_type,
+                              const uint8_t* msg, size_t msg_len, uint8_t* buf, size_t* len) {
+    if (!s || !s->active || (!msg && msg_len) || !buf || !len) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // confidentiality trailer：pad 1,2,3...，最後一個 byte 是 pad 長度，湊滿 16 的倍數
+    size_t pad = (AES_BLOCK - (msg_len + 1) % AES_BLOCK) % AES_BLOCK;
+    size_t cipher_len = msg_len + pad + 1;
+    size_t payload_len = AES_BLOCK + cipher_len;
+    
+    // integrity pad：從 auth type 到 next header 要是 4 的倍數
+    size_t covered = LANPLUS_PAYLOAD_OFF - LANPLUS_AUTH_OFF + payload_len + 2;
+    size_t integ_pad = (4 - covered % 4) % 4;
+    size_t total = LANPLUS_PAYLOAD_OFF + payload_len + integ_pad + 2 + s->icv_len;
+    if (*len < total) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    buf[0] = RMCP_VERSION_1_0;
+    buf[1] = 0x00;
+    buf[2] = RMCP_SEQUENCE_NO_ACK;
+    buf[3] = RMCP_CLASS_IPMI;
+    buf[LANPLUS_AUTH_OFF] = IPMI_AUTH_TYPE_RMCPP;
+    buf[LANPLUS_PTYPE_OFF] = payload_type | IPMI_PAYLOAD_ENCRYPTED | IPMI_PAYLOAD_AUTHENTICATED;
+    put_le32(buf + LANPLUS_SID_OFF, s->bmc_id);
+    put_le32(buf + LANPLUS_SEQ_OFF, s->out_seq);
+    buf[LANPLUS_LEN_OFF] = payload_len & 0xFF;
+    buf[LANPLUS_LEN_OFF + 1] = (payload_len >> 8) & 0xFF;
+    
+    // 0 不能用，繞回來從 1 開始
+    if (++s->out_seq == 0) {
+        s->out_seq = 1;
+    }
+    
+    /* 加密：IV(16) + AES-CBC-128(msg + trailer)，key 是 K2 前 16 bytes */
+    uint8_t* iv = buf + LANPLUS_PAYLOAD_OFF;
+    uint8_t* out = iv + AES_BLOCK;
+    if (RAND_bytes(iv, AES_BLOCK) != 1) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (msg_len) {
+        memcpy(out, msg, msg_len);
+    }
+    for (size_t i = 0; i < pad; i++) {
+        out[msg_len + i] = (uint8_t)(i + 1);
+    }
+    out[msg_len + pad] = (uint8_t)pad;
+    
+    EVP_CIPHER_CTX* cctx = EVP_CIPHER_CTX_new();
+    int outl = 0;
+    int ok = cctx &&
+             EVP_EncryptInit_ex(cctx, EVP_aes_128_cbc(), NULL, s->k2, iv) == 1 &&
+             EVP_CIPHER_CTX_set_padding(cctx, 0) == 1 &&
+             EVP_EncryptUpdate(cctx, out, &outl, out, (int)cipher_len) == 1 &&
+             (size_t)outl == cipher_len;
+    EVP_CIPHER_CTX_free(cctx);
+    if (!ok) {
+        bmc_log(LOG_LEVEL_ERROR, "AES encryption failed");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    /* Integrity trailer */
+    uint8_t* p = out + cipher_len;
+    memset(p, 0xFF, integ_pad);
+    p += integ_pad;
+    *p++ = (uint8_t)integ_pad;
+    *p++ = 0x07;  // next header
+    
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    hmac(integ_md(s), s->k1, s->key_len, buf + LANPLUS_AUTH_OFF,
+         (size_t)(p - buf) - LANPLUS_AUTH_OFF, mac);
+    memcpy(p, mac, s->icv_len);
+    p += s->icv_len;
+    
+    *len = (size_t)(p - buf);
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_wrap(ipmi_session_t* s, const uint8_t* msg, size_t msg_len,
+                      uint8_t* buf, size_t* len) {
+    return ipmi_session_wrap_payload(s, IPMI_PAYLOAD_IPMI, msg, msg_len, buf, len);
+}
+
+int ipmi_session_peek_id(const uint8_t* buf, size_t len, uint32_t* session_id) {
+    if (!buf || !session_id) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (len < LANPLUS_PAYLOAD_OFF || buf[0] != RMCP_VERSION_1_0 ||
+        buf[3] != RMCP_CLASS_IPMI || buf[LANPLUS_AUTH_OFF] != IPMI_AUTH_TYPE_RMCPP) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    *session_id = get_le32(buf + LANPLUS_SID_OFF);
+    return BMC_SUCCESS;
+}
+
+/*
+ * 收到的 session sequence number 是不是新的：比目前最大的大就往前推，
+ * 落在往回 32 個以內而且還沒收過也接受（UDP 可能亂序），重複的和太舊的都丟掉
+ * 只檢查不更新，封包整個驗完才呼叫 seq_accept
+ */
+static int seq_check(const ipmi_session_t* s, uint32_t seq) {
+    if (seq == 0) {
+        return 0;
+    }
+    
+    // 差值當有號數看，繞回 0 之後也算得對
+    int32_t ahead = (int32_t)(seq - s->in_seq);
+    if (ahead > 0 || s->in_seq == 0) {
+        return 1;
+    }
+    
+    uint32_t behind = (uint32_t)-ahead;
+    return behind < IPMI_SESSION_SEQ_WINDOW && !(s->in_window & (1u << behind));
+}
+
+static void seq_accept(ipmi_session_t* s, uint32_t seq) {
+    int32_t ahead = (int32_t)(seq - s->in_seq);
+    
+    if (s->in_seq == 0) {
+        s->in_seq = seq;
+        s->in_window = 1;
+    } else if (ahead > 0) {
+        s->in_window = (uint32_t)ahead < IPMI_SESSION_SEQ_WINDOW ? (s->in_window << ahead) | 1 : 1;
+        s->in_seq = seq;
+    } else {
+        s->in_window |= 1u << (uint32_t)-ahead;
+    }
+}
+
+int ipmi_session_unwrap_payload(ipmi_session_t* s, uint8_t* buf, size_t len,
+                                uint8_t* payload_type, uint8_t** payload, size_t* payload_len) {
+    if (!s || !s->active || !buf || !payload_type || !payload || !payload_len) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (len < LANPLUS_PAYLOAD_OFF + 2u + s->icv_len || buf[0] != RMCP_VERSION_1_0 ||
+        buf[3] != RMCP_CLASS_IPMI || buf[LANPLUS_AUTH_OFF] != IPMI_AUTH_TYPE_RMCPP) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    uint8_t ptype = buf[LANPLUS_PTYPE_OFF];
+    if (get_le32(buf + LANPLUS_SID_OFF) != s->console_id) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    // session 建好之後一定要簽章和加密，不接受明文回應
+    if (!(ptype & IPMI_PAYLOAD_AUTHENTICATED) || !(ptype & IPMI_PAYLOAD_ENCRYPTED)) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping unprotected session packet (type 0x%02x)", ptype);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    /* Integrity：HMAC_K1(auth type ~ next header) */
+    size_t icv_off = len - s->icv_len;
+    uint8_t mac[EVP_MAX_MD_SIZE];
+    hmac(integ_md(s), s->k1, s->key_len, buf + LANPLUS_AUTH_OFF, icv_off - LANPLUS_AUTH_OFF, mac);
+    if (CRYPTO_memcmp(mac, buf + icv_off, s->icv_len) != 0) {
+        bmc_log(LOG_LEVEL_DEBUG, "Session packet integrity check failed");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    uint32_t seq = get_le32(buf + LANPLUS_SEQ_OFF);
+    if (!seq_check(s, seq)) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping replayed or stale session packet (seq %u, last %u)",
+                seq, s->in_seq);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    size_t wire_len = buf[LANPLUS_LEN_OFF] | (buf[LANPLUS_LEN_OFF + 1] << 8);
+    if (wire_len > icv_off - 2 - LANPLUS_PAYLOAD_OFF || wire_len < 2 * AES_BLOCK ||
+        wire_len % AES_BLOCK != 0) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    /* 就地解密 */
+    uint8_t* iv = buf + LANPLUS_PAYLOAD_OFF;
+    uint8_t* data = iv + AES_BLOCK;
+    size_t cipher_len = wire_len - AES_BLOCK;
+    
+    EVP_CIPHER_CTX* cctx = EVP_CIPHER_CTX_new();
+    int outl = 0;
+    int ok = cctx &&
+             EVP_DecryptInit_ex(cctx, EVP_aes_128_cbc(), NULL, s->k2, iv) == 1 &&
+             EVP_CIPHER_CTX_set_padding(cctx, 0) == 1 &&
+             EVP_DecryptUpdate(cctx, data, &outl, data, (int)cipher_len) == 1 &&
+             (size_t)outl == cipher_len;
+    EVP_CIPHER_CTX_free(cctx);
+    if (!ok) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    size_t pad = data[cipher_len - 1];
+    if (pad >= AES_BLOCK || pad + 1 > cipher_len) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    seq_accept(s, seq);
+    s->last_used_us = bmc_monotonic_us();
+    
+    *payload_type = ptype & 0x3F;
+    *payload = data;
+    *payload_len = cipher_len - pad - 1;
+    return BMC_SUCCESS;
+}
+
+int ipmi_session_unwrap(ipmi_session_t* s, uint8_t* buf, size_t len, ipmi_rsp_view_t* view) {
+    if (!view) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    uint8_t ptype;
+    uint8_t* msg;
+    size_t msg_len;
+    int ret = ipmi_session_unwrap_payload(s, buf, len, &ptype, &msg, &msg_len);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (ptype != IPMI_PAYLOAD_IPMI) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    return ipmi_msg_view(msg, msg_len, view);
+}
@@ -0,0 +1,318 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_session_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+
+#define CACHE_MAGIC         0x434D4242      // "BBMC"
+#define CACHE_VERSION       1
+#define CACHE_SLOTS         1024
+#define CACHE_FILE_NAME     "ipmi-sessions"
+
+enum {
+    SLOT_FREE = 0,
+    SLOT_IDLE,          // 可以借
+    SLOT_LEASED         // 某個 process 正在用
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;         // 結構改了就整個重建
+    uint32_t num_slots;
+    uint8_t reserved[48];
+} cache_header_t;
+
+typedef struct {
+    uint8_t key[32];
+    uint32_t state;
+    int32_t owner;              // 借出的 pid
+    int64_t last_used;          // unix time（秒），跨 process 比較用
+    ipmi_session_t session;
+} cache_slot_t;
+
+struct ipmi_session_cache {
+    int fd;
+    size_t map_len;
+    cache_header_t* hdr;
+    cache_slot_t* slots;
+    int ttl_s;
+};
+
+static size_t cache_size(void) {
+    return sizeof(cache_header_t) + CACHE_SLOTS * sizeof(cache_slot_t);
+}
+
+static int cache_lock(ipmi_session_cache_t* cache) {
+    while (flock(cache->fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            bmc_log(LOG_LEVEL_WARN, "flock() failed: %s", strerror(errno));
+            return BMC_ERROR_INVALID_PARAM;
+        }
+    }
+    return BMC_SUCCESS;
+}
+
+static void cache_unlock(ipmi_session_cache_t* cache) {
+    flock(cache->fd, LOCK_UN);
+}
+
+// 檔案大小或版本不對就清空重建（呼叫端要持有鎖）
+static int cache_format(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return -1;
+    }
+    
+    cache_header_t hdr;
+    if ((size_t)st.st_size == cache_size() &&
+        pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) &&
+        hdr.magic == CACHE_MAGIC && hdr.version == CACHE_VERSION &&
+        hdr.slot_size == sizeof(cache_slot_t) && hdr.num_slots == CACHE_SLOTS) {
+        return 0;
+    }
+    
+    if (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t)cache_size()) < 0) {
+        return -1;
+    }
+    
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = CACHE_MAGIC;
+    hdr.version = CACHE_VERSION;
+    hdr.slot_size = sizeof(cache_slot_t);
+    hdr.num_slots = CACHE_SLOTS;
+    
+    return pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) ? 0 : -1;
+}
+
+ipmi_session_cache_t* ipmi_session_cache_open(const char* path) {
+    char default_path[4096];
+    if (!path) {
+        if (bmc_cache_path(CACHE_FILE_NAME, default_path, sizeof(default_path)) != BMC_SUCCESS) {
+            return NULL;
+        }
+        path = default_path;
+    }
+    
+    int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot open session cache %s: %s", path, strerror(errno));
+        return NULL;
+    }
+    
+    // 裡面有 session 金鑰，別人的檔案或別人讀得到的檔案都不用
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_uid != geteuid() || (st.st_mode & 077) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Ignoring session cache %s: bad owner or permissions", path);
+        close(fd);
+        return NULL;
+    }
+    
+    ipmi_session_cache_t* cache = calloc(1, sizeof(ipmi_session_cache_t));
+    if (!cache) {
+        close(fd);
+        return NULL;
+    }
+    cache->fd = fd;
+    cache->ttl_s = IPMI_SESSION_CACHE_TTL;
+    
+    if (cache_lock(cache) != BMC_SUCCESS) {
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    int ret = cache_format(fd);
+    cache_unlock(cache);
+    
+    if (ret < 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot initialize session cache %s: %s", path, strerror(errno));
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    
+    cache->map_len = cache_size();
+    void* map = mmap(NULL, cache->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        bmc_log(LOG_LEVEL_WARN, "mmap() failed: %s", strerror(errno));
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    
+    cache->hdr = map;
+    cache->slots = (cache_slot_t*)((uint8_t*)map + sizeof(cache_header_t));
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Session cache: %s", path);
+    return cache;
+}
+
+void ipmi_session_cache_close(ipmi_session_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    munmap(cache->hdr, cache->map_len);
+    close(cache->fd);
+    free(cache);
+}
+
+int ipmi_session_cache_set_ttl(ipmi_session_cache_t* cache, int ttl_s) {
+    if (!cache || ttl_s <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    cache->ttl_s = ttl_s;
+    return BMC_SUCCESS;
+}
+
+void ipmi_session_cache_key(const char* host, uint16_t port, const char* username,
+                            const char* password, int cipher_suite, uint8_t privilege,
+                            ipmi_session_key_t* key) {
+    char buf[512];
+    int n = snprintf(buf, sizeof(buf), "%s%c%u%c%s%c%s%c%d%c%u",
+                     host ? host : "", 0, port, 0, username ? username : "", 0,
+                     password ? password : "", 0, cipher_suite, 0, privilege);
+    size_t len = n < 0 ? 0 : ((size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+    
+    EVP_Digest(buf, len, key->digest, NULL, EVP_sha256(), NULL);
+    OPENSSL_cleanse(buf, sizeof(buf));
+}
+
+// slot 還能用嗎：過期的、借出去但 process 已經不在的都當作空的
+static int slot_usable(const ipmi_session_cache_t* cache, const cache_slot_t* slot, time_t now) {
+    if (slot->state == SLOT_FREE || now - slot->last_used >= cache->ttl_s) {
+        return 0;
+    }
+    
+    if (slot->state == SLOT_LEASED && kill(slot->owner, 0) < 0 && errno == ESRCH) {
+        return 0;
+    }
+    
+    return 1;
+}
+
+static void slot_clear(cache_slot_t* slot) {
+    OPENSSL_cleanse(slot, sizeof(*slot));
+}
+
+int ipmi_session_cache_checkout(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                                ipmi_session_t* s) {
+    if (!cache || !key || !s) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = cache_lock(cache);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    time_t now = time(NULL);
+    int found = 0;
+    
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        if (!slot_usable(cache, slot, now)) {
+            if (slot->state != SLOT_FREE) {
+                slot_clear(slot);
+            }
+            continue;
+        }
+        if (slot->state != SLOT_IDLE || memcmp(slot->key, key->digest, sizeof(slot->key)) != 0) {
+            continue;
+        }
+        
+        slot->state = SLOT_LEASED;
+        slot->owner = (int32_t)getpid();
+        *s = slot->session;
+        
+        // 閒置時間換算回這個 process 的 monotonic clock，keepalive 判斷才對
+        uint64_t idle_us = (uint64_t)(now - slot->last_used) * 1000000ULL;
+        uint64_t mono = bmc_monotonic_us();
+        s->last_used_us = mono > idle_us ? mono - idle_us : 0;
+        s->active = 1;
+        found = 1;
+        break;
+    }
+    
+    cache_unlock(cache);
+    return found;
+}
+
+int ipmi_session_cache_checkin(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                               const ipmi_session_t* s) {
+    if (!cache || !key || !s || !s->active) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = cache_lock(cache);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    time_t now = time(NULL);
+    cache_slot_t* target = NULL;
+    cache_slot_t* oldest = NULL;
+    
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        
+        // 借出去的那格（同一個 session）優先
+        if (slot->state == SLOT_LEASED && slot->session.bmc_id == s->bmc_id &&
+            memcmp(slot->key, key->digest, sizeof(slot->key)) == 0) {
+            target = slot;
+            break;
+        }
+        
+        if (!slot_usable(cache, slot, now)) {
+            if (!target) {
+                target = slot;
+            }
+        } else if (slot->state == SLOT_IDLE && (!oldest || slot->last_used < oldest->last_used)) {
+            oldest = slot;
+        }
+    }
+    
+    // 滿了就擠掉最久沒用的；全部都借出去了就不存
+    if (!target) {
+        target = oldest;
+    }
+    if (target) {
+        slot_clear(target);
+        memcpy(target->key, key->digest, sizeof(target->key));
+        target->state = SLOT_IDLE;
+        target->last_used = now - (time_t)((bmc_monotonic_us() - s->last_used_us) / 1000000);
+        target->session = *s;
+        target->session.last_used_us = 0;
+    }
+    
+    cache_unlock(cache);
+    return target ? BMC_SUCCESS : BMC_ERROR_MEMORY;
+}
+
+void ipmi_session_cache_drop(ipmi_session_cache_t* cache, const ipmi_session_key_t* key,
+                             uint32_t bmc_id) {
+    if (!cache || !key || cache_lock(cache) != BMC_SUCCESS) {
+        return;
+    }
+    
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        if (slot->state != SLOT_FREE && slot->session.bmc_id == bmc_id &&
+            memcmp(slot->key, key->digest, sizeof(slot->key)) == 0) {
+            slot_clear(slot);
+        }
+    }
+    
+    cache_unlock(cache);
+}
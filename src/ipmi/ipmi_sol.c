@@ -0,0 +1,1020 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_sol.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#define SOL_DEFAULT_SOCKETS     4
+#define SOL_DEFAULT_TIMEOUT_MS  3000
+#define SOL_DEFAULT_RETRIES     3
+#define SOL_DEFAULT_FLUSH_MS    200
+#define SOL_CLOSE_TIMEOUT_MS    2000    // close 時等 Deactivate Payload 回應的上限
+
+#define SOL_TICK_MS             20      // 重送、keepalive、flush 的檢查週期
+#define SOL_KEEPALIVE_MS        20000   // 這麼久沒送東西就送一個 Get Device ID，免得 BMC 把 session 關掉
+#define SOL_BATCH               64
+#define SOL_RX_LEN              512
+#define SOL_RCVBUF_SIZE         (4 * 1024 * 1024)
+#define SOL_LOG_BUF             (64 * 1024)
+#define SOL_TXQ_MAX             4096
+#define SOL_MAX_OUT             200     // BMC 沒說 inbound payload size 時，一個封包最多送幾個字元
+#define SOL_SEQ_MAX             15
+
+#define ACTIVATE_RSP_LEN        13      // cc + aux(4) + inbound(2) + outbound(2) + port(2) + VLAN(2)
+
+// Activate / Deactivate Payload：SOL instance 1；aux 要求加密 + 認證，
+// bits [3:2] = 01b 表示 SOL 期間的 serial / modem alert 延後送
+static const uint8_t g_activate_req[] = { IPMI_PAYLOAD_SOL, 0x01, 0xC4, 0x00, 0x00, 0x00 };
+static const uint8_t g_deactivate_req[] = { IPMI_PAYLOAD_SOL, 0x01, 0x00, 0x00, 0x00, 0x00 };
+
+typedef struct {
+    char* host;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    ipmi_session_t* session;
+    int sock;
+    int log_fd;
+    int force_tried;
+    
+    // 在等回應的 IPMI request（Activate / Deactivate Payload），req_cmd 為 0 表示沒有
+    uint8_t req_cmd;
+    uint8_t req_seq;
+    uint8_t next_ipmi_seq;
+    int req_attempts;
+    uint64_t req_deadline;
+    
+    // BMC → console：最後一個收下的封包，重送的就再 ACK 一次
+    uint8_t rx_seq;
+    uint8_t rx_accepted;
+    
+    // console → BMC：txq 前 tx_len 個字元是在路上的那個封包
+    uint8_t* txq;
+    size_t txq_len;
+    uint8_t tx_seq;              // 0 表示沒有在路上的
+    uint8_t next_tx_seq;
+    uint8_t tx_len;
+    int tx_attempts;
+    uint64_t tx_deadline;
+    uint16_t max_out;
+    
+    uint64_t last_tx_us;
+    
+    // log buffer；dirty 表示在 mgr->dirty 清單裡
+    uint8_t* wbuf;
+    size_t wlen;
+    uint64_t wfirst_us;          // buffer 裡最舊的字元收到的時間
+    int dirty;
+    
+    ipmi_sol_stats_t stats;
+} sol_host_t;
+
+typedef struct {
+    int fd;
+    int tx_len;                  // 排進 sendmmsg 批次、還沒送的封包數
+} sol_sock_t;
+
+struct ipmi_sol_mgr {
+    int epfd;
+    
+    // socks[0..n-1] 給 IPv4，socks[n..2n-1] 給 IPv6，用到才建立
+    sol_sock_t* socks;
+    int sockets_per_family;
+    
+    sol_host_t* hosts;
+    int num_hosts;
+    int cap_hosts;
+    
+    // console_id → host index（open addressing，-1 表示空）
+    int* by_id;
+    size_t by_id_cap;
+    
+    int* dirty;                  // 有東西還沒寫出的 host
+    int num_dirty;
+    
+    int timeout_ms;
+    int retries;
+    int flush_ms;
+    int force;
+    
+    // 送：每個 socket SOL_BATCH 格；收：所有 socket 共用
+    struct mmsghdr* tx_msgs;
+    struct iovec* tx_iov;
+    uint8_t* tx_bufs;
+    struct mmsghdr rx_msgs[SOL_BATCH];
+    struct iovec rx_iov[SOL_BATCH];
+    struct sockaddr_storage rx_from[SOL_BATCH];
+    uint8_t rx_bufs[SOL_BATCH][SOL_RX_LEN];
+};
+
+static uint16_t get_le16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+int ipmi_sol_parse(const uint8_t* payload, size_t len, ipmi_sol_pkt_t* pkt) {
+    if (!payload || !pkt) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (len < IPMI_SOL_HDR_LEN) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    pkt->seq = payload[0] & 0x0F;
+    pkt->ack_seq = payload[1] & 0x0F;
+    pkt->accepted = payload[2];
+    pkt->status = payload[3];
+    pkt->data = payload + IPMI_SOL_HDR_LEN;
+    pkt->data_len = len - IPMI_SOL_HDR_LEN;
+    
+    return BMC_SUCCESS;
+}
+
+size_t ipmi_sol_build(const ipmi_sol_pkt_t* pkt, uint8_t* buf) {
+    buf[0] = pkt->seq & 0x0F;
+    buf[1] = pkt->ack_seq & 0x0F;
+    buf[2] = pkt->accepted;
+    buf[3] = pkt->status;
+    if (pkt->data_len) {
+        memcpy(buf + IPMI_SOL_HDR_LEN, pkt->data, pkt->data_len);
+    }
+    return IPMI_SOL_HDR_LEN + pkt->data_len;
+}
+
+const char* ipmi_sol_state_name(int state) {
+    switch (state) {
+        case IPMI_SOL_STATE_ACTIVATING: return "activating";
+        case IPMI_SOL_STATE_ACTIVE:     return "active";
+        case IPMI_SOL_STATE_CLOSING:    return "closing";
+        case IPMI_SOL_STATE_CLOSED:     return "closed";
+        case IPMI_SOL_STATE_FAILED:     return "failed";
+        default:                        return "unknown";
+    }
+}
+
+/* ===== Manager ===== */
+
+ipmi_sol_mgr_t* ipmi_sol_mgr_create(int num_sockets) {
+    if (num_sockets < 0) {
+        return NULL;
+    }
+    
+    ipmi_sol_mgr_t* mgr = calloc(1, sizeof(ipmi_sol_mgr_t));
+    if (!mgr) {
+        return NULL;
+    }
+    
+    mgr->sockets_per_family = num_sockets ? num_sockets : SOL_DEFAULT_SOCKETS;
+    mgr->timeout_ms = SOL_DEFAULT_TIMEOUT_MS;
+    mgr->retries = SOL_DEFAULT_RETRIES;
+    mgr->flush_ms = SOL_DEFAULT_FLUSH_MS;
+    
+    size_t nsocks = 2 * (size_t)mgr->sockets_per_family;
+    size_t slots = nsocks * SOL_BATCH;
+    mgr->epfd = epoll_create1(EPOLL_CLOEXEC);
+    mgr->socks = calloc(nsocks, sizeof(sol_sock_t));
+    mgr->tx_msgs = calloc(slots, sizeof(struct mmsghdr));
+    mgr->tx_iov = calloc(slots, sizeof(struct iovec));
+    mgr->tx_bufs = malloc(slots * IPMI_LANPLUS_MAX_LEN);
+    if (mgr->epfd < 0 || !mgr->socks || !mgr->tx_msgs || !mgr->tx_iov || !mgr->tx_bufs) {
+        bmc_log(LOG_LEVEL_ERROR, "Failed to set up SOL manager");
+        if (mgr->epfd >= 0) {
+            close(mgr->epfd);
+        }
+        free(mgr->socks);
+        free(mgr->tx_msgs);
+        free(mgr->tx_iov);
+        free(mgr->tx_bufs);
+        free(mgr);
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < nsocks; i++) {
+        mgr->socks[i].fd = -1;
+    }
+    for (size_t i = 0; i < slots; i++) {
+        mgr->tx_iov[i].iov_base = mgr->tx_bufs + i * IPMI_LANPLUS_MAX_LEN;
+        mgr->tx_msgs[i].msg_hdr.msg_iov = &mgr->tx_iov[i];
+        mgr->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    for (int i = 0; i < SOL_BATCH; i++) {
+        mgr->rx_iov[i].iov_base = mgr->rx_bufs[i];
+        mgr->rx_iov[i].iov_len = SOL_RX_LEN;
+        mgr->rx_msgs[i].msg_hdr.msg_name = &mgr->rx_from[i];
+        mgr->rx_msgs[i].msg_hdr.msg_iov = &mgr->rx_iov[i];
+        mgr->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    
+    return mgr;
+}
+
+void ipmi_sol_mgr_destroy(ipmi_sol_mgr_t* mgr) {
+    if (!mgr) {
+        return;
+    }
+    
+    for (int i = 0; i < 2 * mgr->sockets_per_family; i++) {
+        if (mgr->socks[i].fd >= 0) {
+            close(mgr->socks[i].fd);
+        }
+    }
+    close(mgr->epfd);
+    
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        free(mgr->hosts[i].host);
+        free(mgr->hosts[i].txq);
+        free(mgr->hosts[i].wbuf);
+    }
+    free(mgr->hosts);
+    free(mgr->by_id);
+    free(mgr->dirty);
+    free(mgr->socks);
+    free(mgr->tx_msgs);
+    free(mgr->tx_iov);
+    free(mgr->tx_bufs);
+    free(mgr);
+}
+
+int ipmi_sol_mgr_set_timeout(ipmi_sol_mgr_t* mgr, int timeout_ms) {
+    if (!mgr || timeout_ms <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    mgr->timeout_ms = timeout_ms;
+    return BMC_SUCCESS;
+}
+
+int ipmi_sol_mgr_set_retries(ipmi_sol_mgr_t* mgr, int retries) {
+    if (!mgr || retries < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    mgr->retries = retries;
+    return BMC_SUCCESS;
+}
+
+int ipmi_sol_mgr_set_flush_interval(ipmi_sol_mgr_t* mgr, int flush_ms) {
+    if (!mgr || flush_ms < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    mgr->flush_ms = flush_ms;
+    return BMC_SUCCESS;
+}
+
+int ipmi_sol_mgr_set_force(ipmi_sol_mgr_t* mgr, int force) {
+    if (!mgr) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    mgr->force = force ? 1 : 0;
+    return BMC_SUCCESS;
+}
+
+// 每次嘗試的間隔：總時限平均分給第一次和每次重送
+static uint64_t retry_interval_us(const ipmi_sol_mgr_t* mgr) {
+    return (uint64_t)mgr->timeout_ms * 1000 / (uint64_t)(mgr->retries + 1);
+}
+
+static int sol_socket(ipmi_sol_mgr_t* mgr, int family, int slot) {
+    int idx = (family == AF_INET6 ? mgr->sockets_per_family : 0) + slot;
+    sol_sock_t* s = &mgr->socks[idx];
+    
+    if (s->fd >= 0) {
+        return idx;
+    }
+    
+    int fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "socket() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    // 上百台的開機訊息會同時湧進來
+    int rcvbuf = SOL_RCVBUF_SIZE;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+        bmc_log(LOG_LEVEL_WARN, "setsockopt(SO_RCVBUF) failed: %s", strerror(errno));
+    }
+    
+    struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)idx };
+    if (epoll_ctl(mgr->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "epoll_ctl() failed: %s", strerror(errno));
+        close(fd);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    s->fd = fd;
+    return idx;
+}
+
+static size_t id_slot(uint32_t id, size_t cap) {
+    return (size_t)(id * 2654435761u) & (cap - 1);
+}
+
+// console_id 是我們自己挑的亂數，收到的封包 session ID 欄位就是它
+static int id_lookup(const ipmi_sol_mgr_t* mgr, uint32_t id) {
+    if (!mgr->by_id_cap) {
+        return -1;
+    }
+    
+    for (size_t i = id_slot(id, mgr->by_id_cap); ; i = (i + 1) & (mgr->by_id_cap - 1)) {
+        int idx = mgr->by_id[i];
+        if (idx < 0) {
+            return -1;
+        }
+        if (mgr->hosts[idx].session->console_id == id) {
+            return idx;
+        }
+    }
+}
+
+static void id_insert(int* table, size_t cap, uint32_t id, int idx) {
+    size_t i = id_slot(id, cap);
+    while (table[i] >= 0) {
+        i = (i + 1) & (cap - 1);
+    }
+    table[i] = idx;
+}
+
+// 保持一半以下的負載，不夠就加倍重建
+static int id_reserve(ipmi_sol_mgr_t* mgr, int count) {
+    if ((size_t)count * 2 <= mgr->by_id_cap) {
+        return BMC_SUCCESS;
+    }
+    
+    size_t cap = mgr->by_id_cap ? mgr->by_id_cap * 2 : 64;
+    while ((size_t)count * 2 > cap) {
+        cap *= 2;
+    }
+    
+    int* table = malloc(cap * sizeof(int));
+    if (!table) {
+        return BMC_ERROR_MEMORY;
+    }
+    memset(table, 0xFF, cap * sizeof(int));
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        id_insert(table, cap, mgr->hosts[i].session->console_id, i);
+    }
+    
+    free(mgr->by_id);
+    mgr->by_id = table;
+    mgr->by_id_cap = cap;
+    return BMC_SUCCESS;
+}
+
+int ipmi_sol_mgr_add(ipmi_sol_mgr_t* mgr, const char* host, const ipmi_addr_t* addr,
+                     ipmi_session_t* session, int log_fd) {
+    if (!mgr || !addr || addr->addrlen == 0 || !session || !session->active || log_fd < 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (id_lookup(mgr, session->console_id) >= 0) {
+        bmc_log(LOG_LEVEL_ERROR, "SOL session for %s already added", host ? host : "?");
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (mgr->num_hosts == mgr->cap_hosts) {
+        int cap = mgr->cap_hosts ? mgr->cap_hosts * 2 : 64;
+        sol_host_t* hosts = realloc(mgr->hosts, cap * sizeof(*hosts));
+        if (!hosts) {
+            return BMC_ERROR_MEMORY;
+        }
+        mgr->hosts = hosts;
+        int* dirty = realloc(mgr->dirty, cap * sizeof(int));
+        if (!dirty) {
+            return BMC_ERROR_MEMORY;
+        }
+        mgr->dirty = dirty;
+        mgr->cap_hosts = cap;
+    }
+    
+    if (id_reserve(mgr, mgr->num_hosts + 1) != BMC_SUCCESS) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    const struct sockaddr* sa = (const struct sockaddr*)&addr->addr;
+    int idx = mgr->num_hosts;
+    int sock = sol_socket(mgr, sa->sa_family, idx % mgr->sockets_per_family);
+    if (sock < 0) {
+        return sock;
+    }
+    
+    // 顯示名稱跟 engine 一樣：預設 port 只秀 host，其他加上 port
+    char name[300];
+    uint16_t port = ntohs(sa->sa_family == AF_INET6 ?
+                          ((const struct sockaddr_in6*)sa)->sin6_port :
+                          ((const struct sockaddr_in*)sa)->sin_port);
+    if (!host) {
+        ipmi_addr_str(addr, name, sizeof(name));
+    } else if (port == IPMI_DEFAULT_PORT) {
+        snprintf(name, sizeof(name), "%s", host);
+    } else {
+        snprintf(name, sizeof(name), strchr(host, ':') ? "[%s]:%u" : "%s:%u", host, port);
+    }
+    
+    sol_host_t* h = &mgr->hosts[idx];
+    memset(h, 0, sizeof(*h));
+    h->host = strdup(name);
+    h->txq = malloc(SOL_TXQ_MAX);
+    h->wbuf = malloc(SOL_LOG_BUF);
+    if (!h->host || !h->txq || !h->wbuf) {
+        free(h->host);
+        free(h->txq);
+        free(h->wbuf);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    memcpy(&h->addr, &addr->addr, addr->addrlen);
+    h->addrlen = addr->addrlen;
+    h->session = session;
+    h->sock = sock;
+    h->log_fd = log_fd;
+    h->next_ipmi_seq = 1;
+    h->next_tx_seq = 1;
+    h->max_out = SOL_MAX_OUT;
+    h->stats.state = IPMI_SOL_STATE_ACTIVATING;
+    
+    mgr->num_hosts++;
+    id_insert(mgr->by_id, mgr->by_id_cap, session->console_id, idx);
+    return idx;
+}
+
+int ipmi_sol_mgr_send(ipmi_sol_mgr_t* mgr, int idx, const uint8_t* data, size_t len) {
+    if (!mgr || idx < 0 || idx >= mgr->num_hosts || (!data && len)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    sol_host_t* h = &mgr->hosts[idx];
+    if (h->txq_len + len > SOL_TXQ_MAX) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    memcpy(h->txq + h->txq_len, data, len);
+    h->txq_len += len;
+    return BMC_SUCCESS;
+}
+
+int ipmi_sol_mgr_count(const ipmi_sol_mgr_t* mgr) {
+    return mgr ? mgr->num_hosts : 0;
+}
+
+const char* ipmi_sol_mgr_host(const ipmi_sol_mgr_t* mgr, int idx) {
+    if (!mgr || idx < 0 || idx >= mgr->num_hosts) {
+        return NULL;
+    }
+    return mgr->hosts[idx].host;
+}
+
+int ipmi_sol_mgr_get_stats(const ipmi_sol_mgr_t* mgr, int idx, ipmi_sol_stats_t* stats) {
+    if (!mgr || idx < 0 || idx >= mgr->num_hosts || !stats) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    *stats = mgr->hosts[idx].stats;
+    return BMC_SUCCESS;
+}
+
+/* ===== 送出 ===== */
+
+// 把 socket 上排好的批次用 sendmmsg 送出去
+static void flush_socket(ipmi_sol_mgr_t* mgr, int idx) {
+    sol_sock_t* s = &mgr->socks[idx];
+    struct mmsghdr* msgs = &mgr->tx_msgs[(size_t)idx * SOL_BATCH];
+    int sent = 0;
+    
+    while (sent < s->tx_len) {
+        int n = sendmmsg(s->fd, msgs + sent, (unsigned int)(s->tx_len - sent), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // socket 滿了或送不出去就丟掉：ACK 掉了 BMC 會重送，我們自己的 request 有重送計時
+            bmc_log(LOG_LEVEL_DEBUG, "sendmmsg() dropped %d SOL packets: %s",
+                    s->tx_len - sent, strerror(errno));
+            break;
+        }
+        sent += n;
+    }
+    
+    s->tx_len = 0;
+}
+
+static void flush_sockets(ipmi_sol_mgr_t* mgr) {
+    for (int i = 0; i < 2 * mgr->sockets_per_family; i++) {
+        if (mgr->socks[i].tx_len > 0) {
+            flush_socket(mgr, i);
+        }
+    }
+}
+
+// 用 session 包好排進 host 那個 socket 的批次；批次滿了先送
+static int stage(ipmi_sol_mgr_t* mgr, sol_host_t* h, uint8_t payload_type,
+                 const uint8_t* payload, size_t len) {
+    sol_sock_t* s = &mgr->socks[h->sock];
+    if (s->tx_len == SOL_BATCH) {
+        flush_socket(mgr, h->sock);
+    }
+    
+    size_t slot = (size_t)h->sock * SOL_BATCH + s->tx_len;
+    size_t wire_len = IPMI_LANPLUS_MAX_LEN;
+    int ret = ipmi_session_wrap_payload(h->session, payload_type, payload, len,
+                                        mgr->tx_iov[slot].iov_base, &wire_len);
+    if (ret != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "Cannot wrap SOL packet for %s", h->host);
+        return ret;
+    }
+    
+    mgr->tx_iov[slot].iov_len = wire_len;
+    mgr->tx_msgs[slot].msg_hdr.msg_name = &h->addr;
+    mgr->tx_msgs[slot].msg_hdr.msg_namelen = h->addrlen;
+    s->tx_len++;
+    h->last_tx_us = bmc_monotonic_us();
+    return BMC_SUCCESS;
+}
+
+static int stage_ipmi(ipmi_sol_mgr_t* mgr, sol_host_t* h, uint8_t cmd, uint8_t seq,
+                      const uint8_t* data, size_t len) {
+    uint8_t pkt[IPMI_REQ_HDR_LEN + 16];
+    size_t pkt_len = sizeof(pkt);
+    struct iovec iov = { .iov_base = (void*)data, .iov_len = len };
+    
+    int ret = ipmi_req_build(ipmi_req_tmpl_get(IPMI_NETFN_APP, cmd), seq,
+                             &iov, len ? 1 : 0, pkt, &pkt_len);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    return stage(mgr, h, IPMI_PAYLOAD_IPMI, pkt + IPMI_REQ_MSG_LEN_OFF + 1,
+                 pkt[IPMI_REQ_MSG_LEN_OFF]);
+}
+
+// 送 Activate / Deactivate Payload，等回應（重送由 check_timers 處理）
+static void send_request(ipmi_sol_mgr_t* mgr, sol_host_t* h, uint8_t cmd) {
+    h->req_cmd = cmd;
+    h->req_seq = h->next_ipmi_seq;
+    h->next_ipmi_seq = (uint8_t)((h->next_ipmi_seq + 1) & 0x3F);
+    if (h->next_ipmi_seq == 0) {
+        h->next_ipmi_seq = 1;
+    }
+    h->req_attempts = 0;
+    h->req_deadline = bmc_monotonic_us() + retry_interval_us(mgr);
+    
+    const uint8_t* data = cmd == IPMI_CMD_ACTIVATE_PAYLOAD ? g_activate_req : g_deactivate_req;
+    stage_ipmi(mgr, h, cmd, h->req_seq, data, sizeof(g_activate_req));
+}
+
+static void resend_request(ipmi_sol_mgr_t* mgr, sol_host_t* h) {
+    h->req_attempts++;
+    h->req_deadline = bmc_monotonic_us() + retry_interval_us(mgr);
+    
+    const uint8_t* data = h->req_cmd == IPMI_CMD_ACTIVATE_PAYLOAD ? g_activate_req : g_deactivate_req;
+    stage_ipmi(mgr, h, h->req_cmd, h->req_seq, data, sizeof(g_activate_req));
+}
+
+static void send_ack(ipmi_sol_mgr_t* mgr, sol_host_t* h, uint8_t seq, uint8_t accepted, uint8_t op) {
+    uint8_t buf[IPMI_SOL_HDR_LEN];
+    ipmi_sol_pkt_t pkt = { .ack_seq = seq, .accepted = accepted, .status = op };
+    stage(mgr, h, IPMI_PAYLOAD_SOL, buf, ipmi_sol_build(&pkt, buf));
+}
+
+// 送（或重送）txq 最前面那個封包
+static void send_chars(ipmi_sol_mgr_t* mgr, sol_host_t* h) {
+    uint8_t buf[IPMI_SOL_HDR_LEN + 255];
+    
+    if (h->tx_seq == 0) {
+        size_t n = h->txq_len < h->max_out ? h->txq_len : h->max_out;
+        if (n == 0) {
+            return;
+        }
+        h->tx_seq = h->next_tx_seq;
+        h->next_tx_seq = (uint8_t)(h->next_tx_seq % SOL_SEQ_MAX + 1);
+        h->tx_len = (uint8_t)n;
+        h->tx_attempts = 0;
+    }
+    
+    ipmi_sol_pkt_t pkt = { .seq = h->tx_seq, .data = h->txq, .data_len = h->tx_len };
+    stage(mgr, h, IPMI_PAYLOAD_SOL, buf, ipmi_sol_build(&pkt, buf));
+    h->tx_deadline = bmc_monotonic_us() + retry_interval_us(mgr);
+}
+
+/* ===== Log ===== */
+
+// 寫出 host 的 log buffer；回傳 0 表示全部寫完
+static int flush_log(sol_host_t* h) {
+    size_t off = 0;
+    
+    while (off < h->wlen) {
+        ssize_t n = write(h->log_fd, h->wbuf + off, h->wlen - off);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && h->stats.log_errno == 0) {
+                h->stats.log_errno = errno;
+                bmc_log(LOG_LEVEL_ERROR, "Cannot write SOL log for %s: %s", h->host, strerror(errno));
+            }
+            break;
+        }
+        h->stats.writes++;
+        off += (size_t)n;
+    }
+    
+    // 只有寫不完（pipe 塞住）才需要搬
+    if (off > 0 && off < h->wlen) {
+        memmove(h->wbuf, h->wbuf + off, h->wlen - off);
+    }
+    h->wlen -= off;
+    h->wfirst_us = bmc_monotonic_us();
+    
+    return h->wlen == 0 ? 0 : -1;
+}
+
+static void flush_logs(ipmi_sol_mgr_t* mgr, int all) {
+    uint64_t now = bmc_monotonic_us();
+    uint64_t interval = (uint64_t)mgr->flush_ms * 1000;
+    int kept = 0;
+    
+    for (int i = 0; i < mgr->num_dirty; i++) {
+        sol_host_t* h = &mgr->hosts[mgr->dirty[i]];
+        
+        if (all || h->wlen >= SOL_LOG_BUF / 2 || now - h->wfirst_us >= interval) {
+            flush_log(h);
+        }
+        
+        // 寫 log 失敗的就不再寫，buffer 直接丟掉
+        if (h->stats.log_errno) {
+            h->wlen = 0;
+        }
+        
+        if (h->wlen > 0) {
+            mgr->dirty[kept++] = mgr->dirty[i];
+        } else {
+            h->dirty = 0;
+        }
+    }
+    
+    mgr->num_dirty = kept;
+}
+
+/*
+ * 收下 console 輸出：從接收 buffer 複製到 log buffer（唯一的一次複製）
+ * 放不下就先把這台寫出；還是放不下回傳 -1，由呼叫端 NACK
+ */
+static int accept_chars(ipmi_sol_mgr_t* mgr, sol_host_t* h, const uint8_t* data, size_t len) {
+    if (h->stats.log_errno) {
+        return 0;
+    }
+    
+    if (SOL_LOG_BUF - h->wlen < len) {
+        flush_log(h);
+        if (SOL_LOG_BUF - h->wlen < len) {
+            return -1;
+        }
+    }
+    
+    if (h->wlen == 0) {
+        h->wfirst_us = bmc_monotonic_us();
+    }
+    memcpy(h->wbuf + h->wlen, data, len);
+    h->wlen += len;
+    h->stats.bytes += len;
+    
+    if (!h->dirty) {
+        h->dirty = 1;
+        mgr->dirty[mgr->num_dirty++] = (int)(h - mgr->hosts);
+    }
+    return 0;
+}
+
+/* ===== 接收 ===== */
+
+static void fail(sol_host_t* h, int error) {
+    h->stats.state = IPMI_SOL_STATE_FAILED;
+    h->stats.error = error;
+    h->req_cmd = 0;
+}
+
+static void handle_ipmi(ipmi_sol_mgr_t* mgr, sol_host_t* h, const uint8_t* msg, size_t len) {
+    ipmi_rsp_view_t rsp;
+    if (ipmi_msg_view(msg, len, &rsp) != BMC_SUCCESS) {
+        return;
+    }
+    
+    // keepalive 的回應或過期的重複回應
+    if (h->req_cmd == 0 || rsp.cmd != h->req_cmd || rsp.seq != h->req_seq) {
+        return;
+    }
+    
+    uint8_t cmd = h->req_cmd;
+    uint8_t cc = rsp.data_len > 0 ? rsp.data[0] : 0xFF;
+    h->req_cmd = 0;
+    
+    if (cmd == IPMI_CMD_DEACTIVATE_PAYLOAD) {
+        // force：把別人的 SOL 關掉了，再 activate 一次
+        if (h->stats.state == IPMI_SOL_STATE_ACTIVATING) {
+            send_request(mgr, h, IPMI_CMD_ACTIVATE_PAYLOAD);
+        } else {
+            h->stats.state = IPMI_SOL_STATE_CLOSED;
+        }
+        return;
+    }
+    
+    if (h->stats.state != IPMI_SOL_STATE_ACTIVATING) {
+        return;
+    }
+    
+    if (cc == IPMI_CC_PAYLOAD_ACTIVE && mgr->force && !h->force_tried) {
+        bmc_log(LOG_LEVEL_INFO, "SOL on %s is in use, deactivating it", h->host);
+        h->force_tried = 1;
+        send_request(mgr, h, IPMI_CMD_DEACTIVATE_PAYLOAD);
+        return;
+    }
+    
+    if (cc != 0x00 || rsp.data_len < ACTIVATE_RSP_LEN) {
+        bmc_log(LOG_LEVEL_ERROR, "Activate Payload on %s failed: completion code 0x%02x",
+                h->host, cc);
+        h->stats.activate_cc = cc;
+        fail(h, BMC_ERROR_PROTOCOL);
+        return;
+    }
+    
+    // inbound 是 BMC 收得下的大小（我們送的方向），含 4 bytes header
+    uint16_t inbound = get_le16(rsp.data + 5);
+    if (inbound > IPMI_SOL_HDR_LEN && inbound - IPMI_SOL_HDR_LEN < h->max_out) {
+        h->max_out = (uint16_t)(inbound - IPMI_SOL_HDR_LEN);
+    }
+    
+    // SOL 要送到 BMC 指定的 port（通常就是 623）
+    uint16_t port = get_le16(rsp.data + 9);
+    if (port != 0) {
+        if (h->addr.ss_family == AF_INET) {
+            ((struct sockaddr_in*)&h->addr)->sin_port = htons(port);
+        } else {
+            ((struct sockaddr_in6*)&h->addr)->sin6_port = htons(port);
+        }
+    }
+    
+    h->stats.state = IPMI_SOL_STATE_ACTIVE;
+    bmc_log(LOG_LEVEL_DEBUG, "SOL active on %s (max %u chars per packet)", h->host, h->max_out);
+}
+
+static void handle_sol(ipmi_sol_mgr_t* mgr, sol_host_t* h, const uint8_t* payload, size_t len) {
+    ipmi_sol_pkt_t pkt;
+    if (ipmi_sol_parse(payload, len, &pkt) != BMC_SUCCESS) {
+        return;
+    }
+    
+    if (h->stats.state != IPMI_SOL_STATE_ACTIVE && h->stats.state != IPMI_SOL_STATE_CLOSING) {
+        return;
+    }
+    
+    // 我們送的字元的 ACK / NACK
+    if (pkt.ack_seq != 0 && pkt.ack_seq == h->tx_seq) {
+        if (pkt.status & IPMI_SOL_STATUS_NACK) {
+            // BMC 暫時收不下，照重送間隔再送，不算一次重試
+            h->tx_deadline = bmc_monotonic_us() + retry_interval_us(mgr);
+            h->tx_attempts--;
+        } else {
+            size_t n = pkt.accepted < h->tx_len ? pkt.accepted : h->tx_len;
+            memmove(h->txq, h->txq + n, h->txq_len - n);
+            h->txq_len -= n;
+            h->tx_seq = 0;
+            if (h->stats.state == IPMI_SOL_STATE_ACTIVE) {
+                send_chars(mgr, h);
+            }
+        }
+    }
+    
+    if (pkt.seq != 0) {
+        if (pkt.seq == h->rx_seq) {
+            // 我們的 ACK 掉了，BMC 重送；已經寫過了，只再 ACK 一次
+            h->stats.duplicates++;
+            send_ack(mgr, h, pkt.seq, h->rx_accepted, 0);
+        } else if (pkt.data_len > 0xFF || accept_chars(mgr, h, pkt.data, pkt.data_len) != 0) {
+            h->stats.nacks++;
+            send_ack(mgr, h, pkt.seq, 0, IPMI_SOL_OP_NACK);
+        } else {
+            h->stats.packets++;
+            h->rx_seq = pkt.seq;
+            h->rx_accepted = (uint8_t)pkt.data_len;
+            send_ack(mgr, h, pkt.seq, h->rx_accepted, 0);
+        }
+        
+        if (pkt.status & IPMI_SOL_STATUS_OVERRUN) {
+            h->stats.overruns++;
+        }
+    }
+    
+    if (pkt.status & IPMI_SOL_STATUS_DEACTIVATED) {
+        bmc_log(LOG_LEVEL_INFO, "SOL on %s deactivated by BMC", h->host);
+        h->stats.state = IPMI_SOL_STATE_CLOSED;
+        h->req_cmd = 0;
+    }
+}
+
+static void handle_packet(ipmi_sol_mgr_t* mgr, uint8_t* buf, size_t len) {
+    uint32_t id;
+    if (ipmi_session_peek_id(buf, len, &id) != BMC_SUCCESS) {
+        return;
+    }
+    
+    int idx = id_lookup(mgr, id);
+    if (idx < 0) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping %zu bytes for unknown session 0x%08x", len, id);
+        return;
+    }
+    
+    sol_host_t* h = &mgr->hosts[idx];
+    
+    // 就地驗證、解密，payload 指向 buf 裡面
+    uint8_t ptype;
+    uint8_t* payload;
+    size_t payload_len;
+    if (ipmi_session_unwrap_payload(h->session, buf, len, &ptype, &payload, &payload_len) != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "Dropping malformed packet from %s", h->host);
+        return;
+    }
+    
+    if (ptype == IPMI_PAYLOAD_SOL) {
+        handle_sol(mgr, h, payload, payload_len);
+    } else if (ptype == IPMI_PAYLOAD_IPMI) {
+        handle_ipmi(mgr, h, payload, payload_len);
+    }
+}
+
+// 用 recvmmsg 一次收一批；處理完要回的 ACK 也排進批次，最後一起送
+static void drain_socket(ipmi_sol_mgr_t* mgr, int idx) {
+    int fd = mgr->socks[idx].fd;
+    
+    for (;;) {
+        for (int i = 0; i < SOL_BATCH; i++) {
+            mgr->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        }
+        
+        int n = recvmmsg(fd, mgr->rx_msgs, SOL_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                bmc_log(LOG_LEVEL_WARN, "recvmmsg() failed: %s", strerror(errno));
+            }
+            break;
+        }
+        
+        for (int i = 0; i < n; i++) {
+            handle_packet(mgr, mgr->rx_bufs[i], mgr->rx_msgs[i].msg_len);
+        }
+        
+        if (n < SOL_BATCH) {
+            break;
+        }
+    }
+    
+    flush_sockets(mgr);
+}
+
+/* ===== 事件迴圈 ===== */
+
+static void check_timers(ipmi_sol_mgr_t* mgr) {
+    uint64_t now = bmc_monotonic_us();
+    
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        sol_host_t* h = &mgr->hosts[i];
+        int state = h->stats.state;
+        
+        if (state == IPMI_SOL_STATE_CLOSED || state == IPMI_SOL_STATE_FAILED) {
+            continue;
+        }
+        
+        if (state == IPMI_SOL_STATE_ACTIVATING && h->req_cmd == 0) {
+            send_request(mgr, h, IPMI_CMD_ACTIVATE_PAYLOAD);
+            continue;
+        }
+        
+        if (h->req_cmd != 0 && now >= h->req_deadline) {
+            if (h->req_attempts < mgr->retries) {
+                resend_request(mgr, h);
+            } else if (state == IPMI_SOL_STATE_CLOSING) {
+                // BMC 沒回 Deactivate，session 關掉時它自己也會收
+                h->stats.state = IPMI_SOL_STATE_CLOSED;
+                h->req_cmd = 0;
+            } else {
+                bmc_log(LOG_LEVEL_ERROR, "Activate Payload on %s timed out", h->host);
+                fail(h, BMC_ERROR_TIMEOUT);
+            }
+            continue;
+        }
+        
+        if (state != IPMI_SOL_STATE_ACTIVE) {
+            continue;
+        }
+        
+        if (h->tx_seq != 0 && now >= h->tx_deadline) {
+            if (h->tx_attempts < mgr->retries) {
+                h->tx_attempts++;
+                h->stats.retransmits++;
+                send_chars(mgr, h);
+            } else {
+                bmc_log(LOG_LEVEL_WARN, "SOL on %s: %u characters not acknowledged, dropped",
+                        h->host, h->tx_len);
+                memmove(h->txq, h->txq + h->tx_len, h->txq_len - h->tx_len);
+                h->txq_len -= h->tx_len;
+                h->tx_seq = 0;
+            }
+        }
+        
+        if (h->tx_seq == 0 && h->txq_len > 0) {
+            send_chars(mgr, h);
+        }
+        
+        if (now - h->last_tx_us >= (uint64_t)SOL_KEEPALIVE_MS * 1000) {
+            stage_ipmi(mgr, h, IPMI_CMD_GET_DEVICE_ID, 0, NULL, 0);
+        }
+    }
+    
+    flush_sockets(mgr);
+}
+
+// 還在 ACTIVATING / ACTIVE（want_closing 時另外算 CLOSING）的台數
+static int count_live(const ipmi_sol_mgr_t* mgr, int want_closing) {
+    int live = 0;
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        int state = mgr->hosts[i].stats.state;
+        if (state == IPMI_SOL_STATE_ACTIVATING || state == IPMI_SOL_STATE_ACTIVE ||
+            (want_closing && state == IPMI_SOL_STATE_CLOSING)) {
+            live++;
+        }
+    }
+    return live;
+}
+
+static int loop(ipmi_sol_mgr_t* mgr, int duration_ms, const volatile sig_atomic_t* stop,
+                int closing) {
+    struct epoll_event events[16];
+    uint64_t deadline = duration_ms >= 0 ? bmc_monotonic_us() + (uint64_t)duration_ms * 1000 : 0;
+    uint64_t next_tick = 0;
+    
+    for (;;) {
+        uint64_t now = bmc_monotonic_us();
+        
+        if (now >= next_tick) {
+            check_timers(mgr);
+            next_tick = now + SOL_TICK_MS * 1000;
+        }
+        flush_logs(mgr, 0);
+        
+        if (count_live(mgr, closing) == 0 || (stop && *stop) || (deadline && now >= deadline)) {
+            break;
+        }
+        
+        int wait_ms = (int)((next_tick - now + 999) / 1000);
+        int n = epoll_wait(mgr->epfd, events, 16, wait_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            bmc_log(LOG_LEVEL_ERROR, "epoll_wait() failed: %s", strerror(errno));
+            return BMC_ERROR_NETWORK;
+        }
+        
+        for (int i = 0; i < n; i++) {
+            drain_socket(mgr, (int)events[i].data.u32);
+        }
+    }
+    
+    return count_live(mgr, 0);
+}
+
+int ipmi_sol_mgr_run(ipmi_sol_mgr_t* mgr, int duration_ms, const volatile sig_atomic_t* stop) {
+    if (!mgr) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    return loop(mgr, duration_ms, stop, 0);
+}
+
+int ipmi_sol_mgr_close(ipmi_sol_mgr_t* mgr) {
+    if (!mgr) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // activate 還沒回應的也送 Deactivate，免得 BMC 那邊留著一個開著的 SOL
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        sol_host_t* h = &mgr->hosts[i];
+        if (h->stats.state == IPMI_SOL_STATE_ACTIVATING || h->stats.state == IPMI_SOL_STATE_ACTIVE) {
+            h->stats.state = IPMI_SOL_STATE_CLOSING;
+            send_request(mgr, h, IPMI_CMD_DEACTIVATE_PAYLOAD);
+        }
+    }
+    flush_sockets(mgr);
+    
+    int ret = loop(mgr, SOL_CLOSE_TIMEOUT_MS, NULL, 1);
+    flush_logs(mgr, 1);
+    
+    for (int i = 0; i < mgr->num_hosts; i++) {
+        if (mgr->hosts[i].stats.state == IPMI_SOL_STATE_CLOSING) {
+            mgr->hosts[i].stats.state = IPMI_SOL_STATE_CLOSED;
+        }
+    }
+    
+    return ret < 0 ? ret : BMC_SUCCESS;
+}
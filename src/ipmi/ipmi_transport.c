@@ -1,119 +1,498 @@
+#define _GNU_SOURCE
 #include "bmctool/ipmi_context.h"
 #include "bmctool/ipmi.h"
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <poll.h>
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <netdb.h>
 #include <errno.h>
 
-// 解析 hostname 或 IP
-static int resolve_host(const char* host, struct in_addr* addr) {
-    // 先試試是不是 IP address
-    if (inet_pton(AF_INET, host, addr) == 1) {
-        return 0;
+/*
+ * 建構 request 封包，seq 由呼叫端決定；橋接的 request 包成 Send Message；payload 直接從 req->data 讀，不複製整個 ipmi_msg_t
+ * 有 RMCP+ session 時再把 message 部分包成加密封包，每次呼叫都用掉一個 session seq
+ */
+static int build_packet(ipmi_ctx_t* ctx, const ipmi_msg_t* req, uint8_t seq,
+                        uint8_t* buf, size_t* len) {
+    struct iovec iov = { .iov_base = (void*)req->data, .iov_len = req->data_len };
+    uint8_t plain[IPMI_REQ_MAX_LEN];
+    uint8_t* out = ctx->session.active ? plain : buf;
+    size_t out_len = ctx->session.active ? sizeof(plain) : *len;
+    
+    int ret = ipmi_msg_is_bridged(req) ?
+              ipmi_req_build_bridged(req, seq, out, &out_len) :
+              ipmi_req_build(ipmi_req_tmpl_get(req->netfn, req->cmd), seq, &iov, 1,
+                             out, &out_len);
+    if (ret == BMC_SUCCESS && ctx->session.active) {
+        ret = ipmi_session_wrap(&ctx->session, plain + IPMI_REQ_MSG_LEN_OFF + 1,
+                                plain[IPMI_REQ_MSG_LEN_OFF], buf, len);
+    } else {
+        *len = out_len;
     }
     
-    // 不是 IP，試試 DNS lookup
-    struct hostent* he = gethostbyname(host);
-    if (!he) {
-        bmc_log(LOG_LEVEL_ERROR, "gethostbyname(%s) failed", host);
-        return -1;
+    if (ret != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "Build request failed: %s", bmc_error_str(ret));
     }
     
-    memcpy(addr, he->h_addr_list[0], sizeof(struct in_addr));
-    return 0;
+    return ret;
 }
 
-int ipmi_send_recv(ipmi_ctx_t* ctx, const ipmi_msg_t* req, ipmi_msg_t* rsp) {
-    if (!ctx || !req || !rsp) {
-        return BMC_ERROR_INVALID_PARAM;
+static int send_packet(ipmi_ctx_t* ctx, const uint8_t* send_buf, size_t send_len) {
+    bmc_log(LOG_LEVEL_DEBUG, "Sending %zu bytes to %s:%d",
+            send_len, ctx->host, ctx->port);
+    
+    if (g_log_level == LOG_LEVEL_DEBUG && !ctx->session.active) {
+        ipmi_dump_packet(send_buf, send_len);
+    }
+    
+    // Socket 已經 connect() 到 BMC，直接 send()
+    ssize_t sent = send(ctx->sockfd, send_buf, send_len, 0);
+    if (sent < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "send() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    if ((size_t)sent != send_len) {
+        bmc_log(LOG_LEVEL_ERROR, "Partial send: %zd/%zu bytes", sent, send_len);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+// 收一個封包，最多等到 deadline_us
+static int recv_raw(ipmi_ctx_t* ctx, uint8_t* recv_buf, size_t recv_size,
+                    size_t* recv_len, uint64_t deadline_us) {
+    for (;;) {
+        uint64_t now = bmc_monotonic_us();
+        if (now >= deadline_us) {
+            return BMC_ERROR_TIMEOUT;
+        }
+        
+        struct pollfd pfd = { .fd = ctx->sockfd, .events = POLLIN };
+        int wait_ms = (int)((deadline_us - now + 999) / 1000);
+        
+        int n = poll(&pfd, 1, wait_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            bmc_log(LOG_LEVEL_ERROR, "poll() failed: %s", strerror(errno));
+            return BMC_ERROR_NETWORK;
+        }
+        if (n == 0) {
+            return BMC_ERROR_TIMEOUT;
+        }
+        
+        ssize_t received = recv(ctx->sockfd, recv_buf, recv_size, MSG_DONTWAIT);
+        if (received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                continue;
+            }
+            // connected UDP socket 會把 ICMP port unreachable 回報成 ECONNREFUSED
+            if (errno == ECONNREFUSED) {
+                bmc_log(LOG_LEVEL_ERROR, "%s:%d refused the connection", ctx->host, ctx->port);
+                return BMC_ERROR_NETWORK;
+            }
+            bmc_log(LOG_LEVEL_ERROR, "recv() failed: %s", strerror(errno));
+            return BMC_ERROR_NETWORK;
+        }
+        
+        bmc_log(LOG_LEVEL_DEBUG, "Received %zd bytes", received);
+        
+        *recv_len = (size_t)received;
+        return BMC_SUCCESS;
+    }
+}
+
+/**
+ * 等一個回應封包，最多等到 deadline_us
+ *
+ * 解析失敗的封包直接丟掉繼續等，呼叫端再用 seq 判斷是不是自己要的；
+ * rsp 指向 recv_buf 裡面（RMCP+ 時是就地解密後的內容），對上了才複製出去
+ */
+static int recv_response(ipmi_ctx_t* ctx, uint8_t* recv_buf, size_t recv_size,
+                         ipmi_rsp_view_t* rsp, uint64_t deadline_us) {
+    for (;;) {
+        size_t received;
+        int ret = recv_raw(ctx, recv_buf, recv_size, &received, deadline_us);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        if (ctx->session.active) {
+            ret = ipmi_session_unwrap(&ctx->session, recv_buf, received, rsp);
+        } else {
+            if (g_log_level == LOG_LEVEL_DEBUG) {
+                ipmi_dump_packet(recv_buf, received);
+            }
+            ret = ipmi_rsp_view(recv_buf, received, rsp);
+        }
+        
+        if (ret == BMC_SUCCESS) {
+            return BMC_SUCCESS;
+        }
+        
+        bmc_log(LOG_LEVEL_WARN, "Dropping malformed response");
+    }
+}
+
+/*
+ * 對上 seq 的回應是不是 req 要的：一般 request 比 cmd；
+ * 橋接的 request 拆出 satellite 的回應，Send Message 的 ack 回傳 IPMI_BRIDGE_PENDING
+ */
+static int match_response(const ipmi_msg_t* req, uint8_t seq, const ipmi_rsp_view_t* rsp,
+                          ipmi_rsp_view_t* out) {
+    if (ipmi_msg_is_bridged(req)) {
+        return ipmi_bridge_unwrap(rsp, req, seq, out);
+    }
+    
+    if (rsp->cmd != req->cmd) {
+        return BMC_ERROR_PROTOCOL;
     }
     
+    *out = *rsp;
+    return BMC_SUCCESS;
+}
+
+static int check_open(const ipmi_ctx_t* ctx) {
     if (ctx->sockfd < 0) {
         bmc_log(LOG_LEVEL_ERROR, "Socket not open");
         return BMC_ERROR_NETWORK;
     }
     
-    // 準備目標位址
-    struct sockaddr_in dest_addr;
-    memset(&dest_addr, 0, sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(ctx->port);
+    return BMC_SUCCESS;
+}
+
+int ipmi_send_recv(ipmi_ctx_t* ctx, const ipmi_msg_t* req, ipmi_msg_t* rsp) {
+    if (!ctx || !req || !rsp) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
     
-    if (resolve_host(ctx->host, &dest_addr.sin_addr) != 0) {
-        return BMC_ERROR_NETWORK;
+    int ret = check_open(ctx);
+    if (ret != BMC_SUCCESS) {
+        return ret;
     }
     
-    // 建構 request 封包
-    ipmi_msg_t req_copy = *req;
-    req_copy.seq = ctx->seq++;  // 用 ctx 的 seq
+    // 用 ctx 的 seq（6 bits，會繞回 0）；重送時沿用同一個 seq，BMC 才認得出是重複
+    uint8_t seq = ctx->seq;
+    ctx->seq = (ctx->seq + 1) & 0x3F;
+    
+    uint8_t send_buf[IPMI_LANPLUS_MAX_LEN];
+    size_t send_len = 0;
+    
+    uint64_t deadline = bmc_monotonic_us() + (uint64_t)ctx->timeout_ms * 1000;
     
-    uint8_t send_buf[512];
+    uint8_t recv_buf[512];
+    ipmi_rsp_view_t view;
+    ipmi_rsp_view_t match;
+    
+    for (int attempt = 0; ; attempt++) {
+        // 1.5 的封包建一次就好；RMCP+ 每次重送都要新的 session seq，重新包
+        if (attempt == 0 || ctx->session.active) {
+            send_len = sizeof(send_buf);
+            ret = build_packet(ctx, req, seq, send_buf, &send_len);
+            if (ret != BMC_SUCCESS) {
+                return ret;
+            }
+        }
+        
+        ret = send_packet(ctx, send_buf, send_len);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        uint64_t sent_at = bmc_monotonic_us();
+        uint64_t wait_until = sent_at + ipmi_rtt_rto(&ctx->rtt);
+        if (wait_until > deadline) {
+            wait_until = deadline;
+        }
+        
+        // seq 或 cmd 對不上的是之前逾時 request 的遲到回應，丟掉繼續等
+        for (;;) {
+            ret = recv_response(ctx, recv_buf, sizeof(recv_buf), &view, wait_until);
+            if (ret != BMC_SUCCESS) {
+                break;
+            }
+            
+            int m = view.seq == seq ? match_response(req, seq, &view, &match) : BMC_ERROR_PROTOCOL;
+            if (m == IPMI_BRIDGE_PENDING) {
+                continue;
+            }
+            if (m == BMC_SUCCESS) {
+                // Karn：重送過就分不出是回哪一次，不取樣
+                if (attempt == 0) {
+                    ipmi_rtt_sample(&ctx->rtt, (uint32_t)(bmc_monotonic_us() - sent_at));
+                }
+                ipmi_rsp_copy(&match, rsp);
+                return BMC_SUCCESS;
+            }
+            
+            bmc_log(LOG_LEVEL_DEBUG, "Dropping stale response: req=%d, rsp=%d",
+                    seq, view.seq);
+        }
+        
+        if (ret != BMC_ERROR_TIMEOUT) {
+            return ret;
+        }
+        
+        ipmi_rtt_timeout(&ctx->rtt, sent_at, bmc_monotonic_us());
+        
+        if (attempt >= ctx->retries || bmc_monotonic_us() >= deadline) {
+            bmc_log(LOG_LEVEL_ERROR, "Timeout waiting for response");
+            // BMC 可能已經不認這個 session，別再放回快取
+            ctx->session_stale = ctx->session.active;
+            return BMC_ERROR_TIMEOUT;
+        }
+        
+        ctx->retransmits++;
+        bmc_log(LOG_LEVEL_DEBUG, "Retransmitting seq=%d (attempt %d, rto=%u ms)",
+                seq, attempt + 1, ipmi_rtt_rto(&ctx->rtt) / 1000);
+    }
+}
+
+int ipmi_send_oneway(ipmi_ctx_t* ctx, const ipmi_msg_t* req) {
+    if (!ctx || !req) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = check_open(ctx);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    uint8_t send_buf[IPMI_LANPLUS_MAX_LEN];
     size_t send_len = sizeof(send_buf);
     
-    int ret = ipmi_build_request(&req_copy, send_buf, &send_len);
+    ret = build_packet(ctx, req, ctx->seq, send_buf, &send_len);
+    ctx->seq = (ctx->seq + 1) & 0x3F;
     if (ret != BMC_SUCCESS) {
-        bmc_log(LOG_LEVEL_ERROR, "Build request failed: %s", bmc_error_str(ret));
         return ret;
     }
     
-    bmc_log(LOG_LEVEL_DEBUG, "Sending %zu bytes to %s:%d", 
-            send_len, ctx->host, ctx->port);
+    return send_packet(ctx, send_buf, send_len);
+}
+
+// ipmi_send_recv_batch 裡每個 seq 的狀態
+typedef struct {
+    size_t idx;              // 對應的 request index
+    uint64_t sent_us;        // 最後一次送出的時間
+    uint64_t retry_us;       // 到這個時間還沒回應就重送
+    uint64_t expire_us;      // 整體 timeout
+    int attempts;            // 已經重送幾次
+} batch_slot_t;
+
+static int batch_transmit(ipmi_ctx_t* ctx, const ipmi_msg_t* req,
+                          uint8_t seq, batch_slot_t* slot) {
+    uint8_t send_buf[IPMI_LANPLUS_MAX_LEN];
+    size_t send_len = sizeof(send_buf);
     
-    if (g_log_level == LOG_LEVEL_DEBUG) {
-        ipmi_dump_packet(send_buf, send_len);
+    int ret = build_packet(ctx, req, seq, send_buf, &send_len);
+    if (ret == BMC_SUCCESS) {
+        ret = send_packet(ctx, send_buf, send_len);
     }
     
-    // 發送
-    ssize_t sent = sendto(ctx->sockfd, send_buf, send_len, 0,
-                          (struct sockaddr*)&dest_addr, sizeof(dest_addr));
-    if (sent < 0) {
-        bmc_log(LOG_LEVEL_ERROR, "sendto() failed: %s", strerror(errno));
-        return BMC_ERROR_NETWORK;
+    slot->sent_us = bmc_monotonic_us();
+    slot->retry_us = slot->sent_us + ipmi_rtt_rto(&ctx->rtt);
+    if (slot->retry_us > slot->expire_us) {
+        slot->retry_us = slot->expire_us;
     }
     
-    if ((size_t)sent != send_len) {
-        bmc_log(LOG_LEVEL_ERROR, "Partial send: %zd/%zu bytes", sent, send_len);
-        return BMC_ERROR_NETWORK;
+    return ret;
+}
+
+/**
+ * Pipelined 收發：同一台 BMC 最多同時有 ctx->pipeline_depth 個 request 在路上
+ *
+ * 回應用 rqSeq 對回原本的 request，順序不保證；重複或過期的回應直接丟掉。
+ * 沒回應的 request 依 RTT 估計重送，最多 ctx->retries 次。
+ *
+ * @param reqs - request 陣列
+ * @param rsps - 回應陣列（和 reqs 一樣長）
+ * @param status - 每個 request 的結果（BMC_SUCCESS / BMC_ERROR_TIMEOUT ...）
+ * @param count - request 數量
+ * @return BMC_SUCCESS 表示全部都有結果（個別成敗看 status），負數表示整批失敗
+ */
+int ipmi_send_recv_batch(ipmi_ctx_t* ctx, const ipmi_msg_t* reqs, ipmi_msg_t* rsps,
+                         int* status, size_t count) {
+    if (!ctx || (count > 0 && (!reqs || !rsps || !status))) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = check_open(ctx);
+    if (ret != BMC_SUCCESS) {
+        return ret;
     }
     
-    // 接收（帶 timeout）
+    int depth = ctx->pipeline_depth > 0 ? ctx->pipeline_depth : 1;
+    
+    // window 的 slot 指向 slots[] 裡對應的狀態
+    ipmi_seq_window_t win;
+    ipmi_seq_init(&win, ctx->seq);
+    batch_slot_t slots[IPMI_SEQ_SPACE];
     uint8_t recv_buf[512];
-    struct sockaddr_in src_addr;
-    socklen_t src_len = sizeof(src_addr);
     
-    ssize_t received = recvfrom(ctx->sockfd, recv_buf, sizeof(recv_buf), 0,
-                                (struct sockaddr*)&src_addr, &src_len);
+    size_t next = 0;
+    size_t done = 0;
     
-    if (received < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            bmc_log(LOG_LEVEL_ERROR, "Timeout waiting for response");
-            return BMC_ERROR_TIMEOUT;
+    while (done < count) {
+        // 把視窗填滿
+        while (next < count && win.count < depth) {
+            // 狀態就放在 slots[seq]，分配到 seq 之後再把 owner 指過去
+            int seq = ipmi_seq_alloc(&win, slots);
+            batch_slot_t* slot = &slots[seq];
+            win.slots[seq] = slot;
+            slot->idx = next;
+            slot->attempts = 0;
+            slot->expire_us = bmc_monotonic_us() + (uint64_t)ctx->timeout_ms * 1000;
+            
+            ret = batch_transmit(ctx, &reqs[next], (uint8_t)seq, slot);
+            if (ret != BMC_SUCCESS) {
+                ipmi_seq_take(&win, (uint8_t)seq);
+                status[next] = ret;
+                done++;
+            }
+            next++;
+        }
+        
+        if (win.count == 0) {
+            continue;
+        }
+        
+        // 等到最早該重送的時間
+        uint64_t earliest = UINT64_MAX;
+        for (int s = 0; s < IPMI_SEQ_SPACE; s++) {
+            if (win.slots[s] && slots[s].retry_us < earliest) {
+                earliest = slots[s].retry_us;
+            }
+        }
+        
+        ipmi_rsp_view_t rsp;
+        ret = recv_response(ctx, recv_buf, sizeof(recv_buf), &rsp, earliest);
+        
+        if (ret == BMC_SUCCESS) {
+            batch_slot_t* slot = win.slots[rsp.seq & 0x3F];
+            ipmi_rsp_view_t match;
+            
+            int m = slot ? match_response(&reqs[slot->idx], rsp.seq, &rsp, &match) :
+                           BMC_ERROR_PROTOCOL;
+            if (m == IPMI_BRIDGE_PENDING) {
+                continue;
+            }
+            if (m != BMC_SUCCESS) {
+                bmc_log(LOG_LEVEL_DEBUG, "Dropping stale response: seq=%d", rsp.seq);
+                continue;
+            }
+            
+            if (slot->attempts == 0) {
+                ipmi_rtt_sample(&ctx->rtt, (uint32_t)(bmc_monotonic_us() - slot->sent_us));
+            }
+            
+            ipmi_seq_take(&win, rsp.seq);
+            ipmi_rsp_copy(&match, &rsps[slot->idx]);
+            status[slot->idx] = BMC_SUCCESS;
+            done++;
+        } else if (ret == BMC_ERROR_TIMEOUT) {
+            // 到期的：還能重送就重送，不然算逾時
+            uint64_t now = bmc_monotonic_us();
+            
+            for (int s = 0; s < IPMI_SEQ_SPACE; s++) {
+                batch_slot_t* slot = win.slots[s];
+                if (!slot || slot->retry_us > now) {
+                    continue;
+                }
+                
+                ipmi_rtt_timeout(&ctx->rtt, slot->sent_us, now);
+                
+                if (slot->attempts < ctx->retries && now < slot->expire_us) {
+                    slot->attempts++;
+                    ctx->retransmits++;
+                    bmc_log(LOG_LEVEL_DEBUG, "Retransmitting seq=%d (attempt %d)",
+                            s, slot->attempts);
+                    if (batch_transmit(ctx, &reqs[slot->idx],
+                                       (uint8_t)s, slot) == BMC_SUCCESS) {
+                        continue;
+                    }
+                }
+                
+                bmc_log(LOG_LEVEL_DEBUG, "Timeout waiting for seq=%d", s);
+                ctx->session_stale = ctx->session.active;
+                ipmi_seq_take(&win, (uint8_t)s);
+                status[slot->idx] = BMC_ERROR_TIMEOUT;
+                done++;
+            }
+        } else {
+            // socket 壞了，剩下的全部算失敗
+            for (size_t i = next; i < count; i++) {
+                status[i] = ret;
+            }
+            for (int s = 0; s < IPMI_SEQ_SPACE; s++) {
+                batch_slot_t* slot = ipmi_seq_take(&win, (uint8_t)s);
+                if (slot) {
+                    status[slot->idx] = ret;
+                }
+            }
+            break;
         }
-        bmc_log(LOG_LEVEL_ERROR, "recvfrom() failed: %s", strerror(errno));
-        return BMC_ERROR_NETWORK;
     }
     
-    bmc_log(LOG_LEVEL_DEBUG, "Received %zd bytes", received);
-    
-    if (g_log_level == LOG_LEVEL_DEBUG) {
-        ipmi_dump_packet(recv_buf, received);
+    ctx->seq = win.next;
+    return BMC_SUCCESS;
+}
+
+int ipmi_ctx_exchange(ipmi_ctx_t* ctx, const uint8_t* req, size_t req_len,
+                      uint8_t rsp_type, uint8_t tag,
+                      uint8_t* rsp, size_t rsp_size, size_t* rsp_len) {
+    if (!ctx || !req || !rsp || !rsp_len) {
+        return BMC_ERROR_INVALID_PARAM;
     }
     
-    // 解析 response
-    ret = ipmi_parse_response(recv_buf, received, rsp);
+    int ret = check_open(ctx);
     if (ret != BMC_SUCCESS) {
-        bmc_log(LOG_LEVEL_ERROR, "Parse response failed: %s", bmc_error_str(ret));
         return ret;
     }
     
-    // 檢查 sequence number
-    if (rsp->seq != req_copy.seq) {
-        bmc_log(LOG_LEVEL_WARN, "Sequence mismatch: req=%d, rsp=%d", 
-                req_copy.seq, rsp->seq);
-    }
+    uint64_t deadline = bmc_monotonic_us() + (uint64_t)ctx->timeout_ms * 1000;
     
-    return BMC_SUCCESS;
+    for (int attempt = 0; ; attempt++) {
+        ret = send_packet(ctx, req, req_len);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        
+        uint64_t sent_at = bmc_monotonic_us();
+        uint64_t wait_until = sent_at + ipmi_rtt_rto(&ctx->rtt);
+        if (wait_until > deadline) {
+            wait_until = deadline;
+        }
+        
+        for (;;) {
+            ret = recv_raw(ctx, rsp, rsp_size, rsp_len, wait_until);
+            if (ret != BMC_SUCCESS) {
+                break;
+            }
+            
+            if (ipmi_session_is_payload(rsp, *rsp_len, rsp_type, tag)) {
+                if (attempt == 0) {
+                    ipmi_rtt_sample(&ctx->rtt, (uint32_t)(bmc_monotonic_us() - sent_at));
+                }
+                return BMC_SUCCESS;
+            }
+            
+            bmc_log(LOG_LEVEL_DEBUG, "Dropping unexpected handshake packet");
+        }
+        
+        if (ret != BMC_ERROR_TIMEOUT) {
+            return ret;
+        }
+        
+        ipmi_rtt_timeout(&ctx->rtt, sent_at, bmc_monotonic_us());
+        
+        if (attempt >= ctx->retries || bmc_monotonic_us() >= deadline) {
+            bmc_log(LOG_LEVEL_ERROR, "Timeout waiting for handshake response 0x%02x", rsp_type);
+            return BMC_ERROR_TIMEOUT;
+        }
+        
+        ctx->retransmits++;
+    }
 }
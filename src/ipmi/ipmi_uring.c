@@ -0,0 +1,393 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_uring.h"
+
+#ifdef BMC_IO_URING
+
+#include "bmctool/common.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/* ===== syscall ===== */
+
+static int sys_setup(unsigned entries, struct io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+                     const void* arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static int sys_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* ===== Ring ===== */
+
+// 先試比較省的 flags，舊 kernel 不認就退回預設
+static int ring_setup(unsigned entries, struct io_uring_params* p) {
+    memset(p, 0, sizeof(*p));
+    p->flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+    
+    int fd = sys_setup(entries, p);
+    if (fd < 0 && errno == EINVAL) {
+        memset(p, 0, sizeof(*p));
+        fd = sys_setup(entries, p);
+    }
+    
+    return fd;
+}
+
+static int ring_map(ipmi_uring_t* ring, const struct io_uring_params* p) {
+    ring->sq_ring_size = p->sq_off.array + p->sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = p->cq_off.cqes + p->cq_entries * sizeof(struct io_uring_cqe);
+    
+    // SINGLE_MMAP：SQ 和 CQ 的 ring 在同一塊
+    if (p->features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_ring_size > ring->sq_ring_size) {
+            ring->sq_ring_size = ring->cq_ring_size;
+        }
+        ring->cq_ring_size = ring->sq_ring_size;
+    }
+    
+    ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ring == MAP_FAILED) {
+        ring->sq_ring = NULL;
+        return BMC_ERROR_MEMORY;
+    }
+    
+    if (p->features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ring == MAP_FAILED) {
+            ring->cq_ring = NULL;
+            return BMC_ERROR_MEMORY;
+        }
+    }
+    
+    ring->sqes_size = p->sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        return BMC_ERROR_MEMORY;
+    }
+    
+    uint8_t* sq = ring->sq_ring;
+    ring->sq_head = (unsigned*)(sq + p->sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + p->sq_off.tail);
+    ring->sq_mask = *(unsigned*)(sq + p->sq_off.ring_mask);
+    ring->sq_entries = *(unsigned*)(sq + p->sq_off.ring_entries);
+    ring->sq_array = (unsigned*)(sq + p->sq_off.array);
+    ring->local_tail = *ring->sq_tail;
+    
+    // SQ array 固定一對一對應到 sqes，之後只要推 tail
+    for (unsigned i = 0; i < ring->sq_entries; i++) {
+        ring->sq_array[i] = i;
+    }
+    
+    uint8_t* cq = ring->cq_ring;
+    ring->cq_head = (unsigned*)(cq + p->cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + p->cq_off.tail);
+    ring->cq_mask = *(unsigned*)(cq + p->cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + p->cq_off.cqes);
+    
+    return BMC_SUCCESS;
+}
+
+int ipmi_uring_init(ipmi_uring_t* ring, unsigned entries, unsigned num_files) {
+    if (!ring || entries == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    memset(ring, 0, sizeof(*ring));
+    
+    struct io_uring_params p;
+    ring->fd = ring_setup(entries, &p);
+    if (ring->fd < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring_setup() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    ring->features = p.features;
+    
+    // 等待的 timeout 直接給 io_uring_enter（5.11）
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring: kernel too old (no IORING_FEAT_EXT_ARG)");
+        ipmi_uring_cleanup(ring);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    if (ring_map(ring, &p) != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring mmap failed: %s", strerror(errno));
+        ipmi_uring_cleanup(ring);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    if (num_files > 0) {
+        int* fds = malloc(num_files * sizeof(int));
+        if (!fds) {
+            ipmi_uring_cleanup(ring);
+            return BMC_ERROR_MEMORY;
+        }
+        memset(fds, 0xFF, num_files * sizeof(int));
+        
+        int ret = sys_register(ring->fd, IORING_REGISTER_FILES, fds, num_files);
+        free(fds);
+        if (ret < 0) {
+            bmc_log(LOG_LEVEL_ERROR, "io_uring file registration failed: %s", strerror(errno));
+            ipmi_uring_cleanup(ring);
+            return BMC_ERROR_NETWORK;
+        }
+    }
+    
+    return BMC_SUCCESS;
+}
+
+void ipmi_uring_cleanup(ipmi_uring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    
+    // ring fd 關掉時 kernel 會一起收掉註冊的 file 和 buffer ring
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    if (ring->br) {
+        munmap(ring->br, ring->br_size);
+    }
+    free(ring->bufs);
+    
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+int ipmi_uring_set_file(ipmi_uring_t* ring, unsigned slot, int fd) {
+    struct io_uring_files_update up = {
+        .offset = slot,
+        .fds = (uint64_t)(uintptr_t)&fd
+    };
+    
+    if (sys_register(ring->fd, IORING_REGISTER_FILES_UPDATE, &up, 1) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring file update failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== Provided buffers ===== */
+
+int ipmi_uring_setup_buffers(ipmi_uring_t* ring, unsigned count, size_t size, uint16_t bgid) {
+    if (!ring || count == 0 || (count & (count - 1)) != 0 || count > 32768 || size == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // buffer ring 本身要 page 對齊，用 anonymous mmap 配
+    size_t br_size = count * sizeof(struct io_uring_buf);
+    void* br = mmap(NULL, br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (br == MAP_FAILED) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    uint8_t* bufs = malloc(count * size);
+    if (!bufs) {
+        munmap(br, br_size);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    struct io_uring_buf_reg reg = {
+        .ring_addr = (uint64_t)(uintptr_t)br,
+        .ring_entries = count,
+        .bgid = bgid
+    };
+    if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring buffer ring registration failed: %s", strerror(errno));
+        munmap(br, br_size);
+        free(bufs);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    ring->br = br;
+    ring->br_size = br_size;
+    ring->br_mask = count - 1;
+    ring->br_tail = 0;
+    ring->bgid = bgid;
+    ring->bufs = bufs;
+    ring->buf_size = size;
+    
+    for (unsigned i = 0; i < count; i++) {
+        ipmi_uring_recycle(ring, (uint16_t)i);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+uint8_t* ipmi_uring_buffer(ipmi_uring_t* ring, uint16_t bid) {
+    return ring->bufs + (size_t)bid * ring->buf_size;
+}
+
+void ipmi_uring_recycle(ipmi_uring_t* ring, uint16_t bid) {
+    struct io_uring_buf* buf = &ring->br->bufs[ring->br_tail & ring->br_mask];
+    
+    buf->addr = (uint64_t)(uintptr_t)ipmi_uring_buffer(ring, bid);
+    buf->len = (uint32_t)ring->buf_size;
+    buf->bid = bid;
+    
+    // 內容寫好才推 tail，kernel 那邊才不會看到一半的 entry
+    ring->br_tail++;
+    __atomic_store_n(&ring->br->tail, ring->br_tail, __ATOMIC_RELEASE);
+}
+
+/* ===== Submission ===== */
+
+static int ring_submit(ipmi_uring_t* ring, unsigned wait_nr, unsigned flags,
+                       const void* arg, size_t argsz) {
+    // kernel 還沒拿走的都要算，包含上次 EBUSY 沒送完的
+    __atomic_store_n(ring->sq_tail, ring->local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit = ring->local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    
+    int ret = sys_enter(ring->fd, to_submit, wait_nr,
+                        flags | (wait_nr ? IORING_ENTER_GETEVENTS : 0), arg, argsz);
+    ring->enters++;
+    
+    // 逾時 / 被 signal 打斷不算錯；CQ 滿了（EBUSY）由呼叫端先收 completion，沒送完的下次再送
+    if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+        bmc_log(LOG_LEVEL_ERROR, "io_uring_enter() failed: %s", strerror(errno));
+        return BMC_ERROR_NETWORK;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+struct io_uring_sqe* ipmi_uring_get_sqe(ipmi_uring_t* ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    
+    if (ring->local_tail - head >= ring->sq_entries) {
+        if (ring_submit(ring, 0, 0, NULL, 0) != BMC_SUCCESS) {
+            return NULL;
+        }
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->local_tail - head >= ring->sq_entries) {
+            return NULL;
+        }
+    }
+    
+    struct io_uring_sqe* sqe = &ring->sqes[ring->local_tail & ring->sq_mask];
+    ring->local_tail++;
+    memset(sqe, 0, sizeof(*sqe));
+    
+    return sqe;
+}
+
+void ipmi_uring_prep_sendmsg(struct io_uring_sqe* sqe, unsigned file, const struct msghdr* msg,
+                             uint64_t user_data) {
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = (int)file;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->user_data = user_data;
+}
+
+void ipmi_uring_prep_recvmsg_multishot(struct io_uring_sqe* sqe, unsigned file,
+                                       const struct msghdr* msg, uint16_t bgid,
+                                       uint64_t user_data) {
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+    sqe->fd = (int)file;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->buf_group = bgid;
+    sqe->user_data = user_data;
+}
+
+void ipmi_uring_prep_poll(struct io_uring_sqe* sqe, unsigned file, unsigned events,
+                          uint64_t user_data) {
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = (int)file;
+    sqe->poll32_events = events;
+    sqe->user_data = user_data;
+}
+
+int ipmi_uring_submit_and_wait(ipmi_uring_t* ring, unsigned wait_nr, int64_t timeout_us) {
+    // 已經有 completion 就不用等
+    if (wait_nr > 0 && ipmi_uring_peek_cqe(ring)) {
+        wait_nr = 0;
+    }
+    
+    if (wait_nr == 0 || timeout_us < 0) {
+        if (wait_nr == 0 && ring->local_tail == __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)) {
+            return BMC_SUCCESS;
+        }
+        return ring_submit(ring, wait_nr, 0, NULL, 0);
+    }
+    
+    struct __kernel_timespec ts = {
+        .tv_sec = timeout_us / 1000000,
+        .tv_nsec = (timeout_us % 1000000) * 1000
+    };
+    struct io_uring_getevents_arg arg = {
+        .ts = (uint64_t)(uintptr_t)&ts
+    };
+    
+    return ring_submit(ring, wait_nr, IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+/* ===== Completion ===== */
+
+struct io_uring_cqe* ipmi_uring_peek_cqe(ipmi_uring_t* ring) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    
+    if (head == tail) {
+        return NULL;
+    }
+    
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void ipmi_uring_cqe_seen(ipmi_uring_t* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int ipmi_uring_recvmsg_parse(const uint8_t* buf, size_t len, const struct msghdr* msg,
+                             const struct sockaddr** name, const uint8_t** payload,
+                             size_t* payload_len) {
+    // buffer 的格式：io_uring_recvmsg_out、name（固定留 msg_namelen）、control、payload
+    size_t hdr = sizeof(struct io_uring_recvmsg_out) + msg->msg_namelen + msg->msg_controllen;
+    if (len < hdr) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    const struct io_uring_recvmsg_out* out = (const struct io_uring_recvmsg_out*)buf;
+    if (out->flags & MSG_TRUNC) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    *name = (const struct sockaddr*)(buf + sizeof(*out));
+    *payload = buf + hdr;
+    *payload_len = len - hdr;
+    
+    return BMC_SUCCESS;
+}
+
+#endif
@@ -66,6 +66,12 @@ void ipmi_dump_packet(const uint8_t* data, size_t len) {
         return;
     }
     
+    // 至少要有 header (6 bytes) 和 checksum (1 byte)，不然後面的 msg_len - 7 會 underflow
+    if (msg_len < 7) {
+        printf("  ERROR: Message too short\n");
+        return;
+    }
+    
     // Message header
     uint8_t target_addr = data[14];
     uint8_t netfn_lun = data[15];
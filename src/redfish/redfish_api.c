@@ -1,8 +1,15 @@
 #include "bmctool/redfish.h"
+#include "bmctool/redfish_scan.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 // 宣告內部函式
 extern int http_get(redfish_ctx_t* ctx, const char* path, char** response_out);
-extern int redfish_parse_system(const char* json_str, redfish_system_t* system);
+extern int http_get_scan(redfish_ctx_t* ctx, const char* path, redfish_scan_t* scan, int* from_cache);
+extern int http_scan_cached(redfish_ctx_t* ctx, const char* path, redfish_scan_t* scan);
+extern size_t redfish_system_scan_fields(redfish_system_t* system, redfish_scan_field_t* fields);
+extern int redfish_cache_get_parsed(const redfish_cache_t* cache, const char* url, void* out, size_t size);
+extern void redfish_cache_set_parsed(redfish_cache_t* cache, const char* url, const void* obj, size_t size);
 
 int redfish_get_system(redfish_ctx_t* ctx, const char* system_id, redfish_system_t* system) {
     if (!ctx || !system_id || !system) {
@@ -13,17 +20,34 @@ int redfish_get_system(redfish_ctx_t* ctx, const char* system_id, redfish_system
     char path[256];
     snprintf(path, sizeof(path), "/redfish/v1/Systems/%s", system_id);
     
+    // 只取要的欄位，body 邊收邊 parse（Systems 回應裡大半是用不到的 Links、Oem）
+    redfish_scan_field_t fields[REDFISH_SCAN_MAX_FIELDS];
+    size_t num_fields = redfish_system_scan_fields(system, fields);
+    redfish_scan_t* scan = redfish_scan_create(fields, num_fields);
+    if (!scan) {
+        return BMC_ERROR_MEMORY;
+    }
+    
     // 執行 HTTP GET
-    char* response = NULL;
-    int ret = http_get(ctx, path, &response);
-    if (ret != BMC_SUCCESS) {
-        return ret;
+    int from_cache = 0;
+    int ret = http_get_scan(ctx, path, scan, &from_cache);
+    
+    // 304：上次解析好的結果還在就不用再 parse，不在再掃快取裡的 body
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", ctx->base_url, path);
+    if (ret == BMC_SUCCESS && from_cache) {
+        if (redfish_cache_get_parsed(ctx->cache, url, system, sizeof(*system))) {
+            redfish_scan_destroy(scan);
+            return BMC_SUCCESS;
+        }
+        ret = http_scan_cached(ctx, path, scan);
     }
+    redfish_scan_destroy(scan);
     
-    // 解析 JSON
-    ret = redfish_parse_system(response, system);
+    if (ret == BMC_SUCCESS && ctx->cache) {
+        redfish_cache_set_parsed(ctx->cache, url, system, sizeof(*system));
+    }
     
-    free(response);
     return ret;
 }
 
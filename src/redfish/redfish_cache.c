@@ -0,0 +1,485 @@
+#define _GNU_SOURCE
+#include "bmctool/redfish_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC         0x43524D42      // "BMRC"
+#define CACHE_VERSION       1
+#define CACHE_FILE_NAME     "redfish-etags"
+#define CACHE_MIN_BUCKETS   64
+
+// 單筆上限，檔案壞掉時不會 malloc 一個超大的 buffer
+#define CACHE_MAX_URL       4096
+#define CACHE_MAX_ETAG      256
+#define CACHE_MAX_BODY      (16 * 1024 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+} cache_file_header_t;
+
+// 檔案裡每筆的長度，後面接著 url、etag、body（都不含 '\0'）
+typedef struct {
+    uint32_t url_len;
+    uint32_t etag_len;
+    uint32_t body_len;
+} cache_file_entry_t;
+
+/*
+ * url、etag、body 跟 entry 放在同一塊記憶體，都以 '\0' 結尾
+ * parsed 是 redfish_get_system() 這類呼叫端存的解析結果，另外配置
+ */
+typedef struct cache_entry {
+    struct cache_entry* hash_next;
+    struct cache_entry* newer;
+    struct cache_entry* older;
+    uint32_t hash;
+    char* url;
+    char* etag;
+    char* body;
+    size_t body_len;
+    void* parsed;
+    size_t parsed_size;
+    size_t bytes;               // 算進 max_bytes 的大小
+} cache_entry_t;
+
+struct redfish_cache {
+    cache_entry_t** buckets;
+    size_t num_buckets;         // 2 的次方
+    cache_entry_t* newest;
+    cache_entry_t* oldest;
+    size_t max_bytes;
+    redfish_cache_stats_t stats;
+};
+
+// FNV-1a
+static uint32_t url_hash(const char* url) {
+    uint32_t h = 2166136261u;
+    for (const uint8_t* p = (const uint8_t*)url; *p; p++) {
+        h = (h ^ *p) * 16777619u;
+    }
+    return h;
+}
+
+static cache_entry_t* cache_find(const redfish_cache_t* cache, const char* url) {
+    uint32_t h = url_hash(url);
+    cache_entry_t* e = cache->buckets[h & (cache->num_buckets - 1)];
+    
+    while (e && (e->hash != h || strcmp(e->url, url) != 0)) {
+        e = e->hash_next;
+    }
+    return e;
+}
+
+static void lru_unlink(redfish_cache_t* cache, cache_entry_t* e) {
+    if (e->newer) {
+        e->newer->older = e->older;
+    } else {
+        cache->newest = e->older;
+    }
+    if (e->older) {
+        e->older->newer = e->newer;
+    } else {
+        cache->oldest = e->newer;
+    }
+    e->newer = NULL;
+    e->older = NULL;
+}
+
+static void lru_push(redfish_cache_t* cache, cache_entry_t* e) {
+    e->older = cache->newest;
+    e->newer = NULL;
+    if (cache->newest) {
+        cache->newest->newer = e;
+    } else {
+        cache->oldest = e;
+    }
+    cache->newest = e;
+}
+
+static void lru_touch(redfish_cache_t* cache, cache_entry_t* e) {
+    if (cache->newest != e) {
+        lru_unlink(cache, e);
+        lru_push(cache, e);
+    }
+}
+
+static void entry_remove(redfish_cache_t* cache, cache_entry_t* e) {
+    cache_entry_t** pp = &cache->buckets[e->hash & (cache->num_buckets - 1)];
+    while (*pp != e) {
+        pp = &(*pp)->hash_next;
+    }
+    *pp = e->hash_next;
+    
+    lru_unlink(cache, e);
+    cache->stats.entries--;
+    cache->stats.bytes -= e->bytes;
+    
+    free(e->parsed);
+    free(e);
+}
+
+// 丟掉最久沒用的，直到再放 need bytes 也不會超過上限
+static void cache_evict(redfish_cache_t* cache, size_t need) {
+    while (cache->oldest && cache->stats.bytes + need > cache->max_bytes) {
+        entry_remove(cache, cache->oldest);
+        cache->stats.evictions++;
+    }
+}
+
+// 維持 load factor <= 1
+static void cache_grow(redfish_cache_t* cache) {
+    if (cache->stats.entries < cache->num_buckets) {
+        return;
+    }
+    
+    size_t size = cache->num_buckets * 2;
+    cache_entry_t** buckets = calloc(size, sizeof(cache_entry_t*));
+    if (!buckets) {
+        return;                 // 長不大就讓 chain 長一點
+    }
+    
+    for (size_t i = 0; i < cache->num_buckets; i++) {
+        cache_entry_t* e = cache->buckets[i];
+        while (e) {
+            cache_entry_t* next = e->hash_next;
+            e->hash_next = buckets[e->hash & (size - 1)];
+            buckets[e->hash & (size - 1)] = e;
+            e = next;
+        }
+    }
+    
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->num_buckets = size;
+}
+
+redfish_cache_t* redfish_cache_create(size_t max_bytes) {
+    redfish_cache_t* cache = calloc(1, sizeof(redfish_cache_t));
+    if (!cache) {
+        return NULL;
+    }
+    
+    cache->buckets = calloc(CACHE_MIN_BUCKETS, sizeof(cache_entry_t*));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    cache->num_buckets = CACHE_MIN_BUCKETS;
+    cache->max_bytes = max_bytes ? max_bytes : REDFISH_CACHE_DEFAULT_BYTES;
+    
+    return cache;
+}
+
+void redfish_cache_destroy(redfish_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    while (cache->oldest) {
+        entry_remove(cache, cache->oldest);
+    }
+    free(cache->buckets);
+    free(cache);
+}
+
+static int cache_insert(redfish_cache_t* cache, const char* url, size_t url_len,
+                        const char* etag, size_t etag_len, const char* body, size_t body_len) {
+    size_t bytes = sizeof(cache_entry_t) + url_len + etag_len + body_len + 3;
+    
+    // 自己一筆就超過上限的不存
+    if (bytes > cache->max_bytes) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    cache_entry_t* e = malloc(bytes);
+    if (!e) {
+        return BMC_ERROR_MEMORY;
+    }
+    memset(e, 0, sizeof(*e));
+    
+    e->url = (char*)(e + 1);
+    e->etag = e->url + url_len + 1;
+    e->body = e->etag + etag_len + 1;
+    memcpy(e->url, url, url_len);
+    e->url[url_len] = '\0';
+    memcpy(e->etag, etag, etag_len);
+    e->etag[etag_len] = '\0';
+    memcpy(e->body, body, body_len);
+    e->body[body_len] = '\0';
+    e->body_len = body_len;
+    e->bytes = bytes;
+    e->hash = url_hash(e->url);
+    
+    cache_entry_t* old = cache_find(cache, e->url);
+    if (old) {
+        entry_remove(cache, old);
+    }
+    cache_evict(cache, bytes);
+    cache_grow(cache);
+    
+    size_t b = e->hash & (cache->num_buckets - 1);
+    e->hash_next = cache->buckets[b];
+    cache->buckets[b] = e;
+    lru_push(cache, e);
+    cache->stats.entries++;
+    cache->stats.bytes += bytes;
+    
+    return BMC_SUCCESS;
+}
+
+/* ===== 給 Redfish client 用的內部函式 ===== */
+
+// 要帶的 If-None-Match，沒有快取就回傳 NULL
+const char* redfish_cache_etag(const redfish_cache_t* cache, const char* url) {
+    const cache_entry_t* e = cache_find(cache, url);
+    return e ? e->etag : NULL;
+}
+
+// 快取裡的 body，不動 LRU 和統計；指標到下一次改快取之前都有效
+const char* redfish_cache_body(const redfish_cache_t* cache, const char* url, size_t* len) {
+    const cache_entry_t* e = cache_find(cache, url);
+    if (!e) {
+        return NULL;
+    }
+    
+    if (len) {
+        *len = e->body_len;
+    }
+    return e->body;
+}
+
+// BMC 回 304：記一次命中，回傳快取裡的 body（不是複本），快取已經沒了就回傳 NULL
+const char* redfish_cache_hit(redfish_cache_t* cache, const char* url, size_t* len) {
+    cache_entry_t* e = cache_find(cache, url);
+    if (!e) {
+        return NULL;
+    }
+    
+    if (len) {
+        *len = e->body_len;
+    }
+    lru_touch(cache, e);
+    cache->stats.hits++;
+    return e->body;
+}
+
+// 同 redfish_cache_hit，但回傳複本（呼叫端 free）
+char* redfish_cache_revalidated(redfish_cache_t* cache, const char* url, size_t* len) {
+    size_t body_len = 0;
+    const char* cached = redfish_cache_hit(cache, url, &body_len);
+    if (!cached) {
+        return NULL;
+    }
+    
+    char* body = malloc(body_len + 1);
+    if (!body) {
+        return NULL;
+    }
+    memcpy(body, cached, body_len + 1);
+    if (len) {
+        *len = body_len;
+    }
+    return body;
+}
+
+// BMC 回 200：有 ETag 就存起來；沒有 ETag 的資源舊的快取也不能用了
+void redfish_cache_store(redfish_cache_t* cache, const char* url, const char* etag,
+                         const char* body, size_t len) {
+    cache->stats.misses++;
+    
+    if (!etag || !body) {
+        cache_entry_t* old = cache_find(cache, url);
+        if (old) {
+            entry_remove(cache, old);
+        }
+        return;
+    }
+    
+    cache_insert(cache, url, strlen(url), etag, strlen(etag), body, len);
+}
+
+// 解析結果：只有 body 沒變（304）時才拿來用，size 不對就當作沒有
+int redfish_cache_get_parsed(const redfish_cache_t* cache, const char* url, void* out, size_t size) {
+    const cache_entry_t* e = cache_find(cache, url);
+    if (!e || !e->parsed || e->parsed_size != size) {
+        return 0;
+    }
+    
+    memcpy(out, e->parsed, size);
+    return 1;
+}
+
+void redfish_cache_set_parsed(redfish_cache_t* cache, const char* url, const void* obj, size_t size) {
+    cache_entry_t* e = cache_find(cache, url);
+    if (!e) {
+        return;
+    }
+    
+    void* parsed = malloc(size);
+    if (!parsed) {
+        return;
+    }
+    memcpy(parsed, obj, size);
+    
+    cache->stats.bytes -= e->parsed_size;
+    e->bytes -= e->parsed_size;
+    free(e->parsed);
+    
+    e->parsed = parsed;
+    e->parsed_size = size;
+    e->bytes += size;
+    cache->stats.bytes += size;
+    
+    // 這筆自己不會被丟掉（剛用過），超過的從別筆扣
+    lru_touch(cache, e);
+    while (cache->oldest != e && cache->stats.bytes > cache->max_bytes) {
+        entry_remove(cache, cache->oldest);
+        cache->stats.evictions++;
+    }
+}
+
+/* ===== 存檔 ===== */
+
+static int read_entry(FILE* fp, redfish_cache_t* cache) {
+    cache_file_entry_t fe;
+    if (fread(&fe, sizeof(fe), 1, fp) != 1 || fe.url_len == 0 || fe.url_len > CACHE_MAX_URL ||
+        fe.etag_len == 0 || fe.etag_len > CACHE_MAX_ETAG || fe.body_len > CACHE_MAX_BODY) {
+        return -1;
+    }
+    
+    size_t total = (size_t)fe.url_len + fe.etag_len + fe.body_len;
+    char* buf = malloc(total + 1);
+    if (!buf) {
+        return -1;
+    }
+    
+    int ret = -1;
+    if (fread(buf, 1, total, fp) == total) {
+        buf[total] = '\0';
+        cache_insert(cache, buf, fe.url_len, buf + fe.url_len, fe.etag_len,
+                     buf + fe.url_len + fe.etag_len, fe.body_len);
+        ret = 0;
+    }
+    
+    free(buf);
+    return ret;
+}
+
+int redfish_cache_load(redfish_cache_t* cache, const char* path) {
+    char default_path[4096];
+    if (!cache) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    if (!path) {
+        if (bmc_cache_path(CACHE_FILE_NAME, default_path, sizeof(default_path)) != BMC_SUCCESS) {
+            return BMC_ERROR_INVALID_PARAM;
+        }
+        path = default_path;
+    }
+    
+    int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return BMC_SUCCESS;
+    }
+    
+    // 內容會直接當成 BMC 的回應用，別人的檔案或別人改得到的檔案都不用
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_uid != geteuid() || (st.st_mode & 077) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Ignoring Redfish cache %s: bad owner or permissions", path);
+        close(fd);
+        return BMC_SUCCESS;
+    }
+    
+    FILE* fp = fdopen(fd, "rb");
+    if (!fp) {
+        close(fd);
+        return BMC_SUCCESS;
+    }
+    
+    // 檔案裡是從最舊排到最新，依序插入後 LRU 順序跟存檔時一樣
+    cache_file_header_t hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.magic == CACHE_MAGIC &&
+        hdr.version == CACHE_VERSION) {
+        for (uint32_t i = 0; i < hdr.count; i++) {
+            if (read_entry(fp, cache) < 0) {
+                bmc_log(LOG_LEVEL_WARN, "Truncated Redfish cache %s", path);
+                break;
+            }
+        }
+    }
+    
+    fclose(fp);
+    bmc_log(LOG_LEVEL_DEBUG, "Redfish cache: %s, %zu entries", path, cache->stats.entries);
+    return BMC_SUCCESS;
+}
+
+// 先寫暫存檔再 rename，同時跑的 process 不會讀到寫一半的檔案
+int redfish_cache_save(const redfish_cache_t* cache, const char* path) {
+    char default_path[4096];
+    if (!cache) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    if (!path) {
+        if (bmc_cache_path(CACHE_FILE_NAME, default_path, sizeof(default_path)) != BMC_SUCCESS) {
+            return BMC_ERROR_INVALID_PARAM;
+        }
+        path = default_path;
+    }
+    
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    
+    // 回應裡可能有序號、MAC 之類的東西，只給自己讀
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    FILE* fp = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!fp) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        bmc_log(LOG_LEVEL_WARN, "Cannot write Redfish cache %s", tmp);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    cache_file_header_t hdr = {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .count = (uint32_t)cache->stats.entries
+    };
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    
+    for (const cache_entry_t* e = cache->oldest; e && ok; e = e->newer) {
+        cache_file_entry_t fe = {
+            .url_len = (uint32_t)strlen(e->url),
+            .etag_len = (uint32_t)strlen(e->etag),
+            .body_len = (uint32_t)e->body_len
+        };
+        ok = fwrite(&fe, sizeof(fe), 1, fp) == 1 &&
+             fwrite(e->url, 1, fe.url_len, fp) == fe.url_len &&
+             fwrite(e->etag, 1, fe.etag_len, fp) == fe.etag_len &&
+             fwrite(e->body, 1, fe.body_len, fp) == fe.body_len;
+    }
+    ok = (fclose(fp) == 0) && ok;
+    
+    if (!ok || rename(tmp, path) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot write Redfish cache %s", path);
+        unlink(tmp);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+void redfish_cache_get_stats(const redfish_cache_t* cache, redfish_cache_stats_t* stats) {
+    if (!cache || !stats) {
+        return;
+    }
+    
+    *stats = cache->stats;
+}
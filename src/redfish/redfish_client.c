@@ -1,87 +1,686 @@
 #include "bmctool/redfish.h"
+#include "bmctool/redfish_scan.h"
 #include <curl/curl.h>
+#include <json-c/json.h>
+#include <openssl/crypto.h>
+#include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 
+#define HTTP_TIMEOUT_S          10L
+#define HTTP_CONNECT_TIMEOUT_S  5L
+
+#define SESSIONS_PATH           "/redfish/v1/SessionService/Sessions"
+
 typedef struct {
     char* data;
     size_t size;
+    size_t cap;
+    CURL* curl;
+    redfish_scan_t* scan;       // 有的話 200 的 body 邊收邊 parse
+    int keep;                   // 有 scan 時預設不留 body
+    const char* etag;           // 有 ETag 就要留 body 給快取
 } http_response_t;
 
+// curl_global_init 只能做一次，而且要在任何 handle 建立之前
+static int g_curl_initialized = 0;
+
+static int buffer_append(http_response_t* resp, const char* data, size_t len) {
+    // 一次長一倍，大的回應不用每塊都 realloc + 搬一次
+    if (resp->size + len + 1 > resp->cap) {
+        size_t cap = resp->cap ? resp->cap : 4096;
+        while (cap < resp->size + len + 1) {
+            cap *= 2;
+        }
+        
+        char* ptr = realloc(resp->data, cap);
+        if (!ptr) {
+            bmc_log(LOG_LEVEL_ERROR, "Memory allocation failed");
+            return BMC_ERROR_MEMORY;
+        }
+        resp->data = ptr;
+        resp->cap = cap;
+    }
+    
+    memcpy(&(resp->data[resp->size]), data, len);
+    resp->size += len;
+    resp->data[resp->size] = '\0';
+    return BMC_SUCCESS;
+}
+
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t realsize = size * nmemb;
     http_response_t* resp = (http_response_t*)userp;
     
-    char* ptr = realloc(resp->data, resp->size + realsize + 1);
-    if (!ptr) {
-        bmc_log(LOG_LEVEL_ERROR, "Memory allocation failed");
-        return 0;
+    if (!resp->scan) {
+        return buffer_append(resp, contents, realsize) == BMC_SUCCESS ? realsize : 0;
     }
     
-    resp->data = ptr;
-    memcpy(&(resp->data[resp->size]), contents, realsize);
-    resp->size += realsize;
-    resp->data[resp->size] = '\0';
+    // 錯誤頁、304 之類的不 parse；語法錯誤留到 redfish_scan_finish 再報，連線照樣收完
+    long http_code = 0;
+    curl_easy_getinfo(resp->curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code != 200) {
+        return realsize;
+    }
+    redfish_scan_feed(resp->scan, contents, realsize);
+    
+    if (resp->keep || (resp->etag && resp->etag[0] != '\0')) {
+        if (buffer_append(resp, contents, realsize) != BMC_SUCCESS) {
+            return 0;
+        }
+    } else {
+        // 沒留 body 也記大小，log 用；data 一直是 NULL
+        resp->size += realsize;
+    }
     
     return realsize;
 }
 
-int http_get(redfish_ctx_t* ctx, const char* path, char** response_out) {
-    CURL* curl;
-    CURLcode res;
+// 回應裡要的 header
+typedef struct {
+    char token[256];
+    char location[256];
+    char etag[256];
+} resp_headers_t;
+
+// 宣告內部函式
+extern const char* redfish_cache_etag(const redfish_cache_t* cache, const char* url);
+extern const char* redfish_cache_body(const redfish_cache_t* cache, const char* url, size_t* len);
+extern const char* redfish_cache_hit(redfish_cache_t* cache, const char* url, size_t* len);
+extern char* redfish_cache_revalidated(redfish_cache_t* cache, const char* url, size_t* len);
+extern void redfish_cache_store(redfish_cache_t* cache, const char* url, const char* etag,
+                                const char* body, size_t len);
+
+static void copy_header_value(const char* value, size_t len, char* dest, size_t dest_size) {
+    while (len > 0 && (*value == ' ' || *value == '\t')) {
+        value++;
+        len--;
+    }
+    while (len > 0 && (value[len - 1] == '\r' || value[len - 1] == '\n' || value[len - 1] == ' ')) {
+        len--;
+    }
     
-    curl = curl_easy_init();
-    if (!curl) {
+    // 放不下就當作沒有，不要用截斷的 token
+    if (len >= dest_size) {
+        return;
+    }
+    memcpy(dest, value, len);
+    dest[len] = '\0';
+}
+
+static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    size_t len = size * nitems;
+    resp_headers_t* hdrs = (resp_headers_t*)userdata;
+    
+    if (len > 13 && strncasecmp(buffer, "X-Auth-Token:", 13) == 0) {
+        copy_header_value(buffer + 13, len - 13, hdrs->token, sizeof(hdrs->token));
+    } else if (len > 9 && strncasecmp(buffer, "Location:", 9) == 0) {
+        copy_header_value(buffer + 9, len - 9, hdrs->location, sizeof(hdrs->location));
+    } else if (len > 5 && strncasecmp(buffer, "ETag:", 5) == 0) {
+        copy_header_value(buffer + 5, len - 5, hdrs->etag, sizeof(hdrs->etag));
+    }
+    
+    return len;
+}
+
+// redfish_ctx 和 redfish_multi 建立 handle 之前都要先呼叫
+int redfish_curl_global_init(void) {
+    if (!g_curl_initialized) {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+            bmc_log(LOG_LEVEL_ERROR, "curl_global_init() failed");
+            return BMC_ERROR_NETWORK;
+        }
+        g_curl_initialized = 1;
+    }
+    
+    return BMC_SUCCESS;
+}
+
+/*
+ * 建立 context 的 curl handle：不隨 request 變的設定在這裡一次設好
+ * share handle 讓 DNS、TLS session 和連線可以跨 handle 共用
+ */
+int redfish_client_init(redfish_ctx_t* ctx) {
+    if (redfish_curl_global_init() != BMC_SUCCESS) {
         return BMC_ERROR_NETWORK;
     }
     
-    char url[512];
-    snprintf(url, sizeof(url), "%s%s", ctx->base_url, path);
+    CURLSH* share = curl_share_init();
+    CURL* curl = curl_easy_init();
+    if (!share || !curl) {
+        curl_easy_cleanup(curl);
+        curl_share_cleanup(share);
+        return BMC_ERROR_MEMORY;
+    }
     
-    http_response_t response = {0};
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
     
-    curl_easy_setopt(curl, CURLOPT_URL, url);
+    struct curl_slist* headers = curl_slist_append(NULL, "Accept: application/json");
+    struct curl_slist* tail = headers ? curl_slist_append(headers, "OData-Version: 4.0") : NULL;
+    if (!tail) {
+        curl_slist_free_all(headers);
+        curl_easy_cleanup(curl);
+        curl_share_cleanup(share);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, HTTP_TIMEOUT_S);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, HTTP_CONNECT_TIMEOUT_S);
+    // library 裡不要用 SIGALRM 做 DNS timeout
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    
+    ctx->curl = curl;
+    ctx->share = share;
+    ctx->headers = headers;
     
-    if (ctx->username[0] != '\0') {
-        curl_easy_setopt(curl, CURLOPT_USERNAME, ctx->username);
-        curl_easy_setopt(curl, CURLOPT_PASSWORD, ctx->password);
-        curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+    return BMC_SUCCESS;
+}
+
+// 關掉保留的連線；easy handle 要比 share handle 先清
+void redfish_client_cleanup(redfish_ctx_t* ctx) {
+    curl_easy_cleanup(ctx->curl);
+    curl_share_cleanup(ctx->share);
+    curl_slist_free_all(ctx->headers);
+    curl_slist_free_all(ctx->token_headers);
+    
+    ctx->curl = NULL;
+    ctx->share = NULL;
+    ctx->headers = NULL;
+    ctx->token_headers = NULL;
+}
+
+static void token_clear(redfish_ctx_t* ctx) {
+    curl_slist_free_all(ctx->token_headers);
+    ctx->token_headers = NULL;
+    OPENSSL_cleanse(ctx->auth_token, sizeof(ctx->auth_token));
+    ctx->session_uri[0] = '\0';
+}
+
+// 共用的 header 再加一行；失敗回傳 NULL
+static struct curl_slist* headers_with(const struct curl_slist* base, const char* line) {
+    struct curl_slist* headers = NULL;
+    for (const struct curl_slist* h = base; h; h = h->next) {
+        struct curl_slist* tail = curl_slist_append(headers, h->data);
+        if (!tail) {
+            curl_slist_free_all(headers);
+            return NULL;
+        }
+        headers = tail;
+    }
+    
+    struct curl_slist* tail = curl_slist_append(headers, line);
+    if (!tail) {
+        curl_slist_free_all(headers);
+    }
+    return tail;
+}
+
+// "scheme://host[:port]" 的長度，不是絕對 URL 回傳 0
+static size_t url_origin_len(const char* url) {
+    const char* p = strstr(url, "://");
+    if (!p || p == url) {
+        return 0;
+    }
+    p += 3;
+    return (size_t)(p - url) + strcspn(p, "/?#");
+}
+
+/*
+ * 檢查 BMC 給的 session URI，通過就把 path 寫進 path
+ * 只收 path，或 scheme、host、port 都跟 base_url 一樣的絕對 URL；
+ * 不然 DELETE 會把 X-Auth-Token 送到 BMC 指定的別台主機
+ */
+static int session_path(const redfish_ctx_t* ctx, const char* uri, char* path, size_t len) {
+    if (uri[0] == '/' && uri[1] != '/') {
+        snprintf(path, len, "%s", uri);
+        return 1;
     }
     
-    if (!ctx->verify_ssl) {
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+    size_t n = url_origin_len(uri);
+    if (n == 0 || n != url_origin_len(ctx->base_url) ||
+        strncasecmp(uri, ctx->base_url, n) != 0 || uri[n] != '/') {
+        return 0;
+    }
+    snprintf(path, len, "%s", uri + n);
+    return 1;
+}
+
+static int token_set(redfish_ctx_t* ctx, const char* token, const char* session_uri) {
+    char line[300];
+    snprintf(line, sizeof(line), "X-Auth-Token: %s", token);
+    struct curl_slist* headers = headers_with(ctx->headers, line);
+    OPENSSL_cleanse(line, sizeof(line));
+    if (!headers) {
+        return BMC_ERROR_MEMORY;
     }
     
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    token_clear(ctx);
+    ctx->token_headers = headers;
+    snprintf(ctx->auth_token, sizeof(ctx->auth_token), "%s", token);
+    // 快取裡舊版存的 URI 也再檢查一次，不合格就不 DELETE
+    if (!session_path(ctx, session_uri, ctx->session_uri, sizeof(ctx->session_uri))) {
+        ctx->session_uri[0] = '\0';
+    }
     
-    bmc_log(LOG_LEVEL_DEBUG, "GET %s", url);
+    return BMC_SUCCESS;
+}
+
+// session_uri 只存 path，一律接在 base_url 後面
+static void session_url(const redfish_ctx_t* ctx, char* url, size_t len) {
+    snprintf(url, len, "%s%s", ctx->base_url, ctx->session_uri);
+}
+
+// 每個 request 都要設的連線選項
+static void setup_request(redfish_ctx_t* ctx, const char* url, http_response_t* response) {
+    CURL* curl = ctx->curl;
     
-    res = curl_easy_perform(curl);
+    response->curl = curl;
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, ctx->verify_ssl ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, ctx->verify_ssl ? 2L : 0L);
+    
+    // 有 token 就不送 Basic 帳密
+    if (ctx->auth_token[0] != '\0') {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, ctx->token_headers);
+        curl_easy_setopt(curl, CURLOPT_USERNAME, NULL);
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, NULL);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, ctx->headers);
+        if (ctx->username[0] != '\0') {
+            curl_easy_setopt(curl, CURLOPT_USERNAME, ctx->username);
+            curl_easy_setopt(curl, CURLOPT_PASSWORD, ctx->password);
+            curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+        }
+    }
+}
+
+/*
+ * POST SessionService/Sessions 拿 X-Auth-Token
+ * 有快取先查快取；BMC 沒有 SessionService（404、405 之類）就關掉 use_session 改用 Basic
+ */
+static int session_login(redfish_ctx_t* ctx) {
+    redfish_token_key_t key;
+    if (ctx->token_cache) {
+        char token[256];
+        char uri[256];
+        redfish_token_cache_key(ctx->base_url, ctx->username, ctx->password, &key);
+        int found = redfish_token_cache_lookup(ctx->token_cache, &key, token, sizeof(token),
+                                               uri, sizeof(uri));
+        int ret = found == 1 ? token_set(ctx, token, uri) : BMC_ERROR_PROTOCOL;
+        OPENSSL_cleanse(token, sizeof(token));
+        if (ret == BMC_SUCCESS) {
+            bmc_log(LOG_LEVEL_DEBUG, "Using cached session %s", ctx->session_uri);
+            return BMC_SUCCESS;
+        }
+    }
+    
+    CURL* curl = ctx->curl;
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", ctx->base_url, SESSIONS_PATH);
+    
+    // 帳密裡可能有引號之類的字元，交給 json-c 處理 escape
+    struct json_object* req = json_object_new_object();
+    if (!req) {
+        return BMC_ERROR_MEMORY;
+    }
+    json_object_object_add(req, "UserName", json_object_new_string(ctx->username));
+    json_object_object_add(req, "Password", json_object_new_string(ctx->password));
+    const char* body = json_object_to_json_string_ext(req, JSON_C_TO_STRING_PLAIN);
+    
+    struct curl_slist* headers = body ? headers_with(ctx->headers, "Content-Type: application/json") : NULL;
+    if (!headers) {
+        json_object_put(req);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    http_response_t response = {0};
+    resp_headers_t hdrs = {0};
+    setup_request(ctx, url, &response);
+    
+    // 登入本身不帶任何認證
+    curl_easy_setopt(curl, CURLOPT_USERNAME, NULL);
+    curl_easy_setopt(curl, CURLOPT_PASSWORD, NULL);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)strlen(body));
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &hdrs);
+    
+    bmc_log(LOG_LEVEL_DEBUG, "POST %s", url);
+    
+    CURLcode res = curl_easy_perform(curl);
+    
+    long http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    
+    // handle 還要繼續拿來 GET，改過的選項都還原
+    // POSTFIELDS 設下去會把 method 改回 POST，要在 HTTPGET 之前
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, NULL);
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, NULL);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, ctx->headers);
+    curl_slist_free_all(headers);
+    
+    // body 裡有明碼密碼
+    OPENSSL_cleanse((char*)body, strlen(body));
+    json_object_put(req);
     
     if (res != CURLE_OK) {
-        bmc_log(LOG_LEVEL_ERROR, "curl_easy_perform() failed: %s", 
-                curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
+        bmc_log(LOG_LEVEL_ERROR, "Redfish login failed: %s", curl_easy_strerror(res));
         free(response.data);
         return BMC_ERROR_NETWORK;
     }
     
+    if (http_code == 401 || http_code == 403) {
+        bmc_log(LOG_LEVEL_ERROR, "Redfish login rejected: HTTP %ld", http_code);
+        free(response.data);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if ((http_code != 200 && http_code != 201) || hdrs.token[0] == '\0') {
+        bmc_log(LOG_LEVEL_DEBUG, "No usable SessionService (HTTP %ld), using Basic auth", http_code);
+        free(response.data);
+        ctx->use_session = 0;
+        return BMC_SUCCESS;
+    }
+    
+    // Location 沒有或指到別的主機，就從 body 的 @odata.id 拿
+    char path[256] = "";
+    if (hdrs.location[0] != '\0' && !session_path(ctx, hdrs.location, path, sizeof(path))) {
+        bmc_log(LOG_LEVEL_DEBUG, "Ignoring session Location %s", hdrs.location);
+    }
+    if (path[0] == '\0' && response.data) {
+        struct json_object* root = json_tokener_parse(response.data);
+        struct json_object* id;
+        if (root && json_object_object_get_ex(root, "@odata.id", &id) &&
+            json_object_is_type(id, json_type_string) &&
+            !session_path(ctx, json_object_get_string(id), path, sizeof(path))) {
+            path[0] = '\0';
+        }
+        json_object_put(root);
+    }
+    free(response.data);
+    
+    int ret = token_set(ctx, hdrs.token, path);
+    if (ret == BMC_SUCCESS && ctx->token_cache) {
+        redfish_token_cache_store(ctx->token_cache, &key, hdrs.token, path);
+    }
+    OPENSSL_cleanse(&hdrs, sizeof(hdrs));
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Logged in, session %s", ctx->session_uri);
+    return ret;
+}
+
+static void session_delete(redfish_ctx_t* ctx) {
+    CURL* curl = ctx->curl;
+    
+    if (ctx->session_uri[0] == '\0') {
+        return;
+    }
+    
+    char url[512];
+    session_url(ctx, url, sizeof(url));
+    
+    http_response_t response = {0};
+    setup_request(ctx, url, &response);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    
+    bmc_log(LOG_LEVEL_DEBUG, "DELETE %s", url);
+    
+    CURLcode res = curl_easy_perform(curl);
+    
     long http_code = 0;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, NULL);
+    free(response.data);
+    
+    // 刪不掉也沒關係，BMC 閒置一陣子會自己清
+    if (res != CURLE_OK || http_code >= 300) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot delete Redfish session %s: %s", ctx->session_uri,
+                res != CURLE_OK ? curl_easy_strerror(res) : "HTTP error");
+    }
+}
+
+// 登出：刪掉 BMC 上的 session，也從快取拿掉
+int redfish_client_logout(redfish_ctx_t* ctx) {
+    if (!ctx->curl || ctx->auth_token[0] == '\0') {
+        return BMC_SUCCESS;
+    }
+    
+    session_delete(ctx);
     
-    bmc_log(LOG_LEVEL_DEBUG, "HTTP %ld, %zu bytes", http_code, response.size);
+    if (ctx->token_cache) {
+        redfish_token_key_t key;
+        redfish_token_cache_key(ctx->base_url, ctx->username, ctx->password, &key);
+        redfish_token_cache_drop(ctx->token_cache, &key, ctx->auth_token);
+    }
+    token_clear(ctx);
+    
+    return BMC_SUCCESS;
+}
+
+/*
+ * context 不再用這個 token 了（destroy 或改了 endpoint / 帳密）
+ * 有快取就留在 BMC 上給下一次執行，沒有快取就登出
+ */
+void redfish_client_release(redfish_ctx_t* ctx) {
+    if (ctx->auth_token[0] == '\0') {
+        return;
+    }
+    
+    if (ctx->token_cache) {
+        token_clear(ctx);
+    } else {
+        redfish_client_logout(ctx);
+    }
+}
+
+static CURLcode perform_get(redfish_ctx_t* ctx, const char* url, http_response_t* response,
+                            long* http_code, resp_headers_t* hdrs) {
+    CURL* curl = ctx->curl;
+    setup_request(ctx, url, response);
+    
+    // 快取裡有 ETag 就帶 If-None-Match，資源沒變的話 BMC 回 304 不用重送整包
+    struct curl_slist* cond = NULL;
+    const char* etag = ctx->cache ? redfish_cache_etag(ctx->cache, url) : NULL;
+    if (etag) {
+        char line[300];
+        snprintf(line, sizeof(line), "If-None-Match: %s", etag);
+        cond = headers_with(ctx->auth_token[0] != '\0' ? ctx->token_headers : ctx->headers, line);
+        if (cond) {
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, cond);
+        }
+    }
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, hdrs);
+    
+    bmc_log(LOG_LEVEL_DEBUG, "GET %s%s", url, cond ? " (If-None-Match)" : "");
     
-    curl_easy_cleanup(curl);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, http_code);
+    
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, NULL);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, ctx->headers);
+    curl_slist_free_all(cond);
+    
+    return res;
+}
+
+/*
+ * http_get_cached / http_get_scan 共用：scan 為 NULL 時整包 body 放到 *response_out；
+ * 有 scan 時 200 的 body 邊收邊 parse，304 只回報 *from_cache，不 parse
+ * err_level 是 HTTP 錯誤碼的 log 等級，呼叫端會自己重試時用 DEBUG
+ */
+static int do_get(redfish_ctx_t* ctx, const char* path, redfish_scan_t* scan,
+                  char** response_out, int* from_cache, log_level_t err_level) {
+    CURL* curl = ctx->curl;
+    CURLcode res;
+    
+    if (from_cache) {
+        *from_cache = 0;
+    }
+    if (!curl) {
+        return BMC_ERROR_NETWORK;
+    }
+    
+    if (ctx->use_session && ctx->username[0] != '\0' && ctx->auth_token[0] == '\0') {
+        int ret = session_login(ctx);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+    }
+    
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", ctx->base_url, path);
+    
+    http_response_t response = { .scan = scan, .keep = scan == NULL };
+    resp_headers_t hdrs = {0};
+    long http_code = 0;
+    
+    // 快取要存 body 的話才留（header 比 body 先到，ETag 已經知道了）
+    if (ctx->cache) {
+        response.etag = hdrs.etag;
+    }
+    
+    res = perform_get(ctx, url, &response, &http_code, &hdrs);
+    
+    // token 過期或被 BMC 踢掉：從快取拿掉，重新登入再試一次
+    if (res == CURLE_OK && http_code == 401 && ctx->auth_token[0] != '\0') {
+        bmc_log(LOG_LEVEL_DEBUG, "Session token rejected, logging in again");
+        if (ctx->token_cache) {
+            redfish_token_key_t key;
+            redfish_token_cache_key(ctx->base_url, ctx->username, ctx->password, &key);
+            redfish_token_cache_drop(ctx->token_cache, &key, ctx->auth_token);
+        }
+        token_clear(ctx);
+        free(response.data);
+        response = (http_response_t){ .scan = scan, .keep = scan == NULL, .etag = response.etag };
+        hdrs = (resp_headers_t){0};
+        if (scan) {
+            redfish_scan_reset(scan);
+        }
+        
+        int ret = session_login(ctx);
+        if (ret != BMC_SUCCESS) {
+            return ret;
+        }
+        res = perform_get(ctx, url, &response, &http_code, &hdrs);
+    }
+    
+    if (res != CURLE_OK) {
+        bmc_log(LOG_LEVEL_ERROR, "curl_easy_perform() failed: %s",
+                curl_easy_strerror(res));
+        free(response.data);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    
+    bmc_log(LOG_LEVEL_DEBUG, "HTTP %ld, %zu bytes (%s)", http_code, response.size,
+            connects > 0 ? "new connection" : "reused connection");
+    
+    if (http_code == 304 && ctx->cache) {
+        free(response.data);
+        // scan 不在這裡掃，呼叫端可能有解析好的結果可以用
+        const char* body;
+        if (scan) {
+            body = redfish_cache_hit(ctx->cache, url, NULL);
+        } else {
+            *response_out = redfish_cache_revalidated(ctx->cache, url, NULL);
+            body = *response_out;
+        }
+        if (!body) {
+            bmc_log(LOG_LEVEL_ERROR, "HTTP 304 for %s but nothing cached", url);
+            return BMC_ERROR_PROTOCOL;
+        }
+        if (from_cache) {
+            *from_cache = 1;
+        }
+        return BMC_SUCCESS;
+    }
     
     if (http_code != 200) {
-        bmc_log(LOG_LEVEL_ERROR, "HTTP error: %ld", http_code);
+        bmc_log(err_level, "HTTP error: %ld", http_code);
+        free(response.data);
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (scan && redfish_scan_finish(scan) != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
         free(response.data);
         return BMC_ERROR_PROTOCOL;
     }
     
-    *response_out = response.data;
+    if (ctx->cache) {
+        redfish_cache_store(ctx->cache, url, hdrs.etag[0] != '\0' ? hdrs.etag : NULL,
+                            response.data, response.size);
+    }
+    
+    if (scan) {
+        free(response.data);
+    } else {
+        *response_out = response.data;
+    }
     return BMC_SUCCESS;
 }
+
+/*
+ * GET path；有 ETag 快取時 BMC 回 304 也當成功，*response_out 是快取內容的複本，
+ * from_cache（可以是 NULL）設成 1
+ */
+int http_get_cached(redfish_ctx_t* ctx, const char* path, char** response_out, int* from_cache) {
+    return do_get(ctx, path, NULL, response_out, from_cache, LOG_LEVEL_ERROR);
+}
+
+/*
+ * GET path，body 直接餵給 scan，不留整包回應
+ * 304 時不 parse、*from_cache 設成 1：呼叫端可以用 redfish_cache_get_parsed 的結果，
+ * 沒有的話再用 http_scan_cached 掃快取裡的 body
+ */
+int http_get_scan(redfish_ctx_t* ctx, const char* path, redfish_scan_t* scan, int* from_cache) {
+    if (!scan || !from_cache) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    redfish_scan_reset(scan);
+    return do_get(ctx, path, scan, NULL, from_cache, LOG_LEVEL_ERROR);
+}
+
+// 掃 ETag 快取裡 path 的 body（http_get_scan 回報 304 之後用）
+int http_scan_cached(redfish_ctx_t* ctx, const char* path, redfish_scan_t* scan) {
+    char url[512];
+    snprintf(url, sizeof(url), "%s%s", ctx->base_url, path);
+    
+    size_t len = 0;
+    const char* body = ctx->cache ? redfish_cache_body(ctx->cache, url, &len) : NULL;
+    if (!body) {
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    redfish_scan_reset(scan);
+    if (redfish_scan_feed(scan, body, len) != BMC_SUCCESS || redfish_scan_finish(scan) != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
+        return BMC_ERROR_PROTOCOL;
+    }
+    return BMC_SUCCESS;
+}
+
+int http_get(redfish_ctx_t* ctx, const char* path, char** response_out) {
+    return http_get_cached(ctx, path, response_out, NULL);
+}
+
+// 帶 $expand / $select 的試探性 GET：BMC 不吃會回 4xx，呼叫端拿掉 query 重試，錯誤只記 DEBUG
+int http_get_probe(redfish_ctx_t* ctx, const char* path, char** response_out) {
+    return do_get(ctx, path, NULL, response_out, NULL, LOG_LEVEL_DEBUG);
+}
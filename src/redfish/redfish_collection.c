@@ -0,0 +1,271 @@
+#include "bmctool/redfish.h"
+#include <json-c/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSTEMS_PATH        "/redfish/v1/Systems"
+#define SYSTEM_SELECT       "Id,Name,Manufacturer,Model,SerialNumber,PowerState,BiosVersion"
+
+// nextLink 一直繞回來的 BMC 也有，翻到這麼多頁就停
+#define MAX_PAGES           1024
+
+#define EXPAND_FEATURES     (REDFISH_FEATURE_EXPAND_NOLINKS | REDFISH_FEATURE_EXPAND_ALL)
+
+// 宣告內部函式
+extern int http_get(redfish_ctx_t* ctx, const char* path, char** response_out);
+extern int http_get_probe(redfish_ctx_t* ctx, const char* path, char** response_out);
+extern int redfish_parse_system_obj(struct json_object* root, redfish_system_t* system);
+extern int redfish_parse_features(const char* json_str, int* features, int* max_levels);
+
+typedef void (*member_fn)(struct json_object* member, void* user_data);
+
+int redfish_ctx_get_features(redfish_ctx_t* ctx) {
+    if (!ctx) {
+        return 0;
+    }
+    
+    if (ctx->features >= 0) {
+        return ctx->features;
+    }
+    
+    // 問不到就當作什麼都不支援，之後不再問
+    ctx->features = 0;
+    ctx->expand_max_levels = 0;
+    
+    char* response = NULL;
+    if (http_get(ctx, "/redfish/v1", &response) == BMC_SUCCESS) {
+        int features = 0;
+        int max_levels = 0;
+        if (redfish_parse_features(response, &features, &max_levels) == BMC_SUCCESS) {
+            ctx->features = features;
+            ctx->expand_max_levels = max_levels;
+        }
+        free(response);
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Redfish query support:%s%s%s%s (MaxLevels %d)",
+            (ctx->features & REDFISH_FEATURE_EXPAND_NOLINKS) ? " expand=." : "",
+            (ctx->features & REDFISH_FEATURE_EXPAND_ALL) ? " expand=*" : "",
+            (ctx->features & REDFISH_FEATURE_EXPAND_LEVELS) ? " levels" : "",
+            (ctx->features & REDFISH_FEATURE_SELECT) ? " select" : "",
+            ctx->expand_max_levels);
+    
+    return ctx->features;
+}
+
+// path 可能已經有 query（例如 nextLink 的 $skip），有的話用 & 接
+static int build_path(char* buf, size_t len, const char* path, const char* query) {
+    int n = query ? snprintf(buf, len, "%s%c%s", path, strchr(path, '?') ? '&' : '?', query)
+                  : snprintf(buf, len, "%s", path);
+    return (n < 0 || (size_t)n >= len) ? BMC_ERROR_INVALID_PARAM : BMC_SUCCESS;
+}
+
+/*
+ * 帶 query 的 GET；BMC 說支援但實際上不吃（4xx / 5xx）就拿掉 query 再試一次，
+ * 不帶可以的話把 drop_features 關掉，之後不再用
+ */
+static int get_with_query(redfish_ctx_t* ctx, const char* path, const char* query,
+                          int drop_features, char** response_out) {
+    char full[1024];
+    int ret = build_path(full, sizeof(full), path, query);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    if (!query) {
+        return http_get(ctx, full, response_out);
+    }
+    
+    ret = http_get_probe(ctx, full, response_out);
+    if (ret != BMC_ERROR_PROTOCOL) {
+        return ret;
+    }
+    
+    ret = http_get(ctx, path, response_out);
+    if (ret == BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "BMC rejected '%s', not using it again", query);
+        ctx->features &= ~drop_features;
+    }
+    return ret;
+}
+
+// 一個 member 一個 GET
+static int fetch_member(redfish_ctx_t* ctx, const char* path, const char* select,
+                        member_fn fn, void* user_data) {
+    char query[512];
+    const char* q = NULL;
+    if (select && (ctx->features & REDFISH_FEATURE_SELECT)) {
+        snprintf(query, sizeof(query), "$select=%s", select);
+        q = query;
+    }
+    
+    char* response = NULL;
+    int ret = get_with_query(ctx, path, q, REDFISH_FEATURE_SELECT, &response);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    struct json_object* member = json_tokener_parse(response);
+    free(response);
+    if (!member) {
+        bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    fn(member, user_data);
+    json_object_put(member);
+    return BMC_SUCCESS;
+}
+
+static int walk_members(redfish_ctx_t* ctx, const char* collection_path, int levels,
+                        const char* select, member_fn fn, void* user_data) {
+    int features = 0;
+    if (ctx->use_query_options) {
+        features = redfish_ctx_get_features(ctx);
+    } else {
+        select = NULL;
+    }
+    
+    /*
+     * collection 的 Members 算下層資源，"." 就會展開；只支援 "*" 的 BMC 連 Links 都展開，
+     * 回應大一點但還是一次拿完。$select 跟 $expand 一起用時各家 BMC 解讀不一樣
+     * （套在 collection 還是 member 上），展開時不帶
+     */
+    char expand[64] = "";
+    if (features & EXPAND_FEATURES) {
+        char mode = (features & REDFISH_FEATURE_EXPAND_NOLINKS) ? '.' : '*';
+        if (ctx->expand_max_levels > 0 && levels > ctx->expand_max_levels) {
+            levels = ctx->expand_max_levels;
+        }
+        if (features & REDFISH_FEATURE_EXPAND_LEVELS) {
+            snprintf(expand, sizeof(expand), "$expand=%c($levels=%d)", mode, levels);
+        } else {
+            snprintf(expand, sizeof(expand), "$expand=%c", mode);
+        }
+    }
+    
+    char path[512];
+    snprintf(path, sizeof(path), "%s", collection_path);
+    
+    int ret = BMC_SUCCESS;
+    size_t total = 0;
+    size_t fetched = 0;
+    
+    for (int page = 0; page < MAX_PAGES && path[0] != '\0' && ret == BMC_SUCCESS; page++) {
+        char* response = NULL;
+        int use_expand = (ctx->features & EXPAND_FEATURES) && expand[0] != '\0';
+        ret = get_with_query(ctx, path, use_expand ? expand : NULL, EXPAND_FEATURES, &response);
+        if (ret != BMC_SUCCESS) {
+            break;
+        }
+        
+        struct json_object* root = json_tokener_parse(response);
+        free(response);
+        if (!root) {
+            bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
+            ret = BMC_ERROR_PROTOCOL;
+            break;
+        }
+        
+        struct json_object* members;
+        if (!json_object_object_get_ex(root, "Members", &members) ||
+            !json_object_is_type(members, json_type_array)) {
+            bmc_log(LOG_LEVEL_ERROR, "%s is not a collection", path);
+            json_object_put(root);
+            ret = BMC_ERROR_PROTOCOL;
+            break;
+        }
+        
+        size_t n = json_object_array_length(members);
+        for (size_t i = 0; i < n && ret == BMC_SUCCESS; i++) {
+            struct json_object* m = json_object_array_get_idx(members, i);
+            struct json_object* id;
+            
+            // 有問題的 BMC 會在 Members 裡放 null 之類的東西
+            if (!json_object_is_type(m, json_type_object)) {
+                bmc_log(LOG_LEVEL_DEBUG, "%s: skipping non-object member %zu", path, i);
+                continue;
+            }
+            total++;
+            
+            // 展開過的 member 不會只有 @odata.id
+            if (json_object_object_length(m) > 1) {
+                fn(m, user_data);
+                continue;
+            }
+            
+            if (!json_object_object_get_ex(m, "@odata.id", &id) ||
+                !json_object_is_type(id, json_type_string)) {
+                continue;
+            }
+            ret = fetch_member(ctx, json_object_get_string(id), select, fn, user_data);
+            fetched++;
+        }
+        
+        // 下一頁
+        struct json_object* next;
+        if (json_object_object_get_ex(root, "Members@odata.nextLink", &next) &&
+            json_object_is_type(next, json_type_string)) {
+            snprintf(path, sizeof(path), "%s", json_object_get_string(next));
+        } else {
+            path[0] = '\0';
+        }
+        json_object_put(root);
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "%s: %zu members, %zu fetched one by one", collection_path,
+            total, fetched);
+    return ret;
+}
+
+typedef struct {
+    redfish_member_cb cb;
+    void* user_data;
+} members_state_t;
+
+static void members_to_json(struct json_object* member, void* user_data) {
+    members_state_t* st = (members_state_t*)user_data;
+    st->cb(json_object_to_json_string_ext(member, JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE), st->user_data);
+}
+
+int redfish_get_members(redfish_ctx_t* ctx, const char* collection_path, int levels,
+                        const char* select, redfish_member_cb cb, void* user_data) {
+    if (!ctx || !collection_path || levels < 1 || !cb) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    members_state_t st = { .cb = cb, .user_data = user_data };
+    return walk_members(ctx, collection_path, levels, select, members_to_json, &st);
+}
+
+typedef struct {
+    redfish_system_t* systems;
+    size_t max;
+    size_t count;
+} systems_state_t;
+
+static void collect_system(struct json_object* member, void* user_data) {
+    systems_state_t* st = (systems_state_t*)user_data;
+    if (st->count >= st->max) {
+        return;
+    }
+    
+    redfish_system_t* sys = &st->systems[st->count];
+    memset(sys, 0, sizeof(*sys));
+    if (redfish_parse_system_obj(member, sys) == BMC_SUCCESS) {
+        st->count++;
+    }
+}
+
+int redfish_list_systems(redfish_ctx_t* ctx, redfish_system_t* systems, size_t max, size_t* count) {
+    if (!ctx || !systems || !count) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    systems_state_t st = { .systems = systems, .max = max, .count = 0 };
+    int ret = walk_members(ctx, SYSTEMS_PATH, 1, SYSTEM_SELECT, collect_system, &st);
+    
+    *count = st.count;
+    return ret;
+}
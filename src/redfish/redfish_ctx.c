@@ -2,6 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+// 宣告內部函式
+extern int redfish_client_init(redfish_ctx_t* ctx);
+extern void redfish_client_cleanup(redfish_ctx_t* ctx);
+extern int redfish_client_logout(redfish_ctx_t* ctx);
+extern void redfish_client_release(redfish_ctx_t* ctx);
+
 redfish_ctx_t* redfish_ctx_create(void) {
     redfish_ctx_t* ctx = calloc(1, sizeof(redfish_ctx_t));
     if (!ctx) {
@@ -10,6 +16,14 @@ redfish_ctx_t* redfish_ctx_create(void) {
     
     ctx->use_https = 1;      // 預設用 HTTPS
     ctx->verify_ssl = 0;     // 測試時不驗證 SSL
+    ctx->use_session = 1;
+    ctx->use_query_options = 1;
+    ctx->features = -1;
+    
+    if (redfish_client_init(ctx) != BMC_SUCCESS) {
+        free(ctx);
+        return NULL;
+    }
     
     return ctx;
 }
@@ -18,6 +32,8 @@ void redfish_ctx_destroy(redfish_ctx_t* ctx) {
     if (!ctx) {
         return;
     }
+    redfish_client_release(ctx);
+    redfish_client_cleanup(ctx);
     free(ctx);
 }
 
@@ -26,8 +42,12 @@ int redfish_ctx_set_endpoint(redfish_ctx_t* ctx, const char* url) {
         return BMC_ERROR_INVALID_PARAM;
     }
     
+    // 舊的 token 是別台 BMC 的
+    redfish_client_release(ctx);
+    
     strncpy(ctx->base_url, url, sizeof(ctx->base_url) - 1);
     ctx->base_url[sizeof(ctx->base_url) - 1] = '\0';
+    ctx->features = -1;
     
     // 檢查是 http 還是 https
     if (strncmp(url, "http://", 7) == 0) {
@@ -44,6 +64,8 @@ int redfish_ctx_set_auth(redfish_ctx_t* ctx, const char* username, const char* p
         return BMC_ERROR_INVALID_PARAM;
     }
     
+    redfish_client_release(ctx);
+    
     if (username) {
         strncpy(ctx->username, username, sizeof(ctx->username) - 1);
         ctx->username[sizeof(ctx->username) - 1] = '\0';
@@ -56,3 +78,51 @@ int redfish_ctx_set_auth(redfish_ctx_t* ctx, const char* username, const char* p
     
     return BMC_SUCCESS;
 }
+
+int redfish_ctx_set_session_auth(redfish_ctx_t* ctx, int enable) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (!enable) {
+        redfish_client_release(ctx);
+    }
+    ctx->use_session = enable ? 1 : 0;
+    
+    return BMC_SUCCESS;
+}
+
+int redfish_ctx_set_token_cache(redfish_ctx_t* ctx, redfish_token_cache_t* cache) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->token_cache = cache;
+    return BMC_SUCCESS;
+}
+
+int redfish_ctx_set_cache(redfish_ctx_t* ctx, redfish_cache_t* cache) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->cache = cache;
+    return BMC_SUCCESS;
+}
+
+int redfish_ctx_set_query_options(redfish_ctx_t* ctx, int enable) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    ctx->use_query_options = enable ? 1 : 0;
+    return BMC_SUCCESS;
+}
+
+int redfish_ctx_logout(redfish_ctx_t* ctx) {
+    if (!ctx) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    return redfish_client_logout(ctx);
+}
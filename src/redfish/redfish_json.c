@@ -1,4 +1,5 @@
 #include "bmctool/redfish.h"
+#include "bmctool/redfish_scan.h"
 #include <json-c/json.h>
 #include <string.h>
 
@@ -14,17 +15,12 @@ static void json_get_string(struct json_object* obj, const char* key, char* dest
     }
 }
 
-int redfish_parse_system(const char* json_str, redfish_system_t* system) {
-    if (!json_str || !system) {
+// 已經 parse 好的 ComputerSystem（例如 $expand 展開的 member）
+int redfish_parse_system_obj(struct json_object* root, redfish_system_t* system) {
+    if (!root || !system) {
         return BMC_ERROR_INVALID_PARAM;
     }
     
-    struct json_object* root = json_tokener_parse(json_str);
-    if (!root) {
-        bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
-        return BMC_ERROR_PROTOCOL;
-    }
-    
     // 解析各欄位
     json_get_string(root, "Id", system->id, sizeof(system->id));
     json_get_string(root, "Name", system->name, sizeof(system->name));
@@ -39,6 +35,69 @@ int redfish_parse_system(const char* json_str, redfish_system_t* system) {
         json_get_string(root, "BiosVersion", system->bios_version, sizeof(system->bios_version));
     }
     
+    return BMC_SUCCESS;
+}
+
+// 同 redfish_parse_system_obj 的欄位，給串流 scanner 用；回傳欄位數
+size_t redfish_system_scan_fields(redfish_system_t* system, redfish_scan_field_t* fields) {
+    const redfish_scan_field_t f[] = {
+        { "Id", system->id, sizeof(system->id) },
+        { "Name", system->name, sizeof(system->name) },
+        { "Manufacturer", system->manufacturer, sizeof(system->manufacturer) },
+        { "Model", system->model, sizeof(system->model) },
+        { "SerialNumber", system->serial_number, sizeof(system->serial_number) },
+        { "PowerState", system->power_state, sizeof(system->power_state) },
+        { "BiosVersion", system->bios_version, sizeof(system->bios_version) },
+    };
+    
+    memcpy(fields, f, sizeof(f));
+    return sizeof(f) / sizeof(f[0]);
+}
+
+/*
+ * service root 的 ProtocolFeaturesSupported
+ * "ProtocolFeaturesSupported": {
+ *     "ExpandQuery": {"ExpandAll": true, "Levels": true, "Links": true, "NoLinks": true, "MaxLevels": 3},
+ *     "SelectQuery": true
+ * }
+ */
+int redfish_parse_features(const char* json_str, int* features, int* max_levels) {
+    if (!json_str || !features || !max_levels) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    *features = 0;
+    *max_levels = 0;
+    
+    struct json_object* root = json_tokener_parse(json_str);
+    if (!root) {
+        bmc_log(LOG_LEVEL_ERROR, "JSON parse error");
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    struct json_object* pfs;
+    struct json_object* val;
+    if (json_object_object_get_ex(root, "ProtocolFeaturesSupported", &pfs)) {
+        struct json_object* expand;
+        if (json_object_object_get_ex(pfs, "ExpandQuery", &expand)) {
+            if (json_object_object_get_ex(expand, "NoLinks", &val) && json_object_get_boolean(val)) {
+                *features |= REDFISH_FEATURE_EXPAND_NOLINKS;
+            }
+            if (json_object_object_get_ex(expand, "ExpandAll", &val) && json_object_get_boolean(val)) {
+                *features |= REDFISH_FEATURE_EXPAND_ALL;
+            }
+            if (json_object_object_get_ex(expand, "Levels", &val) && json_object_get_boolean(val)) {
+                *features |= REDFISH_FEATURE_EXPAND_LEVELS;
+            }
+            if (json_object_object_get_ex(expand, "MaxLevels", &val)) {
+                *max_levels = json_object_get_int(val);
+            }
+        }
+        if (json_object_object_get_ex(pfs, "SelectQuery", &val) && json_object_get_boolean(val)) {
+            *features |= REDFISH_FEATURE_SELECT;
+        }
+    }
+    
     json_object_put(root);
     return BMC_SUCCESS;
 }
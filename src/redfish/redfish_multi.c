@@ -0,0 +1,711 @@
+#define _GNU_SOURCE
+#include "bmctool/redfish_multi.h"
+#include "bmctool/redfish_scan.h"
+#include <curl/curl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#define MULTI_DEFAULT_MAX_TOTAL     256
+#define MULTI_DEFAULT_PER_HOST      8
+#define MULTI_DEFAULT_TIMEOUT_MS    10000
+#define MULTI_CONNECT_TIMEOUT_MS    5000
+#define MULTI_MAX_EVENTS            64
+#define MULTI_MAX_BODY              (16 * 1024 * 1024)  // 超過就當錯誤，避免 BMC 回傳異常內容吃光記憶體
+
+// 宣告內部函式
+extern int redfish_curl_global_init(void);
+extern size_t redfish_system_scan_fields(redfish_system_t* system, redfish_scan_field_t* fields);
+
+// 一個排隊中或在路上的 GET
+typedef struct multi_req {
+    struct multi_req* next;      // target queue
+    int target;
+    char path[256];
+    redfish_multi_cb cb;
+    redfish_system_cb system_cb; // redfish_multi_get_system 用，cb 為 NULL
+    void* user_data;
+} multi_req_t;
+
+// 一個 easy handle 和它的接收 buffer，完成後放回 free list 重複使用
+typedef struct multi_xfer {
+    struct multi_xfer* next_free;
+    struct multi_xfer* next_all;
+    CURL* easy;
+    multi_req_t* req;            // NULL 表示閒置
+    char* body;
+    size_t len;
+    size_t cap;
+    char url[512];
+    
+    // system request 不留 body，邊收邊 parse 到 system；scan 第一次用到才建
+    redfish_scan_t* scan;
+    redfish_system_t system;
+    int scanning;
+} multi_xfer_t;
+
+typedef struct {
+    char url[256];
+    char username[64];
+    char password[64];
+    int has_auth;
+    multi_req_t* queue_head;
+    multi_req_t* queue_tail;
+    int active;                  // 在路上的 request
+    int on_readyq;
+} multi_target_t;
+
+struct redfish_multi {
+    CURLM* multi;
+    CURLSH* share;               // DNS 和 TLS session；連線快取由 multi handle 自己共用
+    struct curl_slist* headers;
+    int epfd;
+    uint64_t timer_us;           // curl 要求的下一次 timeout，0 表示沒有
+    
+    multi_target_t* targets;
+    int num_targets;
+    int cap_targets;
+    
+    // 有 request 排隊、而且還沒到每台上限的 target（ring buffer）
+    int* readyq;
+    size_t readyq_head;
+    size_t readyq_len;
+    
+    multi_xfer_t* free_xfers;
+    multi_xfer_t* all_xfers;
+    
+    size_t pending;              // 排隊中 + 在路上
+    int active;                  // 在路上
+    int max_total;
+    int max_per_host;
+    int timeout_ms;
+    int verify_ssl;
+    
+    redfish_multi_stats_t stats;
+};
+
+/* ===== Ready queue ===== */
+
+static void readyq_push(redfish_multi_t* m, int target) {
+    multi_target_t* t = &m->targets[target];
+    if (t->on_readyq) {
+        return;
+    }
+    
+    size_t tail = (m->readyq_head + m->readyq_len) % (size_t)m->cap_targets;
+    m->readyq[tail] = target;
+    m->readyq_len++;
+    t->on_readyq = 1;
+}
+
+static int readyq_pop(redfish_multi_t* m) {
+    int target = m->readyq[m->readyq_head];
+    m->readyq_head = (m->readyq_head + 1) % (size_t)m->cap_targets;
+    m->readyq_len--;
+    m->targets[target].on_readyq = 0;
+    return target;
+}
+
+/* ===== curl callback ===== */
+
+static size_t write_cb(void* contents, size_t size, size_t nmemb, void* userp) {
+    multi_xfer_t* x = userp;
+    size_t n = size * nmemb;
+    
+    if (x->scanning) {
+        long http_code = 0;
+        curl_easy_getinfo(x->easy, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code == 200) {
+            redfish_scan_feed(x->scan, contents, n);
+        }
+        x->len += n;
+        return n;
+    }
+    
+    if (x->len + n + 1 > x->cap) {
+        size_t cap = x->cap ? x->cap : 4096;
+        while (cap < x->len + n + 1) {
+            cap *= 2;
+        }
+        if (cap > MULTI_MAX_BODY) {
+            bmc_log(LOG_LEVEL_ERROR, "Response from %s too large", x->url);
+            return 0;
+        }
+        char* body = realloc(x->body, cap);
+        if (!body) {
+            return 0;
+        }
+        x->body = body;
+        x->cap = cap;
+    }
+    
+    memcpy(x->body + x->len, contents, n);
+    x->len += n;
+    x->body[x->len] = '\0';
+    
+    return n;
+}
+
+// curl 告訴我們要等哪個 socket 的哪些事件
+static int socket_cb(CURL* easy, curl_socket_t s, int what, void* userp, void* socketp) {
+    redfish_multi_t* m = userp;
+    (void)easy;
+    
+    // curl 在 close 之前呼叫，DEL 失敗也沒關係
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(m->epfd, EPOLL_CTL_DEL, s, NULL);
+        return 0;
+    }
+    
+    struct epoll_event ev = {
+        .events = ((what & CURL_POLL_IN) ? EPOLLIN : 0) | ((what & CURL_POLL_OUT) ? EPOLLOUT : 0),
+        .data.fd = s
+    };
+    
+    // socketp 是我們 assign 的標記：非 NULL 表示已經在 epoll 裡
+    if (!socketp) {
+        if (epoll_ctl(m->epfd, EPOLL_CTL_ADD, s, &ev) < 0 &&
+            (errno != EEXIST || epoll_ctl(m->epfd, EPOLL_CTL_MOD, s, &ev) < 0)) {
+            bmc_log(LOG_LEVEL_ERROR, "epoll_ctl() failed: %s", strerror(errno));
+            return -1;
+        }
+        curl_multi_assign(m->multi, s, m);
+    } else {
+        epoll_ctl(m->epfd, EPOLL_CTL_MOD, s, &ev);
+    }
+    
+    return 0;
+}
+
+static int timer_cb(CURLM* multi, long timeout_ms, void* userp) {
+    redfish_multi_t* m = userp;
+    (void)multi;
+    
+    m->timer_us = timeout_ms < 0 ? 0 : bmc_monotonic_us() + (uint64_t)timeout_ms * 1000;
+    return 0;
+}
+
+/* ===== Public API ===== */
+
+redfish_multi_t* redfish_multi_create(void) {
+    if (redfish_curl_global_init() != BMC_SUCCESS) {
+        return NULL;
+    }
+    
+    redfish_multi_t* m = calloc(1, sizeof(*m));
+    if (!m) {
+        return NULL;
+    }
+    
+    m->epfd = epoll_create1(EPOLL_CLOEXEC);
+    m->multi = curl_multi_init();
+    m->share = curl_share_init();
+    m->headers = curl_slist_append(NULL, "Accept: application/json");
+    struct curl_slist* tail = m->headers ? curl_slist_append(m->headers, "OData-Version: 4.0")
+                                         : NULL;
+    
+    if (m->epfd < 0 || !m->multi || !m->share || !tail) {
+        bmc_log(LOG_LEVEL_ERROR, "Cannot set up Redfish multi handle");
+        redfish_multi_destroy(m);
+        return NULL;
+    }
+    
+    curl_share_setopt(m->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    
+    curl_multi_setopt(m->multi, CURLMOPT_SOCKETFUNCTION, socket_cb);
+    curl_multi_setopt(m->multi, CURLMOPT_SOCKETDATA, m);
+    curl_multi_setopt(m->multi, CURLMOPT_TIMERFUNCTION, timer_cb);
+    curl_multi_setopt(m->multi, CURLMOPT_TIMERDATA, m);
+    curl_multi_setopt(m->multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+    
+    m->timeout_ms = MULTI_DEFAULT_TIMEOUT_MS;
+    m->verify_ssl = 0;       // 跟 redfish_ctx 一樣，BMC 多半是自簽憑證
+    redfish_multi_set_max_total(m, MULTI_DEFAULT_MAX_TOTAL);
+    redfish_multi_set_max_per_host(m, MULTI_DEFAULT_PER_HOST);
+    
+    return m;
+}
+
+void redfish_multi_destroy(redfish_multi_t* m) {
+    if (!m) {
+        return;
+    }
+    
+    // easy handle 要先從 multi 拿掉、全部清掉，share handle 才能清
+    multi_xfer_t* x = m->all_xfers;
+    while (x) {
+        multi_xfer_t* next = x->next_all;
+        if (x->req) {
+            curl_multi_remove_handle(m->multi, x->easy);
+            free(x->req);
+        }
+        curl_easy_cleanup(x->easy);
+        redfish_scan_destroy(x->scan);
+        free(x->body);
+        free(x);
+        x = next;
+    }
+    
+    for (int t = 0; t < m->num_targets; t++) {
+        multi_req_t* req = m->targets[t].queue_head;
+        while (req) {
+            multi_req_t* next = req->next;
+            free(req);
+            req = next;
+        }
+    }
+    
+    if (m->multi) {
+        curl_multi_cleanup(m->multi);
+    }
+    if (m->share) {
+        curl_share_cleanup(m->share);
+    }
+    curl_slist_free_all(m->headers);
+    if (m->epfd >= 0) {
+        close(m->epfd);
+    }
+    
+    free(m->targets);
+    free(m->readyq);
+    free(m);
+}
+
+int redfish_multi_set_max_total(redfish_multi_t* m, int max_total) {
+    if (!m || max_total <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    m->max_total = max_total;
+    curl_multi_setopt(m->multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)max_total);
+    return BMC_SUCCESS;
+}
+
+int redfish_multi_set_max_per_host(redfish_multi_t* m, int max_per_host) {
+    if (!m || max_per_host <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // HTTP/2 時 PIPEWAIT 讓同一台的 request 等第一條連線，實際只會有一條
+    m->max_per_host = max_per_host;
+    curl_multi_setopt(m->multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)max_per_host);
+    return BMC_SUCCESS;
+}
+
+int redfish_multi_set_timeout(redfish_multi_t* m, int timeout_ms) {
+    if (!m || timeout_ms <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    m->timeout_ms = timeout_ms;
+    return BMC_SUCCESS;
+}
+
+int redfish_multi_set_verify_ssl(redfish_multi_t* m, int verify_ssl) {
+    if (!m) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    m->verify_ssl = verify_ssl ? 1 : 0;
+    return BMC_SUCCESS;
+}
+
+int redfish_multi_add_target(redfish_multi_t* m, const char* base_url,
+                             const char* username, const char* password) {
+    if (!m || !base_url || strlen(base_url) >= sizeof(m->targets[0].url)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    if (m->num_targets == m->cap_targets) {
+        int cap = m->cap_targets ? m->cap_targets * 2 : 64;
+        
+        multi_target_t* targets = realloc(m->targets, cap * sizeof(*targets));
+        if (!targets) {
+            return BMC_ERROR_MEMORY;
+        }
+        m->targets = targets;
+        
+        // readyq 是 ring buffer，換容量時要攤平
+        int* readyq = malloc(cap * sizeof(int));
+        if (!readyq) {
+            return BMC_ERROR_MEMORY;
+        }
+        for (size_t i = 0; i < m->readyq_len; i++) {
+            readyq[i] = m->readyq[(m->readyq_head + i) % (size_t)m->cap_targets];
+        }
+        free(m->readyq);
+        m->readyq = readyq;
+        m->readyq_head = 0;
+        m->cap_targets = cap;
+    }
+    
+    int idx = m->num_targets;
+    multi_target_t* t = &m->targets[idx];
+    memset(t, 0, sizeof(*t));
+    
+    // 結尾的 / 拿掉，path 都是 / 開頭
+    snprintf(t->url, sizeof(t->url), "%s", base_url);
+    size_t len = strlen(t->url);
+    while (len > 0 && t->url[len - 1] == '/') {
+        t->url[--len] = '\0';
+    }
+    
+    if (username) {
+        snprintf(t->username, sizeof(t->username), "%s", username);
+        snprintf(t->password, sizeof(t->password), "%s", password ? password : "");
+        t->has_auth = 1;
+    }
+    
+    m->num_targets++;
+    return idx;
+}
+
+const char* redfish_multi_target_url(const redfish_multi_t* m, int target) {
+    if (!m || target < 0 || target >= m->num_targets) {
+        return NULL;
+    }
+    return m->targets[target].url;
+}
+
+int redfish_multi_num_targets(const redfish_multi_t* m) {
+    return m ? m->num_targets : 0;
+}
+
+size_t redfish_multi_pending(const redfish_multi_t* m) {
+    return m ? m->pending : 0;
+}
+
+void redfish_multi_get_stats(const redfish_multi_t* m, redfish_multi_stats_t* stats) {
+    if (!m || !stats) {
+        return;
+    }
+    *stats = m->stats;
+}
+
+static int submit(redfish_multi_t* m, int target, const char* path, redfish_multi_cb cb,
+                  redfish_system_cb system_cb, void* user_data) {
+    if (!m || target < 0 || target >= m->num_targets || !path) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    multi_req_t* req = calloc(1, sizeof(*req));
+    if (!req) {
+        return BMC_ERROR_MEMORY;
+    }
+    
+    int n = snprintf(req->path, sizeof(req->path), "%s", path);
+    if (n < 0 || (size_t)n >= sizeof(req->path)) {
+        free(req);
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    req->target = target;
+    req->cb = cb;
+    req->system_cb = system_cb;
+    req->user_data = user_data;
+    
+    multi_target_t* t = &m->targets[target];
+    if (t->queue_tail) {
+        t->queue_tail->next = req;
+    } else {
+        t->queue_head = req;
+    }
+    t->queue_tail = req;
+    
+    m->pending++;
+    
+    if (t->active < m->max_per_host) {
+        readyq_push(m, target);
+    }
+    
+    return BMC_SUCCESS;
+}
+
+int redfish_multi_get(redfish_multi_t* m, int target, const char* path,
+                      redfish_multi_cb cb, void* user_data) {
+    return submit(m, target, path, cb, NULL, user_data);
+}
+
+int redfish_multi_get_system(redfish_multi_t* m, int target, const char* system_id,
+                             redfish_system_cb cb, void* user_data) {
+    if (!system_id) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    char path[256];
+    snprintf(path, sizeof(path), "/redfish/v1/Systems/%s", system_id);
+    
+    return submit(m, target, path, NULL, cb, user_data);
+}
+
+/* ===== 事件迴圈 ===== */
+
+// 不隨 request 變的設定在建立 easy handle 時設一次
+static multi_xfer_t* xfer_get(redfish_multi_t* m) {
+    multi_xfer_t* x = m->free_xfers;
+    if (x) {
+        m->free_xfers = x->next_free;
+        return x;
+    }
+    
+    x = calloc(1, sizeof(*x));
+    if (!x) {
+        return NULL;
+    }
+    x->easy = curl_easy_init();
+    if (!x->easy) {
+        free(x);
+        return NULL;
+    }
+    
+    curl_easy_setopt(x->easy, CURLOPT_SHARE, m->share);
+    curl_easy_setopt(x->easy, CURLOPT_HTTPHEADER, m->headers);
+    curl_easy_setopt(x->easy, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(x->easy, CURLOPT_WRITEDATA, x);
+    curl_easy_setopt(x->easy, CURLOPT_PRIVATE, x);
+    curl_easy_setopt(x->easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(x->easy, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(x->easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(x->easy, CURLOPT_CONNECTTIMEOUT_MS, (long)MULTI_CONNECT_TIMEOUT_MS);
+    curl_easy_setopt(x->easy, CURLOPT_NOSIGNAL, 1L);
+    
+    x->next_all = m->all_xfers;
+    m->all_xfers = x;
+    
+    return x;
+}
+
+static void xfer_put(redfish_multi_t* m, multi_xfer_t* x) {
+    x->req = NULL;
+    x->len = 0;
+    x->scanning = 0;
+    x->next_free = m->free_xfers;
+    m->free_xfers = x;
+}
+
+// request 拿出 queue 之後的收尾：更新計數，這台還有排隊的就放回 ready queue
+static void finish_req(redfish_multi_t* m, multi_req_t* req, int status, long http_code,
+                       const char* body, size_t len, const redfish_system_t* system) {
+    multi_target_t* t = &m->targets[req->target];
+    
+    m->pending--;
+    m->stats.requests++;
+    if (status != BMC_SUCCESS) {
+        m->stats.failed++;
+    }
+    
+    if (t->queue_head && t->active < m->max_per_host) {
+        readyq_push(m, req->target);
+    }
+    
+    if (req->cb) {
+        req->cb(m, req->target, status, http_code, body, len, req->user_data);
+    } else if (req->system_cb) {
+        req->system_cb(m, req->target, status, status == BMC_SUCCESS ? system : NULL,
+                       req->user_data);
+    }
+    
+    free(req);
+}
+
+static int start_one(redfish_multi_t* m, int target) {
+    multi_target_t* t = &m->targets[target];
+    multi_req_t* req = t->queue_head;
+    
+    t->queue_head = req->next;
+    if (!t->queue_head) {
+        t->queue_tail = NULL;
+    }
+    req->next = NULL;
+    
+    multi_xfer_t* x = xfer_get(m);
+    if (!x) {
+        finish_req(m, req, BMC_ERROR_MEMORY, 0, NULL, 0, NULL);
+        return BMC_ERROR_MEMORY;
+    }
+    
+    snprintf(x->url, sizeof(x->url), "%s%s", t->url, req->path);
+    x->req = req;
+    x->len = 0;
+    
+    if (req->system_cb) {
+        if (!x->scan) {
+            redfish_scan_field_t fields[REDFISH_SCAN_MAX_FIELDS];
+            size_t num_fields = redfish_system_scan_fields(&x->system, fields);
+            x->scan = redfish_scan_create(fields, num_fields);
+        }
+        if (!x->scan) {
+            xfer_put(m, x);
+            finish_req(m, req, BMC_ERROR_MEMORY, 0, NULL, 0, NULL);
+            return BMC_ERROR_MEMORY;
+        }
+        memset(&x->system, 0, sizeof(x->system));
+        redfish_scan_reset(x->scan);
+        x->scanning = 1;
+    }
+    
+    CURL* easy = x->easy;
+    curl_easy_setopt(easy, CURLOPT_URL, x->url);
+    curl_easy_setopt(easy, CURLOPT_USERNAME, t->has_auth ? t->username : NULL);
+    curl_easy_setopt(easy, CURLOPT_PASSWORD, t->has_auth ? t->password : NULL);
+    curl_easy_setopt(easy, CURLOPT_HTTPAUTH, (long)CURLAUTH_BASIC);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, m->verify_ssl ? 1L : 0L);
+    curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, m->verify_ssl ? 2L : 0L);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, (long)m->timeout_ms);
+    
+    CURLMcode mc = curl_multi_add_handle(m->multi, easy);
+    if (mc != CURLM_OK) {
+        bmc_log(LOG_LEVEL_ERROR, "curl_multi_add_handle() failed: %s", curl_multi_strerror(mc));
+        xfer_put(m, x);
+        finish_req(m, req, BMC_ERROR_NETWORK, 0, NULL, 0, NULL);
+        return BMC_ERROR_NETWORK;
+    }
+    
+    bmc_log(LOG_LEVEL_DEBUG, "GET %s", x->url);
+    t->active++;
+    m->active++;
+    
+    return BMC_SUCCESS;
+}
+
+// 依 ready queue 輪流開始 request，直到全域上限
+static void start_transfers(redfish_multi_t* m) {
+    while (m->readyq_len > 0 && m->active < m->max_total) {
+        int target = readyq_pop(m);
+        multi_target_t* t = &m->targets[target];
+        
+        if (!t->queue_head || t->active >= m->max_per_host) {
+            continue;
+        }
+        
+        start_one(m, target);
+        
+        // 還有空位就排回隊尾，讓每台 BMC 輪流
+        if (t->queue_head && t->active < m->max_per_host) {
+            readyq_push(m, target);
+        }
+    }
+}
+
+static void xfer_done(redfish_multi_t* m, multi_xfer_t* x, CURLcode result) {
+    multi_req_t* req = x->req;
+    multi_target_t* t = &m->targets[req->target];
+    long http_code = 0;
+    long version = 0;
+    long connects = 0;
+    
+    curl_easy_getinfo(x->easy, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(x->easy, CURLINFO_HTTP_VERSION, &version);
+    curl_easy_getinfo(x->easy, CURLINFO_NUM_CONNECTS, &connects);
+    curl_multi_remove_handle(m->multi, x->easy);
+    
+    t->active--;
+    m->active--;
+    m->stats.connects += (unsigned long)connects;
+    m->stats.bytes += x->len;
+    if (version == CURL_HTTP_VERSION_2_0) {
+        m->stats.http2++;
+    }
+    
+    int status = BMC_SUCCESS;
+    if (result != CURLE_OK) {
+        bmc_log(LOG_LEVEL_DEBUG, "GET %s failed: %s", x->url, curl_easy_strerror(result));
+        status = result == CURLE_OPERATION_TIMEDOUT ? BMC_ERROR_TIMEOUT : BMC_ERROR_NETWORK;
+    } else if (http_code != 200) {
+        bmc_log(LOG_LEVEL_DEBUG, "GET %s: HTTP %ld", x->url, http_code);
+        status = BMC_ERROR_PROTOCOL;
+    } else if (x->scanning && redfish_scan_finish(x->scan) != BMC_SUCCESS) {
+        bmc_log(LOG_LEVEL_DEBUG, "GET %s: JSON parse error", x->url);
+        status = BMC_ERROR_PROTOCOL;
+    }
+    
+    // body 在 callback 結束前都有效，xfer 之後才放回去
+    if (x->scanning) {
+        finish_req(m, req, status, http_code, NULL, x->len, &x->system);
+    } else {
+        finish_req(m, req, status, http_code, x->len ? x->body : NULL, x->len, NULL);
+    }
+    xfer_put(m, x);
+}
+
+static void read_completions(redfish_multi_t* m) {
+    CURLMsg* msg;
+    int left;
+    
+    while ((msg = curl_multi_info_read(m->multi, &left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        
+        multi_xfer_t* x = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&x);
+        xfer_done(m, x, msg->data.result);
+    }
+}
+
+int redfish_multi_run(redfish_multi_t* m, int timeout_ms) {
+    if (!m) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    uint64_t run_deadline = 0;
+    if (timeout_ms >= 0) {
+        run_deadline = bmc_monotonic_us() + (uint64_t)timeout_ms * 1000;
+    }
+    
+    int running = 0;
+    start_transfers(m);
+    
+    while (m->pending > 0) {
+        // 等到 curl 的 timer 或整體 deadline 為止
+        uint64_t now = bmc_monotonic_us();
+        uint64_t wake = run_deadline;
+        if (m->timer_us != 0 && (wake == 0 || m->timer_us < wake)) {
+            wake = m->timer_us;
+        }
+        
+        int wait_ms = -1;
+        if (wake != 0) {
+            wait_ms = wake > now ? (int)((wake - now + 999) / 1000) : 0;
+        }
+        
+        struct epoll_event events[MULTI_MAX_EVENTS];
+        int n = epoll_wait(m->epfd, events, MULTI_MAX_EVENTS, wait_ms);
+        if (n < 0 && errno != EINTR) {
+            bmc_log(LOG_LEVEL_ERROR, "epoll_wait() failed: %s", strerror(errno));
+            return BMC_ERROR_NETWORK;
+        }
+        
+        for (int i = 0; i < n; i++) {
+            int mask = 0;
+            if (events[i].events & EPOLLIN) {
+                mask |= CURL_CSELECT_IN;
+            }
+            if (events[i].events & EPOLLOUT) {
+                mask |= CURL_CSELECT_OUT;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                mask |= CURL_CSELECT_ERR;
+            }
+            curl_multi_socket_action(m->multi, events[i].data.fd, mask, &running);
+        }
+        
+        // 先清掉再呼叫，curl 在裡面可能會設新的 timer
+        if (m->timer_us != 0 && bmc_monotonic_us() >= m->timer_us) {
+            m->timer_us = 0;
+            curl_multi_socket_action(m->multi, CURL_SOCKET_TIMEOUT, 0, &running);
+        }
+        
+        read_completions(m);
+        start_transfers(m);
+        
+        if (run_deadline != 0 && bmc_monotonic_us() >= run_deadline) {
+            break;
+        }
+    }
+    
+    return (int)m->pending;
+}
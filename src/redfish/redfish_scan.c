@@ -0,0 +1,510 @@
+#include "bmctool/redfish_scan.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SCAN_MAX_DEPTH      64
+#define SCAN_MAX_PATH       256
+#define SCAN_MAX_LITERAL    64
+
+enum {
+    ST_VALUE,           // 等一個 value
+    ST_OBJ_FIRST,       // '{' 之後：key 或 '}'
+    ST_OBJ_KEY,         // ',' 之後：key
+    ST_COLON,
+    ST_AFTER_VALUE,     // ',' 或 '}'
+    ST_STRING,
+    ST_ESCAPE,
+    ST_UNICODE,
+    ST_LITERAL,
+    ST_SKIP,            // 跳過整個 object / array
+    ST_DONE,
+    ST_ERROR
+};
+
+enum {
+    STR_KEY,
+    STR_CAPTURE,
+    STR_SKIP
+};
+
+struct redfish_scan {
+    redfish_scan_field_t fields[REDFISH_SCAN_MAX_FIELDS];
+    size_t num_fields;
+    uint32_t found;
+    
+    int state;
+    int depth;                          // 走進去的 object 層數（跳過的不算）
+    size_t path_base[SCAN_MAX_DEPTH + 1];   // 每層 key 在 path 裡的起點
+    char path[SCAN_MAX_PATH];
+    size_t path_len;
+    int path_overflow;                  // key 太長，這個 key 底下都不比對
+    
+    // 字串
+    int str_kind;
+    int capture;                        // 寫到哪個欄位，-1 表示不寫
+    size_t cap_len;
+    uint32_t ucode;
+    int uhex;
+    uint32_t high_surrogate;
+    
+    // 數字 / true / false / null
+    char literal[SCAN_MAX_LITERAL];
+    size_t lit_len;
+    
+    // 跳過模式
+    int skip_nest;
+    int skip_in_string;
+    int skip_escape;
+};
+
+redfish_scan_t* redfish_scan_create(const redfish_scan_field_t* fields, size_t num_fields) {
+    if ((!fields && num_fields > 0) || num_fields > REDFISH_SCAN_MAX_FIELDS) {
+        return NULL;
+    }
+    
+    redfish_scan_t* scan = calloc(1, sizeof(redfish_scan_t));
+    if (!scan) {
+        return NULL;
+    }
+    
+    if (num_fields > 0) {
+        memcpy(scan->fields, fields, num_fields * sizeof(redfish_scan_field_t));
+    }
+    scan->num_fields = num_fields;
+    redfish_scan_reset(scan);
+    
+    return scan;
+}
+
+void redfish_scan_destroy(redfish_scan_t* scan) {
+    free(scan);
+}
+
+void redfish_scan_reset(redfish_scan_t* scan) {
+    if (!scan) {
+        return;
+    }
+    
+    scan->found = 0;
+    scan->state = ST_VALUE;
+    scan->depth = 0;
+    scan->path_len = 0;
+    scan->path_overflow = 0;
+    scan->capture = -1;
+}
+
+int redfish_scan_found(const redfish_scan_t* scan, size_t index) {
+    return scan && index < scan->num_fields && (scan->found & (1u << index)) != 0;
+}
+
+static int is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// 目前 path 剛好是某個欄位
+static int match_field(const redfish_scan_t* scan) {
+    if (scan->depth == 0 || scan->path_overflow) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < scan->num_fields; i++) {
+        const char* p = scan->fields[i].path;
+        if (strncmp(p, scan->path, scan->path_len) == 0 && p[scan->path_len] == '\0') {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// 目前 path 底下還有要的欄位（不是的話整個 object 跳過）
+static int match_prefix(const redfish_scan_t* scan) {
+    if (scan->depth == 0) {
+        return scan->num_fields > 0;
+    }
+    if (scan->path_overflow || scan->depth >= SCAN_MAX_DEPTH) {
+        return 0;
+    }
+    
+    for (size_t i = 0; i < scan->num_fields; i++) {
+        const char* p = scan->fields[i].path;
+        if (strncmp(p, scan->path, scan->path_len) == 0 && p[scan->path_len] == '/') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void path_append(redfish_scan_t* scan, char c) {
+    if (scan->path_len + 1 >= SCAN_MAX_PATH) {
+        scan->path_overflow = 1;
+        return;
+    }
+    scan->path[scan->path_len++] = c;
+}
+
+static void capture_byte(redfish_scan_t* scan, char c) {
+    const redfish_scan_field_t* f = &scan->fields[scan->capture];
+    if (scan->cap_len + 1 < f->dest_size) {
+        f->dest[scan->cap_len++] = c;
+    }
+}
+
+// 字串內容的一個 byte
+static void string_byte(redfish_scan_t* scan, char c) {
+    if (scan->str_kind == STR_KEY) {
+        path_append(scan, c);
+    } else if (scan->str_kind == STR_CAPTURE) {
+        capture_byte(scan, c);
+    }
+}
+
+static void string_codepoint(redfish_scan_t* scan, uint32_t cp) {
+    if (cp < 0x80) {
+        string_byte(scan, (char)cp);
+    } else if (cp < 0x800) {
+        string_byte(scan, (char)(0xC0 | (cp >> 6)));
+        string_byte(scan, (char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        string_byte(scan, (char)(0xE0 | (cp >> 12)));
+        string_byte(scan, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        string_byte(scan, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        string_byte(scan, (char)(0xF0 | (cp >> 18)));
+        string_byte(scan, (char)(0x80 | ((cp >> 12) & 0x3F)));
+        string_byte(scan, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        string_byte(scan, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+static void capture_done(redfish_scan_t* scan) {
+    if (scan->capture >= 0) {
+        const redfish_scan_field_t* f = &scan->fields[scan->capture];
+        if (f->dest_size > 0) {
+            f->dest[scan->cap_len < f->dest_size ? scan->cap_len : f->dest_size - 1] = '\0';
+        }
+        scan->found |= 1u << scan->capture;
+        scan->capture = -1;
+    }
+}
+
+// 一個 value 結束了
+static void value_done(redfish_scan_t* scan) {
+    scan->state = scan->depth == 0 ? ST_DONE : ST_AFTER_VALUE;
+}
+
+static void object_open(redfish_scan_t* scan) {
+    if (scan->depth > 0) {
+        path_append(scan, '/');
+    }
+    scan->depth++;
+    scan->path_base[scan->depth] = scan->path_len;
+    scan->state = ST_OBJ_FIRST;
+}
+
+static void object_close(redfish_scan_t* scan) {
+    scan->depth--;
+    value_done(scan);
+}
+
+static void key_start(redfish_scan_t* scan) {
+    scan->path_len = scan->path_base[scan->depth];
+    scan->path_overflow = 0;
+    scan->str_kind = STR_KEY;
+    scan->state = ST_STRING;
+}
+
+static int literal_done(redfish_scan_t* scan) {
+    const char* lit = scan->literal;
+    size_t len = scan->lit_len;
+    
+    int ok = (len == 4 && memcmp(lit, "true", 4) == 0) ||
+             (len == 5 && memcmp(lit, "false", 5) == 0) ||
+             (len == 4 && memcmp(lit, "null", 4) == 0) ||
+             (len > 0 && (lit[0] == '-' || (lit[0] >= '0' && lit[0] <= '9')));
+    if (!ok) {
+        scan->state = ST_ERROR;
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    if (scan->capture >= 0) {
+        if (!(len == 4 && memcmp(lit, "null", 4) == 0)) {
+            for (size_t i = 0; i < len; i++) {
+                capture_byte(scan, lit[i]);
+            }
+        }
+        capture_done(scan);
+    }
+    
+    value_done(scan);
+    return BMC_SUCCESS;
+}
+
+// 跳過模式：只數括號和引號；回傳用掉的 byte 數
+static size_t skip_bytes(redfish_scan_t* scan, const char* data, size_t len) {
+    size_t i = 0;
+    
+    while (i < len) {
+        char c = data[i++];
+        
+        if (scan->skip_in_string) {
+            if (scan->skip_escape) {
+                scan->skip_escape = 0;
+            } else if (c == '\\') {
+                scan->skip_escape = 1;
+            } else if (c == '"') {
+                scan->skip_in_string = 0;
+            }
+            continue;
+        }
+        
+        if (c == '"') {
+            scan->skip_in_string = 1;
+        } else if (c == '{' || c == '[') {
+            scan->skip_nest++;
+        } else if (c == '}' || c == ']') {
+            if (--scan->skip_nest == 0) {
+                value_done(scan);
+                break;
+            }
+        }
+    }
+    
+    return i;
+}
+
+// 字串裡不用特別處理的一段，一次處理完
+static size_t string_run(redfish_scan_t* scan, const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len && data[i] != '"' && data[i] != '\\') {
+        i++;
+    }
+    
+    if (scan->str_kind == STR_KEY) {
+        for (size_t j = 0; j < i; j++) {
+            path_append(scan, data[j]);
+        }
+    } else if (scan->str_kind == STR_CAPTURE) {
+        const redfish_scan_field_t* f = &scan->fields[scan->capture];
+        size_t room = f->dest_size > scan->cap_len + 1 ? f->dest_size - scan->cap_len - 1 : 0;
+        size_t n = i < room ? i : room;
+        memcpy(f->dest + scan->cap_len, data, n);
+        scan->cap_len += n;
+    }
+    
+    return i;
+}
+
+static void string_end(redfish_scan_t* scan) {
+    if (scan->str_kind == STR_KEY) {
+        scan->state = ST_COLON;
+        return;
+    }
+    
+    capture_done(scan);
+    value_done(scan);
+}
+
+// value 的第一個字
+static int value_start(redfish_scan_t* scan, char c) {
+    if (c == '{') {
+        if (match_prefix(scan)) {
+            object_open(scan);
+        } else {
+            scan->skip_nest = 1;
+            scan->skip_in_string = 0;
+            scan->skip_escape = 0;
+            scan->state = ST_SKIP;
+        }
+        return BMC_SUCCESS;
+    }
+    
+    if (c == '[') {
+        scan->skip_nest = 1;
+        scan->skip_in_string = 0;
+        scan->skip_escape = 0;
+        scan->state = ST_SKIP;
+        return BMC_SUCCESS;
+    }
+    
+    scan->capture = match_field(scan);
+    scan->cap_len = 0;
+    
+    if (c == '"') {
+        scan->str_kind = scan->capture >= 0 ? STR_CAPTURE : STR_SKIP;
+        scan->high_surrogate = 0;
+        scan->state = ST_STRING;
+        return BMC_SUCCESS;
+    }
+    
+    if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+        scan->literal[0] = c;
+        scan->lit_len = 1;
+        scan->state = ST_LITERAL;
+        return BMC_SUCCESS;
+    }
+    
+    scan->state = ST_ERROR;
+    return BMC_ERROR_PROTOCOL;
+}
+
+int redfish_scan_feed(redfish_scan_t* scan, const char* data, size_t len) {
+    if (!scan || (!data && len > 0)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    size_t i = 0;
+    while (i < len && scan->state != ST_ERROR) {
+        char c = data[i];
+        
+        switch (scan->state) {
+            case ST_VALUE:
+                i++;
+                if (!is_ws(c)) {
+                    value_start(scan, c);
+                }
+                break;
+            
+            case ST_OBJ_FIRST:
+            case ST_OBJ_KEY:
+                i++;
+                if (c == '"') {
+                    key_start(scan);
+                } else if (c == '}' && scan->state == ST_OBJ_FIRST) {
+                    object_close(scan);
+                } else if (!is_ws(c)) {
+                    scan->state = ST_ERROR;
+                }
+                break;
+            
+            case ST_COLON:
+                i++;
+                if (c == ':') {
+                    scan->state = ST_VALUE;
+                } else if (!is_ws(c)) {
+                    scan->state = ST_ERROR;
+                }
+                break;
+            
+            case ST_AFTER_VALUE:
+                i++;
+                if (c == ',') {
+                    scan->state = ST_OBJ_KEY;
+                } else if (c == '}') {
+                    object_close(scan);
+                } else if (!is_ws(c)) {
+                    scan->state = ST_ERROR;
+                }
+                break;
+            
+            case ST_STRING:
+                if (c == '"') {
+                    i++;
+                    string_end(scan);
+                } else if (c == '\\') {
+                    i++;
+                    scan->state = ST_ESCAPE;
+                } else {
+                    i += string_run(scan, data + i, len - i);
+                }
+                break;
+            
+            case ST_ESCAPE: {
+                i++;
+                scan->state = ST_STRING;
+                const char* from = "\"\\/bfnrt";
+                const char* to = "\"\\/\b\f\n\r\t";
+                const char* p = c != '\0' ? strchr(from, c) : NULL;
+                if (p) {
+                    string_byte(scan, to[p - from]);
+                } else if (c == 'u') {
+                    scan->ucode = 0;
+                    scan->uhex = 0;
+                    scan->state = ST_UNICODE;
+                } else {
+                    scan->state = ST_ERROR;
+                }
+                break;
+            }
+            
+            case ST_UNICODE: {
+                i++;
+                int v = (c >= '0' && c <= '9') ? c - '0' :
+                        (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                        (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (v < 0) {
+                    scan->state = ST_ERROR;
+                    break;
+                }
+                scan->ucode = (scan->ucode << 4) | (uint32_t)v;
+                if (++scan->uhex < 4) {
+                    break;
+                }
+                
+                // UTF-16 surrogate pair 要兩個 \u 合起來
+                scan->state = ST_STRING;
+                uint32_t u = scan->ucode;
+                if (u >= 0xD800 && u <= 0xDBFF) {
+                    scan->high_surrogate = u;
+                } else if (u >= 0xDC00 && u <= 0xDFFF && scan->high_surrogate) {
+                    string_codepoint(scan, 0x10000 + ((scan->high_surrogate - 0xD800) << 10) +
+                                           (u - 0xDC00));
+                    scan->high_surrogate = 0;
+                } else {
+                    string_codepoint(scan, u);
+                    scan->high_surrogate = 0;
+                }
+                break;
+            }
+            
+            case ST_LITERAL:
+                if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    c == '-' || c == '+' || c == '.') {
+                    i++;
+                    if (scan->lit_len >= sizeof(scan->literal)) {
+                        scan->state = ST_ERROR;
+                        break;
+                    }
+                    scan->literal[scan->lit_len++] = c;
+                } else {
+                    // 結束字元留給下一個狀態處理
+                    literal_done(scan);
+                }
+                break;
+            
+            case ST_SKIP:
+                i += skip_bytes(scan, data + i, len - i);
+                break;
+            
+            case ST_DONE:
+                i++;
+                if (!is_ws(c)) {
+                    scan->state = ST_ERROR;
+                }
+                break;
+            
+            default:
+                scan->state = ST_ERROR;
+                break;
+        }
+    }
+    
+    return scan->state == ST_ERROR ? BMC_ERROR_PROTOCOL : BMC_SUCCESS;
+}
+
+int redfish_scan_finish(redfish_scan_t* scan) {
+    if (!scan) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    // 最上層是數字之類的，沒有結束字元
+    if (scan->state == ST_LITERAL && scan->depth == 0) {
+        literal_done(scan);
+    }
+    
+    if (scan->state != ST_DONE) {
+        scan->state = ST_ERROR;
+        return BMC_ERROR_PROTOCOL;
+    }
+    
+    return BMC_SUCCESS;
+}
@@ -0,0 +1,296 @@
+#define _GNU_SOURCE
+#include "bmctool/redfish_token_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+
+#define CACHE_MAGIC         0x46524D42      // "BMRF"
+#define CACHE_VERSION       1
+#define CACHE_SLOTS         1024
+#define CACHE_FILE_NAME     "redfish-tokens"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;         // 結構改了就整個重建
+    uint32_t num_slots;
+    uint8_t reserved[48];
+} cache_header_t;
+
+// token[0] 為 '\0' 表示空的
+typedef struct {
+    uint8_t key[32];
+    int64_t last_used;          // unix time（秒），跨 process 比較用
+    char token[256];
+    char session_uri[256];
+} cache_slot_t;
+
+struct redfish_token_cache {
+    int fd;
+    size_t map_len;
+    cache_header_t* hdr;
+    cache_slot_t* slots;
+    int ttl_s;
+};
+
+static size_t cache_size(void) {
+    return sizeof(cache_header_t) + CACHE_SLOTS * sizeof(cache_slot_t);
+}
+
+static int cache_lock(redfish_token_cache_t* cache) {
+    while (flock(cache->fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            bmc_log(LOG_LEVEL_WARN, "flock() failed: %s", strerror(errno));
+            return BMC_ERROR_INVALID_PARAM;
+        }
+    }
+    return BMC_SUCCESS;
+}
+
+static void cache_unlock(redfish_token_cache_t* cache) {
+    flock(cache->fd, LOCK_UN);
+}
+
+// 檔案大小或版本不對就清空重建（呼叫端要持有鎖）
+static int cache_format(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return -1;
+    }
+    
+    cache_header_t hdr;
+    if ((size_t)st.st_size == cache_size() &&
+        pread(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) &&
+        hdr.magic == CACHE_MAGIC && hdr.version == CACHE_VERSION &&
+        hdr.slot_size == sizeof(cache_slot_t) && hdr.num_slots == CACHE_SLOTS) {
+        return 0;
+    }
+    
+    if (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t)cache_size()) < 0) {
+        return -1;
+    }
+    
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = CACHE_MAGIC;
+    hdr.version = CACHE_VERSION;
+    hdr.slot_size = sizeof(cache_slot_t);
+    hdr.num_slots = CACHE_SLOTS;
+    
+    return pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr) ? 0 : -1;
+}
+
+redfish_token_cache_t* redfish_token_cache_open(const char* path) {
+    char default_path[4096];
+    if (!path) {
+        if (bmc_cache_path(CACHE_FILE_NAME, default_path, sizeof(default_path)) != BMC_SUCCESS) {
+            return NULL;
+        }
+        path = default_path;
+    }
+    
+    int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot open token cache %s: %s", path, strerror(errno));
+        return NULL;
+    }
+    
+    // token 拿到就能登入 BMC，別人的檔案或別人讀得到的檔案都不用
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_uid != geteuid() || (st.st_mode & 077) != 0) {
+        bmc_log(LOG_LEVEL_WARN, "Ignoring token cache %s: bad owner or permissions", path);
+        close(fd);
+        return NULL;
+    }
+    
+    redfish_token_cache_t* cache = calloc(1, sizeof(redfish_token_cache_t));
+    if (!cache) {
+        close(fd);
+        return NULL;
+    }
+    cache->fd = fd;
+    cache->ttl_s = REDFISH_TOKEN_CACHE_TTL;
+    
+    if (cache_lock(cache) != BMC_SUCCESS) {
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    int ret = cache_format(fd);
+    cache_unlock(cache);
+    
+    if (ret < 0) {
+        bmc_log(LOG_LEVEL_WARN, "Cannot initialize token cache %s: %s", path, strerror(errno));
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    
+    cache->map_len = cache_size();
+    void* map = mmap(NULL, cache->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        bmc_log(LOG_LEVEL_WARN, "mmap() failed: %s", strerror(errno));
+        close(fd);
+        free(cache);
+        return NULL;
+    }
+    
+    cache->hdr = map;
+    cache->slots = (cache_slot_t*)((uint8_t*)map + sizeof(cache_header_t));
+    
+    bmc_log(LOG_LEVEL_DEBUG, "Token cache: %s", path);
+    return cache;
+}
+
+void redfish_token_cache_close(redfish_token_cache_t* cache) {
+    if (!cache) {
+        return;
+    }
+    
+    munmap(cache->hdr, cache->map_len);
+    close(cache->fd);
+    free(cache);
+}
+
+int redfish_token_cache_set_ttl(redfish_token_cache_t* cache, int ttl_s) {
+    if (!cache || ttl_s <= 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    cache->ttl_s = ttl_s;
+    return BMC_SUCCESS;
+}
+
+void redfish_token_cache_key(const char* base_url, const char* username, const char* password,
+                             redfish_token_key_t* key) {
+    char buf[512];
+    int n = snprintf(buf, sizeof(buf), "%s%c%s%c%s",
+                     base_url ? base_url : "", 0, username ? username : "", 0,
+                     password ? password : "");
+    size_t len = n < 0 ? 0 : ((size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+    
+    EVP_Digest(buf, len, key->digest, NULL, EVP_sha256(), NULL);
+    OPENSSL_cleanse(buf, sizeof(buf));
+}
+
+static void slot_clear(cache_slot_t* slot) {
+    OPENSSL_cleanse(slot, sizeof(*slot));
+}
+
+static int slot_usable(const redfish_token_cache_t* cache, const cache_slot_t* slot, time_t now) {
+    return slot->token[0] != '\0' && now - slot->last_used < cache->ttl_s;
+}
+
+int redfish_token_cache_lookup(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                               char* token, size_t token_len,
+                               char* session_uri, size_t uri_len) {
+    if (!cache || !key || !token || token_len == 0 || !session_uri || uri_len == 0) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = cache_lock(cache);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    time_t now = time(NULL);
+    int found = 0;
+    
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        if (!slot_usable(cache, slot, now)) {
+            if (slot->token[0] != '\0') {
+                slot_clear(slot);
+            }
+            continue;
+        }
+        if (memcmp(slot->key, key->digest, sizeof(slot->key)) != 0) {
+            continue;
+        }
+        
+        // BMC 的 SessionTimeout 也是每個 request 重算，這裡跟著延長
+        slot->last_used = now;
+        snprintf(token, token_len, "%s", slot->token);
+        snprintf(session_uri, uri_len, "%s", slot->session_uri);
+        found = 1;
+        break;
+    }
+    
+    cache_unlock(cache);
+    return found;
+}
+
+int redfish_token_cache_store(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                              const char* token, const char* session_uri) {
+    if (!cache || !key || !token || token[0] == '\0' ||
+        strlen(token) >= sizeof(((cache_slot_t*)0)->token)) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    
+    int ret = cache_lock(cache);
+    if (ret != BMC_SUCCESS) {
+        return ret;
+    }
+    
+    time_t now = time(NULL);
+    cache_slot_t* target = NULL;
+    cache_slot_t* oldest = NULL;
+    
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        
+        // 同一個 key 只留一個 token（兩個 process 同時登入時後寫的贏）
+        if (slot->token[0] != '\0' && memcmp(slot->key, key->digest, sizeof(slot->key)) == 0) {
+            target = slot;
+            break;
+        }
+        
+        if (!slot_usable(cache, slot, now)) {
+            if (!target) {
+                target = slot;
+            }
+        } else if (!oldest || slot->last_used < oldest->last_used) {
+            oldest = slot;
+        }
+    }
+    
+    // 滿了就擠掉最久沒用的
+    if (!target) {
+        target = oldest;
+    }
+    slot_clear(target);
+    memcpy(target->key, key->digest, sizeof(target->key));
+    target->last_used = now;
+    snprintf(target->token, sizeof(target->token), "%s", token);
+    snprintf(target->session_uri, sizeof(target->session_uri), "%s",
+             session_uri ? session_uri : "");
+    
+    cache_unlock(cache);
+    return BMC_SUCCESS;
+}
+
+void redfish_token_cache_drop(redfish_token_cache_t* cache, const redfish_token_key_t* key,
+                              const char* token) {
+    if (!cache || !key || !token || cache_lock(cache) != BMC_SUCCESS) {
+        return;
+    }
+    
+    // 只拿掉這個 token：別的 process 可能已經登入過存了新的
+    for (int i = 0; i < CACHE_SLOTS; i++) {
+        cache_slot_t* slot = &cache->slots[i];
+        if (slot->token[0] != '\0' && strcmp(slot->token, token) == 0 &&
+            memcmp(slot->key, key->digest, sizeof(slot->key)) == 0) {
+            slot_clear(slot);
+        }
+    }
+    
+    cache_unlock(cache);
+}
@@ -0,0 +1,600 @@
+#!/usr/bin/env python3
+"""
+IPMI BMC mock（給 tests/test_ipmi.py 用）
+
+在連續的幾個 UDP port 上各模擬一台 BMC：IPMI 1.5 不認證的 session-less 請求、
+RMCP+（cipher suite 3 / 17，帳號 admin / secret），以及要測的各種命令。
+有問題的 BMC 行為用命令列參數打開。每個收到的 IPMI 命令印一行
+
+    REQ <port> <netfn> <cmd> <data hex>
+
+測試靠這些行數封包。ASF Presence Ping 印 PING <port>。
+
+用法：ipmi_mock_bmc.py <port> [--count N] [--sel N] [--sel-partial] [--sel-cancel]
+                               [--sdr N] [--sdr-max-read N] [--fru-max-read N] [--ipmi15-only]
+                               [--sol-lines N] [--sol-dup] [--sol-busy] [--ctl FILE]
+"""
+import argparse
+import ctypes
+import ctypes.util
+import hashlib
+import hmac
+import os
+import select
+import socket
+import struct
+import sys
+
+USER = b'admin'
+PASSWORD = b'secret'
+
+RMCP_CLASS_ASF = 0x06
+RMCP_CLASS_IPMI = 0x07
+ASF_IANA = 0x000011BE
+ASF_PRESENCE_PING = 0x80
+ASF_PRESENCE_PONG = 0x40
+PAYLOAD_IPMI = 0x00
+PAYLOAD_SOL = 0x01
+PAYLOAD_OPEN_SESSION_REQ = 0x10
+PAYLOAD_OPEN_SESSION_RSP = 0x11
+PAYLOAD_RAKP1 = 0x12
+PAYLOAD_RAKP2 = 0x13
+PAYLOAD_RAKP3 = 0x14
+PAYLOAD_RAKP4 = 0x15
+
+NETFN_APP = 0x06
+NETFN_STORAGE = 0x0A
+NETFN_DCGRP = 0x2C
+
+DCMI_GROUP_ID = 0xDC
+
+CC_PAYLOAD_ACTIVE = 0x80
+CC_INVALID_COMMAND = 0xC1
+CC_REQ_LEN_INVALID = 0xC7
+CC_RESERVATION_CANCELED = 0xC5
+CC_CANNOT_RETURN_LEN = 0xCA
+CC_INVALID_DATA_FIELD = 0xCC
+CC_NOT_PRESENT = 0xCB
+
+opts = None
+
+# ===== AES-CBC-128（Python 標準函式庫沒有，直接叫 libcrypto） =====
+
+_crypto = ctypes.CDLL(ctypes.util.find_library('crypto'))
+_crypto.EVP_CIPHER_CTX_new.restype = ctypes.c_void_p
+_crypto.EVP_aes_128_cbc.restype = ctypes.c_void_p
+
+
+def aes_cbc(key, iv, data, encrypt):
+    ctx = ctypes.c_void_p(_crypto.EVP_CIPHER_CTX_new())
+    init = _crypto.EVP_EncryptInit_ex if encrypt else _crypto.EVP_DecryptInit_ex
+    update = _crypto.EVP_EncryptUpdate if encrypt else _crypto.EVP_DecryptUpdate
+    init(ctx, ctypes.c_void_p(_crypto.EVP_aes_128_cbc()), None, key[:16], iv)
+    _crypto.EVP_CIPHER_CTX_set_padding(ctx, 0)
+    out = ctypes.create_string_buffer(len(data) + 32)
+    n = ctypes.c_int(0)
+    update(ctx, out, ctypes.byref(n), data, len(data))
+    _crypto.EVP_CIPHER_CTX_free(ctx)
+    return out.raw[:n.value]
+
+
+def checksum(data):
+    return -sum(data) & 0xFF
+
+
+# ===== SEL =====
+
+class Sel:
+    def __init__(self, count):
+        self.entries = []
+        self.next_id = 1
+        self.add_ts = 0
+        self.erase_ts = 100
+        self.reservation = 0
+        self.add(count)
+
+    def add(self, n):
+        for _ in range(n):
+            rid = self.next_id
+            self.next_id += 1
+            # System event：temperature sensor，upper critical going high
+            self.entries.append(struct.pack('<HBIHBBBB', rid, 0x02, 1700000000 + rid * 60,
+                                            0x20, 0x04, 0x01, rid % 40, 0x01) + bytes([0x59, 0, 0]))
+        self.add_ts += 1
+
+    def clear(self):
+        self.entries.clear()
+        self.erase_ts += 1
+        self.add_ts += 1
+        self.reservation += 1
+
+    # 最舊的 n 筆被蓋掉
+    def wrap(self, n):
+        del self.entries[:n]
+        self.add(n)
+
+    def info(self):
+        return bytes([0, 0x51]) + struct.pack('<HHII', len(self.entries), 1000,
+                                               self.add_ts, self.erase_ts) + bytes([0x0F])
+
+    def reserve(self):
+        self.reservation = (self.reservation + 1) & 0xFFFF or 1
+        return bytes([0]) + struct.pack('<H', self.reservation)
+
+    def get_entry(self, body):
+        reservation, rid, offset, count = struct.unpack('<HHBB', body[:6])
+        whole = offset == 0 and count == 0xFF
+        if opts.sel_partial and whole:
+            return bytes([CC_CANNOT_RETURN_LEN])
+        if not whole and reservation != self.reservation:
+            return bytes([CC_RESERVATION_CANCELED])
+        if opts.sel_cancel and offset > 0:
+            # 模擬讀到一半有新 event 進來，reservation 被 cancel（只一次）
+            opts.sel_cancel = False
+            self.reservation += 1
+            return bytes([CC_RESERVATION_CANCELED])
+        if not self.entries:
+            return bytes([CC_NOT_PRESENT])
+
+        if rid == 0x0000:
+            idx = 0
+        elif rid == 0xFFFF:
+            idx = len(self.entries) - 1
+        else:
+            ids = [e[0] | (e[1] << 8) for e in self.entries]
+            if rid not in ids:
+                return bytes([CC_NOT_PRESENT])
+            idx = ids.index(rid)
+
+        entry = self.entries[idx]
+        nxt = 0xFFFF if idx + 1 == len(self.entries) else self.entries[idx + 1][0] | (self.entries[idx + 1][1] << 8)
+        data = entry if whole else entry[offset:offset + count]
+        return bytes([0]) + struct.pack('<H', nxt) + data
+
+
+# ===== SDR =====
+
+def sdr_name(name):
+    b = name.encode()
+    return bytes([0xC0 | len(b)]) + b
+
+
+def sdr_record(rid, rtype, body):
+    return struct.pack('<HBBB', rid, 0x51, rtype, len(body)) + body
+
+
+def sdr_full(rid, num, name, stype, unit):
+    # Full Sensor：M = 1、B = 0，threshold 都有
+    r = bytearray(42)
+    r[0], r[1], r[2], r[3] = 0x20, 0x00, num, 0x03
+    r[7], r[8], r[16], r[19] = stype, 0x01, unit, 1
+    r[31:37] = bytes([200, 190, 180, 10, 20, 30])
+    return sdr_record(rid, 0x01, bytes(r) + sdr_name(name))
+
+
+def sdr_compact(rid, num, name):
+    r = bytearray(26)
+    r[0], r[2], r[3], r[7], r[8] = 0x20, num, 0x07, 0x07, 0x6F
+    return sdr_record(rid, 0x02, bytes(r) + sdr_name(name))
+
+
+class Sdr:
+    def __init__(self, count):
+        self.records = []
+        self.add_ts = 1000
+        self.reservation = 0
+        self.add(count)
+
+    def add(self, n):
+        for _ in range(n):
+            i = len(self.records)
+            rid = i * 2 + 1
+            if i % 2:
+                self.records.append(sdr_compact(rid, i, f'CPU{i} Status'))
+            else:
+                self.records.append(sdr_full(rid, i, f'Temp {i}', 0x01, 0x01))
+        self.add_ts += 1
+
+    def info(self):
+        return bytes([0, 0x51]) + struct.pack('<HHII', len(self.records), 0xFFFF,
+                                               self.add_ts, 0) + bytes([0x22])
+
+    def reserve(self):
+        self.reservation = (self.reservation + 1) & 0xFFFF or 1
+        return bytes([0]) + struct.pack('<H', self.reservation)
+
+    def get(self, body):
+        reservation, rid, offset, count = struct.unpack('<HHBB', body[:6])
+        if offset and reservation != self.reservation:
+            return bytes([CC_RESERVATION_CANCELED])
+        ids = [r[0] | (r[1] << 8) for r in self.records]
+        idx = 0 if rid == 0 else ids.index(rid) if rid in ids else None
+        if idx is None:
+            return bytes([CC_NOT_PRESENT])
+        record = self.records[idx]
+        nxt = 0xFFFF if idx + 1 == len(self.records) else ids[idx + 1]
+        n = len(record) - offset if count == 0xFF else count
+        if n > opts.sdr_max_read:
+            return bytes([CC_CANNOT_RETURN_LEN])
+        return bytes([0]) + struct.pack('<H', nxt) + record[offset:offset + n]
+
+
+# ===== FRU =====
+
+def fru_field(text):
+    b = text.encode()
+    return bytes([0xC0 | len(b)]) + b
+
+
+def fru_area(body):
+    # 結束標記、補到 8 的倍數、最後一個 byte 是 checksum
+    body = bytearray(body) + b'\xc1'
+    while (len(body) + 1) % 8:
+        body += b'\x00'
+    body[1] = (len(body) + 1) // 8
+    return bytes(body) + bytes([checksum(body)])
+
+
+class Fru:
+    SIZE = 512
+
+    def __init__(self):
+        self.set_serial('0001')
+
+    def set_serial(self, serial):
+        chassis = fru_area(bytes([1, 0, 23]) + fru_field('CH-PART-01') + fru_field('CHS' + serial))
+        board = fru_area(bytes([1, 0, 25, 0x10, 0x20, 0x0C]) + fru_field('Acme') +
+                         fru_field('X11 Board') + fru_field('BRD' + serial) + fru_field('BP-77'))
+        product = fru_area(bytes([1, 0, 25]) + fru_field('Acme Corp') + fru_field('Server 9000') +
+                           fru_field('S9K') + fru_field('v2') + fru_field('PRD' + serial) +
+                           fru_field('ASSET42'))
+        o1 = 1
+        o2 = o1 + len(chassis) // 8
+        o3 = o2 + len(board) // 8
+        header = bytes([1, 0, o1, o2, o3, 0, 0])
+        data = header + bytes([checksum(header)]) + chassis + board + product
+        self.data = data + bytes(self.SIZE - len(data))
+
+    def info(self):
+        return bytes([0]) + struct.pack('<H', len(self.data)) + bytes([0])
+
+    def read(self, body):
+        offset, count = struct.unpack('<HB', body[1:4])
+        if count > opts.fru_max_read:
+            return bytes([CC_REQ_LEN_INVALID])
+        data = self.data[offset:offset + count]
+        return bytes([0, len(data)]) + data
+
+
+# ===== SOL =====
+
+class Sol:
+    """SOL instance 1：啟用後 console 輸出一包送一個，ACK 回來才送下一包"""
+    CHUNK = 50
+
+    def __init__(self, port):
+        self.owner = None               # 開著 SOL 的 session；--sol-busy 表示被別人開著
+        self.busy = opts.sol_busy
+        self.data = b''.join(f'port {port} console line {i:04d}\r\n'.encode()
+                             for i in range(opts.sol_lines))
+        self.off = 0
+        self.seq = 0
+        self.pending = None             # (seq, 長度)
+
+    def activate(self, session):
+        if self.busy or self.owner is not None:
+            return False
+        self.owner = session
+        return True
+
+    def deactivate(self):
+        if not self.busy and self.owner is None:
+            return False
+        self.busy = False
+        self.owner = None
+        self.pending = None
+        return True
+
+    # 下一包；沒有要送的回傳 None
+    def next_packet(self):
+        chunk = self.data[self.off:self.off + self.CHUNK]
+        if self.pending or not chunk:
+            return None
+        self.seq = self.seq % 15 + 1
+        self.pending = (self.seq, len(chunk))
+        return bytes([self.seq, 0, 0, 0]) + chunk
+
+    def ack(self, payload):
+        ack_seq, accepted, status = payload[1] & 0x0F, payload[2], payload[3]
+        if self.pending and ack_seq == self.pending[0] and not status & 0x40:
+            self.off += min(accepted, self.pending[1])
+            self.pending = None
+
+
+# ===== 一台 BMC =====
+
+class Bmc:
+    def __init__(self, port):
+        self.port = port
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('127.0.0.1', port))
+        self.sessions = {}      # BMC session ID -> dict
+        self.sel = Sel(opts.sel)
+        self.sdr = Sdr(opts.sdr)
+        self.fru = Fru()
+        self.sol = Sol(port)
+        self.session = None     # 目前這個命令是哪個 session 送的
+
+    # 測試寫進 ctl 檔的命令，下一個 IPMI 命令進來時套用
+    def control(self):
+        if not opts.ctl or not os.path.exists(opts.ctl):
+            return
+        with open(opts.ctl) as f:
+            for line in f:
+                words = line.split()
+                if words[0] == 'add':
+                    self.sel.add(int(words[1]))
+                elif words[0] == 'clear':
+                    self.sel.clear()
+                elif words[0] == 'wrap':
+                    self.sel.wrap(int(words[1]))
+                elif words[0] == 'sdr-add':
+                    self.sdr.add(int(words[1]))
+                elif words[0] == 'fru-serial':
+                    self.fru.set_serial(words[1])
+        os.unlink(opts.ctl)
+
+    def command(self, netfn, cmd, body):
+        print(f'REQ {self.port} {netfn:02x} {cmd:02x} {body.hex()}', flush=True)
+        self.control()
+
+        if netfn == NETFN_APP and cmd == 0x01:          # Get Device ID
+            return bytes([0, 0x20, 0x81, 0x02, 0x10, 0x02, 0xBF, 0x57, 0x01, 0x00, 0x10, 0x00])
+        if netfn == NETFN_APP and cmd == 0x38:          # Get Channel Authentication Capabilities
+            return self.auth_caps(body)
+        if netfn == NETFN_APP and cmd == 0x48:          # Activate Payload（SOL）
+            if not self.sol.activate(self.session):
+                return bytes([CC_PAYLOAD_ACTIVE])
+            return bytes([0, 0, 0, 0, 0]) + struct.pack('<HHHH', 68, 255, self.port, 0xFFFF)
+        if netfn == NETFN_APP and cmd == 0x49:          # Deactivate Payload
+            return bytes([0 if self.sol.deactivate() else CC_PAYLOAD_ACTIVE])
+        if netfn == NETFN_APP and cmd == 0x3B:          # Set Session Privilege Level
+            return bytes([0, body[0] & 0x0F])
+        if netfn == NETFN_APP and cmd == 0x3C:          # Close Session
+            return bytes([0])
+        if netfn == 0x00 and cmd == 0x01:               # Get Chassis Status
+            return bytes([0, 0x01, 0x00, 0x00])
+        if netfn == NETFN_DCGRP and cmd == 0x02 and body[:1] == bytes([DCMI_GROUP_ID]):
+            return self.power_reading()
+        if netfn == NETFN_STORAGE and cmd == 0x10:
+            return self.fru.info()
+        if netfn == NETFN_STORAGE and cmd == 0x11:
+            return self.fru.read(body)
+        if netfn == NETFN_STORAGE and cmd == 0x20:
+            return self.sdr.info()
+        if netfn == NETFN_STORAGE and cmd == 0x22:
+            return self.sdr.reserve()
+        if netfn == NETFN_STORAGE and cmd == 0x23:
+            return self.sdr.get(body)
+        if netfn == NETFN_STORAGE and cmd == 0x40:
+            return self.sel.info()
+        if netfn == NETFN_STORAGE and cmd == 0x42:
+            return self.sel.reserve()
+        if netfn == NETFN_STORAGE and cmd == 0x43:
+            return self.sel.get_entry(body)
+        return bytes([CC_INVALID_COMMAND])
+
+    # MD5 / password、非 null 帳號；--ipmi15-only 時不認 bit 7（要 IPMI 2.0 資料）的問法
+    def auth_caps(self, body):
+        if opts.ipmi15_only:
+            if body[0] & 0x80:
+                return bytes([CC_INVALID_DATA_FIELD])
+            return bytes([0, 0x01, 0x14, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00])
+        return bytes([0, 0x01, 0x94, 0x04, 0x03, 0x00, 0x00, 0x00, 0x00])
+
+    # DCMI Get Power Reading：每台 BMC 的瓦數不同（100 W 起，每台加 10 W），讀數一直 active
+    def power_reading(self):
+        watts = 100 + (self.port - opts.port) * 10
+        return bytes([0, DCMI_GROUP_ID]) + struct.pack('<HHHHII', watts, watts - 5, watts + 5,
+                                                      watts, 0, 1000) + bytes([0x40])
+
+    # rqAddr ... data checksum；回應的 rsAddr / rqSeq / cmd 照 request 的填
+    def respond(self, msg):
+        netfn, lun = msg[1] >> 2, msg[1] & 3
+        rq_addr, rq_seq, cmd = msg[3], msg[4], msg[5]
+        data = self.command(netfn, cmd, msg[6:-1])
+        if data is None:
+            return None
+        hdr = bytes([rq_addr, ((netfn | 1) << 2) | lun])
+        body = bytes([msg[0], rq_seq, cmd]) + data
+        return hdr + bytes([checksum(hdr)]) + body + bytes([checksum(body)])
+
+    def handle(self, pkt, addr):
+        if len(pkt) >= 12 and pkt[0] == 0x06 and pkt[3] == RMCP_CLASS_ASF:
+            self.handle_asf(pkt, addr)
+            return
+        if len(pkt) < 5 or pkt[0] != 0x06 or pkt[3] != RMCP_CLASS_IPMI:
+            return
+        if pkt[4] == 0x06:
+            self.handle_rmcpplus(pkt, addr)
+        elif pkt[4] == 0x00 and len(pkt) >= 14:
+            # IPMI 1.5、不認證：auth type + seq(4) + session ID(4) + 長度
+            msg = pkt[14:14 + pkt[13]]
+            rsp = self.respond(msg)
+            if rsp is not None:
+                self.sock.sendto(pkt[:4] + bytes(9) + bytes([len(rsp)]) + rsp, addr)
+
+    # Presence Pong：同一個 tag，supported entities 有 IPMI
+    def handle_asf(self, pkt, addr):
+        iana, mtype, tag = struct.unpack('>IBB', pkt[4:10])
+        if iana != ASF_IANA or mtype != ASF_PRESENCE_PING:
+            return
+        print(f'PING {self.port}', flush=True)
+        data = struct.pack('>II', ASF_IANA, 0) + bytes([0x81, 0x00]) + bytes(6)
+        self.sock.sendto(pkt[:4] + struct.pack('>IBBBB', ASF_IANA, ASF_PRESENCE_PONG, tag, 0,
+                                               len(data)) + data, addr)
+
+    # ----- RMCP+ -----
+
+    @staticmethod
+    def rmcpplus(ptype, sid, seq, payload):
+        return bytes([0x06, 0x00, 0xFF, RMCP_CLASS_IPMI, 0x06, ptype]) + \
+            struct.pack('<IIH', sid, seq, len(payload)) + payload
+
+    def handle_rmcpplus(self, pkt, addr):
+        if len(pkt) < 16:
+            return
+        ptype = pkt[5] & 0x3F
+        sid, _, plen = struct.unpack('<IIH', pkt[6:16])
+        payload = pkt[16:16 + plen]
+
+        if ptype == PAYLOAD_OPEN_SESSION_REQ:
+            self.open_session(payload, addr)
+        elif ptype == PAYLOAD_RAKP1:
+            self.rakp1(payload, addr)
+        elif ptype == PAYLOAD_RAKP3:
+            self.rakp3(payload, addr)
+        elif ptype in (PAYLOAD_IPMI, PAYLOAD_SOL) and pkt[5] & 0xC0 == 0xC0:
+            s = self.sessions.get(sid)
+            if not s or not s['active']:
+                return
+            icv = s['icv_len']
+            if not hmac.compare_digest(hmac.new(s['k1'], pkt[4:-icv], s['integrity']).digest()[:icv],
+                                       pkt[-icv:]):
+                return
+            plain = aes_cbc(s['k2'], payload[:16], payload[16:], False)
+            msg = plain[:len(plain) - plain[-1] - 1]
+            if ptype == PAYLOAD_SOL:
+                if self.sol.owner is s and len(msg) >= 4:
+                    self.sol.ack(msg)
+            else:
+                self.session = s
+                rsp = self.respond(msg)
+                self.session = None
+                if rsp is not None:
+                    self.send_encrypted(s, addr, rsp)
+                if msg[1] >> 2 == NETFN_APP and msg[5] == 0x3C:     # Close Session
+                    del self.sessions[sid]
+            if self.sol.owner is s:
+                self.send_sol(s, addr)
+
+    def open_session(self, p, addr):
+        tag, console_sid = p[0], struct.unpack('<I', p[4:8])[0]
+        auth, integ, conf = p[12], p[20], p[28]
+        bmc_sid = int.from_bytes(os.urandom(4), 'little') or 1
+        self.sessions[bmc_sid] = {
+            'console': console_sid,
+            'auth': hashlib.sha256 if auth == 3 else hashlib.sha1,
+            'integrity': hashlib.sha256 if integ == 4 else hashlib.sha1,
+            'icv_len': 16 if integ == 4 else 12,
+            'active': False,
+        }
+        rsp = bytes([tag, 0, 0x04, 0]) + struct.pack('<II', console_sid, bmc_sid) + \
+            bytes([0, 0, 0, 8, auth, 0, 0, 0, 1, 0, 0, 8, integ, 0, 0, 0, 2, 0, 0, 8, conf, 0, 0, 0])
+        self.sock.sendto(self.rmcpplus(PAYLOAD_OPEN_SESSION_RSP, 0, 0, rsp), addr)
+
+    def rakp1(self, p, addr):
+        tag, bmc_sid = p[0], struct.unpack('<I', p[4:8])[0]
+        s = self.sessions.get(bmc_sid)
+        if not s:
+            return
+        rm, role, ulen = p[8:24], p[24], p[27]
+        user = p[28:28 + ulen]
+        if user != USER:
+            # 0x0D：unauthorized name
+            self.sock.sendto(self.rmcpplus(PAYLOAD_RAKP2, 0, 0, bytes([tag, 0x0D, 0, 0]) +
+                                           struct.pack('<I', s['console'])), addr)
+            return
+        rc, guid = os.urandom(16), os.urandom(16)
+        kuid = PASSWORD.ljust(20, b'\0')
+        s.update(rm=rm, rc=rc, guid=guid, role=role, user=user, kuid=kuid)
+        code = hmac.new(kuid, struct.pack('<II', s['console'], bmc_sid) + rm + rc + guid +
+                        bytes([role, ulen]) + user, s['auth']).digest()
+        self.sock.sendto(self.rmcpplus(PAYLOAD_RAKP2, 0, 0, bytes([tag, 0, 0, 0]) +
+                                       struct.pack('<I', s['console']) + rc + guid + code), addr)
+
+    def rakp3(self, p, addr):
+        tag, bmc_sid = p[0], struct.unpack('<I', p[4:8])[0]
+        s = self.sessions.get(bmc_sid)
+        if not s or 'kuid' not in s:
+            return
+        head = bytes([tag, 0, 0, 0]) + struct.pack('<I', s['console'])
+        expect = hmac.new(s['kuid'], s['rc'] + struct.pack('<I', s['console']) +
+                          bytes([s['role'], len(s['user'])]) + s['user'], s['auth']).digest()
+        if not hmac.compare_digest(p[8:], expect):
+            # 0x0F：invalid integrity check value
+            self.sock.sendto(self.rmcpplus(PAYLOAD_RAKP4, 0, 0, bytes([tag, 0x0F, 0, 0]) +
+                                           struct.pack('<I', s['console'])), addr)
+            return
+        sik = hmac.new(s['kuid'], s['rm'] + s['rc'] + bytes([s['role'], len(s['user'])]) + s['user'],
+                       s['auth']).digest()
+        s['k1'] = hmac.new(sik, b'\x01' * 20, s['auth']).digest()
+        s['k2'] = hmac.new(sik, b'\x02' * 20, s['auth']).digest()
+        s['seq'] = 1
+        s['active'] = True
+        icv = hmac.new(sik, s['rm'] + struct.pack('<I', bmc_sid) + s['guid'], s['auth']).digest()
+        self.sock.sendto(self.rmcpplus(PAYLOAD_RAKP4, 0, 0, head + icv[:s['icv_len']]), addr)
+
+    # --sol-dup 時每包送兩次，像 console 的 ACK 掉了 BMC 重送
+    def send_sol(self, s, addr):
+        pkt = self.sol.next_packet()
+        if pkt is None:
+            return
+        for _ in range(2 if opts.sol_dup else 1):
+            self.send_encrypted(s, addr, pkt, PAYLOAD_SOL)
+
+    def send_encrypted(self, s, addr, msg, ptype=PAYLOAD_IPMI):
+        pad = (16 - (len(msg) + 1) % 16) % 16
+        iv = os.urandom(16)
+        payload = iv + aes_cbc(s['k2'], iv, msg + bytes(range(1, pad + 1)) + bytes([pad]), True)
+        pkt = self.rmcpplus(0xC0 | ptype, s['console'], s['seq'], payload)
+        s['seq'] += 1
+        ipad = (4 - (len(pkt) - 4 + 2) % 4) % 4
+        pkt += b'\xff' * ipad + bytes([ipad, 0x07])
+        pkt += hmac.new(s['k1'], pkt[4:], s['integrity']).digest()[:s['icv_len']]
+        self.sock.sendto(pkt, addr)
+
+
+def main():
+    global opts
+    parser = argparse.ArgumentParser(description='IPMI BMC mock')
+    parser.add_argument('port', type=int)
+    parser.add_argument('--count', type=int, default=1, help='BMCs on consecutive ports')
+    parser.add_argument('--sel', type=int, default=20, help='initial SEL entries')
+    parser.add_argument('--sel-partial', action='store_true',
+                        help='reject whole-record Get SEL Entry reads (cc 0xCA)')
+    parser.add_argument('--sel-cancel', action='store_true',
+                        help='cancel the SEL reservation once, in the middle of a partial read')
+    parser.add_argument('--sdr', type=int, default=8, help='initial SDR records')
+    parser.add_argument('--sdr-max-read', type=int, default=255,
+                        help='longest Get SDR read the BMC accepts (cc 0xCA beyond it)')
+    parser.add_argument('--fru-max-read', type=int, default=255,
+                        help='longest Read FRU Data the BMC accepts (cc 0xC7 beyond it)')
+    parser.add_argument('--ipmi15-only', action='store_true',
+                        help='answer Get Channel Auth Caps like an IPMI 1.5 BMC (cc 0xCC for bit 7)')
+    parser.add_argument('--sol-lines', type=int, default=0, help='console lines sent once SOL is active')
+    parser.add_argument('--sol-dup', action='store_true', help='send every SOL packet twice')
+    parser.add_argument('--sol-busy', action='store_true',
+                        help='SOL already active in another session (cc 0x80 until deactivated)')
+    parser.add_argument('--ctl', help='control file: add N / clear / wrap N (SEL), sdr-add N, '
+                                      'fru-serial S')
+    opts = parser.parse_args()
+
+    bmcs = {}
+    for i in range(opts.count):
+        bmc = Bmc(opts.port + i)
+        bmcs[bmc.sock] = bmc
+    print(f'IPMI mock on 127.0.0.1:{opts.port}-{opts.port + opts.count - 1}', flush=True)
+
+    try:
+        while True:
+            ready, _, _ = select.select(list(bmcs), [], [])
+            for sock in ready:
+                pkt, addr = sock.recvfrom(1024)
+                bmcs[sock].handle(pkt, addr)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    sys.exit(main())
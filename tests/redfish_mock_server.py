@@ -1,35 +1,172 @@
 #!/usr/bin/env python3
-from http.server import HTTPServer, BaseHTTPRequestHandler
+from http.server import ThreadingHTTPServer, BaseHTTPRequestHandler
 import json
 import base64
+import hashlib
+import secrets
+import sys
+from urllib.parse import urlsplit, parse_qs
+
+SESSIONS_PATH = '/redfish/v1/SessionService/Sessions'
+
+# token -> session id
+sessions = {}
+
+# --expire-tokens：每個 token 只能用這麼多次，之後回 401（像 BMC 的 session timeout）
+TOKEN_USES = 2
+token_uses = {}
+
+# 模擬有問題的 BMC，由命令列參數打開（見 run_server）
+quirks = set()
+
+def make_system(sid, serial):
+    return {
+        "@odata.id": f"/redfish/v1/Systems/{sid}",
+        "Id": sid,
+        "Name": "System",
+        "Manufacturer": "Advantech",
+        "Model": "BMC-Test-System",
+        "SerialNumber": serial,
+        "PowerState": "On",
+        "BiosVersion": "1.0.0",
+        "Links": {"Chassis": [{"@odata.id": "/redfish/v1/Chassis/1"}]}
+    }
+
+SYSTEMS = {sid: make_system(sid, serial)
+           for sid, serial in (("1", "12345678"), ("2", "12345679"), ("3", "12345680"))}
+
+# --big-system：System 1 前面塞 8 MB 的 Oem（裡面有同名欄位、括號、引號），名字帶 escape
+def make_big_system(system):
+    blob = 'x{"[\\]}' * (1 << 20)
+    decoy = {"SerialNumber": "WRONG", "Name": "WRONG", "Status": {"Health": "Critical"}}
+    big = {"@odata.id": system["@odata.id"],
+           "Oem": {"Vendor": dict(decoy, Blob=blob, Nested=[decoy, [decoy], "}"])}}
+    big.update(system)
+    big["Links"] = dict(system["Links"], ManagedBy=[decoy])
+    big["Name"] = 'Big "System" \u00e9'
+    return big
+
+# $select=A,B：只留這些欄位（@odata.id 一定留）
+def select_props(obj, query):
+    if '$select' not in query:
+        return obj
+    props = set(query['$select'][0].split(','))
+    return {k: v for k, v in obj.items() if k in props or k == '@odata.id'}
 
 class RedfishHandler(BaseHTTPRequestHandler):
+    # keep-alive：回應都帶 Content-Length，client 可以一直用同一條連線
+    protocol_version = 'HTTP/1.1'
+    
+    def do_POST(self):
+        if self.path != SESSIONS_PATH:
+            self.send_error(405, 'Method Not Allowed')
+            return
+        
+        length = int(self.headers.get('Content-Length', 0))
+        try:
+            body = json.loads(self.rfile.read(length))
+        except ValueError:
+            self.send_error(400, 'Bad Request')
+            return
+        if body.get('UserName') != 'admin' or body.get('Password') != 'password':
+            self.send_error(401, 'Unauthorized')
+            return
+        
+        session_id = str(len(sessions) + 1)
+        token = secrets.token_hex(16)
+        sessions[token] = session_id
+        uri = f'{SESSIONS_PATH}/{session_id}'
+        
+        self.send_response(201)
+        self.send_header('X-Auth-Token', token)
+        self.send_header('Location', uri)
+        self.send_header('Content-Type', 'application/json')
+        data = json.dumps({"@odata.id": uri, "Id": session_id, "UserName": "admin"}).encode('utf-8')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+    
+    def do_DELETE(self):
+        token = self.headers.get('X-Auth-Token')
+        session_id = sessions.get(token)
+        if session_id is None:
+            self.send_error(401, 'Unauthorized')
+            return
+        if self.path != f'{SESSIONS_PATH}/{session_id}':
+            self.send_error(404, 'Not Found')
+            return
+        
+        del sessions[token]
+        self.send_response(204)
+        self.end_headers()
+    
     def do_GET(self):
+        # 檢查 session token
+        token = self.headers.get('X-Auth-Token')
+        if token is not None and token not in sessions:
+            self.send_error(401, 'Unauthorized')
+            return
+        if token is not None and 'expire-tokens' in quirks:
+            token_uses[token] = token_uses.get(token, 0) + 1
+            if token_uses[token] > TOKEN_USES:
+                del sessions[token]
+                self.send_error(401, 'Unauthorized')
+                return
+        
         # 檢查基本認證
         auth = self.headers.get('Authorization')
         if auth:
             auth_type, credentials = auth.split(' ', 1)
             if auth_type == 'Basic':
+                print(f"[Auth] basic {self.path}")
                 decoded = base64.b64decode(credentials).decode('utf-8')
                 username, password = decoded.split(':', 1)
                 if username != 'admin' or password != 'password':
                     self.send_error(401, 'Unauthorized')
                     return
         
+        url = urlsplit(self.path)
+        query = parse_qs(url.query)
+        path = url.path
+        
+        # 宣稱支援 $expand / $select 但實際上不吃
+        if 'reject-query' in quirks and ('$expand' in query or '$select' in query):
+            self.send_error(400, 'Bad Request')
+            return
+        
         # 處理不同路徑
-        if self.path == '/redfish/v1/Systems/1':
+        if path == '/redfish/v1':
             response = {
-                "Id": "1",
-                "Name": "System",
-                "Manufacturer": "Advantech",
-                "Model": "BMC-Test-System",
-                "SerialNumber": "12345678",
-                "PowerState": "On",
-                "BiosVersion": "1.0.0"
+                "@odata.id": "/redfish/v1",
+                "Id": "RootService",
+                "Systems": {"@odata.id": "/redfish/v1/Systems"},
+                "ProtocolFeaturesSupported": {
+                    "ExpandQuery": {"ExpandAll": True, "Levels": True, "Links": True,
+                                    "NoLinks": True, "MaxLevels": 2},
+                    "SelectQuery": True
+                }
             }
             self.send_json_response(response)
             
-        elif self.path.startswith('/redfish/v1/Chassis/') and self.path.endswith('/Thermal'):
+        elif path == '/redfish/v1/Systems':
+            members = [{"@odata.id": f"/redfish/v1/Systems/{sid}"} for sid in SYSTEMS]
+            # $expand=.($levels=1) 直接把 member 展開
+            if '$expand' in query:
+                members = [select_props(SYSTEMS[sid], query) for sid in SYSTEMS]
+            if 'null-member' in quirks:
+                members = [None] + members + [42]
+            response = {
+                "@odata.id": "/redfish/v1/Systems",
+                "Name": "Computer System Collection",
+                "Members@odata.count": len(members),
+                "Members": members
+            }
+            self.send_json_response(response)
+            
+        elif path.startswith('/redfish/v1/Systems/') and path[len('/redfish/v1/Systems/'):] in SYSTEMS:
+            self.send_json_response(select_props(SYSTEMS[path[len('/redfish/v1/Systems/'):]], query))
+            
+        elif path.startswith('/redfish/v1/Chassis/') and path.endswith('/Thermal'):
             response = {
                 "Id": "Thermal",
                 "Name": "Thermal",
@@ -59,16 +196,30 @@ class RedfishHandler(BaseHTTPRequestHandler):
             self.send_error(404, 'Not Found')
     
     def send_json_response(self, data):
+        body = json.dumps(data, indent=2).encode('utf-8')
+        etag = '"%s"' % hashlib.sha1(body).hexdigest()[:16]
+        
+        # 內容沒變就回 304
+        if self.headers.get('If-None-Match') == etag:
+            self.send_response(304)
+            self.send_header('ETag', etag)
+            self.end_headers()
+            return
+        
         self.send_response(200)
         self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.send_header('ETag', etag)
         self.end_headers()
-        self.wfile.write(json.dumps(data, indent=2).encode('utf-8'))
+        self.wfile.write(body)
     
+    # 帶 client port，測試靠它數用了幾條連線
     def log_message(self, format, *args):
-        print(f"[Redfish] {self.address_string()} - {format % args}")
+        host, port = self.client_address[:2]
+        print(f"[Redfish] {host}:{port} - {format % args}")
 
 def run_server(port=8000):
-    server = HTTPServer(('127.0.0.1', port), RedfishHandler)
+    server = ThreadingHTTPServer(('127.0.0.1', port), RedfishHandler)
     print("=" * 50)
     print(f"Mock Redfish Server running on http://127.0.0.1:{port}")
     print("Username: admin")
@@ -82,4 +233,10 @@ def run_server(port=8000):
         server.shutdown()
 
 if __name__ == '__main__':
-    run_server()
+    # 用法：redfish_mock_server.py [port] [--reject-query] [--null-member] [--expire-tokens]
+    #                              [--big-system]
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    quirks.update(a[2:] for a in sys.argv[1:] if a.startswith('--'))
+    if 'big-system' in quirks:
+        SYSTEMS["1"] = make_big_system(SYSTEMS["1"])
+    run_server(int(args[0]) if args else 8000)
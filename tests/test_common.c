@@ -0,0 +1,91 @@
+#define _GNU_SOURCE
+#include "bmctool/common.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * common/ 的單元測試
+ *
+ * 沒有用測試框架，CHECK 失敗就印出位置、累計失敗數，最後有失敗就回傳 1
+ */
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static void test_error_str(void) {
+    CHECK(strcmp(bmc_error_str(BMC_SUCCESS), "Success") == 0);
+    CHECK(strcmp(bmc_error_str(BMC_ERROR_INVALID_PARAM), "Invalid parameter") == 0);
+    CHECK(strcmp(bmc_error_str(BMC_ERROR_MEMORY), "Memory error") == 0);
+    CHECK(strcmp(bmc_error_str(BMC_ERROR_NETWORK), "Network error") == 0);
+    CHECK(strcmp(bmc_error_str(BMC_ERROR_TIMEOUT), "Timeout") == 0);
+    CHECK(strcmp(bmc_error_str(BMC_ERROR_PROTOCOL), "Protocol error") == 0);
+    CHECK(strcmp(bmc_error_str(-100), "Unknown error") == 0);
+}
+
+static void test_monotonic(void) {
+    uint64_t a = bmc_monotonic_us();
+    usleep(2000);
+    uint64_t b = bmc_monotonic_us();
+    
+    CHECK(b >= a + 1000);
+}
+
+static void test_cache_path(void) {
+    char tmpl[] = "/tmp/bmctool-test-XXXXXX";
+    char* base = mkdtemp(tmpl);
+    CHECK(base != NULL);
+    if (!base) {
+        return;
+    }
+    
+    // 目錄不存在要自己建
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s/sub/cache", base);
+    setenv("BMCTOOL_CACHE_DIR", dir, 1);
+    
+    char path[512];
+    char expect[512];
+    snprintf(expect, sizeof(expect), "%s/sdr.bin", dir);
+    CHECK(bmc_cache_path("sdr.bin", path, sizeof(path)) == BMC_SUCCESS);
+    CHECK(strcmp(path, expect) == 0);
+    
+    struct stat st;
+    CHECK(stat(dir, &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & 0777) == 0700);
+    
+    // buffer 放不下不能回傳截斷的路徑
+    char small[8];
+    CHECK(bmc_cache_path("sdr.bin", small, sizeof(small)) == BMC_ERROR_INVALID_PARAM);
+    CHECK(bmc_cache_path(NULL, path, sizeof(path)) == BMC_ERROR_INVALID_PARAM);
+    CHECK(bmc_cache_path("sdr.bin", path, 0) == BMC_ERROR_INVALID_PARAM);
+    
+    unsetenv("BMCTOOL_CACHE_DIR");
+    rmdir(dir);
+    snprintf(dir, sizeof(dir), "%s/sub", base);
+    rmdir(dir);
+    rmdir(base);
+}
+
+int main(void) {
+    printf("error_str\n");
+    test_error_str();
+    printf("monotonic\n");
+    test_monotonic();
+    printf("cache_path\n");
+    test_cache_path();
+    
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All common tests passed\n");
+    return 0;
+}
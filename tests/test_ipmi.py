@@ -0,0 +1,474 @@
+#!/usr/bin/env python3
+"""
+IPMI 端對端測試
+
+每個測試起一個 ipmi_mock_bmc.py（可以帶參數模擬有問題的 BMC），
+跑 bmctool 再檢查輸出和 mock 收到的命令。
+
+用法：tests/test_ipmi.py [bmctool 路徑]
+"""
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BMCTOOL = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else './bmctool')
+
+NETFN_APP = 0x06
+NETFN_STORAGE = 0x0A
+NETFN_DCGRP = 0x2C
+CMD_GET_DEVICE_ID = 0x01
+CMD_GET_CHANNEL_AUTH_CAP = 0x38
+CMD_SET_SESSION_PRIV = 0x3B
+CMD_ACTIVATE_PAYLOAD = 0x48
+CMD_DEACTIVATE_PAYLOAD = 0x49
+CMD_DCMI_GET_POWER_READING = 0x02
+CMD_GET_FRU_INFO = 0x10
+CMD_READ_FRU_DATA = 0x11
+CMD_GET_SDR_REPO_INFO = 0x20
+CMD_RESERVE_SDR = 0x22
+CMD_GET_SDR = 0x23
+CMD_GET_SEL_INFO = 0x40
+CMD_RESERVE_SEL = 0x42
+CMD_GET_SEL_ENTRY = 0x43
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print(f"  FAIL {what}")
+        failures += 1
+
+
+def free_ports(count):
+    """連續 count 個沒人用的 UDP port"""
+    for _ in range(100):
+        with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+            s.bind(('127.0.0.1', 0))
+            base = s.getsockname()[1]
+        if base + count > 65536:
+            continue
+        try:
+            socks = []
+            for i in range(count):
+                t = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+                socks.append(t)
+                t.bind(('127.0.0.1', base + i))
+            return base
+        except OSError:
+            pass
+        finally:
+            for t in socks:
+                t.close()
+    raise RuntimeError('no free UDP ports')
+
+
+class Mock:
+    """ipmi_mock_bmc.py 子行程；requests() 回傳它收到的 (port, netfn, cmd, data)"""
+
+    def __init__(self, *args, count=1):
+        self.port = free_ports(count)
+        self.dir = tempfile.mkdtemp(prefix='bmctool-ipmi-mock-')
+        self.ctl = os.path.join(self.dir, 'ctl')
+        self.log = tempfile.TemporaryFile(mode='w+')
+        self.proc = subprocess.Popen(
+            [sys.executable, '-u', os.path.join(HERE, 'ipmi_mock_bmc.py'), str(self.port),
+             '--count', str(count), '--ctl', self.ctl, *args],
+            stdout=self.log, stderr=subprocess.STDOUT)
+
+        # UDP 沒辦法 connect 看它起來了沒，等它印出啟動訊息
+        deadline = time.monotonic() + 5
+        while time.monotonic() < deadline:
+            self.log.seek(0)
+            if 'IPMI mock on' in self.log.read():
+                return
+            if self.proc.poll() is not None:
+                break
+            time.sleep(0.05)
+        raise RuntimeError('mock BMC did not start')
+
+    def control(self, line):
+        with open(self.ctl, 'a') as f:
+            f.write(line + '\n')
+
+    def requests(self):
+        self.log.seek(0)
+        reqs = []
+        for line in self.log:
+            words = line.split()
+            if words and words[0] == 'REQ':
+                data = bytes.fromhex(words[4]) if len(words) > 4 else b''
+                reqs.append((int(words[1]), int(words[2], 16), int(words[3], 16), data))
+        return reqs
+
+    def pings(self):
+        self.log.seek(0)
+        return sum(1 for line in self.log if line.startswith('PING '))
+
+    def count(self, netfn, cmd):
+        return sum(1 for r in self.requests() if r[1] == netfn and r[2] == cmd)
+
+    def reset(self):
+        self.log.seek(0)
+        self.log.truncate()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.proc.terminate()
+        self.proc.wait()
+        self.log.close()
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+
+class Env:
+    """每個測試自己的快取目錄"""
+
+    def __enter__(self):
+        self.dir = tempfile.mkdtemp(prefix='bmctool-ipmi-')
+        return self
+
+    def __exit__(self, *exc):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def run(self, mock, *args, opts=(), timeout=60):
+        env = dict(os.environ, BMCTOOL_CACHE_DIR=self.dir)
+        p = subprocess.run([BMCTOOL, '-H', '127.0.0.1', '-p', str(mock.port), '-I', 'lanplus',
+                            '-U', 'admin', '-P', 'secret', *opts, 'ipmi', *args],
+                           env=env, capture_output=True, text=True, timeout=timeout)
+        return p.returncode, p.stdout, p.stderr
+
+    def fleet(self, hosts, *args, opts=(), timeout=60):
+        """hosts 是 (host, port) 清單，寫成 hosts file 給 -F"""
+        path = os.path.join(self.dir, 'hosts')
+        with open(path, 'w') as f:
+            f.writelines(f'{h}:{p}\n' for h, p in hosts)
+        env = dict(os.environ, BMCTOOL_CACHE_DIR=self.dir)
+        p = subprocess.run([BMCTOOL, '-F', path, '-I', 'lanplus', '-U', 'admin', '-P', 'secret',
+                            *opts, 'ipmi', *args],
+                           env=env, capture_output=True, text=True, timeout=timeout)
+        return p.returncode, p.stdout, p.stderr
+
+    def discover(self, mock, cidr, *args, opts=(), timeout=60):
+        p = subprocess.run([BMCTOOL, '-p', str(mock.port), *opts, 'discover', cidr, *args],
+                           capture_output=True, text=True, timeout=timeout)
+        return p.returncode, p.stdout, p.stderr
+
+
+def sel_ids(out):
+    return [int(line.split()[0], 16) for line in out.splitlines() if line.startswith('0x')]
+
+
+def sdr_names(out):
+    return [line.split('  ')[0] for line in out.splitlines()
+            if line.startswith(('Temp ', 'CPU'))]
+
+
+def sdr_names_expected(count):
+    return [f'CPU{i} Status' if i % 2 else f'Temp {i}' for i in range(count)]
+
+
+# ===== user-010：SDR =====
+
+def test_sdr_cache():
+    with Mock('--sdr', '8') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sdr')
+        check(rc == 0 and sdr_names(out) == sdr_names_expected(8), f'sdr exit {rc}: {out} {err}')
+        check(mock.count(NETFN_STORAGE, CMD_GET_SDR) == 8, 'one whole read per record')
+
+        # 時間戳和筆數都沒變：只問 repository info
+        mock.reset()
+        rc, out, err = env.run(mock, 'sdr')
+        check(rc == 0 and '8 (cached)' in out, f'cached run: {out} {err}')
+        check(sdr_names(out) == sdr_names_expected(8), 'cached records')
+        check(mock.count(NETFN_STORAGE, CMD_GET_SDR_REPO_INFO) == 1 and
+              mock.count(NETFN_STORAGE, CMD_GET_SDR) == 0, 'no Get SDR from cache')
+
+        # 新增 record：時間戳變了，重新下載
+        mock.control('sdr-add 2')
+        rc, out, err = env.run(mock, 'sdr')
+        check(rc == 0 and sdr_names(out) == sdr_names_expected(10), f'after add: {out} {err}')
+
+
+def test_sdr_chunks():
+    # BMC 一次最多給 16 bytes：整筆讀失敗，header 之後分段讀，32 被拒就減半
+    with Mock('--sdr', '4', '--sdr-max-read', '16') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sdr')
+        check(rc == 0 and sdr_names(out) == sdr_names_expected(4), f'sdr exit {rc}: {out} {err}')
+        reads = [r[3] for r in mock.requests() if r[1] == NETFN_STORAGE and r[2] == CMD_GET_SDR]
+        whole = [d for d in reads if d[5] == 0xFF]
+        chunks = [d[5] for d in reads if d[4] > 0]
+        check(len(whole) == 1, f'whole read tried once, got {len(whole)}')
+        check(chunks and max(chunks) == 32 and chunks[-1] <= 16, f'chunk sizes {chunks}')
+        check(chunks.count(32) <= 2, f'32-byte chunks not retried per record: {chunks}')
+        check(mock.count(NETFN_STORAGE, CMD_RESERVE_SDR) == 1, 'reserved once')
+
+
+# ===== user-012：SEL =====
+
+def test_sel_whole_reads():
+    # 整筆讀不用 reservation，不能為了它多一個來回
+    with Mock('--sel', '20') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sel', 'all')
+        check(rc == 0, f'sel exit {rc}: {err}')
+        check(sel_ids(out) == list(range(1, 21)), f'20 entries in order: {sel_ids(out)}')
+        check(mock.count(NETFN_STORAGE, CMD_RESERVE_SEL) == 0, 'no Reserve SEL for whole reads')
+        check(mock.count(NETFN_STORAGE, CMD_GET_SEL_ENTRY) == 20, 'one Get SEL Entry per entry')
+
+
+def test_sel_partial_reads():
+    # BMC 不肯整筆讀：reserve 之後分段讀
+    with Mock('--sel', '5', '--sel-partial') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sel', 'all')
+        check(rc == 0, f'sel exit {rc}: {err}')
+        check(sel_ids(out) == list(range(1, 6)), f'5 entries in order: {sel_ids(out)}')
+        check(mock.count(NETFN_STORAGE, CMD_RESERVE_SEL) == 1, 'reserved once')
+        partial = [r for r in mock.requests() if r[1] == NETFN_STORAGE and r[2] == CMD_GET_SEL_ENTRY
+                   and r[3][5] != 0xFF]
+        check(len(partial) == 10, f'two partial reads per entry, got {len(partial)}')
+        check(all(r[3][:2] != b'\0\0' for r in partial), 'partial reads carry the reservation')
+
+
+def test_sel_partial_canceled():
+    # 分段讀到一半 reservation 被 cancel：重新 reserve，整筆重讀
+    with Mock('--sel', '3', '--sel-partial', '--sel-cancel') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sel', 'all')
+        check(rc == 0, f'sel exit {rc}: {err}')
+        check(sel_ids(out) == [1, 2, 3], f'entries after re-reserve: {sel_ids(out)}')
+        check(mock.count(NETFN_STORAGE, CMD_RESERVE_SEL) == 2, 'reserved again after cancel')
+
+
+def test_sel_incremental():
+    with Mock('--sel', '10') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'sel')
+        check(rc == 0 and len(sel_ids(out)) == 10, f'first run: {err}')
+
+        # 沒有新 event：只問 Get SEL Info
+        mock.reset()
+        rc, out, err = env.run(mock, 'sel')
+        check(rc == 0 and 'No new entries' in out, f'second run: {out} {err}')
+        check(mock.count(NETFN_STORAGE, CMD_GET_SEL_ENTRY) == 0, 'nothing read when unchanged')
+
+        # 新增 3 筆：重讀上次最後一筆拿 next，再讀新的
+        mock.control('add 3')
+        mock.reset()
+        rc, out, err = env.run(mock, 'sel')
+        check(sel_ids(out) == [11, 12, 13], f'only new entries: {sel_ids(out)}')
+        check(mock.count(NETFN_STORAGE, CMD_GET_SEL_ENTRY) == 4, 'last entry + 3 new')
+
+        # 繞回：上次最後一筆還在但前面的被蓋掉，仍然只給新的
+        mock.control('wrap 2')
+        rc, out, err = env.run(mock, 'sel')
+        check(sel_ids(out) == [14, 15], f'after wrap: {sel_ids(out)}')
+
+        # 清掉：從頭讀
+        mock.control('clear')
+        mock.control('add 1')
+        rc, out, err = env.run(mock, 'sel')
+        check(sel_ids(out) == [16], f'after clear: {sel_ids(out)}')
+
+
+# ===== user-008：fleet 登入 =====
+
+def test_fleet_login():
+    # 全部登入完才開始送命令
+    with Mock(count=4) as mock, Env() as env:
+        hosts = [('127.0.0.1', mock.port + i) for i in range(4)]
+        rc, out, err = env.fleet(hosts, 'get-device-id')
+        check(rc == 0 and '4/4 hosts responded' in out, f'fleet exit {rc}: {out} {err}')
+        order = [(r[1], r[2]) for r in mock.requests()]
+        priv = [i for i, r in enumerate(order) if r == (NETFN_APP, CMD_SET_SESSION_PRIV)]
+        dev = [i for i, r in enumerate(order) if r == (NETFN_APP, CMD_GET_DEVICE_ID)]
+        check(len(priv) == 4 and len(dev) == 4, f'4 logins and 4 commands: {order}')
+        check(priv and dev and max(priv) < min(dev), 'sessions attached before submitting')
+
+
+def test_fleet_login_concurrent():
+    # 不回應的 BMC 一起等，總時間不是台數 x timeout
+    silent = []
+    try:
+        for _ in range(4):
+            s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            s.bind(('127.0.0.1', 0))
+            silent.append(s)
+        with Mock(count=2) as mock, Env() as env:
+            hosts = [('127.0.0.1', mock.port), ('127.0.0.1', mock.port + 1)]
+            hosts += [s.getsockname() for s in silent]
+            start = time.monotonic()
+            rc, out, err = env.fleet(hosts, 'get-device-id', opts=('-t', '1000', '-R', '1'))
+            elapsed = time.monotonic() - start
+            check(rc != 0 and '2/6 hosts responded' in out, f'fleet exit {rc}: {out} {err}')
+            check(out.count('Session setup failed') == 4, f'silent hosts reported: {out}')
+            check(elapsed < 3, f'logins ran concurrently: {elapsed:.1f} s')
+    finally:
+        for s in silent:
+            s.close()
+
+
+# ===== user-013：FRU =====
+
+def fru_reads(mock):
+    return [r[3][3] for r in mock.requests() if r[1] == NETFN_STORAGE and r[2] == CMD_READ_FRU_DATA]
+
+
+def test_fru_chunk_shrink():
+    # BMC 只收 64 bytes 以內：224、112 被 0xC7 拒絕，減到 56 讀完
+    with Mock('--fru-max-read', '64') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'fru')
+        check(rc == 0 and 'PRD0001' in out and 'ASSET42' in out, f'fru exit {rc}: {out} {err}')
+        reads = fru_reads(mock)
+        check(reads[:3] == [8, 224, 224] and 112 in reads, f'chunk sizes {reads}')
+        last = len(reads) - reads[::-1].index(112)
+        check(reads[last:] and all(n == 56 for n in reads[last:]), f'settled on 56: {reads}')
+
+        # 內容沒變：只讀 common header
+        mock.reset()
+        rc, out, err = env.run(mock, 'fru')
+        check(rc == 0 and '(cached)' in out and 'PRD0001' in out, f'cached run: {out} {err}')
+        check(fru_reads(mock) == [8], f'cached reads {fru_reads(mock)}')
+
+        # serial 變長，area offset 跟著變：重讀，直接用快取記下的 56，不再被拒
+        mock.control('fru-serial 0002-REV-B')
+        mock.reset()
+        rc, out, err = env.run(mock, 'fru')
+        check(rc == 0 and '(cached)' not in out and 'PRD0002-REV-B' in out, f'after change: {out} {err}')
+        reads = fru_reads(mock)
+        check(len(reads) > 1 and max(reads) <= 56, f'remembered chunk: {reads}')
+
+
+# ===== user-014：power 取樣 =====
+
+def test_power_sample():
+    # 兩台 BMC 加一台不回的：不回的登入失敗不取樣，另外兩台每個 tick 各一筆
+    silent = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    silent.bind(('127.0.0.1', 0))
+    try:
+        with Mock(count=2) as mock, Env() as env:
+            hosts = [('127.0.0.1', mock.port), ('127.0.0.1', mock.port + 1), silent.getsockname()]
+            rc, out, err = env.fleet(hosts, 'power-sample', '50', '10', 'csv',
+                                     opts=('-t', '500', '-R', '1'))
+            check(rc == 0, f'power-sample exit {rc}: {err}')
+            check('not sampled' in err, f'silent host skipped: {err}')
+
+            lines = out.splitlines()
+            check(lines[0] == 't_us,tick,host,watts,status,cc,latency_us', f'csv header {lines[:1]}')
+            rows = [line.split(',') for line in lines[1:]]
+            check(len(rows) == 20, f'{len(rows)} samples')
+            for port, watts in ((mock.port, '100'), (mock.port + 1, '110')):
+                mine = [r for r in rows if r[2].endswith(str(port))]
+                check(sorted(int(r[1]) for r in mine) == list(range(10)), f'ticks for {port}')
+                check(all(r[3] == watts and r[4] == 'ok' for r in mine), f'readings for {port}')
+
+            # tick 照 50 ms 排，不會因為回應快就擠在一起
+            last = max(int(r[0]) for r in rows)
+            check(last >= 9 * 50000, f'last sample at {last} us')
+            check(mock.count(NETFN_DCGRP, CMD_DCMI_GET_POWER_READING) == 20, 'one request per tick')
+    finally:
+        silent.close()
+
+
+# ===== user-016：discover =====
+
+def discovered(out):
+    return [line.split() for line in out.splitlines() if line.startswith('127.')]
+
+
+def test_discover_auth():
+    # 127.0.0.0/29 的 6 個位址只有 mock 綁的 127.0.0.1 會回；回了的不再 ping 第二輪
+    with Mock() as mock, Env() as env:
+        rc, out, err = env.discover(mock, '127.0.0.0/29', 'auth', opts=('-t', '300', '-R', '1'))
+        check(rc == 0 and '1/6 addresses answered' in out, f'discover exit {rc}: {out} {err}')
+        rows = discovered(out)
+        check(len(rows) == 1 and rows[0][0] == '127.0.0.1', f'hosts {rows}')
+        check(rows and rows[0][3] == 'yes' and rows[0][4] == '1.5/2.0', f'row {rows}')
+        check(rows and 'md5,password' in rows[0] and 'user' in rows[0], f'auth/login {rows}')
+        check(mock.pings() == 1, f'{mock.pings()} pings to the live host')
+        check(mock.count(NETFN_APP, CMD_GET_CHANNEL_AUTH_CAP) == 1, 'one auth caps probe')
+
+
+def test_discover_ipmi15_fallback():
+    # 只懂 1.5 的 BMC 對 bit 7 回 0xCC：改用 1.5 的問法再問
+    with Mock('--ipmi15-only') as mock, Env() as env:
+        rc, out, err = env.discover(mock, '127.0.0.1/32', 'auth')
+        rows = discovered(out)
+        check(rc == 0 and len(rows) == 1 and rows[0][4] == '1.5', f'discover: {out} {err}')
+        probes = [r[3] for r in mock.requests() if r[2] == CMD_GET_CHANNEL_AUTH_CAP]
+        check(probes == [bytes([0x8E, 0x04]), bytes([0x0E, 0x04])], f'probes {probes}')
+
+
+# ===== user-017：SOL =====
+
+def sol_console(port, lines):
+    return ''.join(f'port {port} console line {i:04d}\r\n' for i in range(lines))
+
+
+def test_sol_capture():
+    # 每包都送兩次：重複的只再 ACK，不寫進 log；seq 繞回 15 之後照樣收
+    with Mock('--sol-lines', '40', '--sol-dup', count=2) as mock, Env() as env:
+        hosts = [('127.0.0.1', mock.port), ('127.0.0.1', mock.port + 1)]
+        rc, out, err = env.fleet(hosts, 'sol', env.dir, '1')
+        check(rc == 0 and '2/2 consoles captured' in out, f'sol exit {rc}: {out} {err}')
+        for port in (mock.port, mock.port + 1):
+            with open(os.path.join(env.dir, f'127.0.0.1-{port}.log'), newline='') as f:
+                check(f.read() == sol_console(port, 40), f'console log for {port}')
+        check(out.count('1200 bytes, 24 packets, 24 dup, 0 nack') == 2, f'stats: {out}')
+        check(mock.count(NETFN_APP, CMD_ACTIVATE_PAYLOAD) == 2 and
+              mock.count(NETFN_APP, CMD_DEACTIVATE_PAYLOAD) == 2, 'activated and closed')
+
+
+def test_sol_busy_force():
+    # 別的 session 開著 SOL：沒有 force 就失敗；有 force 先 deactivate 再 activate
+    with Mock('--sol-lines', '4', '--sol-busy') as mock, Env() as env:
+        hosts = [('127.0.0.1', mock.port)]
+        rc, out, err = env.fleet(hosts, 'sol', env.dir, '1')
+        check(rc != 0 and 'cc 0x80, in use; try force' in out, f'busy: {out} {err}')
+
+        mock.reset()
+        rc, out, err = env.fleet(hosts, 'sol', env.dir, '1', 'force')
+        check(rc == 0 and '1/1 consoles captured' in out, f'force: {out} {err}')
+        cmds = [r[2] for r in mock.requests() if r[2] in (CMD_ACTIVATE_PAYLOAD, CMD_DEACTIVATE_PAYLOAD)]
+        check(cmds == [CMD_ACTIVATE_PAYLOAD, CMD_DEACTIVATE_PAYLOAD, CMD_ACTIVATE_PAYLOAD,
+                       CMD_DEACTIVATE_PAYLOAD], f'force sequence {cmds}')
+        with open(os.path.join(env.dir, f'127.0.0.1-{mock.port}.log'), newline='') as f:
+            check(f.read() == sol_console(mock.port, 4), 'console log after force')
+
+
+TESTS = [
+    test_sdr_cache,
+    test_sdr_chunks,
+    test_sel_whole_reads,
+    test_sel_partial_reads,
+    test_sel_partial_canceled,
+    test_sel_incremental,
+    test_fleet_login,
+    test_fleet_login_concurrent,
+    test_fru_chunk_shrink,
+    test_power_sample,
+    test_discover_auth,
+    test_discover_ipmi15_fallback,
+    test_sol_capture,
+    test_sol_busy_force,
+]
+
+
+def main():
+    for t in TESTS:
+        print(t.__name__[5:])
+        t()
+
+    if failures:
+        print(f"{failures} check(s) failed")
+        return 1
+    print("All IPMI tests passed")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
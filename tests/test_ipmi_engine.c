@@ -0,0 +1,565 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi_engine.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/*
+ * ipmi_engine 的測試
+ *
+ * 同一個 process 裡開一個 responder thread 當 BMC（IPMI 1.5、不認證），
+ * 收到的 request 先攢著，socket 空了才倒過來一起回，回應順序跟送出順序不同；
+ * Send Message 先回 ack，satellite 的回應在同一批的最後才送。
+ */
+
+#define RESP_PKT_SIZE           512
+#define RESP_MAX_HELD           64
+
+// IPMI 1.5 封包裡 message 的位置（RMCP 4 + session 9 + 長度 1）
+#define MSG_OFF                 14
+
+#define ME_ADDR                 0x2C
+#define ME_CHANNEL              6
+#define CC_BRIDGE_NAK           0x83    // Send Message：目的位址 NAK
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+typedef struct {
+    uint8_t pkt[RESP_PKT_SIZE];
+    size_t len;
+    struct sockaddr_in from;
+} held_req_t;
+
+typedef struct {
+    int fd;
+    uint16_t port;
+    pthread_t thread;
+    volatile int stop;
+    uint8_t bias;                // 加在 BMC 自己的 sensor 讀值上，分辨是哪一台回的
+    int settle_us;               // 收到第一個封包後等一下再收，讓同一批一起到
+    volatile int drop;           // 接下來這麼多個封包收了不回（模擬掉包）
+    int max_held;                // 一批最多收到幾個（= 同時在路上的 request 數）
+    int dup_seq;                 // 同一批裡出現重複的 rqSeq
+    unsigned long requests;
+    unsigned long bridged;
+    held_req_t held[RESP_MAX_HELD];
+} responder_t;
+
+typedef struct {
+    int done;
+    int status;
+    uint8_t cmd;
+    uint8_t data[8];
+    size_t data_len;
+} result_t;
+
+/* ===== Responder ===== */
+
+/*
+ * 依 request message（rsSA ~ checksum）的 header 組回應 message 到 out，回傳長度
+ * 地址對調、netFn + 1、seq 和 cmd 照抄
+ */
+static size_t reply_msg(const uint8_t* req, const uint8_t* data, size_t data_len, uint8_t* out) {
+    out[0] = req[3];
+    out[1] = (uint8_t)((((req[1] >> 2) | 1) << 2) | (req[4] & 0x03));
+    out[2] = ipmi_checksum(out, 2);
+    out[3] = req[0];
+    out[4] = req[4] & 0xFC;
+    out[5] = req[5];
+    memcpy(out + 6, data, data_len);
+    out[6 + data_len] = ipmi_checksum(out + 3, 3 + data_len);
+    
+    return 7 + data_len;
+}
+
+static void send_reply(responder_t* r, const held_req_t* h, const uint8_t* data, size_t data_len) {
+    uint8_t pkt[RESP_PKT_SIZE];
+    
+    memcpy(pkt, h->pkt, MSG_OFF);
+    size_t len = reply_msg(h->pkt + MSG_OFF, data, data_len, pkt + MSG_OFF);
+    pkt[MSG_OFF - 1] = (uint8_t)len;
+    sendto(r->fd, pkt, MSG_OFF + len, 0, (const struct sockaddr*)&h->from, sizeof(h->from));
+}
+
+// Get Sensor Reading 的讀值跟 sensor 號碼和回應的人綁在一起，拿來驗證對回了哪一個
+static uint8_t sensor_value(uint8_t addr, uint8_t sensor) {
+    return (uint8_t)(addr == ME_ADDR ? sensor * 3 + 40 : sensor * 7 + 25);
+}
+
+static void answer(responder_t* r, const held_req_t* h, int embedded) {
+    const uint8_t* msg = h->pkt + MSG_OFF;
+    uint8_t netfn = msg[1] >> 2;
+    uint8_t cmd = msg[5];
+    const uint8_t* data = msg + 6;
+    size_t data_len = h->pkt[MSG_OFF - 1] - 7;
+    uint8_t rsp[RESP_PKT_SIZE];
+    
+    if (netfn == IPMI_NETFN_APP && cmd == IPMI_CMD_SEND_MESSAGE) {
+        const uint8_t* inner = data + 1;
+        // 轉送不出去就只有外層的 NAK，不會有 satellite 的回應
+        if ((data[0] & 0x0F) != ME_CHANNEL || inner[0] != ME_ADDR) {
+            if (!embedded) {
+                rsp[0] = CC_BRIDGE_NAK;
+                send_reply(r, h, rsp, 1);
+            }
+            return;
+        }
+        if (!embedded) {
+            rsp[0] = 0x00;
+            send_reply(r, h, rsp, 1);
+            return;
+        }
+        
+        uint8_t sat[4] = { 0x00, sensor_value(ME_ADDR, inner[6]), 0xC0, 0xC0 };
+        rsp[0] = 0x00;
+        size_t len = reply_msg(inner, sat, sizeof(sat), rsp + 1);
+        send_reply(r, h, rsp, 1 + len);
+        return;
+    }
+    
+    if (netfn == IPMI_NETFN_SENSOR && cmd == IPMI_CMD_GET_SENSOR_READING && data_len >= 1) {
+        uint8_t d[4] = { 0x00, (uint8_t)(sensor_value(IPMI_BMC_SLAVE_ADDR, data[0]) + r->bias),
+                         0xC0, 0xC0 };
+        send_reply(r, h, d, sizeof(d));
+        return;
+    }
+    
+    if (netfn == IPMI_NETFN_APP && cmd == IPMI_CMD_GET_DEVICE_ID) {
+        static const uint8_t id[] = { 0x00, 0x20, 0x81, 0x02, 0x10, 0x02, 0xBF, 0x57, 0x01,
+                                      0x00, 0x10, 0x00 };
+        send_reply(r, h, id, sizeof(id));
+        return;
+    }
+    
+    rsp[0] = 0xC1;
+    send_reply(r, h, rsp, 1);
+}
+
+static int is_bridged(const held_req_t* h) {
+    const uint8_t* msg = h->pkt + MSG_OFF;
+    return (msg[1] >> 2) == IPMI_NETFN_APP && msg[5] == IPMI_CMD_SEND_MESSAGE;
+}
+
+static uint8_t held_seq(const held_req_t* h) {
+    return h->pkt[MSG_OFF + 4] >> 2;
+}
+
+static void* responder_main(void* arg) {
+    responder_t* r = arg;
+    struct pollfd pfd = { .fd = r->fd, .events = POLLIN };
+    
+    while (!r->stop) {
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        if (r->settle_us > 0) {
+            usleep((useconds_t)r->settle_us);
+        }
+        
+        // 把 socket 收乾淨
+        int n = 0;
+        while (n < RESP_MAX_HELD) {
+            held_req_t* h = &r->held[n];
+            socklen_t fromlen = sizeof(h->from);
+            ssize_t len = recvfrom(r->fd, h->pkt, sizeof(h->pkt), MSG_DONTWAIT,
+                                   (struct sockaddr*)&h->from, &fromlen);
+            if (len < 0) {
+                break;
+            }
+            if ((size_t)len < MSG_OFF + 7 || h->pkt[4] != IPMI_AUTH_TYPE_NONE) {
+                continue;
+            }
+            if (r->drop > 0) {
+                r->drop--;
+                continue;
+            }
+            h->len = (size_t)len;
+            n++;
+        }
+        r->requests += (unsigned long)n;
+        if (n > r->max_held) {
+            r->max_held = n;
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                r->dup_seq |= held_seq(&r->held[i]) == held_seq(&r->held[j]);
+            }
+        }
+        
+        // 倒過來回；橋接的先只回 ack，satellite 的回應最後才到
+        for (int i = n - 1; i >= 0; i--) {
+            answer(r, &r->held[i], 0);
+        }
+        for (int i = 0; i < n; i++) {
+            if (is_bridged(&r->held[i])) {
+                r->bridged++;
+                answer(r, &r->held[i], 1);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+static int responder_start(responder_t* r) {
+    memset(r, 0, sizeof(*r));
+    
+    struct sockaddr_in sin = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t len = sizeof(sin);
+    r->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (r->fd < 0 || bind(r->fd, (struct sockaddr*)&sin, sizeof(sin)) < 0 ||
+        getsockname(r->fd, (struct sockaddr*)&sin, &len) < 0) {
+        printf("responder socket: %s\n", strerror(errno));
+        return -1;
+    }
+    r->port = ntohs(sin.sin_port);
+    
+    return pthread_create(&r->thread, NULL, responder_main, r) == 0 ? 0 : -1;
+}
+
+static void responder_stop(responder_t* r) {
+    r->stop = 1;
+    pthread_join(r->thread, NULL);
+    close(r->fd);
+}
+
+/* ===== Engine ===== */
+
+static void on_done(ipmi_engine_t* eng, int target, int status,
+                    const ipmi_rsp_view_t* rsp, void* user_data) {
+    result_t* res = user_data;
+    (void)eng;
+    (void)target;
+    
+    res->done++;
+    res->status = status;
+    if (rsp) {
+        res->cmd = rsp->cmd;
+        res->data_len = rsp->data_len < sizeof(res->data) ? rsp->data_len : sizeof(res->data);
+        memcpy(res->data, rsp->data, res->data_len);
+    }
+}
+
+static ipmi_engine_t* engine_for(const responder_t* r, int depth, int* target) {
+    ipmi_engine_t* eng = ipmi_engine_create(1);
+    if (!eng) {
+        return NULL;
+    }
+    
+    ipmi_engine_set_depth(eng, depth);
+    ipmi_engine_set_timeout(eng, 2000);
+    *target = ipmi_engine_add_target(eng, "127.0.0.1", r->port);
+    if (*target < 0) {
+        ipmi_engine_destroy(eng);
+        return NULL;
+    }
+    
+    return eng;
+}
+
+// 對 target 送 count 個 Get Sensor Reading，sensor 號碼從 first 開始
+static void submit_reads(ipmi_engine_t* eng, int target, uint8_t first, int count, result_t* res) {
+    for (int i = 0; i < count; i++) {
+        ipmi_msg_t req = { .netfn = IPMI_NETFN_SENSOR, .cmd = IPMI_CMD_GET_SENSOR_READING,
+                           .data = { (uint8_t)(first + i) }, .data_len = 1 };
+        memset(&res[i], 0, sizeof(res[i]));
+        CHECK(ipmi_engine_submit(eng, target, &req, on_done, &res[i]) == BMC_SUCCESS);
+    }
+}
+
+// 每個 request 剛好完成一次，讀值是 bias 那台 responder 回的
+static int reads_ok(const result_t* res, uint8_t first, int count, uint8_t bias) {
+    for (int i = 0; i < count; i++) {
+        uint8_t want = (uint8_t)(sensor_value(IPMI_BMC_SLAVE_ADDR, (uint8_t)(first + i)) + bias);
+        if (res[i].done != 1 || res[i].status != BMC_SUCCESS ||
+            res[i].cmd != IPMI_CMD_GET_SENSOR_READING || res[i].data_len != 4 ||
+            res[i].data[1] != want) {
+            printf("  request %d: done=%d status=%d value=%u (want %u)\n", i, res[i].done,
+                   res[i].status, res[i].data_len > 1 ? res[i].data[1] : 0, want);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ===== 多台 BMC 共用一個 socket（user-001） ===== */
+
+static void test_targets(void) {
+    enum { TARGETS = 3, PER_TARGET = 20 };
+    responder_t r[TARGETS];
+    result_t res[TARGETS][PER_TARGET];
+    int targets[TARGETS];
+    
+    ipmi_engine_t* eng = ipmi_engine_create(1);
+    CHECK(eng != NULL);
+    if (!eng) {
+        return;
+    }
+    ipmi_engine_set_timeout(eng, 2000);
+    
+    // 回應從哪個位址來決定是哪一台，socket 只有一個
+    int started = 0;
+    while (started < TARGETS && responder_start(&r[started]) == 0) {
+        r[started].bias = (uint8_t)(started * 50);
+        targets[started] = ipmi_engine_add_target(eng, "127.0.0.1", r[started].port);
+        CHECK(targets[started] == started);
+        started++;
+    }
+    CHECK(started == TARGETS);
+    
+    for (int t = 0; t < started; t++) {
+        submit_reads(eng, targets[t], (uint8_t)(t * PER_TARGET), PER_TARGET, res[t]);
+    }
+    CHECK(ipmi_engine_pending(eng) == (size_t)(started * PER_TARGET));
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    
+    for (int t = 0; t < started; t++) {
+        CHECK(reads_ok(res[t], (uint8_t)(t * PER_TARGET), PER_TARGET, r[t].bias));
+        CHECK(r[t].requests == PER_TARGET);
+    }
+    
+    ipmi_engine_stats_t st;
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.received == (unsigned long)(started * PER_TARGET) && st.stale == 0);
+    
+    ipmi_engine_destroy(eng);
+    for (int t = 0; t < started; t++) {
+        responder_stop(&r[t]);
+    }
+}
+
+/* ===== 每台 BMC 的 rqSeq window（user-002） ===== */
+
+static void test_window(void) {
+    enum { DEPTH = 4, COUNT = 40 };
+    responder_t r;
+    result_t res[COUNT];
+    
+    if (responder_start(&r) != 0) {
+        g_failures++;
+        return;
+    }
+    r.settle_us = 20000;
+    
+    int target;
+    ipmi_engine_t* eng = engine_for(&r, DEPTH, &target);
+    CHECK(eng != NULL);
+    if (!eng) {
+        responder_stop(&r);
+        return;
+    }
+    
+    // 一次在路上的剛好是 depth 個，rqSeq 不重複；回應倒過來回也要對回原本的 request
+    submit_reads(eng, target, 0, COUNT, res);
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    CHECK(reads_ok(res, 0, COUNT, 0));
+    CHECK(r.max_held == DEPTH);
+    CHECK(!r.dup_seq);
+    
+    ipmi_engine_stats_t st;
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.received == COUNT && st.stale == 0 && st.retransmits == 0);
+    
+    // rqSeq 用完一輪（6 bits）之後還是對得上
+    submit_reads(eng, target, 100, COUNT, res);
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    CHECK(reads_ok(res, 100, COUNT, 0));
+    CHECK(r.max_held == DEPTH && !r.dup_seq);
+    
+    ipmi_engine_destroy(eng);
+    responder_stop(&r);
+}
+
+/* ===== 依 RTT 重送（user-003） ===== */
+
+static void test_retransmit(void) {
+    responder_t r;
+    result_t res[8];
+    
+    if (responder_start(&r) != 0) {
+        g_failures++;
+        return;
+    }
+    
+    int target;
+    ipmi_engine_t* eng = engine_for(&r, 1, &target);
+    CHECK(eng != NULL);
+    if (!eng) {
+        responder_stop(&r);
+        return;
+    }
+    ipmi_engine_set_retries(eng, 3);
+    
+    // 先有 RTT 樣本，RTO 從預設的 1 秒降到下限
+    submit_reads(eng, target, 0, 8, res);
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    CHECK(reads_ok(res, 0, 8, 0));
+    
+    // 掉兩個包：重送兩次就回來，等的是 RTO（50 + 100 ms backoff）而不是 1 秒
+    r.drop = 2;
+    submit_reads(eng, target, 8, 1, res);
+    uint64_t start = bmc_monotonic_us();
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    uint64_t elapsed_ms = (bmc_monotonic_us() - start) / 1000;
+    CHECK(reads_ok(res, 8, 1, 0));
+    CHECK(elapsed_ms < 1000);
+    
+    ipmi_engine_stats_t st;
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.retransmits == 2 && st.timeouts == 0);
+    
+    // 一直沒回應：重送用完回 timeout，callback 還是只叫一次
+    r.drop = 1000;
+    ipmi_engine_set_retries(eng, 2);
+    submit_reads(eng, target, 9, 1, res);
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    CHECK(res[0].done == 1 && res[0].status == BMC_ERROR_TIMEOUT);
+    
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.retransmits == 4 && st.timeouts == 1);
+    
+    ipmi_engine_destroy(eng);
+    responder_stop(&r);
+}
+
+/* ===== sendmmsg / recvmmsg 批次（user-005） ===== */
+
+// 跑 count 個 request，回傳用了幾次 syscall
+static unsigned long sweep_syscalls(responder_t* r, int batch_size, int count, result_t* res) {
+    int target;
+    ipmi_engine_t* eng = engine_for(r, 32, &target);
+    if (!eng) {
+        return 0;
+    }
+    CHECK(ipmi_engine_set_batch_size(eng, batch_size) == BMC_SUCCESS);
+    
+    submit_reads(eng, target, 0, count, res);
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    CHECK(reads_ok(res, 0, count, 0));
+    
+    ipmi_engine_stats_t st;
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.sent == (unsigned long)count && st.received == (unsigned long)count);
+    
+    ipmi_engine_destroy(eng);
+    return st.syscalls;
+}
+
+static void test_batching(void) {
+    enum { COUNT = 128 };
+    responder_t r;
+    result_t res[COUNT];
+    
+    if (responder_start(&r) != 0) {
+        g_failures++;
+        return;
+    }
+    r.settle_us = 5000;
+    
+    // 一次一個：每個封包至少一次 send 一次 recv；批次時一整個 window 一次 syscall
+    unsigned long single = sweep_syscalls(&r, 1, COUNT, res);
+    unsigned long batched = sweep_syscalls(&r, 64, COUNT, res);
+    CHECK(single >= 2 * COUNT);
+    CHECK(batched > 0 && batched * 4 < single);
+    
+    responder_stop(&r);
+}
+
+/* ===== 橋接（user-015） ===== */
+
+static void test_bridged(void) {
+    responder_t r;
+    if (responder_start(&r) != 0) {
+        g_failures++;
+        return;
+    }
+    
+    int target;
+    ipmi_engine_t* eng = engine_for(&r, 8, &target);
+    CHECK(eng != NULL);
+    if (!eng) {
+        responder_stop(&r);
+        return;
+    }
+    
+    // 同一台 BMC 上，給 ME 的和給 BMC 自己的 Get Sensor Reading 混在一起 pipeline
+    enum { N = 6 };
+    result_t res[N];
+    result_t nak;
+    memset(res, 0, sizeof(res));
+    memset(&nak, 0, sizeof(nak));
+    
+    for (int i = 0; i < N; i++) {
+        ipmi_msg_t req = { .netfn = IPMI_NETFN_SENSOR, .cmd = IPMI_CMD_GET_SENSOR_READING,
+                           .data = { (uint8_t)(0x10 + i) }, .data_len = 1 };
+        if (i % 2 == 0) {
+            req.target_addr = ME_ADDR;
+            req.channel = ME_CHANNEL;
+        }
+        CHECK(ipmi_engine_submit(eng, target, &req, on_done, &res[i]) == BMC_SUCCESS);
+    }
+    
+    // BMC 轉送失敗：外層的 completion code 要交給 callback
+    ipmi_msg_t bad = { .netfn = IPMI_NETFN_SENSOR, .cmd = IPMI_CMD_GET_SENSOR_READING,
+                       .target_addr = 0x30, .channel = ME_CHANNEL, .data = { 0x01 }, .data_len = 1 };
+    CHECK(ipmi_engine_submit(eng, target, &bad, on_done, &nak) == BMC_SUCCESS);
+    
+    CHECK(ipmi_engine_run(eng, 5000) == 0);
+    
+    for (int i = 0; i < N; i++) {
+        uint8_t addr = i % 2 == 0 ? ME_ADDR : IPMI_BMC_SLAVE_ADDR;
+        CHECK(res[i].done == 1 && res[i].status == BMC_SUCCESS);
+        CHECK(res[i].cmd == IPMI_CMD_GET_SENSOR_READING);
+        CHECK(res[i].data_len == 4 && res[i].data[0] == 0x00 &&
+              res[i].data[1] == sensor_value(addr, (uint8_t)(0x10 + i)));
+    }
+    CHECK(nak.done == 1 && nak.status == BMC_SUCCESS);
+    CHECK(nak.cmd == IPMI_CMD_SEND_MESSAGE && nak.data_len == 1 && nak.data[0] == CC_BRIDGE_NAK);
+    
+    // ack 不算回應，也不算 stale；沒有重送
+    ipmi_engine_stats_t st;
+    ipmi_engine_get_stats(eng, &st);
+    CHECK(st.received == N + 1 && st.stale == 0 && st.retransmits == 0);
+    CHECK(r.bridged == N / 2 + 1);
+    
+    ipmi_engine_destroy(eng);
+    responder_stop(&r);
+}
+
+int main(void) {
+    printf("targets\n");
+    test_targets();
+    
+    printf("window\n");
+    test_window();
+    
+    printf("retransmit\n");
+    test_retransmit();
+    
+    printf("batching\n");
+    test_batching();
+    
+    printf("bridged\n");
+    test_bridged();
+    
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All IPMI engine tests passed\n");
+    return 0;
+}
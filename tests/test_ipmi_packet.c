@@ -0,0 +1,466 @@
+#define _GNU_SOURCE
+#include "bmctool/ipmi.h"
+#include "bmctool/ipmi_session.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * IPMI 封包、rqSeq 視窗、橋接和 RMCP+ session 的回歸測試
+ *
+ * 金鑰的預期值是用 Python hmac 模組照 IPMI 2.0 規格 13.31 / 13.32 另外算的，
+ * 不是從這份程式碼印出來的
+ */
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+// 組一個 IPMI message（rsAddr 到 data checksum），回傳長度
+static size_t build_msg(uint8_t* out, uint8_t netfn, uint8_t rs_addr, uint8_t seq, uint8_t cmd,
+                        const uint8_t* data, size_t data_len) {
+    out[0] = IPMI_REMOTE_SWID;
+    out[1] = (uint8_t)(netfn << 2);
+    out[2] = ipmi_checksum(out, 2);
+    out[3] = rs_addr;
+    out[4] = (uint8_t)(seq << 2);
+    out[5] = cmd;
+    if (data_len) {
+        memcpy(out + 6, data, data_len);
+    }
+    out[6 + data_len] = ipmi_checksum(out + 3, 3 + data_len);
+    
+    return 7 + data_len;
+}
+
+/* ===== ipmi_msg_view / ipmi_rsp_view / ipmi_rsp_copy ===== */
+
+static void test_msg_view(void) {
+    uint8_t msg[300];
+    ipmi_rsp_view_t view;
+    const uint8_t data[] = { 0x00, 0x20, 0x81 };
+    
+    size_t len = build_msg(msg, (IPMI_NETFN_APP | 1), IPMI_BMC_SLAVE_ADDR, 9, 0x01,
+                           data, sizeof(data));
+    CHECK(ipmi_msg_view(msg, len, &view) == BMC_SUCCESS);
+    CHECK(view.netfn == (IPMI_NETFN_APP | 1) && view.cmd == 0x01 && view.seq == 9);
+    CHECK(view.data == msg + 6 && view.data_len == sizeof(data));
+    
+    // 少於 header + checksum 的長度不能往下減成很大的 data_len；全 0 的 checksum 也是對的
+    uint8_t zero[8] = {0};
+    for (size_t n = 0; n < 7; n++) {
+        CHECK(ipmi_msg_view(zero, n, &view) == BMC_ERROR_PROTOCOL);
+    }
+    CHECK(ipmi_msg_view(zero, 7, &view) == BMC_SUCCESS && view.data_len == 0);
+    
+    // checksum 錯
+    msg[2] ^= 0x01;
+    CHECK(ipmi_msg_view(msg, len, &view) == BMC_ERROR_PROTOCOL);
+    msg[2] ^= 0x01;
+    msg[len - 1] ^= 0x01;
+    CHECK(ipmi_msg_view(msg, len, &view) == BMC_ERROR_PROTOCOL);
+    
+    // payload 剛好 IPMI_MAX_DATA_SIZE 可以，多 1 byte 就不收（RMCP+ 的長度是 16 bits）
+    uint8_t big[IPMI_MAX_DATA_SIZE + 1];
+    memset(big, 0x5A, sizeof(big));
+    len = build_msg(msg, (IPMI_NETFN_APP | 1), IPMI_BMC_SLAVE_ADDR, 1, 0x01, big, IPMI_MAX_DATA_SIZE);
+    CHECK(ipmi_msg_view(msg, len, &view) == BMC_SUCCESS && view.data_len == IPMI_MAX_DATA_SIZE);
+    len = build_msg(msg, (IPMI_NETFN_APP | 1), IPMI_BMC_SLAVE_ADDR, 1, 0x01, big, sizeof(big));
+    CHECK(ipmi_msg_view(msg, len, &view) == BMC_ERROR_PROTOCOL);
+}
+
+static void test_rsp_view(void) {
+    uint8_t pkt[64] = { RMCP_VERSION_1_0, 0x00, RMCP_SEQUENCE_NO_ACK, RMCP_CLASS_IPMI,
+                        IPMI_AUTH_TYPE_NONE, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const size_t off = 14;   // RMCP(4) + session(9) + msg_len(1)
+    const uint8_t data[] = { 0x00 };
+    ipmi_rsp_view_t view;
+    
+    size_t msg_len = build_msg(pkt + off, (IPMI_NETFN_APP | 1), IPMI_BMC_SLAVE_ADDR, 3, 0x01,
+                               data, sizeof(data));
+    pkt[off - 1] = (uint8_t)msg_len;
+    CHECK(ipmi_rsp_view(pkt, off + msg_len, &view) == BMC_SUCCESS && view.seq == 3);
+    
+    // msg_len 比封包剩下的還長、或比 header 還短
+    CHECK(ipmi_rsp_view(pkt, off + msg_len - 1, &view) == BMC_ERROR_PROTOCOL);
+    pkt[off - 1] = 6;
+    CHECK(ipmi_rsp_view(pkt, off + msg_len, &view) == BMC_ERROR_PROTOCOL);
+    pkt[off - 1] = 0;
+    CHECK(ipmi_rsp_view(pkt, off + msg_len, &view) == BMC_ERROR_PROTOCOL);
+    
+    // 只有 RMCP header 和 auth type
+    CHECK(ipmi_rsp_view(pkt, 5, &view) == BMC_ERROR_PROTOCOL);
+}
+
+static void test_rsp_copy(void) {
+    static uint8_t src[1024];
+    ipmi_msg_t msg;
+    ipmi_rsp_view_t view = { .netfn = 7, .cmd = 0x01, .seq = 4, .data = src,
+                             .data_len = sizeof(src) };
+    
+    memset(src, 0xA5, sizeof(src));
+    ipmi_rsp_copy(&view, &msg);
+    CHECK(msg.data_len == IPMI_MAX_DATA_SIZE);
+    CHECK(msg.netfn == 7 && msg.cmd == 0x01 && msg.seq == 4);
+    CHECK(msg.data[IPMI_MAX_DATA_SIZE - 1] == 0xA5);
+    
+    view.data_len = 2;
+    ipmi_rsp_copy(&view, &msg);
+    CHECK(msg.data_len == 2);
+}
+
+/* ===== request 樣板 ===== */
+
+#define TMPL_THREADS    8
+
+// 每個 thread 都從共用快取建封包，要跟自己現算的樣板建出來的一樣
+static void* tmpl_worker(void* arg) {
+    long* mismatches = arg;
+    uint8_t a[IPMI_REQ_MAX_LEN];
+    uint8_t b[IPMI_REQ_MAX_LEN];
+    const uint8_t data[] = { 0x01, 0x02, 0x03 };
+    struct iovec iov = { .iov_base = (void*)data, .iov_len = sizeof(data) };
+    
+    for (int netfn = 0; netfn < 64; netfn += 3) {
+        for (int cmd = 0; cmd < 256; cmd += 7) {
+            ipmi_req_tmpl_t tmpl;
+            ipmi_req_tmpl_init(&tmpl, (uint8_t)netfn, (uint8_t)cmd);
+            size_t len_a = sizeof(a);
+            size_t len_b = sizeof(b);
+            ipmi_req_build(ipmi_req_tmpl_get((uint8_t)netfn, (uint8_t)cmd), 9, &iov, 1, a, &len_a);
+            ipmi_req_build(&tmpl, 9, &iov, 1, b, &len_b);
+            if (len_a != len_b || memcmp(a, b, len_a) != 0) {
+                (*mismatches)++;
+            }
+        }
+    }
+    return NULL;
+}
+
+static void test_tmpl_cache(void) {
+    pthread_t threads[TMPL_THREADS];
+    long mismatches[TMPL_THREADS] = {0};
+    
+    for (int i = 0; i < TMPL_THREADS; i++) {
+        CHECK(pthread_create(&threads[i], NULL, tmpl_worker, &mismatches[i]) == 0);
+    }
+    for (int i = 0; i < TMPL_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        CHECK(mismatches[i] == 0);
+    }
+    
+    // netfn 只有 6 bits，同一個 (netfn, cmd) 永遠拿到同一份
+    CHECK(ipmi_req_tmpl_get(0x46, 0x01) == ipmi_req_tmpl_get(0x06, 0x01));
+}
+
+/* ===== rqSeq 視窗 ===== */
+
+static void test_seq_window(void) {
+    ipmi_seq_window_t win;
+    int owners[IPMI_SEQ_SPACE];
+    
+    // 6 bits 繞回 0
+    ipmi_seq_init(&win, 62);
+    CHECK(ipmi_seq_alloc(&win, &owners[0]) == 62);
+    CHECK(ipmi_seq_alloc(&win, &owners[1]) == 63);
+    CHECK(ipmi_seq_alloc(&win, &owners[2]) == 0);
+    CHECK(win.count == 3);
+    
+    // 回應的 rqSeq 只看低 6 bits；重複或沒發過的回應拿不到 owner
+    CHECK(ipmi_seq_take(&win, 63 | 0x40) == &owners[1]);
+    CHECK(ipmi_seq_take(&win, 63) == NULL);
+    CHECK(ipmi_seq_take(&win, 5) == NULL);
+    CHECK(win.count == 2);
+    
+    // 剛釋放的 seq 不會馬上被重用
+    CHECK(ipmi_seq_alloc(&win, &owners[3]) == 1);
+    
+    // 滿了之後回傳 -1；釋放一個就分到那一個，跳過還在路上的
+    ipmi_seq_init(&win, 0);
+    for (int i = 0; i < IPMI_SEQ_SPACE; i++) {
+        CHECK(ipmi_seq_alloc(&win, &owners[i]) == i);
+    }
+    CHECK(ipmi_seq_alloc(&win, &owners[0]) == -1);
+    CHECK(ipmi_seq_take(&win, 17) == &owners[17]);
+    CHECK(ipmi_seq_alloc(&win, &owners[17]) == 17);
+    CHECK(ipmi_seq_alloc(&win, NULL) == -1);
+}
+
+/* ===== 橋接 ===== */
+
+static void test_bridge_unwrap(void) {
+    ipmi_msg_t req = { .netfn = IPMI_NETFN_APP, .cmd = 0x01, .target_addr = 0x2C,
+                       .channel = 6 };
+    uint8_t data[64];
+    ipmi_rsp_view_t outer = { .netfn = (IPMI_NETFN_APP | 1), .cmd = IPMI_CMD_SEND_MESSAGE,
+                              .seq = 5, .data = data };
+    ipmi_rsp_view_t inner;
+    const uint8_t payload[] = { 0x00, 0x50, 0x01 };
+    
+    // 只有 completion code 0 是 ack，回應還在路上
+    data[0] = 0x00;
+    outer.data_len = 1;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == IPMI_BRIDGE_PENDING);
+    
+    // BMC 轉送失敗，呼叫端要看到外層的 completion code
+    data[0] = 0x82;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_SUCCESS);
+    CHECK(inner.data == data && inner.data_len == 1 && inner.data[0] == 0x82);
+    
+    // satellite 的回應
+    data[0] = 0x00;
+    outer.data_len = 1 + build_msg(data + 1, (IPMI_NETFN_APP | 1), 0x2C, 5, 0x01,
+                                   payload, sizeof(payload));
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_SUCCESS);
+    CHECK(inner.seq == 5 && inner.cmd == 0x01 && inner.data_len == sizeof(payload));
+    CHECK(memcmp(inner.data, payload, sizeof(payload)) == 0);
+    
+    // 外層 seq 帶高位元也一樣
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5 | 0x40, &inner) == BMC_SUCCESS);
+    
+    // 不是這個 request 的：seq、cmd、位址不對
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 6, &inner) == BMC_ERROR_PROTOCOL);
+    req.cmd = 0x02;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+    req.cmd = 0x01;
+    req.target_addr = 0x2E;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+    req.target_addr = 0x2C;
+    
+    // 內層 checksum 錯、被截斷、沒有 completion code
+    data[outer.data_len - 1] ^= 0xFF;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+    data[outer.data_len - 1] ^= 0xFF;
+    outer.data_len = 4;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+    outer.data_len = 1 + build_msg(data + 1, (IPMI_NETFN_APP | 1), 0x2C, 5, 0x01, NULL, 0);
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+    
+    // 外層不是 Send Message
+    outer.data_len = 1 + build_msg(data + 1, (IPMI_NETFN_APP | 1), 0x2C, 5, 0x01,
+                                   payload, sizeof(payload));
+    outer.cmd = 0x01;
+    CHECK(ipmi_bridge_unwrap(&outer, &req, 5, &inner) == BMC_ERROR_PROTOCOL);
+}
+
+/* ===== RMCP+ 金鑰導出 ===== */
+
+#define TEST_CONSOLE_ID     0x11223344
+#define TEST_BMC_ID         0x55667788
+
+typedef struct {
+    int cipher_suite;
+    uint8_t auth[IPMI_SESSION_KEY_MAX];    // RAKP2 key exchange auth code
+    uint8_t sik[IPMI_SESSION_KEY_MAX];
+    uint8_t k1[IPMI_SESSION_KEY_MAX];
+    uint8_t k2[IPMI_SESSION_KEY_MAX];
+} key_vector_t;
+
+/*
+ * 帳號 admin / 密碼 secret，Rm = 00..0f，Rc = 10..1f，GUID = 20..2f，
+ * ROLE = 0x14，SIDm = 0x11223344，SIDc = 0x55667788
+ */
+static const key_vector_t g_vectors[] = {
+    {
+        3,
+        { 0xc3, 0x07, 0xe8, 0x65, 0x08, 0x81, 0x04, 0x39, 0xe5, 0x82,
+          0x95, 0xae, 0xcb, 0x36, 0x27, 0x38, 0xd0, 0xba, 0x7e, 0x15 },
+        { 0xa3, 0x9a, 0xe2, 0xb1, 0x60, 0xa1, 0xe5, 0xef, 0xe0, 0x17,
+          0xff, 0xd6, 0xec, 0x1a, 0x4f, 0xf8, 0xee, 0xac, 0x6f, 0x54 },
+        { 0x58, 0xdb, 0xc1, 0xaf, 0xa0, 0x0e, 0xb3, 0xf9, 0x48, 0x7c,
+          0x9e, 0xae, 0xf0, 0xdc, 0x78, 0x92, 0xcc, 0x43, 0xe4, 0x96 },
+        { 0x8b, 0xd9, 0xb8, 0xce, 0x06, 0x74, 0xb5, 0xd7, 0x45, 0xce,
+          0xd9, 0x1e, 0x72, 0x8a, 0xc1, 0xa5, 0x14, 0x64, 0xfc, 0xaf },
+    },
+    {
+        17,
+        { 0xfc, 0xca, 0x6b, 0xf2, 0xd3, 0x39, 0xec, 0x8e, 0x1b, 0x7f,
+          0x24, 0x7d, 0xa5, 0x70, 0x1e, 0xda, 0xec, 0x20, 0x39, 0xb3,
+          0xa5, 0x9a, 0xbc, 0xdd, 0x34, 0x9b, 0x20, 0x35, 0x92, 0x8a,
+          0x6c, 0x08 },
+        { 0x0c, 0x4b, 0x74, 0x64, 0x11, 0x0c, 0xf1, 0x8f, 0xd9, 0x4e,
+          0xc4, 0x6a, 0xa0, 0x24, 0x2c, 0x66, 0xab, 0x06, 0x15, 0x77,
+          0x09, 0xc0, 0x2e, 0xa7, 0xdb, 0x16, 0x53, 0xaa, 0xc0, 0x4b,
+          0x10, 0x23 },
+        { 0xb5, 0x6f, 0xae, 0xf1, 0xc3, 0x77, 0x59, 0xee, 0x6f, 0x92,
+          0xdc, 0xcb, 0x3d, 0xfb, 0x8a, 0x76, 0x10, 0xc8, 0x3e, 0x06,
+          0x48, 0x83, 0xaa, 0x73, 0x5d, 0x3e, 0x84, 0xc1, 0xcb, 0x0c,
+          0x57, 0x28 },
+        { 0x45, 0xd8, 0x8a, 0xac, 0x4a, 0x3d, 0x9b, 0x6a, 0xc2, 0xcd,
+          0xf0, 0x22, 0xf1, 0xf3, 0x1a, 0x5a, 0x82, 0xac, 0x0a, 0xec,
+          0xfe, 0x8d, 0x85, 0x59, 0xb4, 0x06, 0x0e, 0xb4, 0xa1, 0x3b,
+          0x43, 0x34 },
+    },
+};
+
+static void put_le32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+// 照測試向量組 RAKP2，交給 parse_rakp2 導出金鑰
+static int derive(const key_vector_t* v, ipmi_session_t* s, int corrupt) {
+    ipmi_handshake_t hs;
+    uint8_t pkt[16 + 40 + IPMI_SESSION_KEY_MAX] = { RMCP_VERSION_1_0, 0x00, RMCP_SEQUENCE_NO_ACK,
+                                                    RMCP_CLASS_IPMI, IPMI_AUTH_TYPE_RMCPP,
+                                                    IPMI_PAYLOAD_RAKP2 };
+    
+    if (ipmi_session_init(s, v->cipher_suite, IPMI_PRIV_ADMIN) != BMC_SUCCESS ||
+        ipmi_handshake_init(&hs, "admin", "secret") != BMC_SUCCESS) {
+        return BMC_ERROR_INVALID_PARAM;
+    }
+    s->console_id = TEST_CONSOLE_ID;
+    s->bmc_id = TEST_BMC_ID;
+    hs.role = 0x10 | IPMI_PRIV_ADMIN;
+    for (int i = 0; i < 16; i++) {
+        hs.rm[i] = (uint8_t)i;
+    }
+    
+    uint8_t* p = pkt + 16;
+    size_t plen = 40 + s->key_len;
+    pkt[14] = (uint8_t)plen;
+    p[0] = hs.tag;
+    put_le32(p + 4, TEST_CONSOLE_ID);
+    for (int i = 0; i < 32; i++) {
+        p[8 + i] = (uint8_t)(16 + i);    // Rc 和 GUID
+    }
+    memcpy(p + 40, v->auth, s->key_len);
+    if (corrupt) {
+        p[40] ^= 0x01;
+    }
+    
+    int ret = ipmi_session_parse_rakp2(s, &hs, pkt, 16 + plen);
+    ipmi_handshake_clear(&hs);
+    return ret;
+}
+
+static void test_key_derivation(void) {
+    for (size_t i = 0; i < sizeof(g_vectors) / sizeof(g_vectors[0]); i++) {
+        const key_vector_t* v = &g_vectors[i];
+        ipmi_session_t s;
+        
+        CHECK(derive(v, &s, 0) == BMC_SUCCESS);
+        CHECK(memcmp(s.sik, v->sik, s.key_len) == 0);
+        CHECK(memcmp(s.k1, v->k1, s.key_len) == 0);
+        CHECK(memcmp(s.k2, v->k2, s.key_len) == 0);
+        
+        // BMC 的 auth code 不對（密碼錯）就不能導出金鑰
+        CHECK(derive(v, &s, 1) == BMC_ERROR_PROTOCOL);
+        ipmi_session_clear(&s);
+    }
+}
+
+/* ===== session sequence number 的 replay window ===== */
+
+typedef struct {
+    uint8_t pkt[IPMI_LANPLUS_MAX_LEN];
+    size_t len;
+} wire_t;
+
+// 用 BMC 那端的 session 以指定的 sequence number 送一包回應
+static void bmc_send(ipmi_session_t* bmc, uint32_t seq, wire_t* w) {
+    const uint8_t data[] = { 0x00 };
+    uint8_t msg[16];
+    size_t msg_len = build_msg(msg, (IPMI_NETFN_APP | 1), IPMI_BMC_SLAVE_ADDR, 1, 0x01,
+                               data, sizeof(data));
+    
+    bmc->out_seq = seq;
+    w->len = sizeof(w->pkt);
+    CHECK(ipmi_session_wrap(bmc, msg, msg_len, w->pkt, &w->len) == BMC_SUCCESS);
+}
+
+// unwrap 會就地解密，每次收都用一份複本
+static int recv_copy(ipmi_session_t* s, const wire_t* w) {
+    uint8_t buf[IPMI_LANPLUS_MAX_LEN];
+    ipmi_rsp_view_t view;
+    
+    memcpy(buf, w->pkt, w->len);
+    return ipmi_session_unwrap(s, buf, w->len, &view);
+}
+
+static void test_replay_window(void) {
+    ipmi_session_t s;
+    ipmi_session_t bmc;
+    wire_t w[8];
+    
+    CHECK(derive(&g_vectors[1], &s, 0) == BMC_SUCCESS);
+    s.active = 1;
+    s.out_seq = 1;
+    
+    // BMC 送過來的封包帶的是我們的 session ID
+    bmc = s;
+    bmc.bmc_id = s.console_id;
+    
+    bmc_send(&bmc, 10, &w[0]);
+    bmc_send(&bmc, 8, &w[1]);
+    bmc_send(&bmc, 50, &w[2]);
+    bmc_send(&bmc, 19, &w[3]);
+    bmc_send(&bmc, 18, &w[4]);
+    bmc_send(&bmc, 51, &w[5]);
+    bmc_send(&bmc, 0, &w[6]);
+    
+    CHECK(recv_copy(&s, &w[0]) == BMC_SUCCESS);
+    CHECK(recv_copy(&s, &w[0]) == BMC_ERROR_PROTOCOL);     // 重送
+    CHECK(recv_copy(&s, &w[1]) == BMC_SUCCESS);            // 亂序但在 window 裡
+    CHECK(recv_copy(&s, &w[1]) == BMC_ERROR_PROTOCOL);
+    CHECK(recv_copy(&s, &w[2]) == BMC_SUCCESS);
+    CHECK(s.in_seq == 50);
+    CHECK(recv_copy(&s, &w[3]) == BMC_SUCCESS);            // 50 - 31
+    CHECK(recv_copy(&s, &w[4]) == BMC_ERROR_PROTOCOL);     // 50 - 32，太舊
+    CHECK(recv_copy(&s, &w[6]) == BMC_ERROR_PROTOCOL);     // 0 不是合法的 sequence number
+    
+    // 被改過的封包不能推動 window，原封包之後還是收得到
+    w[7] = w[5];
+    w[7].pkt[w[7].len - 20] ^= 0x01;
+    CHECK(recv_copy(&s, &w[7]) == BMC_ERROR_PROTOCOL);
+    CHECK(s.in_seq == 50);
+    CHECK(recv_copy(&s, &w[5]) == BMC_SUCCESS);
+    
+    // 32 bits 繞回去之後還是往前
+    bmc_send(&bmc, 0xFFFFFFFE, &w[0]);
+    CHECK(recv_copy(&s, &w[0]) == BMC_ERROR_PROTOCOL);     // 跟 51 比是往回
+    s.in_seq = 0xFFFFFFF0;
+    s.in_window = 1;
+    CHECK(recv_copy(&s, &w[0]) == BMC_SUCCESS);
+    bmc_send(&bmc, 3, &w[1]);
+    CHECK(recv_copy(&s, &w[1]) == BMC_SUCCESS);
+    CHECK(s.in_seq == 3);
+    CHECK(recv_copy(&s, &w[0]) == BMC_ERROR_PROTOCOL);
+    
+    ipmi_session_clear(&s);
+    ipmi_session_clear(&bmc);
+}
+
+int main(void) {
+    printf("msg_view\n");
+    test_msg_view();
+    printf("rsp_view\n");
+    test_rsp_view();
+    printf("rsp_copy\n");
+    test_rsp_copy();
+    printf("tmpl_cache\n");
+    test_tmpl_cache();
+    printf("seq_window\n");
+    test_seq_window();
+    printf("bridge_unwrap\n");
+    test_bridge_unwrap();
+    printf("key_derivation\n");
+    test_key_derivation();
+    printf("replay_window\n");
+    test_replay_window();
+    
+    if (g_failures) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All IPMI packet tests passed\n");
+    return 0;
+}
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""
+Redfish 端對端測試
+
+每個測試起一個 redfish_mock_server.py（可以帶 quirk 參數模擬有問題的 BMC），
+跑 bmctool 再檢查輸出和 mock 收到的 request。
+
+用法：tests/test_redfish.py [bmctool 路徑]
+"""
+import os
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BMCTOOL = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else './bmctool')
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print(f"  FAIL {what}")
+        failures += 1
+
+
+def free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(('127.0.0.1', 0))
+        return s.getsockname()[1]
+
+
+class Mock:
+    """redfish_mock_server.py 子行程；requests() 回傳它記下的 request line"""
+
+    def __init__(self, *quirks):
+        self.port = free_port()
+        self.url = f'http://127.0.0.1:{self.port}'
+        self.log = tempfile.TemporaryFile(mode='w+')
+        self.proc = subprocess.Popen(
+            [sys.executable, '-u', os.path.join(HERE, 'redfish_mock_server.py'),
+             str(self.port), *quirks],
+            stdout=self.log, stderr=subprocess.STDOUT)
+
+        # 等它開始 listen
+        deadline = time.monotonic() + 5
+        while time.monotonic() < deadline:
+            try:
+                socket.create_connection(('127.0.0.1', self.port), timeout=0.2).close()
+                return
+            except OSError:
+                time.sleep(0.05)
+        raise RuntimeError('mock server did not start')
+
+    def requests(self):
+        self.log.seek(0)
+        return [line.split('"')[1] + ' ' + line.split('"')[2].split()[0]
+                for line in self.log if line.startswith('[Redfish]') and '"' in line]
+
+    def basic_auth(self):
+        """用 Basic 認證的 GET 有幾個"""
+        self.log.seek(0)
+        return sum(1 for line in self.log if line.startswith('[Auth] basic'))
+
+    def connections(self):
+        """每個 request 是從哪個 client port 來的"""
+        self.log.seek(0)
+        return [line.split()[1] for line in self.log if line.startswith('[Redfish]') and '"' in line]
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.proc.terminate()
+        self.proc.wait()
+        self.log.close()
+
+
+class Env:
+    """每個測試自己的快取目錄"""
+
+    def __enter__(self):
+        self.dir = tempfile.mkdtemp(prefix='bmctool-redfish-')
+        return self
+
+    def __exit__(self, *exc):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def run(self, mock, *args, opts=()):
+        env = dict(os.environ, BMCTOOL_CACHE_DIR=self.dir)
+        p = subprocess.run([BMCTOOL, *opts, '-H', mock.url, '-U', 'admin', '-P', 'password',
+                            'redfish', *args], env=env, capture_output=True, text=True,
+                           timeout=60)
+        return p.returncode, p.stdout, p.stderr
+
+    def run_rss(self, mock, *args):
+        """跑一次，回傳 (exit code, stdout, 最大 RSS KiB)"""
+        env = dict(os.environ, BMCTOOL_CACHE_DIR=self.dir)
+        with tempfile.TemporaryFile(mode='w+') as out:
+            p = subprocess.Popen([BMCTOOL, '-H', mock.url, '-U', 'admin', '-P', 'password',
+                                  'redfish', *args], env=env, stdout=out, stderr=subprocess.DEVNULL)
+            _, status, usage = os.wait4(p.pid, 0)
+            p.returncode = os.waitstatus_to_exitcode(status)
+            out.seek(0)
+            return p.returncode, out.read(), usage.ru_maxrss
+
+
+SERIALS = ('12345678', '12345679', '12345680')
+
+
+# ===== user-024：$expand / $select =====
+
+def test_expand_fallback():
+    # BMC 宣稱支援 $expand 但回 400：拿掉 query 重試，預期中的 400 不能印成 ERROR
+    with Mock('--reject-query') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'systems')
+        check(rc == 0, f'systems exit {rc}: {err}')
+        check(all(s in out for s in SERIALS), 'all systems listed')
+        check('HTTP error' not in err, f'no error logged for rejected query: {err.strip()}')
+        reqs = mock.requests()
+        check(any('$expand' in r and r.endswith(' 400') for r in reqs), 'tried $expand first')
+        check('GET /redfish/v1/Systems HTTP/1.1 200' in reqs, 'retried without query')
+
+
+def test_expand_used():
+    with Mock() as mock, Env() as env:
+        rc, out, err = env.run(mock, 'systems')
+        check(rc == 0 and all(s in out for s in SERIALS), 'systems via $expand')
+        reqs = mock.requests()
+        check(not any(r.startswith('GET /redfish/v1/Systems/') for r in reqs),
+              'no per-member GET when $expand works')
+
+
+def test_null_member():
+    # Members 裡的 null / 數字要跳過，不能讓 json-c assert
+    with Mock('--null-member') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'members', '/redfish/v1/Systems', 'Id,SerialNumber')
+        check(rc == 0, f'members exit {rc}: {err}')
+        lines = [l for l in out.splitlines() if l.startswith('{')]
+        check(len(lines) == 3, f'3 members printed, got {len(lines)}')
+
+
+# ===== user-023：ETag 快取 =====
+
+def test_etag_cache_opt_in():
+    # 沒加 -e 不讀也不寫快取檔
+    with Mock() as mock, Env() as env:
+        for _ in range(2):
+            rc, out, err = env.run(mock, 'system', '1')
+            check(rc == 0 and '12345678' in out, f'system exit {rc}: {err}')
+        check(not os.path.exists(os.path.join(env.dir, 'redfish-etags')), 'no cache file without -e')
+        check('GET /redfish/v1/Systems/1 HTTP/1.1 304' not in mock.requests(), 'no 304 without -e')
+
+
+def test_etag_cache_304():
+    with Mock() as mock, Env() as env:
+        for _ in range(2):
+            rc, out, err = env.run(mock, 'system', '1', opts=('-e',))
+            check(rc == 0 and '12345678' in out, f'system exit {rc}: {err}')
+        path = os.path.join(env.dir, 'redfish-etags')
+        check(os.path.exists(path) and os.stat(path).st_mode & 0o777 == 0o600, 'cache file is 0600')
+        reqs = mock.requests()
+        check(reqs.count('GET /redfish/v1/Systems/1 HTTP/1.1 200') == 1, 'fetched once')
+        check(reqs.count('GET /redfish/v1/Systems/1 HTTP/1.1 304') == 1, 'revalidated with 304')
+
+
+def test_etag_cache_untrusted():
+    # 別人寫得到的檔案、symlink 都不能拿來當 BMC 的回應
+    with Mock() as mock, Env() as env:
+        env.run(mock, 'system', '1', opts=('-e',))
+        path = os.path.join(env.dir, 'redfish-etags')
+        os.chmod(path, 0o666)
+        rc, out, err = env.run(mock, 'system', '1', opts=('-e',))
+        check(rc == 0 and 'bad owner or permissions' in err, f'loose mode rejected: {err.strip()}')
+
+        os.rename(path, path + '.real')
+        os.chmod(path + '.real', 0o600)
+        os.symlink(path + '.real', path)
+        rc, out, err = env.run(mock, 'system', '1', opts=('-e',))
+        check(rc == 0, f'symlinked cache exit {rc}: {err}')
+        check('GET /redfish/v1/Systems/1 HTTP/1.1 304' not in mock.requests(), 'untrusted cache not used')
+
+
+# ===== user-020：連線重用 =====
+
+def test_connection_reuse():
+    # 登入、兩個 GET、登出都走同一條 keep-alive 連線
+    with Mock() as mock, Env() as env:
+        rc, out, err = env.run(mock, 'systems')
+        check(rc == 0 and all(s in out for s in SERIALS), f'systems exit {rc}: {err}')
+        reqs = mock.requests()
+        check(len(reqs) == 4 and reqs[0].startswith('POST') and reqs[-1].startswith('DELETE'),
+              f'requests {reqs}')
+        check(len(set(mock.connections())) == 1, f'connections {mock.connections()}')
+
+
+def test_connection_reuse_304():
+    # 304 沒有 body，連線照樣留著用
+    with Mock() as mock, Env() as env:
+        env.run(mock, 'system', '1', opts=('-e',))
+        start = len(mock.connections())
+        rc, out, err = env.run(mock, 'system', '1', opts=('-e',))
+        check(rc == 0 and '12345678' in out, f'system exit {rc}: {err}')
+        check(len(set(mock.connections()[start:])) == 1, f'connections {mock.connections()}')
+
+
+# ===== user-022：SessionService token =====
+
+def test_session_token():
+    # 登入一次，之後都帶 X-Auth-Token；結束時刪掉 session
+    with Mock() as mock, Env() as env:
+        rc, out, err = env.run(mock, 'systems')
+        check(rc == 0 and all(s in out for s in SERIALS), f'systems exit {rc}: {err}')
+        reqs = mock.requests()
+        check(reqs[0] == 'POST /redfish/v1/SessionService/Sessions HTTP/1.1 201', f'login {reqs[:1]}')
+        check(reqs[-1] == 'DELETE /redfish/v1/SessionService/Sessions/1 HTTP/1.1 204', f'logout {reqs[-1:]}')
+        check(mock.basic_auth() == 0, 'no Basic credentials after login')
+
+
+def test_session_relogin():
+    # token 用兩次就過期：401 之後重新登入再送同一個 GET，輸出不受影響
+    with Mock('--reject-query', '--expire-tokens') as mock, Env() as env:
+        rc, out, err = env.run(mock, 'systems')
+        check(rc == 0 and all(s in out for s in SERIALS), f'systems exit {rc}: {err}')
+        reqs = mock.requests()
+        logins = [r for r in reqs if r.startswith('POST')]
+        expired = [r for r in reqs if r.startswith('GET') and r.endswith(' 401')]
+        check(len(expired) >= 2 and len(logins) == len(expired) + 1,
+              f'{len(logins)} logins for {len(expired)} expired tokens')
+        check(mock.basic_auth() == 0, 'no fallback to Basic on 401')
+
+
+def test_session_token_cache():
+    # -S：token 留在 BMC 上，下一次執行直接拿來用，不再登入也不刪
+    with Mock() as mock, Env() as env:
+        for _ in range(2):
+            rc, out, err = env.run(mock, 'system', '1', opts=('-S',))
+            check(rc == 0 and '12345678' in out, f'system exit {rc}: {err}')
+        reqs = mock.requests()
+        check(sum(r.startswith('POST') for r in reqs) == 1, f'one login: {reqs}')
+        check(not any(r.startswith('DELETE') for r in reqs), 'cached session not deleted')
+        check(reqs.count('GET /redfish/v1/Systems/1 HTTP/1.1 200') == 2, 'both runs fetched')
+
+
+# ===== user-025：串流 parse =====
+
+def test_streaming_scan():
+    # System 1 前面有 8 MB 的 Oem：只取要的欄位，同名的巢狀欄位不算，body 不整包留在記憶體
+    with Mock('--big-system') as mock, Env() as env:
+        rc, out, base_rss = env.run_rss(mock, 'system', '2')
+        check(rc == 0 and '12345679' in out, f'small system exit {rc}')
+
+        rc, out, rss = env.run_rss(mock, 'system', '1')
+        check(rc == 0, f'big system exit {rc}: {out}')
+        check('12345678' in out and 'WRONG' not in out, f'top-level fields only: {out}')
+        check('Big "System" \u00e9' in out, f'escapes decoded: {out}')
+        check(rss - base_rss < 4096, f'peak RSS grew {rss - base_rss} KiB for a 9 MB body')
+
+
+TESTS = [
+    test_expand_fallback,
+    test_expand_used,
+    test_null_member,
+    test_etag_cache_opt_in,
+    test_etag_cache_304,
+    test_etag_cache_untrusted,
+    test_connection_reuse,
+    test_connection_reuse_304,
+    test_session_token,
+    test_session_relogin,
+    test_session_token_cache,
+    test_streaming_scan,
+]
+
+
+def main():
+    for t in TESTS:
+        print(t.__name__[5:])
+        t()
+
+    if failures:
+        print(f"{failures} check(s) failed")
+        return 1
+    print("All Redfish tests passed")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())